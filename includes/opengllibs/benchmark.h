@@ -0,0 +1,276 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Замер времени проходов рендеринга: CPU (std::chrono) и GPU (запросы GL_TIMESTAMP).
+// Запросы GPU хранятся кольцом на LATENCY кадров, поэтому результаты читаются, когда GPU
+// их уже давно посчитал, и чтение не останавливает конвейер.
+// Кадры до setRecording(true) (прогрев) в статистику не попадают.
+class Benchmark
+{
+public:
+    static const int LATENCY = 4; // сколько кадров запрос может находиться в конвейере
+
+    Benchmark()
+    {
+        // таймер GPU может отсутствовать (количество бит счётчика = 0)
+        GLint bits = 0;
+        glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+        gpuTimers = bits > 0;
+    }
+
+    ~Benchmark()
+    {
+        for (Pass& pass : passes)
+            glDeleteQueries(2 * LATENCY, pass.queries);
+        for (QueryCounter& counter : queryCounters)
+            glDeleteQueries(LATENCY, counter.queries);
+    }
+
+    Benchmark(const Benchmark&) = delete;
+    Benchmark& operator=(const Benchmark&) = delete;
+
+    // зарегистрировать проход; возвращает его индекс для beginPass/endPass
+    int addPass(const std::string& name)
+    {
+        passes.emplace_back();
+        Pass& pass = passes.back();
+        pass.name = name;
+        glGenQueries(2 * LATENCY, pass.queries);
+        return (int)passes.size() - 1;
+    }
+
+    // зарегистрировать счётчик, значение которого даёт запрос OpenGL (например, GL_PRIMITIVES_GENERATED);
+    // результат читается с той же задержкой в LATENCY кадров и попадает в раздел "counters"
+    int addQueryCounter(const std::string& name, GLenum target)
+    {
+        queryCounters.emplace_back();
+        QueryCounter& counter = queryCounters.back();
+        counter.name = name;
+        counter.target = target;
+        glGenQueries(LATENCY, counter.queries);
+        return (int)queryCounters.size() - 1;
+    }
+
+    void setRecording(bool value) { recording = value; }
+
+    // строковый параметр конфигурации, попадает в раздел "info" отчёта
+    void setInfo(const std::string& key, const std::string& value) { info[key] = value; }
+
+    // значение счётчика за текущий кадр (например, число треугольников)
+    void setCounter(const std::string& name, double value)
+    {
+        if (recording)
+            counters[name].push_back(value);
+    }
+
+    // ------------------------------------------------------------------------
+    void beginFrame()
+    {
+        slot = frame % LATENCY;
+        // забираем результаты кадра, который LATENCY кадров назад использовал этот слот
+        for (Pass& pass : passes)
+            resolve(pass, slot);
+        for (QueryCounter& counter : queryCounters)
+            resolve(counter, slot);
+        frameStart = Clock::now();
+    }
+
+    void endFrame()
+    {
+        if (recording)
+            frameSamples.push_back(millisecondsSince(frameStart));
+        ++frame;
+    }
+
+    void beginPass(int index)
+    {
+        Pass& pass = passes[index];
+        pass.cpuStart = Clock::now();
+        if (gpuTimers)
+            glQueryCounter(pass.queries[2 * slot], GL_TIMESTAMP);
+    }
+
+    void endPass(int index)
+    {
+        Pass& pass = passes[index];
+        if (gpuTimers)
+        {
+            glQueryCounter(pass.queries[2 * slot + 1], GL_TIMESTAMP);
+            pass.pending[slot] = true;
+            pass.pendingRecorded[slot] = recording;
+        }
+        if (recording)
+            pass.cpuSamples.push_back(millisecondsSince(pass.cpuStart));
+    }
+
+    void beginQuery(int index)
+    {
+        QueryCounter& counter = queryCounters[index];
+        glBeginQuery(counter.target, counter.queries[slot]);
+    }
+
+    void endQuery(int index)
+    {
+        QueryCounter& counter = queryCounters[index];
+        glEndQuery(counter.target);
+        counter.pending[slot] = true;
+        counter.pendingRecorded[slot] = recording;
+    }
+
+    // дождаться всех оставшихся запросов (вызывать после последнего кадра)
+    void finish()
+    {
+        for (int i = 0; i < LATENCY; ++i)
+        {
+            for (Pass& pass : passes)
+                resolve(pass, i);
+            for (QueryCounter& counter : queryCounters)
+                resolve(counter, i);
+        }
+    }
+
+    // ------------------------------------------------------------------------
+    void writeJson(std::ostream& out) const
+    {
+        out << "{\n";
+        out << "  \"info\": {";
+        bool first = true;
+        for (const auto& entry : info)
+        {
+            out << (first ? "\n" : ",\n") << "    \"" << escape(entry.first) << "\": \"" << escape(entry.second) << "\"";
+            first = false;
+        }
+        out << (first ? "},\n" : "\n  },\n");
+        out << "  \"frames\": " << frameSamples.size() << ",\n";
+        out << "  \"gpu_timers\": " << (gpuTimers ? "true" : "false") << ",\n";
+        out << "  \"frame_cpu_ms\": ";
+        writeStats(out, frameSamples);
+        out << ",\n  \"passes\": {";
+        for (size_t i = 0; i < passes.size(); ++i)
+        {
+            out << (i == 0 ? "\n" : ",\n") << "    \"" << escape(passes[i].name) << "\": {\n";
+            out << "      \"cpu_ms\": ";
+            writeStats(out, passes[i].cpuSamples);
+            out << ",\n      \"gpu_ms\": ";
+            writeStats(out, passes[i].gpuSamples);
+            out << "\n    }";
+        }
+        out << (passes.empty() ? "},\n" : "\n  },\n");
+        out << "  \"counters\": {";
+        first = true;
+        for (const auto& entry : counters)
+        {
+            out << (first ? "\n" : ",\n") << "    \"" << escape(entry.first) << "\": ";
+            writeStats(out, entry.second);
+            first = false;
+        }
+        out << (first ? "}\n" : "\n  }\n");
+        out << "}\n";
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Pass
+    {
+        std::string name;
+        GLuint queries[2 * LATENCY];           // пары (начало, конец) для каждого слота кольца
+        bool pending[LATENCY] = {};            // в слоте есть непрочитанный результат
+        bool pendingRecorded[LATENCY] = {};    // результат слота попадает в статистику
+        Clock::time_point cpuStart;
+        std::vector<double> cpuSamples;
+        std::vector<double> gpuSamples;
+    };
+
+    struct QueryCounter
+    {
+        std::string name;
+        GLenum target = 0;
+        GLuint queries[LATENCY];
+        bool pending[LATENCY] = {};
+        bool pendingRecorded[LATENCY] = {};
+    };
+
+    std::vector<Pass> passes;
+    std::vector<QueryCounter> queryCounters;
+    std::map<std::string, std::string> info;
+    std::map<std::string, std::vector<double>> counters;
+    std::vector<double> frameSamples;
+    Clock::time_point frameStart;
+    bool gpuTimers = false;
+    bool recording = false;
+    long long frame = 0;
+    int slot = 0;
+
+    static double millisecondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    void resolve(Pass& pass, int index)
+    {
+        if (!pass.pending[index])
+            return;
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(pass.queries[2 * index], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(pass.queries[2 * index + 1], GL_QUERY_RESULT, &end);
+        if (pass.pendingRecorded[index])
+            pass.gpuSamples.push_back((double)(end - begin) / 1.0e6);
+        pass.pending[index] = false;
+    }
+
+    void resolve(QueryCounter& counter, int index)
+    {
+        if (!counter.pending[index])
+            return;
+        GLuint64 value = 0;
+        glGetQueryObjectui64v(counter.queries[index], GL_QUERY_RESULT, &value);
+        if (counter.pendingRecorded[index])
+            counters[counter.name].push_back((double)value);
+        counter.pending[index] = false;
+    }
+
+    static void writeStats(std::ostream& out, std::vector<double> samples)
+    {
+        if (samples.empty())
+        {
+            out << "null";
+            return;
+        }
+        std::sort(samples.begin(), samples.end());
+        double sum = 0.0;
+        for (double value : samples)
+            sum += value;
+        auto percentile = [&samples](double p) { return samples[(size_t)(p * (samples.size() - 1) + 0.5)]; };
+        out << "{ \"mean\": " << sum / samples.size()
+            << ", \"min\": " << samples.front()
+            << ", \"p50\": " << percentile(0.5)
+            << ", \"p95\": " << percentile(0.95)
+            << ", \"max\": " << samples.back() << " }";
+    }
+
+    static std::string escape(const std::string& text)
+    {
+        std::string result;
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+                result += '\\';
+            if ((unsigned char)c < 0x20)
+                continue;
+            result += c;
+        }
+        return result;
+    }
+};
+
+#endif
@@ -0,0 +1,675 @@
+#ifndef BLOCK_COMPRESSION_H
+#define BLOCK_COMPRESSION_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Блочное сжатие текстур на CPU (без OpenGL): кодирование и декодирование блоков 4x4 форматов
+//  BC1 — RGB, 8 байт на блок (4 бита на пиксель), всегда четырёхцветный режим;
+//  BC3 — BC1 для цвета и BC4 для альфы, 16 байт;
+//  BC4 — один канал (R), 8 байт;  BC5 — два канала (R, G) двумя блоками BC4, 16 байт;
+//  BC7 — RGBA, 16 байт; кодировщик пишет только режим 6 (одна пара конечных точек RGBA 7.7.7.7 + p-бит,
+//        4-битные индексы), декодер читает только его.
+// Конечные точки — главная ось цветов блока (PCA), затем одно уточнение методом наименьших квадратов по
+// выбранным индексам; остаётся вариант с меньшей ошибкой. Декодеры нужны для отчёта о качестве (PSNR).
+enum BlockFormat
+{
+    BLOCK_BC1,
+    BLOCK_BC3,
+    BLOCK_BC4,
+    BLOCK_BC5,
+    BLOCK_BC7,
+    BLOCK_FORMAT_COUNT
+};
+const char* const blockFormatNames[BLOCK_FORMAT_COUNT] = { "bc1", "bc3", "bc4", "bc5", "bc7" };
+
+// изображение RGBA8, строки сверху вниз
+struct RGBAImage
+{
+    int width = 0, height = 0;
+    std::vector<uint8_t> pixels;
+
+    RGBAImage() {}
+    RGBAImage(int w, int h) : width(w), height(h), pixels((size_t)w * h * 4, 0) {}
+
+    uint8_t* at(int x, int y) { return &pixels[((size_t)y * width + x) * 4]; }
+    const uint8_t* at(int x, int y) const { return &pixels[((size_t)y * width + x) * 4]; }
+
+    // следующий мип-уровень: среднее 2x2 (у нечётной стороны последний пиксель повторяется)
+    RGBAImage downsample() const
+    {
+        RGBAImage next(std::max(width / 2, 1), std::max(height / 2, 1));
+        for (int y = 0; y < next.height; ++y)
+            for (int x = 0; x < next.width; ++x)
+            {
+                int x0 = std::min(2 * x, width - 1), x1 = std::min(2 * x + 1, width - 1);
+                int y0 = std::min(2 * y, height - 1), y1 = std::min(2 * y + 1, height - 1);
+                for (int c = 0; c < 4; ++c)
+                    next.at(x, y)[c] = (uint8_t)((at(x0, y0)[c] + at(x1, y0)[c] + at(x0, y1)[c] + at(x1, y1)[c] + 2) / 4);
+            }
+        return next;
+    }
+
+    // цепочка мип-уровней от этого изображения до 1x1
+    std::vector<RGBAImage> mipChain() const
+    {
+        std::vector<RGBAImage> mips(1, *this);
+        while (mips.back().width > 1 || mips.back().height > 1)
+            mips.push_back(mips.back().downsample());
+        return mips;
+    }
+};
+
+class BlockCompression
+{
+public:
+    // формат по числу каналов исходного изображения: RGB — BC1, RGBA — BC3, один канал — BC4, два — BC5
+    static BlockFormat automaticFormat(int channels)
+    {
+        switch (channels)
+        {
+        case 1: return BLOCK_BC4;
+        case 2: return BLOCK_BC5;
+        case 4: return BLOCK_BC3;
+        default: return BLOCK_BC1;
+        }
+    }
+
+    static size_t blockBytes(BlockFormat format)
+    {
+        return format == BLOCK_BC1 || format == BLOCK_BC4 ? 8 : 16;
+    }
+
+    // байт уровня width x height (неполные блоки на краях занимают целый блок)
+    static size_t levelBytes(BlockFormat format, int width, int height)
+    {
+        return (size_t)((width + 3) / 4) * ((height + 3) / 4) * blockBytes(format);
+    }
+
+    static void encode(BlockFormat format, const RGBAImage& image, std::vector<uint8_t>& out)
+    {
+        out.resize(levelBytes(format, image.width, image.height));
+        uint8_t* block = out.data();
+        Pixels pixels;
+        for (int by = 0; by < image.height; by += 4)
+            for (int bx = 0; bx < image.width; bx += 4)
+            {
+                fetch(image, bx, by, pixels);
+                encodeBlock(format, pixels, block);
+                block += blockBytes(format);
+            }
+    }
+
+    // false — в данных есть блоки, которые декодер не понимает (BC7 не в режиме 6)
+    static bool decode(BlockFormat format, const uint8_t* data, int width, int height, RGBAImage& image)
+    {
+        image = RGBAImage(width, height);
+        bool ok = true;
+        Pixels pixels;
+        for (int by = 0; by < height; by += 4)
+            for (int bx = 0; bx < width; bx += 4)
+            {
+                ok = decodeBlock(format, data, pixels) && ok;
+                store(image, bx, by, pixels);
+                data += blockBytes(format);
+            }
+        return ok;
+    }
+
+    // PSNR (дБ) по каналам [first, first + count); одинаковые изображения — 100
+    static double psnr(const RGBAImage& a, const RGBAImage& b, int first, int count)
+    {
+        double error = 0.0;
+        size_t samples = 0;
+        for (size_t p = 0; p + 3 < a.pixels.size() && p + 3 < b.pixels.size(); p += 4)
+            for (int c = first; c < first + count; ++c)
+            {
+                double d = (double)a.pixels[p + c] - b.pixels[p + c];
+                error += d * d;
+                ++samples;
+            }
+        if (samples == 0 || error == 0.0)
+            return 100.0;
+        return std::min(100.0, 10.0 * std::log10(255.0 * 255.0 / (error / samples)));
+    }
+
+private:
+    typedef uint8_t Pixels[16][4];
+
+    // блок 4x4 с (bx, by); пиксели за краем изображения повторяют крайние
+    static void fetch(const RGBAImage& image, int bx, int by, Pixels& pixels)
+    {
+        for (int i = 0; i < 16; ++i)
+        {
+            const uint8_t* p = image.at(std::min(bx + i % 4, image.width - 1), std::min(by + i / 4, image.height - 1));
+            std::memcpy(pixels[i], p, 4);
+        }
+    }
+
+    static void store(RGBAImage& image, int bx, int by, const Pixels& pixels)
+    {
+        for (int i = 0; i < 16; ++i)
+            if (bx + i % 4 < image.width && by + i / 4 < image.height)
+                std::memcpy(image.at(bx + i % 4, by + i / 4), pixels[i], 4);
+    }
+
+    static void encodeBlock(BlockFormat format, const Pixels& pixels, uint8_t* out)
+    {
+        uint8_t channel[16];
+        switch (format)
+        {
+        case BLOCK_BC1:
+            encodeColor(pixels, out);
+            break;
+        case BLOCK_BC3:
+            for (int i = 0; i < 16; ++i)
+                channel[i] = pixels[i][3];
+            encodeChannel(channel, out);
+            encodeColor(pixels, out + 8);
+            break;
+        case BLOCK_BC4:
+        case BLOCK_BC5:
+            for (int c = 0; c < (format == BLOCK_BC4 ? 1 : 2); ++c)
+            {
+                for (int i = 0; i < 16; ++i)
+                    channel[i] = pixels[i][c];
+                encodeChannel(channel, out + 8 * c);
+            }
+            break;
+        default:
+            encodeMode6(pixels, out);
+            break;
+        }
+    }
+
+    static bool decodeBlock(BlockFormat format, const uint8_t* in, Pixels& pixels)
+    {
+        uint8_t channel[16];
+        switch (format)
+        {
+        case BLOCK_BC1:
+            decodeColor(in, pixels);
+            return true;
+        case BLOCK_BC3:
+            decodeColor(in + 8, pixels);
+            decodeChannel(in, channel);
+            for (int i = 0; i < 16; ++i)
+                pixels[i][3] = channel[i];
+            return true;
+        case BLOCK_BC4:
+        case BLOCK_BC5:
+            for (int i = 0; i < 16; ++i)
+            {
+                pixels[i][1] = pixels[i][2] = 0;
+                pixels[i][3] = 255;
+            }
+            for (int c = 0; c < (format == BLOCK_BC4 ? 1 : 2); ++c)
+            {
+                decodeChannel(in + 8 * c, channel);
+                for (int i = 0; i < 16; ++i)
+                    pixels[i][c] = channel[i];
+            }
+            return true;
+        default:
+            return decodeMode6(in, pixels);
+        }
+    }
+
+    // --- общее: главная ось точек блока -------------------------------------------------------------------
+
+    // средняя точка и главная ось (степенной метод по ковариации) для первых dims каналов
+    static void principalAxis(const Pixels& pixels, int dims, float mean[4], float axis[4])
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            mean[c] = 0.0f;
+            for (int i = 0; i < 16; ++i)
+                mean[c] += pixels[i][c];
+            mean[c] /= 16.0f;
+        }
+        float covariance[4][4] = {};
+        for (int i = 0; i < 16; ++i)
+            for (int a = 0; a < dims; ++a)
+                for (int b = 0; b < dims; ++b)
+                    covariance[a][b] += (pixels[i][a] - mean[a]) * (pixels[i][b] - mean[b]);
+        for (int c = 0; c < 4; ++c)
+            axis[c] = c < dims ? 1.0f : 0.0f;
+        for (int iteration = 0; iteration < 8; ++iteration)
+        {
+            float next[4] = {};
+            for (int a = 0; a < dims; ++a)
+                for (int b = 0; b < dims; ++b)
+                    next[a] += covariance[a][b] * axis[b];
+            float length = 0.0f;
+            for (int c = 0; c < dims; ++c)
+                length = std::max(length, std::fabs(next[c]));
+            if (length < 1e-6f)
+                break;
+            for (int c = 0; c < dims; ++c)
+                axis[c] = next[c] / length;
+        }
+    }
+
+    // концы проекции точек на ось
+    static void axisEndpoints(const Pixels& pixels, int dims, float high[4], float low[4])
+    {
+        float mean[4], axis[4];
+        principalAxis(pixels, dims, mean, axis);
+        float minT = 1e30f, maxT = -1e30f;
+        float norm = 0.0f;
+        for (int c = 0; c < dims; ++c)
+            norm += axis[c] * axis[c];
+        for (int i = 0; i < 16; ++i)
+        {
+            float t = 0.0f;
+            for (int c = 0; c < dims; ++c)
+                t += (pixels[i][c] - mean[c]) * axis[c];
+            t = norm > 0.0f ? t / norm : 0.0f;
+            minT = std::min(minT, t);
+            maxT = std::max(maxT, t);
+        }
+        for (int c = 0; c < 4; ++c)
+        {
+            high[c] = std::min(255.0f, std::max(0.0f, mean[c] + axis[c] * maxT));
+            low[c] = std::min(255.0f, std::max(0.0f, mean[c] + axis[c] * minT));
+        }
+    }
+
+    // конечные точки методом наименьших квадратов: точка i = (1 - w[i]) * e0 + w[i] * e1
+    static bool leastSquares(const Pixels& pixels, int dims, const float weights[16], float e0[4], float e1[4])
+    {
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+        float ax[4] = {}, bx[4] = {};
+        for (int i = 0; i < 16; ++i)
+        {
+            float b = weights[i], a = 1.0f - b;
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+            for (int c = 0; c < dims; ++c)
+            {
+                ax[c] += a * pixels[i][c];
+                bx[c] += b * pixels[i][c];
+            }
+        }
+        float det = aa * bb - ab * ab;
+        if (std::fabs(det) < 1e-6f)
+            return false;
+        for (int c = 0; c < dims; ++c)
+        {
+            e0[c] = std::min(255.0f, std::max(0.0f, (ax[c] * bb - bx[c] * ab) / det));
+            e1[c] = std::min(255.0f, std::max(0.0f, (bx[c] * aa - ax[c] * ab) / det));
+        }
+        return true;
+    }
+
+    // --- BC1: цвет ----------------------------------------------------------------------------------------
+
+    static uint16_t pack565(const float color[4])
+    {
+        int r = (int)std::lround(color[0] * 31.0f / 255.0f);
+        int g = (int)std::lround(color[1] * 63.0f / 255.0f);
+        int b = (int)std::lround(color[2] * 31.0f / 255.0f);
+        return (uint16_t)((r << 11) | (g << 5) | b);
+    }
+
+    static void unpack565(uint16_t value, int color[3])
+    {
+        int r = (value >> 11) & 31, g = (value >> 5) & 63, b = value & 31;
+        color[0] = (r << 3) | (r >> 2);
+        color[1] = (g << 2) | (g >> 4);
+        color[2] = (b << 3) | (b >> 2);
+    }
+
+    // палитра четырёхцветного режима
+    static void colorPalette(uint16_t c0, uint16_t c1, int palette[4][3])
+    {
+        unpack565(c0, palette[0]);
+        unpack565(c1, palette[1]);
+        for (int c = 0; c < 3; ++c)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+    }
+
+    // индексы ближайших цветов палитры; возвращает суммарную ошибку
+    static int colorIndices(const Pixels& pixels, uint16_t c0, uint16_t c1, uint8_t indices[16])
+    {
+        int palette[4][3];
+        colorPalette(c0, c1, palette);
+        int total = 0;
+        for (int i = 0; i < 16; ++i)
+        {
+            int best = 0, bestError = 1 << 30;
+            for (int p = 0; p < 4; ++p)
+            {
+                int error = 0;
+                for (int c = 0; c < 3; ++c)
+                    error += (pixels[i][c] - palette[p][c]) * (pixels[i][c] - palette[p][c]);
+                if (error < bestError)
+                {
+                    bestError = error;
+                    best = p;
+                }
+            }
+            indices[i] = (uint8_t)best;
+            total += bestError;
+        }
+        return total;
+    }
+
+    static void encodeColor(const Pixels& pixels, uint8_t* out)
+    {
+        float high[4], low[4];
+        axisEndpoints(pixels, 3, high, low);
+        uint16_t c0 = pack565(high), c1 = pack565(low);
+        uint8_t indices[16];
+        int error = colorIndices(pixels, c0, c1, indices);
+
+        // уточнение: вес второй точки для индексов 0, 1, 2, 3
+        static const float WEIGHTS[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+        float weights[16];
+        for (int i = 0; i < 16; ++i)
+            weights[i] = WEIGHTS[indices[i]];
+        float e0[4] = {}, e1[4] = {};
+        if (error > 0 && leastSquares(pixels, 3, weights, e0, e1))
+        {
+            uint16_t r0 = pack565(e0), r1 = pack565(e1);
+            uint8_t refined[16];
+            int refinedError = colorIndices(pixels, r0, r1, refined);
+            if (refinedError < error)
+            {
+                c0 = r0;
+                c1 = r1;
+                error = refinedError;
+                std::memcpy(indices, refined, 16);
+            }
+        }
+
+        // четырёхцветный режим требует c0 > c1
+        if (c0 < c1)
+        {
+            std::swap(c0, c1);
+            static const uint8_t SWAPPED[4] = { 1, 0, 3, 2 };
+            for (int i = 0; i < 16; ++i)
+                indices[i] = SWAPPED[indices[i]];
+        }
+        else if (c0 == c1)
+            std::memset(indices, 0, 16);
+
+        uint32_t bits = 0;
+        for (int i = 0; i < 16; ++i)
+            bits |= (uint32_t)indices[i] << (2 * i);
+        out[0] = (uint8_t)(c0 & 0xFF);
+        out[1] = (uint8_t)(c0 >> 8);
+        out[2] = (uint8_t)(c1 & 0xFF);
+        out[3] = (uint8_t)(c1 >> 8);
+        for (int b = 0; b < 4; ++b)
+            out[4 + b] = (uint8_t)(bits >> (8 * b));
+    }
+
+    static void decodeColor(const uint8_t* in, Pixels& pixels)
+    {
+        uint16_t c0 = (uint16_t)(in[0] | (in[1] << 8)), c1 = (uint16_t)(in[2] | (in[3] << 8));
+        uint32_t bits = in[4] | (in[5] << 8) | (in[6] << 16) | ((uint32_t)in[7] << 24);
+        int palette[4][3];
+        colorPalette(c0, c1, palette);
+        bool transparent = c0 <= c1;
+        if (transparent)
+            for (int c = 0; c < 3; ++c)
+            {
+                palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+                palette[3][c] = 0;
+            }
+        for (int i = 0; i < 16; ++i)
+        {
+            int index = (bits >> (2 * i)) & 3;
+            for (int c = 0; c < 3; ++c)
+                pixels[i][c] = (uint8_t)palette[index][c];
+            pixels[i][3] = transparent && index == 3 ? 0 : 255;
+        }
+    }
+
+    // --- BC4: один канал ----------------------------------------------------------------------------------
+
+    static void channelPalette(int a0, int a1, int palette[8])
+    {
+        palette[0] = a0;
+        palette[1] = a1;
+        if (a0 > a1)
+            for (int i = 2; i < 8; ++i)
+                palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+        else
+        {
+            for (int i = 2; i < 6; ++i)
+                palette[i] = ((6 - i) * a0 + (i - 1) * a1) / 5;
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+    }
+
+    static void encodeChannel(const uint8_t values[16], uint8_t* out)
+    {
+        int low = 255, high = 0;
+        for (int i = 0; i < 16; ++i)
+        {
+            low = std::min(low, (int)values[i]);
+            high = std::max(high, (int)values[i]);
+        }
+        // восьмиуровневый режим (a0 > a1); при равных концах все индексы 0
+        int palette[8];
+        channelPalette(high, low, palette);
+        uint64_t bits = 0;
+        for (int i = 0; i < 16 && high > low; ++i)
+        {
+            int best = 0, bestError = 1 << 30;
+            for (int p = 0; p < 8; ++p)
+            {
+                int error = std::abs(values[i] - palette[p]);
+                if (error < bestError)
+                {
+                    bestError = error;
+                    best = p;
+                }
+            }
+            bits |= (uint64_t)best << (3 * i);
+        }
+        out[0] = (uint8_t)high;
+        out[1] = (uint8_t)low;
+        for (int b = 0; b < 6; ++b)
+            out[2 + b] = (uint8_t)(bits >> (8 * b));
+    }
+
+    static void decodeChannel(const uint8_t* in, uint8_t values[16])
+    {
+        int palette[8];
+        channelPalette(in[0], in[1], palette);
+        uint64_t bits = 0;
+        for (int b = 0; b < 6; ++b)
+            bits |= (uint64_t)in[2 + b] << (8 * b);
+        for (int i = 0; i < 16; ++i)
+            values[i] = (uint8_t)palette[(bits >> (3 * i)) & 7];
+    }
+
+    // --- BC7, режим 6 -------------------------------------------------------------------------------------
+
+    // веса 4-битных индексов BC7 (из 64)
+    static const int* mode6Weights()
+    {
+        static const int WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+        return WEIGHTS;
+    }
+
+    // конечная точка 7.7.7.7 + общий p-бит: 8-битное значение канала — (q << 1) | p
+    static void quantizeMode6(const float endpoint[4], uint8_t q[4], int& pbit)
+    {
+        float bestError = 1e30f;
+        for (int p = 0; p < 2; ++p)
+        {
+            uint8_t candidate[4];
+            float error = 0.0f;
+            for (int c = 0; c < 4; ++c)
+            {
+                int v = (int)std::lround((endpoint[c] - p) / 2.0f);
+                candidate[c] = (uint8_t)std::min(127, std::max(0, v));
+                float d = (float)((candidate[c] << 1) | p) - endpoint[c];
+                error += d * d;
+            }
+            if (error < bestError)
+            {
+                bestError = error;
+                pbit = p;
+                std::memcpy(q, candidate, 4);
+            }
+        }
+    }
+
+    static int mode6Indices(const Pixels& pixels, const uint8_t q0[4], int p0, const uint8_t q1[4], int p1,
+                            uint8_t indices[16])
+    {
+        const int* weights = mode6Weights();
+        int palette[16][4];
+        for (int w = 0; w < 16; ++w)
+            for (int c = 0; c < 4; ++c)
+            {
+                int e0 = (q0[c] << 1) | p0, e1 = (q1[c] << 1) | p1;
+                palette[w][c] = ((64 - weights[w]) * e0 + weights[w] * e1 + 32) >> 6;
+            }
+        int total = 0;
+        for (int i = 0; i < 16; ++i)
+        {
+            int best = 0, bestError = 1 << 30;
+            for (int w = 0; w < 16; ++w)
+            {
+                int error = 0;
+                for (int c = 0; c < 4; ++c)
+                    error += (pixels[i][c] - palette[w][c]) * (pixels[i][c] - palette[w][c]);
+                if (error < bestError)
+                {
+                    bestError = error;
+                    best = w;
+                }
+            }
+            indices[i] = (uint8_t)best;
+            total += bestError;
+        }
+        return total;
+    }
+
+    static void encodeMode6(const Pixels& pixels, uint8_t* out)
+    {
+        float e0[4], e1[4];
+        axisEndpoints(pixels, 4, e0, e1);
+        uint8_t q0[4], q1[4], indices[16];
+        int p0 = 0, p1 = 0;
+        quantizeMode6(e0, q0, p0);
+        quantizeMode6(e1, q1, p1);
+        int error = mode6Indices(pixels, q0, p0, q1, p1, indices);
+
+        float weights[16];
+        for (int i = 0; i < 16; ++i)
+            weights[i] = mode6Weights()[indices[i]] / 64.0f;
+        float r0[4], r1[4];
+        if (error > 0 && leastSquares(pixels, 4, weights, r0, r1))
+        {
+            uint8_t s0[4], s1[4], refined[16];
+            int t0 = 0, t1 = 0;
+            quantizeMode6(r0, s0, t0);
+            quantizeMode6(r1, s1, t1);
+            int refinedError = mode6Indices(pixels, s0, t0, s1, t1, refined);
+            if (refinedError < error)
+            {
+                std::memcpy(q0, s0, 4);
+                std::memcpy(q1, s1, 4);
+                p0 = t0;
+                p1 = t1;
+                std::memcpy(indices, refined, 16);
+            }
+        }
+
+        // старший бит индекса пикселя 0 не хранится и должен быть нулём
+        if (indices[0] >= 8)
+        {
+            for (int c = 0; c < 4; ++c)
+                std::swap(q0[c], q1[c]);
+            std::swap(p0, p1);
+            for (int i = 0; i < 16; ++i)
+                indices[i] = (uint8_t)(15 - indices[i]);
+        }
+
+        BitWriter writer(out);
+        writer.write(1u << 6, 7); // режим 6: шесть нулей и единица
+        for (int c = 0; c < 4; ++c)
+        {
+            writer.write(q0[c], 7);
+            writer.write(q1[c], 7);
+        }
+        writer.write((uint32_t)p0, 1);
+        writer.write((uint32_t)p1, 1);
+        for (int i = 0; i < 16; ++i)
+            writer.write(indices[i], i == 0 ? 3 : 4);
+    }
+
+    static bool decodeMode6(const uint8_t* in, Pixels& pixels)
+    {
+        BitReader reader(in);
+        if (reader.read(7) != (1u << 6))
+        {
+            std::memset(pixels, 0, sizeof(Pixels));
+            return false;
+        }
+        int e0[4], e1[4];
+        for (int c = 0; c < 4; ++c)
+        {
+            e0[c] = (int)reader.read(7) << 1;
+            e1[c] = (int)reader.read(7) << 1;
+        }
+        int p0 = (int)reader.read(1), p1 = (int)reader.read(1);
+        for (int c = 0; c < 4; ++c)
+        {
+            e0[c] |= p0;
+            e1[c] |= p1;
+        }
+        const int* weights = mode6Weights();
+        for (int i = 0; i < 16; ++i)
+        {
+            int w = weights[reader.read(i == 0 ? 3 : 4)];
+            for (int c = 0; c < 4; ++c)
+                pixels[i][c] = (uint8_t)(((64 - w) * e0[c] + w * e1[c] + 32) >> 6);
+        }
+        return true;
+    }
+
+    // поток битов блока BC7, младшие биты первыми
+    struct BitWriter
+    {
+        uint8_t* out;
+        int position = 0;
+        explicit BitWriter(uint8_t* block) : out(block) { std::memset(out, 0, 16); }
+        void write(uint32_t value, int bits)
+        {
+            for (int b = 0; b < bits; ++b, ++position)
+                out[position >> 3] |= (uint8_t)(((value >> b) & 1u) << (position & 7));
+        }
+    };
+
+    struct BitReader
+    {
+        const uint8_t* in;
+        int position = 0;
+        explicit BitReader(const uint8_t* block) : in(block) {}
+        uint32_t read(int bits)
+        {
+            uint32_t value = 0;
+            for (int b = 0; b < bits; ++b, ++position)
+                value |= (uint32_t)((in[position >> 3] >> (position & 7)) & 1u) << b;
+            return value;
+        }
+    };
+};
+
+#endif
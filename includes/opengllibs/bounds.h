@@ -0,0 +1,174 @@
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+// Выровненный по осям ограничивающий параллелепипед (AABB) в мировых координатах
+struct AABB
+{
+    glm::vec3 min = glm::vec3(0.0f);
+    glm::vec3 max = glm::vec3(0.0f);
+
+    glm::vec3 center() const { return (min + max) * 0.5f; }
+    glm::vec3 extents() const { return (max - min) * 0.5f; }
+
+    // преобразовать AABB матрицей модели; результат — AABB, охватывающий преобразованный параллелепипед
+    AABB transformed(const glm::mat4& m) const
+    {
+        glm::vec3 c = glm::vec3(m * glm::vec4(center(), 1.0f));
+        glm::vec3 e = extents();
+        // |M| * e даёт полуразмеры охватывающего AABB (метод Арво)
+        glm::vec3 r(0.0f);
+        for (int i = 0; i < 3; ++i)
+            r += glm::abs(glm::vec3(m[i])) * e[i];
+        AABB result;
+        result.min = c - r;
+        result.max = c + r;
+        return result;
+    }
+
+    // квадрат расстояния от точки до параллелепипеда (0, если точка внутри)
+    float distanceSquared(const glm::vec3& p) const
+    {
+        glm::vec3 d = glm::max(glm::max(min - p, p - max), glm::vec3(0.0f));
+        return glm::dot(d, d);
+    }
+
+    // пересечение луча origin + t * direction с параллелепипедом (метод плит): [tNear, tFar] — отрезок луча
+    // внутри него; false, если луч проходит мимо. Для точки начала внутри tNear < 0, а выход — tFar
+    bool intersectRay(const glm::vec3& origin, const glm::vec3& direction, float& tNear, float& tFar) const
+    {
+        tNear = -INFINITY;
+        tFar = INFINITY;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            if (direction[axis] == 0.0f)
+            {
+                if (origin[axis] < min[axis] || origin[axis] > max[axis])
+                    return false;
+                continue;
+            }
+            float t0 = (min[axis] - origin[axis]) / direction[axis];
+            float t1 = (max[axis] - origin[axis]) / direction[axis];
+            tNear = std::max(tNear, std::min(t0, t1));
+            tFar = std::min(tFar, std::max(t0, t1));
+        }
+        return tNear <= tFar;
+    }
+};
+
+// Пирамида видимости камеры: шесть плоскостей (a, b, c, d) с нормалями внутрь, извлечённые из матрицы
+// projection * view (метод Грибба — Хартманна). Точка p внутри, если dot(n, p) + d >= 0 для всех плоскостей.
+struct Frustum
+{
+    enum Result
+    {
+        OUTSIDE,
+        INTERSECTS,
+        INSIDE
+    };
+
+    glm::vec4 planes[6];
+
+    static Frustum fromMatrix(const glm::mat4& viewProjection)
+    {
+        // строки матрицы (glm хранит столбцы)
+        glm::vec4 rows[4];
+        for (int i = 0; i < 4; ++i)
+            rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+        Frustum frustum;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            frustum.planes[axis * 2] = rows[3] + rows[axis];     // левая, нижняя, ближняя
+            frustum.planes[axis * 2 + 1] = rows[3] - rows[axis]; // правая, верхняя, дальняя
+        }
+        for (glm::vec4& plane : frustum.planes)
+            plane /= glm::length(glm::vec3(plane));
+        return frustum;
+    }
+
+    // положение AABB относительно пирамиды: для каждой плоскости сравниваются расстояние до центра
+    // и проекция полуразмеров на нормаль (ближайшая и дальняя вершины)
+    Result classify(const AABB& box) const
+    {
+        glm::vec3 c = box.center();
+        glm::vec3 e = box.extents();
+        Result result = INSIDE;
+        for (const glm::vec4& plane : planes)
+        {
+            glm::vec3 n(plane);
+            float distance = glm::dot(n, c) + plane.w;
+            float radius = glm::dot(glm::abs(n), e);
+            if (distance + radius < 0.0f)
+                return OUTSIDE;
+            if (distance - radius < 0.0f)
+                result = INTERSECTS;
+        }
+        return result;
+    }
+};
+
+// Порядок граней кубической карты совпадает с GL_TEXTURE_CUBE_MAP_POSITIVE_X + i:
+// +X, -X, +Y, -Y, +Z, -Z
+const unsigned int CUBE_FACE_ALL = 0x3F;
+
+// Направление кубической карты для координат (s, t) в [-1, 1] грани face
+// (обращение таблицы выбора грани из спецификации OpenGL; у результата наибольшая по модулю координата равна 1)
+inline glm::vec3 cubeFaceDirection(int face, const glm::vec2& st)
+{
+    switch (face)
+    {
+    case 0: return glm::vec3(1.0f, -st.y, -st.x);
+    case 1: return glm::vec3(-1.0f, -st.y, st.x);
+    case 2: return glm::vec3(st.x, 1.0f, st.y);
+    case 3: return glm::vec3(st.x, -1.0f, -st.y);
+    case 4: return glm::vec3(st.x, -st.y, 1.0f);
+    default: return glm::vec3(-st.x, -st.y, -1.0f);
+    }
+}
+
+// Маска граней кубической карты теней, в пирамиды видимости которых попадает AABB.
+// Пирамида грани с осью a и знаком s — это точки p (относительно света), для которых
+// s*p[a] >= |p[b]| и s*p[a] >= |p[c]|, т.е. четыре плоскости через позицию света с нормалями вида
+// (s, ±1, 0) по осям (a, b). Для каждой плоскости берётся "положительная" вершина AABB: если даже она
+// снаружи, снаружи и весь параллелепипед. Дополнительно отбрасываются объекты дальше far_plane.
+inline unsigned int cubeFaceMask(const AABB& box, const glm::vec3& lightPos, float farPlane)
+{
+    if (box.distanceSquared(lightPos) > farPlane * farPlane)
+        return 0;
+    glm::vec3 lo = box.min - lightPos;
+    glm::vec3 hi = box.max - lightPos;
+    unsigned int mask = 0;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        int b = (axis + 1) % 3;
+        int c = (axis + 2) % 3;
+        for (int sign = 0; sign < 2; ++sign)
+        {
+            // максимум s*p[a] по AABB
+            float major = sign == 0 ? hi[axis] : -lo[axis];
+            // для плоскостей s*p[a] - p[b] >= 0 и s*p[a] + p[b] >= 0 максимум достигается на разных вершинах,
+            // но по независимым осям: max(s*p[a]) - min(p[b]) и max(s*p[a]) + max(p[b])
+            if (major - lo[b] < 0.0f || major + hi[b] < 0.0f)
+                continue;
+            if (major - lo[c] < 0.0f || major + hi[c] < 0.0f)
+                continue;
+            mask |= 1u << (axis * 2 + sign);
+        }
+    }
+    return mask;
+}
+
+// число установленных бит в маске граней
+inline int faceCount(unsigned int mask)
+{
+    int count = 0;
+    for (; mask != 0; mask &= mask - 1)
+        ++count;
+    return count;
+}
+
+#endif
@@ -0,0 +1,145 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <glm/glm.hpp>
+
+#include <opengllibs/bounds.h>
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+// Иерархия ограничивающих объёмов (BVH) над AABB объектов сцены для отсечения пирамидой видимости камеры.
+// Строится делением по медиане центров вдоль самой длинной оси узла; объекты каждого поддерева лежат
+// непрерывным диапазоном в order, поэтому поддерево целиком внутри пирамиды добавляется без проверок.
+// Движение объектов — update() и refit(): границы узлов пересчитываются снизу вверх, дерево не перестраивается.
+class BoundsBVH
+{
+public:
+    static const unsigned int LEAF_SIZE = 4;
+
+    void build(const std::vector<AABB>& bounds)
+    {
+        objectBounds = bounds;
+        order.resize(bounds.size());
+        std::iota(order.begin(), order.end(), 0u);
+        nodes.clear();
+        if (bounds.empty())
+            return;
+        nodes.emplace_back();
+        buildNode(0, 0, (unsigned int)bounds.size());
+    }
+
+    // новые границы объекта; узлы обновляет refit()
+    void update(unsigned int object, const AABB& box)
+    {
+        objectBounds[object] = box;
+    }
+
+    void refit()
+    {
+        // дети всегда создаются после родителя, поэтому обратный порядок — снизу вверх
+        for (size_t n = nodes.size(); n-- > 0;)
+        {
+            Node& node = nodes[n];
+            if (node.left == 0)
+                node.box = rangeBounds(node.first, node.count);
+            else
+                node.box = merge(nodes[node.left].box, nodes[node.left + 1].box);
+        }
+    }
+
+    // индексы объектов, пересекающих пирамиду (порядок — по дереву); возвращает число проверенных узлов
+    int cull(const Frustum& frustum, std::vector<unsigned int>& visible) const
+    {
+        visible.clear();
+        if (nodes.empty())
+            return 0;
+        int tested = 0;
+        unsigned int stack[64];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0)
+        {
+            const Node& node = nodes[stack[--top]];
+            ++tested;
+            Frustum::Result result = frustum.classify(node.box);
+            if (result == Frustum::OUTSIDE)
+                continue;
+            if (result == Frustum::INSIDE)
+            {
+                visible.insert(visible.end(), order.begin() + node.first, order.begin() + node.first + node.count);
+                continue;
+            }
+            if (node.left != 0)
+            {
+                stack[top++] = node.left + 1;
+                stack[top++] = node.left;
+                continue;
+            }
+            // лист на границе пирамиды: каждый объект отдельно
+            for (unsigned int i = node.first; i < node.first + node.count; ++i)
+                if (frustum.classify(objectBounds[order[i]]) != Frustum::OUTSIDE)
+                    visible.push_back(order[i]);
+        }
+        return tested;
+    }
+
+    size_t nodeCount() const { return nodes.size(); }
+
+private:
+    struct Node
+    {
+        AABB box;
+        unsigned int first = 0; // диапазон объектов поддерева в order
+        unsigned int count = 0;
+        unsigned int left = 0;  // индекс левого ребёнка (правый — left + 1); 0 — лист
+    };
+
+    std::vector<AABB> objectBounds;
+    std::vector<unsigned int> order;
+    std::vector<Node> nodes;
+
+    static AABB merge(const AABB& a, const AABB& b)
+    {
+        AABB result;
+        result.min = glm::min(a.min, b.min);
+        result.max = glm::max(a.max, b.max);
+        return result;
+    }
+
+    AABB rangeBounds(unsigned int first, unsigned int count) const
+    {
+        AABB box = objectBounds[order[first]];
+        for (unsigned int i = first + 1; i < first + count; ++i)
+            box = merge(box, objectBounds[order[i]]);
+        return box;
+    }
+
+    // заполнить узел index над order[first, first + count) и, если объектов больше LEAF_SIZE, построить детей.
+    // Дети создаются парой подряд (правый — left + 1), затем строятся их поддеревья. Глубина дерева
+    // ~log2(n / LEAF_SIZE), что для стека обхода в 64 элемента с запасом
+    void buildNode(unsigned int index, unsigned int first, unsigned int count)
+    {
+        nodes[index].box = rangeBounds(first, count);
+        nodes[index].first = first;
+        nodes[index].count = count;
+        if (count <= LEAF_SIZE)
+            return;
+        glm::vec3 size = nodes[index].box.max - nodes[index].box.min;
+        int axis = size.x > size.y ? (size.x > size.z ? 0 : 2) : (size.y > size.z ? 1 : 2);
+        unsigned int half = count / 2;
+        std::nth_element(order.begin() + first, order.begin() + first + half, order.begin() + first + count,
+                         [this, axis](unsigned int a, unsigned int b) {
+                             return objectBounds[a].center()[axis] < objectBounds[b].center()[axis];
+                         });
+        unsigned int left = (unsigned int)nodes.size();
+        nodes.emplace_back();
+        nodes.emplace_back();
+        nodes[index].left = left;
+        buildNode(left, first, half);
+        buildNode(left + 1, first + half, count - half);
+    }
+};
+
+#endif
@@ -0,0 +1,192 @@
+#ifndef CASTER_CULL_H
+#define CASTER_CULL_H
+
+#include <glm/glm.hpp>
+
+#include <opengllibs/bounds.h>
+
+#include <algorithm>
+#include <vector>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define CASTER_CULL_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CASTER_CULL_SSE
+#endif
+
+// Отсечение объектов, отбрасывающих тень, для одного точечного источника: за один проход по всем объектам
+// проверяется сфера far_plane и шесть пирамид видимости граней кубической карты (тот же тест, что cubeFaceMask).
+// Границы хранятся структурой массивов (SoA: minX[], minY[], ... maxZ[]), поэтому тест идёт сразу по 8 (AVX)
+// или 4 (SSE2) объектам; без SSE2 — скалярный cubeFaceMask. Результат — маска граней каждого объекта.
+class CasterCuller
+{
+public:
+#if defined(CASTER_CULL_AVX)
+    static const int LANES = 8;
+#elif defined(CASTER_CULL_SSE)
+    static const int LANES = 4;
+#else
+    static const int LANES = 1;
+#endif
+
+    static const char* instructionSet()
+    {
+#if defined(CASTER_CULL_AVX)
+        return "avx";
+#elif defined(CASTER_CULL_SSE)
+        return "sse2";
+#else
+        return "scalar";
+#endif
+    }
+
+    // количество объектов; границы новых объектов задаёт setBounds
+    void resize(size_t count)
+    {
+        objectCount = count;
+        // хвост до кратного LANES заполнен далёкими точками: их расстояние до источника больше любого far_plane
+        size_t padded = (count + LANES - 1) / LANES * LANES;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            mins[axis].resize(padded);
+            maxs[axis].resize(padded);
+            std::fill(mins[axis].begin() + count, mins[axis].end(), FAR_AWAY);
+            std::fill(maxs[axis].begin() + count, maxs[axis].end(), FAR_AWAY);
+        }
+        masks.resize(padded, 0);
+    }
+
+    size_t size() const { return objectCount; }
+
+    void setBounds(size_t index, const AABB& box)
+    {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            mins[axis][index] = box.min[axis];
+            maxs[axis][index] = box.max[axis];
+        }
+    }
+
+    // маски граней всех объектов для источника в lightPos с дальностью farPlane;
+    // вектор может быть длиннее size(), хвост — нули
+    const std::vector<unsigned int>& cull(const glm::vec3& lightPos, float farPlane)
+    {
+#if defined(CASTER_CULL_AVX)
+        cullAVX(lightPos, farPlane);
+#elif defined(CASTER_CULL_SSE)
+        cullSSE(lightPos, farPlane);
+#else
+        for (size_t i = 0; i < objectCount; ++i)
+        {
+            AABB box;
+            box.min = glm::vec3(mins[0][i], mins[1][i], mins[2][i]);
+            box.max = glm::vec3(maxs[0][i], maxs[1][i], maxs[2][i]);
+            masks[i] = cubeFaceMask(box, lightPos, farPlane);
+        }
+#endif
+        return masks;
+    }
+
+private:
+    static constexpr float FAR_AWAY = 1.0e18f;
+
+    std::vector<float> mins[3];
+    std::vector<float> maxs[3];
+    std::vector<unsigned int> masks;
+    size_t objectCount = 0;
+
+#if defined(CASTER_CULL_AVX)
+    // объекты в пирамиде грани: major — максимум s*p[a] по AABB, (lo, hi) двух других осей (см. cubeFaceMask)
+    static __m256 faceAVX(__m256 major, __m256 loB, __m256 hiB, __m256 loC, __m256 hiC)
+    {
+        const __m256 zero = _mm256_setzero_ps();
+        __m256 inside = _mm256_and_ps(_mm256_cmp_ps(_mm256_sub_ps(major, loB), zero, _CMP_GE_OQ),
+                                      _mm256_cmp_ps(_mm256_add_ps(major, hiB), zero, _CMP_GE_OQ));
+        inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_sub_ps(major, loC), zero, _CMP_GE_OQ));
+        return _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(major, hiC), zero, _CMP_GE_OQ));
+    }
+
+    void cullAVX(const glm::vec3& lightPos, float farPlane)
+    {
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 farSquared = _mm256_set1_ps(farPlane * farPlane);
+        __m256 light[3], bits[6];
+        for (int axis = 0; axis < 3; ++axis)
+            light[axis] = _mm256_set1_ps(lightPos[axis]);
+        for (int face = 0; face < 6; ++face)
+            bits[face] = _mm256_castsi256_ps(_mm256_set1_epi32(1 << face));
+
+        for (size_t i = 0; i < masks.size(); i += 8)
+        {
+            // границы относительно источника и квадрат расстояния от источника до AABB
+            __m256 lo[3], hi[3];
+            __m256 distance = zero;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                lo[axis] = _mm256_sub_ps(_mm256_loadu_ps(&mins[axis][i]), light[axis]);
+                hi[axis] = _mm256_sub_ps(_mm256_loadu_ps(&maxs[axis][i]), light[axis]);
+                __m256 d = _mm256_max_ps(_mm256_max_ps(lo[axis], _mm256_sub_ps(zero, hi[axis])), zero);
+                distance = _mm256_add_ps(distance, _mm256_mul_ps(d, d));
+            }
+            __m256 inRange = _mm256_cmp_ps(distance, farSquared, _CMP_LE_OQ);
+
+            // грани +X, -X, +Y, -Y, +Z, -Z; оси развёрнуты явно, чтобы lo/hi оставались в регистрах
+            __m256 mask = _mm256_and_ps(faceAVX(hi[0], lo[1], hi[1], lo[2], hi[2]), bits[0]);
+            mask = _mm256_or_ps(mask, _mm256_and_ps(faceAVX(_mm256_sub_ps(zero, lo[0]), lo[1], hi[1], lo[2], hi[2]), bits[1]));
+            mask = _mm256_or_ps(mask, _mm256_and_ps(faceAVX(hi[1], lo[2], hi[2], lo[0], hi[0]), bits[2]));
+            mask = _mm256_or_ps(mask, _mm256_and_ps(faceAVX(_mm256_sub_ps(zero, lo[1]), lo[2], hi[2], lo[0], hi[0]), bits[3]));
+            mask = _mm256_or_ps(mask, _mm256_and_ps(faceAVX(hi[2], lo[0], hi[0], lo[1], hi[1]), bits[4]));
+            mask = _mm256_or_ps(mask, _mm256_and_ps(faceAVX(_mm256_sub_ps(zero, lo[2]), lo[0], hi[0], lo[1], hi[1]), bits[5]));
+            _mm256_storeu_ps(reinterpret_cast<float*>(&masks[i]), _mm256_and_ps(mask, inRange));
+        }
+    }
+#elif defined(CASTER_CULL_SSE)
+    // объекты в пирамиде грани: major — максимум s*p[a] по AABB, (lo, hi) двух других осей (см. cubeFaceMask)
+    static __m128 faceSSE(__m128 major, __m128 loB, __m128 hiB, __m128 loC, __m128 hiC)
+    {
+        const __m128 zero = _mm_setzero_ps();
+        __m128 inside = _mm_and_ps(_mm_cmpge_ps(_mm_sub_ps(major, loB), zero), _mm_cmpge_ps(_mm_add_ps(major, hiB), zero));
+        inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_sub_ps(major, loC), zero));
+        return _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(major, hiC), zero));
+    }
+
+    void cullSSE(const glm::vec3& lightPos, float farPlane)
+    {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 farSquared = _mm_set1_ps(farPlane * farPlane);
+        __m128 light[3], bits[6];
+        for (int axis = 0; axis < 3; ++axis)
+            light[axis] = _mm_set1_ps(lightPos[axis]);
+        for (int face = 0; face < 6; ++face)
+            bits[face] = _mm_castsi128_ps(_mm_set1_epi32(1 << face));
+
+        for (size_t i = 0; i < masks.size(); i += 4)
+        {
+            // границы относительно источника и квадрат расстояния от источника до AABB
+            __m128 lo[3], hi[3];
+            __m128 distance = zero;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                lo[axis] = _mm_sub_ps(_mm_loadu_ps(&mins[axis][i]), light[axis]);
+                hi[axis] = _mm_sub_ps(_mm_loadu_ps(&maxs[axis][i]), light[axis]);
+                __m128 d = _mm_max_ps(_mm_max_ps(lo[axis], _mm_sub_ps(zero, hi[axis])), zero);
+                distance = _mm_add_ps(distance, _mm_mul_ps(d, d));
+            }
+            __m128 inRange = _mm_cmple_ps(distance, farSquared);
+
+            // грани +X, -X, +Y, -Y, +Z, -Z; оси развёрнуты явно, чтобы lo/hi оставались в регистрах
+            __m128 mask = _mm_and_ps(faceSSE(hi[0], lo[1], hi[1], lo[2], hi[2]), bits[0]);
+            mask = _mm_or_ps(mask, _mm_and_ps(faceSSE(_mm_sub_ps(zero, lo[0]), lo[1], hi[1], lo[2], hi[2]), bits[1]));
+            mask = _mm_or_ps(mask, _mm_and_ps(faceSSE(hi[1], lo[2], hi[2], lo[0], hi[0]), bits[2]));
+            mask = _mm_or_ps(mask, _mm_and_ps(faceSSE(_mm_sub_ps(zero, lo[1]), lo[2], hi[2], lo[0], hi[0]), bits[3]));
+            mask = _mm_or_ps(mask, _mm_and_ps(faceSSE(hi[2], lo[0], hi[0], lo[1], hi[1]), bits[4]));
+            mask = _mm_or_ps(mask, _mm_and_ps(faceSSE(_mm_sub_ps(zero, lo[2]), lo[0], hi[0], lo[1], hi[1]), bits[5]));
+            _mm_storeu_ps(reinterpret_cast<float*>(&masks[i]), _mm_and_ps(mask, inRange));
+        }
+    }
+#endif
+};
+
+#endif
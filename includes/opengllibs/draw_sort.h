@@ -0,0 +1,41 @@
+#ifndef DRAW_SORT_H
+#define DRAW_SORT_H
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// 64-битный ключ сортировки отрисовки: старшие биты — самое дорогое переключение состояния.
+//  63..56 программа, 55..44 материал (текстуры и состояние растеризации), 43..32 VAO,
+//  31..0  расстояние до камеры (биты неотрицательного float упорядочены так же, как значения).
+// После сортировки по возрастанию объекты с одинаковым состоянием идут подряд, внутри — спереди назад,
+// поэтому ранний тест глубины отбрасывает перекрытые фрагменты.
+typedef uint64_t DrawKey;
+
+const DrawKey DRAW_KEY_STATE_MASK = 0xFFFFFFFF00000000ull;
+
+inline DrawKey makeDrawKey(unsigned int program, unsigned int material, unsigned int vao, float depth)
+{
+    if (!(depth > 0.0f))
+        depth = 0.0f;
+    uint32_t depthBits;
+    std::memcpy(&depthBits, &depth, sizeof(depthBits));
+    return ((DrawKey)(program & 0xFF) << 56) | ((DrawKey)(material & 0xFFF) << 44) | ((DrawKey)(vao & 0xFFF) << 32) | depthBits;
+}
+
+inline unsigned int drawKeyMaterial(DrawKey key)
+{
+    return (unsigned int)(key >> 44) & 0xFFF;
+}
+
+// количество переключений состояния при отрисовке в порядке keys (первая установка состояния тоже считается)
+inline int countStateChanges(const std::vector<DrawKey>& keys)
+{
+    int changes = 0;
+    for (size_t i = 0; i < keys.size(); ++i)
+        if (i == 0 || ((keys[i] ^ keys[i - 1]) & DRAW_KEY_STATE_MASK) != 0)
+            ++changes;
+    return changes;
+}
+
+#endif
@@ -0,0 +1,515 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Кэш состояния OpenGL. install() подменяет указатели функций GLAD (как GLCallCounter) обёртками, которые
+// помнят последнее установленное значение и не передают драйверу вызов, ничего не меняющий: программу, VAO,
+// активный текстурный блок и текстуры по блокам и целям, кадровые буферы чтения и записи, viewport,
+// glEnable/glDisable, функцию и маску глубины, отсекаемую грань и значения униформ (по программе и location).
+// Пока значение не установлено через обёртку, оно считается неизвестным и первый вызов всегда передаётся.
+// Удаление объектов и перелинковка программ сбрасывают связанные с ними записи. Ставится после
+// GLCallCounter: тогда счётчик вызовов видит только переданные драйверу вызовы.
+class GLStateCache
+{
+public:
+    static GLStateCache& get()
+    {
+        static GLStateCache instance;
+        return instance;
+    }
+
+    void install()
+    {
+        if (installed)
+            return;
+        installed = true;
+        GLint units = 0;
+        glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &units);
+        textureUnits = units > 0 ? units : 16;
+        invalidate();
+
+        replace(glad_glUseProgram, gl.useProgram, &useProgram);
+        replace(glad_glBindVertexArray, gl.bindVertexArray, &bindVertexArray);
+        replace(glad_glActiveTexture, gl.activeTexture, &activeTexture);
+        replace(glad_glBindTexture, gl.bindTexture, &bindTexture);
+        replace(glad_glBindFramebuffer, gl.bindFramebuffer, &bindFramebuffer);
+        replace(glad_glViewport, gl.viewport, &viewport);
+        replace(glad_glEnable, gl.enable, &enable);
+        replace(glad_glDisable, gl.disable, &disable);
+        replace(glad_glDepthFunc, gl.depthFunc, &depthFunc);
+        replace(glad_glDepthMask, gl.depthMask, &depthMask);
+        replace(glad_glCullFace, gl.cullFace, &cullFace);
+        replace(glad_glUniform1i, gl.uniform1i, &uniform1i);
+        replace(glad_glUniform1f, gl.uniform1f, &uniform1f);
+        replace(glad_glUniform2f, gl.uniform2f, &uniform2f);
+        replace(glad_glUniform2fv, gl.uniform2fv, &uniform2fv);
+        replace(glad_glUniform3f, gl.uniform3f, &uniform3f);
+        replace(glad_glUniform3fv, gl.uniform3fv, &uniform3fv);
+        replace(glad_glUniform4f, gl.uniform4f, &uniform4f);
+        replace(glad_glUniform4fv, gl.uniform4fv, &uniform4fv);
+        replace(glad_glUniformMatrix2fv, gl.uniformMatrix2fv, &uniformMatrix2fv);
+        replace(glad_glUniformMatrix3fv, gl.uniformMatrix3fv, &uniformMatrix3fv);
+        replace(glad_glUniformMatrix4fv, gl.uniformMatrix4fv, &uniformMatrix4fv);
+        // функции, после которых записи кэша устаревают
+        replace(glad_glDeleteProgram, gl.deleteProgram, &deleteProgram);
+        replace(glad_glLinkProgram, gl.linkProgram, &linkProgram);
+        replace(glad_glProgramBinary, gl.programBinary, &programBinary);
+        replace(glad_glDeleteTextures, gl.deleteTextures, &deleteTextures);
+        replace(glad_glDeleteVertexArrays, gl.deleteVertexArrays, &deleteVertexArrays);
+        replace(glad_glDeleteFramebuffers, gl.deleteFramebuffers, &deleteFramebuffers);
+    }
+
+    bool active() const { return installed; }
+
+    // забыть всё состояние (например, после кода, вызывающего OpenGL в обход GLAD)
+    void invalidate()
+    {
+        program = UNKNOWN;
+        vertexArray = UNKNOWN;
+        activeUnit = UNKNOWN;
+        textures.assign((size_t)textureUnits * TEXTURE_TARGET_COUNT, UNKNOWN);
+        drawFramebuffer = UNKNOWN;
+        readFramebuffer = UNKNOWN;
+        viewportValid = false;
+        capabilities.clear();
+        depthFuncValue = UNKNOWN;
+        depthMaskValue = UNKNOWN;
+        cullFaceValue = UNKNOWN;
+        uniforms.clear();
+    }
+
+    // обнулить счётчики (например, в начале кадра)
+    void reset()
+    {
+        for (int f = 0; f < FUNCTION_COUNT; ++f)
+            issuedCalls[f] = elidedCalls[f] = 0;
+    }
+
+    // вызовы с последнего reset(): переданные драйверу и отброшенные как повторные
+    unsigned long long issued() const { return sum(issuedCalls, ""); }
+    unsigned long long elided() const { return sum(elidedCalls, ""); }
+    // то же для функций, имя которых начинается с prefix (например, "glUniform")
+    unsigned long long issued(const std::string& prefix) const { return sum(issuedCalls, prefix); }
+    unsigned long long elided(const std::string& prefix) const { return sum(elidedCalls, prefix); }
+
+    // (переданные, отброшенные) по именам функций
+    std::vector<std::pair<std::string, std::pair<unsigned long long, unsigned long long>>> perFunction() const
+    {
+        std::vector<std::pair<std::string, std::pair<unsigned long long, unsigned long long>>> result;
+        for (int f = 0; f < FUNCTION_COUNT; ++f)
+            result.push_back({ functionNames[f], { issuedCalls[f], elidedCalls[f] } });
+        return result;
+    }
+
+private:
+    static constexpr GLuint UNKNOWN = 0xFFFFFFFFu;
+
+    enum Function
+    {
+        USE_PROGRAM, BIND_VERTEX_ARRAY, ACTIVE_TEXTURE, BIND_TEXTURE, BIND_FRAMEBUFFER, VIEWPORT, ENABLE, DISABLE,
+        DEPTH_FUNC, DEPTH_MASK, CULL_FACE, UNIFORM_1I, UNIFORM_1F, UNIFORM_2F, UNIFORM_2FV, UNIFORM_3F, UNIFORM_3FV,
+        UNIFORM_4F, UNIFORM_4FV, UNIFORM_MATRIX_2FV, UNIFORM_MATRIX_3FV, UNIFORM_MATRIX_4FV,
+        FUNCTION_COUNT
+    };
+    const char* const functionNames[FUNCTION_COUNT] = {
+        "glUseProgram", "glBindVertexArray", "glActiveTexture", "glBindTexture", "glBindFramebuffer", "glViewport",
+        "glEnable", "glDisable", "glDepthFunc", "glDepthMask", "glCullFace", "glUniform1i", "glUniform1f",
+        "glUniform2f", "glUniform2fv", "glUniform3f", "glUniform3fv", "glUniform4f", "glUniform4fv",
+        "glUniformMatrix2fv", "glUniformMatrix3fv", "glUniformMatrix4fv"
+    };
+
+    // цели текстур, привязки которых отслеживаются; остальные передаются без проверки
+    enum TextureTarget
+    {
+        TARGET_2D, TARGET_2D_ARRAY, TARGET_CUBE_MAP, TARGET_CUBE_MAP_ARRAY, TARGET_3D, TARGET_BUFFER,
+        TEXTURE_TARGET_COUNT
+    };
+
+    // значение униформы одного location: функция установки и байты значения (матрица 4x4 — самое длинное)
+    struct UniformValue
+    {
+        Function setter;
+        unsigned char size;
+        unsigned char bytes[16 * sizeof(GLfloat)];
+    };
+
+    // исходные функции GLAD
+    struct
+    {
+        PFNGLUSEPROGRAMPROC useProgram;
+        PFNGLBINDVERTEXARRAYPROC bindVertexArray;
+        PFNGLACTIVETEXTUREPROC activeTexture;
+        PFNGLBINDTEXTUREPROC bindTexture;
+        PFNGLBINDFRAMEBUFFERPROC bindFramebuffer;
+        PFNGLVIEWPORTPROC viewport;
+        PFNGLENABLEPROC enable;
+        PFNGLDISABLEPROC disable;
+        PFNGLDEPTHFUNCPROC depthFunc;
+        PFNGLDEPTHMASKPROC depthMask;
+        PFNGLCULLFACEPROC cullFace;
+        PFNGLUNIFORM1IPROC uniform1i;
+        PFNGLUNIFORM1FPROC uniform1f;
+        PFNGLUNIFORM2FPROC uniform2f;
+        PFNGLUNIFORM2FVPROC uniform2fv;
+        PFNGLUNIFORM3FPROC uniform3f;
+        PFNGLUNIFORM3FVPROC uniform3fv;
+        PFNGLUNIFORM4FPROC uniform4f;
+        PFNGLUNIFORM4FVPROC uniform4fv;
+        PFNGLUNIFORMMATRIX2FVPROC uniformMatrix2fv;
+        PFNGLUNIFORMMATRIX3FVPROC uniformMatrix3fv;
+        PFNGLUNIFORMMATRIX4FVPROC uniformMatrix4fv;
+        PFNGLDELETEPROGRAMPROC deleteProgram;
+        PFNGLLINKPROGRAMPROC linkProgram;
+        PFNGLPROGRAMBINARYPROC programBinary;
+        PFNGLDELETETEXTURESPROC deleteTextures;
+        PFNGLDELETEVERTEXARRAYSPROC deleteVertexArrays;
+        PFNGLDELETEFRAMEBUFFERSPROC deleteFramebuffers;
+    } gl = {};
+
+    bool installed = false;
+    int textureUnits = 0;
+    GLuint program = UNKNOWN;
+    GLuint vertexArray = UNKNOWN;
+    GLuint activeUnit = UNKNOWN; // номер блока, не GL_TEXTURE0 + номер
+    std::vector<GLuint> textures; // [блок * TEXTURE_TARGET_COUNT + цель]
+    GLuint drawFramebuffer = UNKNOWN, readFramebuffer = UNKNOWN;
+    bool viewportValid = false;
+    GLint viewportValue[4] = { 0, 0, 0, 0 };
+    std::vector<std::pair<GLenum, bool>> capabilities; // известные состояния glEnable/glDisable
+    GLuint depthFuncValue = UNKNOWN, depthMaskValue = UNKNOWN, cullFaceValue = UNKNOWN;
+    std::unordered_map<uint64_t, UniformValue> uniforms; // ключ — (программа << 32) | location
+    unsigned long long issuedCalls[FUNCTION_COUNT] = {};
+    unsigned long long elidedCalls[FUNCTION_COUNT] = {};
+
+    GLStateCache() {}
+
+    template <typename Proc>
+    static void replace(Proc& slot, Proc& original, Proc wrapper)
+    {
+        if (slot == NULL)
+            return;
+        original = slot;
+        slot = wrapper;
+    }
+
+    unsigned long long sum(const unsigned long long* calls, const std::string& prefix) const
+    {
+        unsigned long long total = 0;
+        for (int f = 0; f < FUNCTION_COUNT; ++f)
+            if (std::string(functionNames[f]).compare(0, prefix.size(), prefix) == 0)
+                total += calls[f];
+        return total;
+    }
+
+    // учесть вызов: changed — значение отличается от известного и вызов передаётся драйверу
+    bool record(Function function, bool changed)
+    {
+        ++(changed ? issuedCalls : elidedCalls)[function];
+        return changed;
+    }
+
+    // заменить известное значение value на next; true — значение изменилось (или было неизвестно)
+    bool update(Function function, GLuint& value, GLuint next)
+    {
+        bool changed = value != next;
+        value = next;
+        return record(function, changed);
+    }
+
+    static int textureTarget(GLenum target)
+    {
+        switch (target)
+        {
+        case GL_TEXTURE_2D: return TARGET_2D;
+        case GL_TEXTURE_2D_ARRAY: return TARGET_2D_ARRAY;
+        case GL_TEXTURE_CUBE_MAP: return TARGET_CUBE_MAP;
+        case GL_TEXTURE_CUBE_MAP_ARRAY: return TARGET_CUBE_MAP_ARRAY;
+        case GL_TEXTURE_3D: return TARGET_3D;
+        case GL_TEXTURE_BUFFER: return TARGET_BUFFER;
+        default: return -1;
+        }
+    }
+
+    bool setCapability(Function function, GLenum cap, bool enabled)
+    {
+        for (std::pair<GLenum, bool>& known : capabilities)
+            if (known.first == cap)
+            {
+                bool changed = known.second != enabled;
+                known.second = enabled;
+                return record(function, changed);
+            }
+        capabilities.push_back({ cap, enabled });
+        return record(function, true);
+    }
+
+    // значение униформы location текущей программы; true — его нужно передать драйверу.
+    // cacheable = false — значение передаётся всегда (транспонированная матрица: те же байты, другое значение)
+    bool setUniform(Function function, GLint location, GLsizei count, const void* data, size_t elementSize,
+                    bool cacheable = true)
+    {
+        // location -1 драйвер молча пропускает
+        if (location < 0)
+            return record(function, false);
+        if (program == UNKNOWN || program == 0)
+            return record(function, true);
+        uint64_t key = ((uint64_t)program << 32) | (uint32_t)location;
+        if (count != 1 || !cacheable || elementSize > sizeof(UniformValue::bytes))
+        {
+            // массивы не кэшируются: элементы занимают location подряд, их записи устаревают
+            for (GLsizei i = 0; i < count; ++i)
+                uniforms.erase(key + (uint64_t)i);
+            return record(function, true);
+        }
+        auto found = uniforms.find(key);
+        if (found != uniforms.end() && found->second.setter == function && found->second.size == elementSize &&
+            std::memcmp(found->second.bytes, data, elementSize) == 0)
+            return record(function, false);
+        UniformValue& value = uniforms[key];
+        value.setter = function;
+        value.size = (unsigned char)elementSize;
+        std::memcpy(value.bytes, data, elementSize);
+        return record(function, true);
+    }
+
+    void forgetUniforms(GLuint forgotten)
+    {
+        for (auto it = uniforms.begin(); it != uniforms.end();)
+            it = (it->first >> 32) == forgotten ? uniforms.erase(it) : std::next(it);
+    }
+
+    // обёртки
+    static void APIENTRY useProgram(GLuint id)
+    {
+        GLStateCache& s = get();
+        if (s.update(USE_PROGRAM, s.program, id))
+            s.gl.useProgram(id);
+    }
+
+    static void APIENTRY bindVertexArray(GLuint id)
+    {
+        GLStateCache& s = get();
+        if (s.update(BIND_VERTEX_ARRAY, s.vertexArray, id))
+            s.gl.bindVertexArray(id);
+    }
+
+    static void APIENTRY activeTexture(GLenum unit)
+    {
+        GLStateCache& s = get();
+        if (s.update(ACTIVE_TEXTURE, s.activeUnit, unit - GL_TEXTURE0))
+            s.gl.activeTexture(unit);
+    }
+
+    static void APIENTRY bindTexture(GLenum target, GLuint texture)
+    {
+        GLStateCache& s = get();
+        int slot = textureTarget(target);
+        if (slot < 0 || s.activeUnit >= (GLuint)s.textureUnits)
+        {
+            // неотслеживаемая цель или неизвестный блок: передаётся, известная привязка блока устаревает
+            if (s.activeUnit < (GLuint)s.textureUnits && slot >= 0)
+                s.textures[s.activeUnit * TEXTURE_TARGET_COUNT + slot] = UNKNOWN;
+            s.record(BIND_TEXTURE, true);
+            s.gl.bindTexture(target, texture);
+            return;
+        }
+        if (s.update(BIND_TEXTURE, s.textures[s.activeUnit * TEXTURE_TARGET_COUNT + slot], texture))
+            s.gl.bindTexture(target, texture);
+    }
+
+    static void APIENTRY bindFramebuffer(GLenum target, GLuint framebuffer)
+    {
+        GLStateCache& s = get();
+        bool draw = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+        bool read = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+        bool changed = (draw && s.drawFramebuffer != framebuffer) || (read && s.readFramebuffer != framebuffer);
+        if (draw)
+            s.drawFramebuffer = framebuffer;
+        if (read)
+            s.readFramebuffer = framebuffer;
+        if (s.record(BIND_FRAMEBUFFER, changed))
+            s.gl.bindFramebuffer(target, framebuffer);
+    }
+
+    static void APIENTRY viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+    {
+        GLStateCache& s = get();
+        const GLint next[4] = { x, y, width, height };
+        bool changed = !s.viewportValid || std::memcmp(s.viewportValue, next, sizeof(next)) != 0;
+        s.viewportValid = true;
+        std::memcpy(s.viewportValue, next, sizeof(next));
+        if (s.record(VIEWPORT, changed))
+            s.gl.viewport(x, y, width, height);
+    }
+
+    static void APIENTRY enable(GLenum cap)
+    {
+        GLStateCache& s = get();
+        if (s.setCapability(ENABLE, cap, true))
+            s.gl.enable(cap);
+    }
+
+    static void APIENTRY disable(GLenum cap)
+    {
+        GLStateCache& s = get();
+        if (s.setCapability(DISABLE, cap, false))
+            s.gl.disable(cap);
+    }
+
+    static void APIENTRY depthFunc(GLenum func)
+    {
+        GLStateCache& s = get();
+        if (s.update(DEPTH_FUNC, s.depthFuncValue, func))
+            s.gl.depthFunc(func);
+    }
+
+    static void APIENTRY depthMask(GLboolean flag)
+    {
+        GLStateCache& s = get();
+        if (s.update(DEPTH_MASK, s.depthMaskValue, flag ? GL_TRUE : GL_FALSE))
+            s.gl.depthMask(flag);
+    }
+
+    static void APIENTRY cullFace(GLenum mode)
+    {
+        GLStateCache& s = get();
+        if (s.update(CULL_FACE, s.cullFaceValue, mode))
+            s.gl.cullFace(mode);
+    }
+
+    static void APIENTRY uniform1i(GLint location, GLint v0)
+    {
+        if (get().setUniform(UNIFORM_1I, location, 1, &v0, sizeof(v0)))
+            get().gl.uniform1i(location, v0);
+    }
+
+    static void APIENTRY uniform1f(GLint location, GLfloat v0)
+    {
+        if (get().setUniform(UNIFORM_1F, location, 1, &v0, sizeof(v0)))
+            get().gl.uniform1f(location, v0);
+    }
+
+    static void APIENTRY uniform2f(GLint location, GLfloat v0, GLfloat v1)
+    {
+        const GLfloat v[2] = { v0, v1 };
+        if (get().setUniform(UNIFORM_2F, location, 1, v, sizeof(v)))
+            get().gl.uniform2f(location, v0, v1);
+    }
+
+    static void APIENTRY uniform2fv(GLint location, GLsizei count, const GLfloat* value)
+    {
+        if (get().setUniform(UNIFORM_2FV, location, count, value, 2 * sizeof(GLfloat)))
+            get().gl.uniform2fv(location, count, value);
+    }
+
+    static void APIENTRY uniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2)
+    {
+        const GLfloat v[3] = { v0, v1, v2 };
+        if (get().setUniform(UNIFORM_3F, location, 1, v, sizeof(v)))
+            get().gl.uniform3f(location, v0, v1, v2);
+    }
+
+    static void APIENTRY uniform3fv(GLint location, GLsizei count, const GLfloat* value)
+    {
+        if (get().setUniform(UNIFORM_3FV, location, count, value, 3 * sizeof(GLfloat)))
+            get().gl.uniform3fv(location, count, value);
+    }
+
+    static void APIENTRY uniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3)
+    {
+        const GLfloat v[4] = { v0, v1, v2, v3 };
+        if (get().setUniform(UNIFORM_4F, location, 1, v, sizeof(v)))
+            get().gl.uniform4f(location, v0, v1, v2, v3);
+    }
+
+    static void APIENTRY uniform4fv(GLint location, GLsizei count, const GLfloat* value)
+    {
+        if (get().setUniform(UNIFORM_4FV, location, count, value, 4 * sizeof(GLfloat)))
+            get().gl.uniform4fv(location, count, value);
+    }
+
+    static void APIENTRY uniformMatrix2fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+    {
+        if (get().setUniform(UNIFORM_MATRIX_2FV, location, count, value, 4 * sizeof(GLfloat), !transpose))
+            get().gl.uniformMatrix2fv(location, count, transpose, value);
+    }
+
+    static void APIENTRY uniformMatrix3fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+    {
+        if (get().setUniform(UNIFORM_MATRIX_3FV, location, count, value, 9 * sizeof(GLfloat), !transpose))
+            get().gl.uniformMatrix3fv(location, count, transpose, value);
+    }
+
+    static void APIENTRY uniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+    {
+        if (get().setUniform(UNIFORM_MATRIX_4FV, location, count, value, 16 * sizeof(GLfloat), !transpose))
+            get().gl.uniformMatrix4fv(location, count, transpose, value);
+    }
+
+    static void APIENTRY deleteProgram(GLuint id)
+    {
+        GLStateCache& s = get();
+        s.forgetUniforms(id);
+        // текущая программа остаётся установленной до следующего glUseProgram, но её имя может быть выдано снова
+        if (s.program == id)
+            s.program = UNKNOWN;
+        s.gl.deleteProgram(id);
+    }
+
+    static void APIENTRY linkProgram(GLuint id)
+    {
+        get().forgetUniforms(id);
+        get().gl.linkProgram(id);
+    }
+
+    static void APIENTRY programBinary(GLuint id, GLenum format, const void* binary, GLsizei length)
+    {
+        get().forgetUniforms(id);
+        get().gl.programBinary(id, format, binary, length);
+    }
+
+    // удалённый привязанный объект заменяется привязкой 0
+    static void APIENTRY deleteTextures(GLsizei n, const GLuint* ids)
+    {
+        GLStateCache& s = get();
+        for (GLsizei i = 0; i < n; ++i)
+            for (GLuint& bound : s.textures)
+                if (bound == ids[i] && ids[i] != 0)
+                    bound = 0;
+        s.gl.deleteTextures(n, ids);
+    }
+
+    static void APIENTRY deleteVertexArrays(GLsizei n, const GLuint* ids)
+    {
+        GLStateCache& s = get();
+        for (GLsizei i = 0; i < n; ++i)
+            if (s.vertexArray == ids[i] && ids[i] != 0)
+                s.vertexArray = 0;
+        s.gl.deleteVertexArrays(n, ids);
+    }
+
+    static void APIENTRY deleteFramebuffers(GLsizei n, const GLuint* ids)
+    {
+        GLStateCache& s = get();
+        for (GLsizei i = 0; i < n; ++i)
+        {
+            if (ids[i] == 0)
+                continue;
+            if (s.drawFramebuffer == ids[i])
+                s.drawFramebuffer = 0;
+            if (s.readFramebuffer == ids[i])
+                s.readFramebuffer = 0;
+        }
+        s.gl.deleteFramebuffers(n, ids);
+    }
+};
+
+#endif
@@ -0,0 +1,144 @@
+#ifndef GLCALLS_H
+#define GLCALLS_H
+
+#include <glad/glad.h>
+
+#include <map>
+#include <string>
+
+// подменить указатель GLAD для функции name обёрткой со счётчиком
+#define GL_CALLS_HOOK(name) hook<__LINE__>(glad_##name, #name)
+
+// Счётчик вызовов OpenGL. install() подменяет указатели функций GLAD (glad_glXxx) обёртками, которые
+// увеличивают счётчик функции и вызывают исходную функцию. Считаются функции из списка в install() —
+// всё, что вызывается в цикле рендеринга. Обёртки стоят лишний косвенный вызов, поэтому счётчик
+// ставится только по запросу (--count-gl-calls, --bench-uniforms) после gladLoadGLLoader().
+class GLCallCounter
+{
+public:
+    static GLCallCounter& get()
+    {
+        static GLCallCounter instance;
+        return instance;
+    }
+
+    void install()
+    {
+        if (installed)
+            return;
+        installed = true;
+        // по одной функции на строку: номер строки различает обёртки (см. hook)
+        GL_CALLS_HOOK(glGetUniformLocation);
+        GL_CALLS_HOOK(glUniform1i);
+        GL_CALLS_HOOK(glUniform1f);
+        GL_CALLS_HOOK(glUniform2f);
+        GL_CALLS_HOOK(glUniform2fv);
+        GL_CALLS_HOOK(glUniform3f);
+        GL_CALLS_HOOK(glUniform3fv);
+        GL_CALLS_HOOK(glUniform4f);
+        GL_CALLS_HOOK(glUniform4fv);
+        GL_CALLS_HOOK(glUniformMatrix2fv);
+        GL_CALLS_HOOK(glUniformMatrix3fv);
+        GL_CALLS_HOOK(glUniformMatrix4fv);
+        GL_CALLS_HOOK(glUseProgram);
+        GL_CALLS_HOOK(glBindFramebuffer);
+        GL_CALLS_HOOK(glFramebufferTextureLayer);
+        GL_CALLS_HOOK(glViewport);
+        GL_CALLS_HOOK(glClear);
+        GL_CALLS_HOOK(glClearBufferfv);
+        GL_CALLS_HOOK(glClearColor);
+        GL_CALLS_HOOK(glActiveTexture);
+        GL_CALLS_HOOK(glBindTexture);
+        GL_CALLS_HOOK(glBindSampler);
+        GL_CALLS_HOOK(glBindVertexArray);
+        GL_CALLS_HOOK(glBindBuffer);
+        GL_CALLS_HOOK(glBufferSubData);
+        GL_CALLS_HOOK(glBufferData);
+        GL_CALLS_HOOK(glBindBufferRange);
+        GL_CALLS_HOOK(glFenceSync);
+        GL_CALLS_HOOK(glClientWaitSync);
+        GL_CALLS_HOOK(glDeleteSync);
+        GL_CALLS_HOOK(glDrawArrays);
+        GL_CALLS_HOOK(glDrawArraysInstanced);
+        GL_CALLS_HOOK(glDrawElements);
+        GL_CALLS_HOOK(glDrawElementsInstanced);
+        GL_CALLS_HOOK(glDrawElementsInstancedBaseInstance);
+        GL_CALLS_HOOK(glMultiDrawElementsIndirect);
+        GL_CALLS_HOOK(glVertexAttribPointer);
+        GL_CALLS_HOOK(glVertexAttribIPointer);
+        GL_CALLS_HOOK(glEnable);
+        GL_CALLS_HOOK(glDisable);
+        GL_CALLS_HOOK(glCullFace);
+        GL_CALLS_HOOK(glQueryCounter);
+        GL_CALLS_HOOK(glBeginQuery);
+        GL_CALLS_HOOK(glEndQuery);
+        GL_CALLS_HOOK(glGetQueryObjectui64v);
+    }
+
+    bool active() const { return installed; }
+
+    // обнулить счётчики (например, в начале кадра)
+    void reset()
+    {
+        for (auto& entry : calls)
+            entry.second = 0;
+    }
+
+    // всего вызовов с последнего reset()
+    unsigned long long total() const
+    {
+        unsigned long long sum = 0;
+        for (const auto& entry : calls)
+            sum += entry.second;
+        return sum;
+    }
+
+    // вызовы функций, имя которых начинается с prefix (например, "glUniform")
+    unsigned long long count(const std::string& prefix) const
+    {
+        unsigned long long sum = 0;
+        for (const auto& entry : calls)
+            if (entry.first.compare(0, prefix.size(), prefix) == 0)
+                sum += entry.second;
+        return sum;
+    }
+
+    const std::map<std::string, unsigned long long>& perFunction() const { return calls; }
+
+private:
+    bool installed = false;
+    std::map<std::string, unsigned long long> calls;
+
+    GLCallCounter() {}
+
+    // обёртка для одной функции: хранит исходный указатель и счётчик
+    template <int Id, typename R, typename... Args>
+    struct Hook
+    {
+        static R (APIENTRYP original)(Args...);
+        static unsigned long long* counter;
+
+        static R APIENTRY call(Args... args)
+        {
+            ++*counter;
+            return original(args...);
+        }
+    };
+
+    template <int Id, typename R, typename... Args>
+    void hook(R (APIENTRYP& slot)(Args...), const char* name)
+    {
+        if (slot == NULL)
+            return;
+        Hook<Id, R, Args...>::original = slot;
+        Hook<Id, R, Args...>::counter = &calls[name];
+        slot = &Hook<Id, R, Args...>::call;
+    }
+};
+
+template <int Id, typename R, typename... Args>
+R (APIENTRYP GLCallCounter::Hook<Id, R, Args...>::original)(Args...) = NULL;
+template <int Id, typename R, typename... Args>
+unsigned long long* GLCallCounter::Hook<Id, R, Args...>::counter = NULL;
+
+#endif
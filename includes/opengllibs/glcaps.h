@@ -0,0 +1,47 @@
+#ifndef GLCAPS_H
+#define GLCAPS_H
+
+#include <glad/glad.h>
+
+#include <set>
+#include <string>
+
+// Возможности текущего контекста OpenGL: версия и список расширений.
+// Заполняется один раз после загрузки GLAD (GLCaps::get()), дальше проверки ничего не стоят.
+class GLCaps
+{
+public:
+    int major = 0;
+    int minor = 0;
+
+    static const GLCaps& get()
+    {
+        static GLCaps caps;
+        return caps;
+    }
+
+    bool has(const std::string& extension) const
+    {
+        return extensions.count(extension) != 0;
+    }
+
+    bool atLeast(int reqMajor, int reqMinor) const
+    {
+        return major > reqMajor || (major == reqMajor && minor >= reqMinor);
+    }
+
+private:
+    std::set<std::string> extensions;
+
+    GLCaps()
+    {
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; ++i)
+            extensions.insert((const char*)glGetStringi(GL_EXTENSIONS, i));
+    }
+};
+
+#endif
@@ -0,0 +1,242 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#ifdef HAVE_EGL
+// не подтягиваем заголовки X11 через eglplatform.h — нам нужен только surfaceless-дисплей
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Контекст OpenGL без окна для запуска на машинах без дисплея и GPU (например, Mesa llvmpipe на CI).
+// Если сборка поддерживает EGL (HAVE_EGL), создаётся surfaceless-контекст через EGL_MESA_platform_surfaceless,
+// иначе используется скрытое окно GLFW. В обоих случаях рисовать нужно в OffscreenTarget, т.к. экранного
+// буфера кадра нет (или он невидим).
+class HeadlessContext
+{
+public:
+    // создать контекст версии major.minor (core profile) и сделать его текущим
+    bool create(int major, int minor)
+    {
+#ifdef HAVE_EGL
+        if (createEGL(major, minor))
+            return true;
+        std::cout << "HEADLESS:: EGL context creation failed, falling back to hidden GLFW window" << std::endl;
+#endif
+        return createGLFW(major, minor);
+    }
+
+    // функция загрузки указателей OpenGL для GLAD, соответствующая созданному контексту
+    GLADloadproc loader() const
+    {
+#ifdef HAVE_EGL
+        if (context != EGL_NO_CONTEXT)
+            return (GLADloadproc)eglGetProcAddress;
+#endif
+        return (GLADloadproc)glfwGetProcAddress;
+    }
+
+    void destroy()
+    {
+#ifdef HAVE_EGL
+        if (display != EGL_NO_DISPLAY)
+        {
+            eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            if (surface != EGL_NO_SURFACE)
+                eglDestroySurface(display, surface);
+            if (context != EGL_NO_CONTEXT)
+                eglDestroyContext(display, context);
+            eglTerminate(display);
+            display = EGL_NO_DISPLAY;
+            context = EGL_NO_CONTEXT;
+            surface = EGL_NO_SURFACE;
+        }
+#endif
+        if (window != nullptr)
+        {
+            glfwDestroyWindow(window);
+            glfwTerminate();
+            window = nullptr;
+        }
+    }
+
+private:
+#ifdef HAVE_EGL
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLContext context = EGL_NO_CONTEXT;
+    EGLSurface surface = EGL_NO_SURFACE;
+
+    static bool hasExtension(const char* list, const char* name)
+    {
+        if (list == nullptr)
+            return false;
+        size_t len = std::strlen(name);
+        for (const char* p = std::strstr(list, name); p != nullptr; p = std::strstr(p + len, name))
+            if ((p == list || p[-1] == ' ') && (p[len] == ' ' || p[len] == '\0'))
+                return true;
+        return false;
+    }
+
+    bool createEGL(int major, int minor)
+    {
+        // 1. дисплей: сначала surfaceless-платформа Mesa, затем дисплей по умолчанию
+        const char* clientExts = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+        PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+            (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (getPlatformDisplay != nullptr && hasExtension(clientExts, "EGL_MESA_platform_surfaceless"))
+            display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        if (display == EGL_NO_DISPLAY)
+            display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr))
+        {
+            display = EGL_NO_DISPLAY;
+            return false;
+        }
+        if (!eglBindAPI(EGL_OPENGL_API))
+        {
+            destroy();
+            return false;
+        }
+
+        // 2. конфигурация: без неё, если драйвер позволяет, иначе pbuffer 1x1
+        const char* displayExts = eglQueryString(display, EGL_EXTENSIONS);
+        EGLConfig config = (EGLConfig)0;
+        bool needSurface = !hasExtension(displayExts, "EGL_KHR_surfaceless_context");
+        if (needSurface || !hasExtension(displayExts, "EGL_KHR_no_config_context"))
+        {
+            const EGLint configAttribs[] = {
+                EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+                EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+                EGL_NONE
+            };
+            EGLint count = 0;
+            if (!eglChooseConfig(display, configAttribs, &config, 1, &count) || count == 0)
+            {
+                destroy();
+                return false;
+            }
+        }
+
+        // 3. контекст core profile нужной версии
+        const EGLint contextAttribs[] = {
+            EGL_CONTEXT_MAJOR_VERSION_KHR, major,
+            EGL_CONTEXT_MINOR_VERSION_KHR, minor,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR,
+            EGL_NONE
+        };
+        context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+        if (context == EGL_NO_CONTEXT)
+        {
+            destroy();
+            return false;
+        }
+        if (needSurface)
+        {
+            const EGLint pbufferAttribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+            surface = eglCreatePbufferSurface(display, config, pbufferAttribs);
+        }
+        if (!eglMakeCurrent(display, surface, surface, context))
+        {
+            destroy();
+            return false;
+        }
+        return true;
+    }
+#endif
+
+    GLFWwindow* window = nullptr;
+
+    bool createGLFW(int major, int minor)
+    {
+        if (!glfwInit())
+            return false;
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, major);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, minor);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+        glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+        window = glfwCreateWindow(1, 1, "PointShadowHeadless", NULL, NULL);
+        if (window == NULL)
+        {
+            glfwTerminate();
+            return false;
+        }
+        glfwMakeContextCurrent(window);
+        return true;
+    }
+};
+
+// Внеэкранная цель рендеринга: FBO с цветовым и глубинным renderbuffer'ами.
+// В headless-режиме заменяет экранный буфер кадра (FBO 0).
+class OffscreenTarget
+{
+public:
+    unsigned int FBO = 0;
+    unsigned int colorRBO = 0;
+    unsigned int depthRBO = 0;
+    int width = 0;
+    int height = 0;
+
+    bool create(int w, int h)
+    {
+        width = w;
+        height = h;
+        glGenFramebuffers(1, &FBO);
+        glGenRenderbuffers(1, &colorRBO);
+        glGenRenderbuffers(1, &depthRBO);
+        glBindRenderbuffer(GL_RENDERBUFFER, colorRBO);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, depthRBO);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorRBO);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthRBO);
+        bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        if (!complete)
+            std::cout << "ERROR::OFFSCREEN:: framebuffer is not complete" << std::endl;
+        return complete;
+    }
+
+    // сохранить содержимое цветового буфера в файл формата PPM (бинарный P6)
+    bool writePPM(const std::string& path) const
+    {
+        std::vector<unsigned char> pixels((size_t)width * height * 3);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, FBO);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+        std::ofstream file(path, std::ios::binary);
+        if (!file)
+            return false;
+        file << "P6\n" << width << " " << height << "\n255\n";
+        // OpenGL хранит строки снизу вверх, PPM — сверху вниз
+        for (int y = height - 1; y >= 0; --y)
+            file.write((const char*)&pixels[(size_t)y * width * 3], (std::streamsize)width * 3);
+        return (bool)file;
+    }
+
+    void destroy()
+    {
+        glDeleteFramebuffers(1, &FBO);
+        glDeleteRenderbuffers(1, &colorRBO);
+        glDeleteRenderbuffers(1, &depthRBO);
+        FBO = colorRBO = depthRBO = 0;
+    }
+};
+
+#endif
@@ -0,0 +1,171 @@
+#ifndef LIGHT_CLUSTERS_H
+#define LIGHT_CLUSTERS_H
+
+#include <glm/glm.hpp>
+
+#include <opengllibs/bounds.h>
+#include <opengllibs/worker_pool.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Кластерное назначение точечных источников (clustered forward): пирамида видимости камеры делится на
+// TILES_X x TILES_Y экранных плиток и SLICES срезов глубины (границы срезов — геометрическая прогрессия от near
+// до far), у каждого кластера — AABB в координатах вида. Источник попадает в кластер, если его сфера влияния
+// пересекает AABB кластера. Результат компактный: grid[cluster] = (смещение, количество) в общем списке indices.
+// Код без OpenGL: тот же расчёт выполняет вычислительный шейдер point_shadows_clusters.cs, эта реализация —
+// запасной путь без вычислительных шейдеров и эталон для проверки.
+class LightClusters
+{
+public:
+    // размеры сетки совпадают с CLUSTER_* в point_shadows_lights.glsl
+    static const int TILES_X = 16;
+    static const int TILES_Y = 9;
+    static const int SLICES = 24;
+    static const int CLUSTER_COUNT = TILES_X * TILES_Y * SLICES;
+    // источников в одном кластере; лишние отбрасываются и учитываются в overflowed()
+    static const int MAX_LIGHTS_PER_CLUSTER = 128;
+
+    // перспективная проекция камеры (симметричная): границы кластеров пересчитываются, только если она изменилась
+    void setProjection(const glm::mat4& projection, float nearPlane, float farPlane)
+    {
+        if (!bounds.empty() && projection == lastProjection && nearPlane == zNear && farPlane == zFar)
+            return;
+        lastProjection = projection;
+        zNear = nearPlane;
+        zFar = farPlane;
+        bounds.resize(CLUSTER_COUNT);
+        for (int slice = 0; slice < SLICES; ++slice)
+        {
+            float d0 = sliceDepth(slice), d1 = sliceDepth(slice + 1);
+            for (int y = 0; y < TILES_Y; ++y)
+                for (int x = 0; x < TILES_X; ++x)
+                {
+                    // плитка в NDC; на глубине d точка NDC (nx, ny) лежит в (nx * d / P00, ny * d / P11, -d)
+                    float nx0 = -1.0f + 2.0f * x / TILES_X, nx1 = -1.0f + 2.0f * (x + 1) / TILES_X;
+                    float ny0 = -1.0f + 2.0f * y / TILES_Y, ny1 = -1.0f + 2.0f * (y + 1) / TILES_Y;
+                    AABB& box = bounds[clusterIndex(x, y, slice)];
+                    box.min.x = std::min(nx0 * d0, nx0 * d1) / projection[0][0];
+                    box.max.x = std::max(nx1 * d0, nx1 * d1) / projection[0][0];
+                    box.min.y = std::min(ny0 * d0, ny0 * d1) / projection[1][1];
+                    box.max.y = std::max(ny1 * d0, ny1 * d1) / projection[1][1];
+                    box.min.z = -d1;
+                    box.max.z = -d0;
+                }
+        }
+    }
+
+    static int clusterIndex(int x, int y, int slice) { return (slice * TILES_Y + y) * TILES_X + x; }
+
+    // глубина (расстояние вдоль оси взгляда) начала среза slice
+    float sliceDepth(int slice) const
+    {
+        return zNear * std::pow(zFar / zNear, (float)slice / SLICES);
+    }
+
+    // срез, в который попадает глубина viewDepth (за пределами [near, far] — крайний срез)
+    int sliceOf(float viewDepth) const
+    {
+        if (!(viewDepth > zNear))
+            return 0;
+        int slice = (int)std::floor(std::log(viewDepth / zNear) / std::log(zFar / zNear) * SLICES);
+        return std::min(std::max(slice, 0), SLICES - 1);
+    }
+
+    const AABB& clusterBounds(int cluster) const { return bounds[cluster]; }
+
+    // назначить источники кластерам. spheres — центры сфер влияния в координатах вида (xyz) и радиусы (w).
+    // Срезы глубины делятся между threads потоками (1 — всё в вызывающем потоке) постоянного WorkerPool,
+    // который создаётся при первом вызове и при смене threads; каждый поток пишет свои списки, общий список
+    // собирается после завершения всех срезов, поэтому результат не зависит от числа потоков
+    void assign(const std::vector<glm::vec4>& spheres, unsigned int threads)
+    {
+        threads = std::max(1u, std::min(threads, (unsigned int)SLICES));
+        gridData.assign(CLUSTER_COUNT, glm::uvec2(0));
+        sliceLights.resize(SLICES);
+        sliceOverflow.assign(SLICES, 0);
+
+        if (!pool || pool->size() != threads)
+            pool.reset(new WorkerPool(threads));
+        pool->run(threads, [&](size_t t) { assignSlices(spheres, (unsigned int)t, threads); });
+
+        // смещения в списках срезов становятся смещениями в общем списке
+        indexData.clear();
+        overflowCount = 0;
+        for (int slice = 0; slice < SLICES; ++slice)
+        {
+            uint32_t base = (uint32_t)indexData.size();
+            for (int cluster = clusterIndex(0, 0, slice); cluster < clusterIndex(0, 0, slice + 1); ++cluster)
+                gridData[cluster].x += base;
+            indexData.insert(indexData.end(), sliceLights[slice].begin(), sliceLights[slice].end());
+            overflowCount += sliceOverflow[slice];
+        }
+    }
+
+    // (смещение в indices(), количество источников) каждого кластера
+    const std::vector<glm::uvec2>& grid() const { return gridData; }
+    // индексы источников подряд по кластерам
+    const std::vector<uint32_t>& indices() const { return indexData; }
+    // сколько кластеров не вместили все свои источники
+    int overflowed() const { return overflowCount; }
+
+    // пересекает ли сфера (center, radius) AABB
+    static bool sphereIntersects(const AABB& box, const glm::vec3& center, float radius)
+    {
+        glm::vec3 d = glm::max(glm::max(box.min - center, center - box.max), glm::vec3(0.0f));
+        return glm::dot(d, d) <= radius * radius;
+    }
+
+private:
+    std::vector<AABB> bounds;
+    glm::mat4 lastProjection = glm::mat4(0.0f);
+    float zNear = 0.1f, zFar = 100.0f;
+    std::vector<glm::uvec2> gridData;
+    std::vector<uint32_t> indexData;
+    std::vector<std::vector<uint32_t>> sliceLights;
+    std::vector<int> sliceOverflow;
+    int overflowCount = 0;
+    std::unique_ptr<WorkerPool> pool;
+
+    // срезы first, first + step, ...: сначала источники, задевающие слой глубины среза, затем плитки
+    void assignSlices(const std::vector<glm::vec4>& spheres, unsigned int first, unsigned int step)
+    {
+        std::vector<uint32_t> candidates;
+        for (int slice = (int)first; slice < SLICES; slice += (int)step)
+        {
+            float d0 = sliceDepth(slice), d1 = sliceDepth(slice + 1);
+            candidates.clear();
+            for (size_t i = 0; i < spheres.size(); ++i)
+            {
+                float depth = -spheres[i].z;
+                if (depth + spheres[i].w >= d0 && depth - spheres[i].w <= d1)
+                    candidates.push_back((uint32_t)i);
+            }
+            std::vector<uint32_t>& list = sliceLights[slice];
+            list.clear();
+            for (int cluster = clusterIndex(0, 0, slice); cluster < clusterIndex(0, 0, slice + 1); ++cluster)
+            {
+                uint32_t offset = (uint32_t)list.size();
+                uint32_t count = 0;
+                for (uint32_t i : candidates)
+                {
+                    if (!sphereIntersects(bounds[cluster], glm::vec3(spheres[i]), spheres[i].w))
+                        continue;
+                    if (count == MAX_LIGHTS_PER_CLUSTER)
+                    {
+                        ++sliceOverflow[slice];
+                        break;
+                    }
+                    list.push_back(i);
+                    ++count;
+                }
+                gridData[cluster] = glm::uvec2(offset, count);
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Файл, отображённый в память только для чтения (mmap / MapViewOfFile). Страницы читаются ОС по мере
+// обращения, без копирования в буфер процесса; отображение живёт, пока жив объект.
+class MappedFile
+{
+public:
+    MappedFile() {}
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path)
+    {
+        close();
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                                  FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+        LARGE_INTEGER length;
+        if (GetFileSizeEx(file, &length) && length.QuadPart > 0)
+        {
+            HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+            if (mapping != NULL)
+            {
+                mapped = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+                CloseHandle(mapping);
+                if (mapped != NULL)
+                    mappedBytes = (size_t)length.QuadPart;
+            }
+        }
+        CloseHandle(file);
+#else
+        int file = ::open(path.c_str(), O_RDONLY);
+        if (file < 0)
+            return false;
+        struct stat status;
+        if (fstat(file, &status) == 0 && status.st_size > 0)
+        {
+            void* address = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+            if (address != MAP_FAILED)
+            {
+                mapped = address;
+                mappedBytes = (size_t)status.st_size;
+            }
+        }
+        ::close(file);
+#endif
+        return mapped != nullptr;
+    }
+
+    void close()
+    {
+        if (mapped == nullptr)
+            return;
+#ifdef _WIN32
+        UnmapViewOfFile(mapped);
+#else
+        munmap(mapped, mappedBytes);
+#endif
+        mapped = nullptr;
+        mappedBytes = 0;
+    }
+
+    bool isOpen() const { return mapped != nullptr; }
+    const uint8_t* data() const { return (const uint8_t*)mapped; }
+    size_t size() const { return mappedBytes; }
+
+private:
+    void* mapped = nullptr;
+    size_t mappedBytes = 0;
+};
+
+#endif
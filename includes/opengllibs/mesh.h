@@ -6,7 +6,11 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <opengllibs/bounds.h>
 #include <opengllibs/shader.h>
+#include <opengllibs/vertex_format.h>
+
+#include <algorithm>
 
 #include <string>
 #include <vector>
@@ -40,6 +44,52 @@ struct Texture {
     string path;       // Путь к текстуре на диске
 };
 
+// Упакованные атрибуты вершины в формате GPU (см. VertexFormat::tangentSurface()); так же их пакует mesh_cooker
+inline PackedTangentSurface packTangentSurface(const Vertex& vertex)
+{
+    PackedTangentSurface surface;
+    surface.normal = packNormal(vertex.Normal);
+    surface.texCoords = packTexCoords(vertex.TexCoords);
+    surface.tangent = packNormal(vertex.Tangent);
+    surface.bitangent = packNormal(vertex.Bitangent);
+    return surface;
+}
+
+// Сетка, подготовленная на CPU без OpenGL (её можно строить в любом потоке): вершины, индексы и упакованная
+// геометрия. Вершины упаковываются (нормали и тангентный базис — 10:10:10:2, текстурные координаты — half),
+// повторяющиеся вершины удаляются. Буферы GPU из неё создаёт конструктор Mesh в потоке OpenGL
+struct MeshData
+{
+    vector<Vertex>       vertices;
+    vector<unsigned int> indices;
+    unsigned int material = 0; // индекс материала в источнике (сцене ASSIMP)
+    IndexedGeometry<PackedTangentSurface> packed;
+    MeshRange range;
+    AABB bounds;
+
+    // упаковать vertices и indices в packed и посчитать границы
+    void pack()
+    {
+        packed.beginMesh();
+        packRange(0, indices.size(), packed, bounds);
+        range = packed.endMesh();
+    }
+
+    // упаковать индексы [first, last) в out (после out.beginMesh()), границы их вершин — в rangeBounds.
+    // Части меша можно упаковывать в разных потоках и собирать IndexedGeometry::append по порядку
+    void packRange(size_t first, size_t last, IndexedGeometry<PackedTangentSurface>& out, AABB& rangeBounds) const
+    {
+        rangeBounds.min = rangeBounds.max = first < last ? vertices[indices[first]].Position : glm::vec3(0.0f);
+        for (size_t i = first; i < last; ++i)
+        {
+            const Vertex& vertex = vertices[indices[i]];
+            out.addVertex(vertex.Position, packTangentSurface(vertex));
+            rangeBounds.min = glm::min(rangeBounds.min, vertex.Position);
+            rangeBounds.max = glm::max(rangeBounds.max, vertex.Position);
+        }
+    }
+};
+
 // Класс для работы с сеткой, включая рендеринг и обработку данных
 class Mesh {
 public:
@@ -47,17 +97,33 @@ public:
     vector<Vertex>       vertices;
     vector<unsigned int> indices;
     vector<Texture>      textures;
-    unsigned int VAO;    // Vertex Array Object (контейнер для всех буферов)
+    unsigned int VAO;    // Vertex Array Object полного потока (позиции и упакованные атрибуты)
+    GeometryBuffers geometry; // компактные буферы на GPU: поток глубины и полный поток (см. vertex_format.h)
+    vector<MeshRange> lods;   // диапазоны индексов уровней детализации, [0] — полный меш
+    AABB bounds;              // границы в координатах модели
 
-    // Конструктор, инициализирующий сетку
+    // Конструктор, инициализирующий сетку: вершины упаковываются здесь же
     Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
+        : Mesh(packed(std::move(vertices), std::move(indices)), std::move(textures))
     {
-        this->vertices = vertices;
-        this->indices = indices;
-        this->textures = textures;
+    }
+
+    // Сетка из подготовленных данных: вершины и индексы перемещаются, упакованная геометрия загружается в буферы.
+    // Индексы и веса костей на GPU не передаются: загрузчик Model их не заполняет.
+    Mesh(MeshData&& data, vector<Texture> textures)
+        : vertices(std::move(data.vertices)), indices(std::move(data.indices)), textures(std::move(textures)),
+          lods(1, data.range), bounds(data.bounds)
+    {
+        geometry.create(data.packed, VertexFormat::tangentSurface());
+        VAO = geometry.surfaceVAO;
+    }
 
-        // Инициализируем данные для рендеринга
-        setupMesh();
+    // Сетка из готовых потоков (CookedMesh): буферы заполняются прямо из них, вершины на CPU не хранятся
+    Mesh(const GeometryStreams& streams, vector<MeshRange> lodRanges, const AABB& meshBounds, vector<Texture> textures)
+        : textures(std::move(textures)), lods(std::move(lodRanges)), bounds(meshBounds)
+    {
+        geometry.create(streams, VertexFormat::tangentSurface());
+        VAO = geometry.surfaceVAO;
     }
 
     // Метод для отрисовки сетки с использованием шейдера
@@ -90,64 +156,31 @@ public:
             glBindTexture(GL_TEXTURE_2D, textures[i].id);
         }
 
-        // Отрисовываем сетку
+        // Отрисовываем сетку (VAO не отвязывается: следующий меш привяжет свой, повторная привязка отбрасывается кэшем состояния)
         glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+        glDrawElements(GL_TRIANGLES, lods[0].count, geometry.indexType, 0);
 
         // Сбрасываем все обратно на дефолтные значения
         glActiveTexture(GL_TEXTURE0);
     }
 
-private:
-    // Буферы для вершин и индексов
-    unsigned int VBO, EBO;
-
-    // Метод для инициализации всех буферов (VBO, EBO) и настройка указателей атрибутов
-    void setupMesh()
+    // Отрисовка только позиций (проходы глубины и теней): без текстур, 12 байт на вершину.
+    // lod — уровень детализации (у сеток, загруженных через Assimp, он один)
+    void DrawDepth(int lod = 0)
     {
-        // Создаем VAO, VBO и EBO
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
-
-        // Привязываем VAO
-        glBindVertexArray(VAO);
+        const MeshRange& range = lods[std::min(lod, (int)lods.size() - 1)];
+        glBindVertexArray(geometry.depthVAO);
+        glDrawElements(GL_TRIANGLES, range.count, geometry.indexType, (const void*)(range.firstIndex * geometry.indexSize()));
+    }
 
-        // Загружаем данные вершин в VBO
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
-
-        // Загружаем индексы в EBO
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
-
-        // Устанавливаем указатели на атрибуты вершин
-        // Позиции вершин
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-        // Нормали вершин
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-        // Текстурные координаты
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-        // Тангенты
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
-        // Битангенты
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
-        // Индексы костей
-        glEnableVertexAttribArray(5);
-        glVertexAttribIPointer(5, 4, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, m_BoneIDs));
-
-        // Веса костей
-        glEnableVertexAttribArray(6);
-        glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, m_Weights));
-
-        // Сбрасываем привязку VAO
-        glBindVertexArray(0);
+private:
+    static MeshData packed(vector<Vertex>&& vertices, vector<unsigned int>&& indices)
+    {
+        MeshData data;
+        data.vertices = std::move(vertices);
+        data.indices = std::move(indices);
+        data.pack();
+        return data;
     }
 };
 
@@ -0,0 +1,353 @@
+#ifndef MESH_CONTAINER_H
+#define MESH_CONTAINER_H
+
+#include <opengllibs/bounds.h>
+#include <opengllibs/mapped_file.h>
+#include <opengllibs/vertex_format.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Подготовленная модель (.cmesh): то, что Model получает из Assimp после импорта и упаковки, записанное один раз
+// (mesh_cooker). Заголовок, таблица мешей, таблица материалов (тип и путь текстуры), строки, затем потоки каждого
+// меша ровно в том виде, в каком их принимает GeometryBuffers: позиции и индексы набора глубины, позиции, упакованные
+// атрибуты (PackedTangentSurface) и индексы полного набора; индексы 16- или 32-битные, блоки выровнены на 16 байт.
+// У меша до MAX_LODS уровней детализации — диапазонов в тех же индексных буферах (уровень 0 — полный меш).
+// Файл отображается в память (MappedFile), и потоки уходят в glBufferData без разбора и копирования.
+class CookedMesh
+{
+public:
+    static const uint32_t MAGIC = 0x48534D43; // "CMSH"
+    static const uint32_t VERSION = 1;
+    static const int MAX_LODS = 4;
+
+    // текстура материала: тип ("texture_diffuse", ...) и путь относительно файла модели
+    typedef std::pair<std::string, std::string> MaterialTexture;
+
+    // меш для записи: геометрия (уровни детализации дописаны в конец её индексов) и их диапазоны
+    struct SourceMesh
+    {
+        IndexedGeometry<PackedTangentSurface> geometry;
+        std::vector<MeshRange> lods;
+        AABB bounds;
+        uint32_t material = 0;
+    };
+
+    struct MeshView
+    {
+        GeometryStreams streams;
+        std::vector<MeshRange> lods;
+        AABB bounds;
+        uint32_t material;
+        uint32_t vertexCount;
+    };
+
+    // записать во временный файл и переименовать
+    static bool write(const std::string& path, const std::vector<SourceMesh>& meshes,
+                      const std::vector<std::vector<MaterialTexture>>& materials)
+    {
+        Header header;
+        header.meshCount = (uint32_t)meshes.size();
+        header.materialCount = (uint32_t)materials.size();
+        std::vector<MaterialEntry> materialTable;
+        std::vector<TextureEntry> textureTable;
+        std::string strings;
+        for (const std::vector<MaterialTexture>& material : materials)
+        {
+            materialTable.push_back({ (uint32_t)textureTable.size(), (uint32_t)material.size() });
+            for (const MaterialTexture& texture : material)
+            {
+                TextureEntry entry;
+                entry.typeOffset = (uint32_t)strings.size();
+                entry.typeLength = (uint32_t)texture.first.size();
+                strings += texture.first;
+                entry.pathOffset = (uint32_t)strings.size();
+                entry.pathLength = (uint32_t)texture.second.size();
+                strings += texture.second;
+                textureTable.push_back(entry);
+            }
+        }
+        header.textureCount = (uint32_t)textureTable.size();
+        header.stringBytes = (uint32_t)strings.size();
+
+        // потоки меша в порядке STREAM_*; 16-битные индексы — там же, где их выбрал бы GeometryBuffers
+        std::vector<MeshEntry> meshTable(meshes.size());
+        std::vector<std::vector<std::vector<uint8_t>>> streams(meshes.size());
+        uint64_t offset = align(sizeof(Header) + meshTable.size() * sizeof(MeshEntry) +
+                                materialTable.size() * sizeof(MaterialEntry) + textureTable.size() * sizeof(TextureEntry) +
+                                strings.size());
+        AABB modelBounds = meshes.empty() ? AABB() : meshes[0].bounds;
+        for (size_t m = 0; m < meshes.size(); ++m)
+        {
+            const SourceMesh& source = meshes[m];
+            MeshEntry& entry = meshTable[m];
+            entry.material = source.material;
+            entry.indexType = GeometryStreams::indexTypeFor(source.geometry);
+            entry.vertexCount = (uint32_t)source.geometry.positions.size();
+            entry.depthVertexCount = (uint32_t)source.geometry.depthPositions.size();
+            entry.lodCount = (uint32_t)std::min(source.lods.size(), (size_t)MAX_LODS);
+            for (uint32_t l = 0; l < entry.lodCount; ++l)
+            {
+                entry.lodFirst[l] = source.lods[l].firstIndex;
+                entry.lodIndices[l] = (uint32_t)source.lods[l].count;
+            }
+            storeBounds(source.bounds, entry.bounds);
+            modelBounds.min = glm::min(modelBounds.min, source.bounds.min);
+            modelBounds.max = glm::max(modelBounds.max, source.bounds.max);
+
+            std::vector<std::vector<uint8_t>>& data = streams[m];
+            data.resize(STREAM_COUNT);
+            data[STREAM_DEPTH_POSITIONS] = bytesOf(source.geometry.depthPositions);
+            data[STREAM_DEPTH_INDICES] = indexBytes(source.geometry.depthIndices, entry.indexType);
+            data[STREAM_POSITIONS] = bytesOf(source.geometry.positions);
+            data[STREAM_SURFACES] = bytesOf(source.geometry.surfaces);
+            data[STREAM_INDICES] = indexBytes(source.geometry.indices, entry.indexType);
+            for (int s = 0; s < STREAM_COUNT; ++s)
+            {
+                entry.offset[s] = offset;
+                entry.bytes[s] = data[s].size();
+                offset = align(offset + data[s].size());
+            }
+        }
+        storeBounds(modelBounds, header.bounds);
+
+        std::string temporary = path + ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            file.write((const char*)&header, sizeof(header));
+            file.write((const char*)meshTable.data(), meshTable.size() * sizeof(MeshEntry));
+            file.write((const char*)materialTable.data(), materialTable.size() * sizeof(MaterialEntry));
+            file.write((const char*)textureTable.data(), textureTable.size() * sizeof(TextureEntry));
+            file.write(strings.data(), strings.size());
+            for (size_t m = 0; m < meshes.size(); ++m)
+                for (int s = 0; s < STREAM_COUNT; ++s)
+                {
+                    const char padding[16] = {};
+                    file.write(padding, (std::streamsize)(meshTable[m].offset[s] - (uint64_t)file.tellp()));
+                    file.write((const char*)streams[m][s].data(), streams[m][s].size());
+                }
+            if (!file)
+            {
+                file.close();
+                std::remove(temporary.c_str());
+                return false;
+            }
+        }
+        std::error_code error;
+        std::filesystem::rename(temporary, path, error);
+        if (error)
+            std::remove(temporary.c_str());
+        return !error;
+    }
+
+    // отобразить файл и проверить заголовок, таблицы, границы всех потоков, индексы и диапазоны уровней
+    bool open(const std::string& path)
+    {
+        meshViews.clear();
+        materialTextures.clear();
+        if (!file.open(path) || file.size() < sizeof(Header))
+            return false;
+        const Header* header = (const Header*)file.data();
+        const size_t tablesBytes = sizeof(Header) + (size_t)header->meshCount * sizeof(MeshEntry) +
+                                   (size_t)header->materialCount * sizeof(MaterialEntry) +
+                                   (size_t)header->textureCount * sizeof(TextureEntry) + header->stringBytes;
+        if (header->magic != MAGIC || header->version != VERSION || file.size() < tablesBytes)
+            return fail();
+        loadBounds(header->bounds, modelBounds);
+
+        const MeshEntry* meshTable = (const MeshEntry*)(file.data() + sizeof(Header));
+        const MaterialEntry* materialTable = (const MaterialEntry*)(meshTable + header->meshCount);
+        const TextureEntry* textureTable = (const TextureEntry*)(materialTable + header->materialCount);
+        const char* strings = (const char*)(textureTable + header->textureCount);
+        for (uint32_t m = 0; m < header->materialCount; ++m)
+        {
+            const MaterialEntry& material = materialTable[m];
+            if ((uint64_t)material.firstTexture + material.textureCount > header->textureCount)
+                return fail();
+            std::vector<MaterialTexture> textures;
+            for (uint32_t t = material.firstTexture; t < material.firstTexture + material.textureCount; ++t)
+            {
+                const TextureEntry& texture = textureTable[t];
+                if ((uint64_t)texture.typeOffset + texture.typeLength > header->stringBytes ||
+                    (uint64_t)texture.pathOffset + texture.pathLength > header->stringBytes)
+                    return fail();
+                textures.push_back({ std::string(strings + texture.typeOffset, texture.typeLength),
+                                     std::string(strings + texture.pathOffset, texture.pathLength) });
+            }
+            materialTextures.push_back(textures);
+        }
+
+        for (uint32_t m = 0; m < header->meshCount; ++m)
+        {
+            const MeshEntry& entry = meshTable[m];
+            if ((entry.indexType != GL_UNSIGNED_SHORT && entry.indexType != GL_UNSIGNED_INT) ||
+                entry.lodCount == 0 || entry.lodCount > MAX_LODS || entry.material >= header->materialCount)
+                return fail();
+            for (int s = 0; s < STREAM_COUNT; ++s)
+                if (entry.offset[s] % 16 != 0 || entry.offset[s] > file.size() || entry.bytes[s] > file.size() - entry.offset[s])
+                    return fail();
+            const size_t indexSize = GeometryBuffers::indexSize(entry.indexType);
+            const uint64_t indexCount = entry.bytes[STREAM_INDICES] / indexSize;
+            if (entry.bytes[STREAM_POSITIONS] != (uint64_t)entry.vertexCount * sizeof(glm::vec3) ||
+                entry.bytes[STREAM_SURFACES] != (uint64_t)entry.vertexCount * sizeof(PackedTangentSurface) ||
+                entry.bytes[STREAM_DEPTH_POSITIONS] != (uint64_t)entry.depthVertexCount * sizeof(glm::vec3) ||
+                entry.bytes[STREAM_INDICES] != entry.bytes[STREAM_DEPTH_INDICES] || entry.bytes[STREAM_INDICES] % indexSize != 0)
+                return fail();
+            // индекс за пределами своего набора вершин — чтение за границей буфера в glDrawElements
+            if (indexCount > 0 &&
+                (maxIndex(file.data() + entry.offset[STREAM_INDICES], indexCount, entry.indexType) >= entry.vertexCount ||
+                 maxIndex(file.data() + entry.offset[STREAM_DEPTH_INDICES], indexCount, entry.indexType) >= entry.depthVertexCount))
+                return fail();
+
+            MeshView view;
+            view.material = entry.material;
+            view.vertexCount = entry.vertexCount;
+            loadBounds(entry.bounds, view.bounds);
+            for (uint32_t l = 0; l < entry.lodCount; ++l)
+            {
+                if ((uint64_t)entry.lodFirst[l] + entry.lodIndices[l] > indexCount)
+                    return fail();
+                MeshRange range;
+                range.firstIndex = entry.lodFirst[l];
+                range.count = (GLsizei)entry.lodIndices[l];
+                view.lods.push_back(range);
+            }
+            GeometryStreams& streams = view.streams;
+            streams.indexType = entry.indexType;
+            streams.depthPositions = file.data() + entry.offset[STREAM_DEPTH_POSITIONS];
+            streams.depthPositionBytes = entry.bytes[STREAM_DEPTH_POSITIONS];
+            streams.depthIndices = file.data() + entry.offset[STREAM_DEPTH_INDICES];
+            streams.depthIndexBytes = entry.bytes[STREAM_DEPTH_INDICES];
+            streams.positions = file.data() + entry.offset[STREAM_POSITIONS];
+            streams.positionBytes = entry.bytes[STREAM_POSITIONS];
+            streams.surfaces = file.data() + entry.offset[STREAM_SURFACES];
+            streams.surfaceBytes = entry.bytes[STREAM_SURFACES];
+            streams.indices = file.data() + entry.offset[STREAM_INDICES];
+            streams.indexBytes = entry.bytes[STREAM_INDICES];
+            meshViews.push_back(view);
+        }
+        return true;
+    }
+
+    int meshCount() const { return (int)meshViews.size(); }
+    const MeshView& mesh(int i) const { return meshViews[i]; }
+    int materialCount() const { return (int)materialTextures.size(); }
+    const std::vector<MaterialTexture>& material(int i) const { return materialTextures[i]; }
+    const AABB& bounds() const { return modelBounds; }
+
+    // сторона куба кластеризации уровня lod (mesh_cooker) в долях диагонали меша, 0 — полный меш; отклонение
+    // поверхности уровня от исходной — порядка этой стороны, по ней выбирается уровень на расстоянии
+    static float lodCellFraction(int lod) { return lod == 0 ? 0.0f : 1.0f / (float)(64 >> (lod - 1)); }
+    size_t fileBytes() const { return file.size(); }
+
+private:
+    enum
+    {
+        STREAM_DEPTH_POSITIONS,
+        STREAM_DEPTH_INDICES,
+        STREAM_POSITIONS,
+        STREAM_SURFACES,
+        STREAM_INDICES,
+        STREAM_COUNT
+    };
+
+    struct Header
+    {
+        uint32_t magic = MAGIC;
+        uint32_t version = VERSION;
+        uint32_t meshCount = 0;
+        uint32_t materialCount = 0;
+        uint32_t textureCount = 0;
+        uint32_t stringBytes = 0;
+        float bounds[6] = {}; // min, max всей модели
+    };
+
+    struct MeshEntry
+    {
+        uint32_t material = 0;
+        uint32_t indexType = GL_UNSIGNED_INT;
+        uint32_t vertexCount = 0;
+        uint32_t depthVertexCount = 0;
+        uint32_t lodCount = 0;
+        uint32_t reserved = 0;
+        float bounds[6] = {};
+        uint32_t lodFirst[MAX_LODS] = {};
+        uint32_t lodIndices[MAX_LODS] = {};
+        uint64_t offset[STREAM_COUNT] = {};
+        uint64_t bytes[STREAM_COUNT] = {};
+    };
+
+    struct MaterialEntry
+    {
+        uint32_t firstTexture;
+        uint32_t textureCount;
+    };
+
+    struct TextureEntry
+    {
+        uint32_t typeOffset = 0, typeLength = 0;
+        uint32_t pathOffset = 0, pathLength = 0;
+    };
+
+    MappedFile file;
+    std::vector<MeshView> meshViews;
+    std::vector<std::vector<MaterialTexture>> materialTextures;
+    AABB modelBounds;
+
+    static uint64_t align(uint64_t offset) { return (offset + 15) & ~(uint64_t)15; }
+
+    static void storeBounds(const AABB& bounds, float* out)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            out[i] = bounds.min[i];
+            out[3 + i] = bounds.max[i];
+        }
+    }
+
+    static void loadBounds(const float* in, AABB& bounds)
+    {
+        bounds.min = glm::vec3(in[0], in[1], in[2]);
+        bounds.max = glm::vec3(in[3], in[4], in[5]);
+    }
+
+    template <class T>
+    static std::vector<uint8_t> bytesOf(const std::vector<T>& data)
+    {
+        return std::vector<uint8_t>((const uint8_t*)data.data(), (const uint8_t*)(data.data() + data.size()));
+    }
+
+    static std::vector<uint8_t> indexBytes(const std::vector<GLuint>& indices, GLenum indexType)
+    {
+        if (indexType == GL_UNSIGNED_INT)
+            return bytesOf(indices);
+        return bytesOf(std::vector<GLushort>(indices.begin(), indices.end()));
+    }
+
+    static uint32_t maxIndex(const uint8_t* data, uint64_t count, GLenum indexType)
+    {
+        if (indexType == GL_UNSIGNED_SHORT)
+        {
+            const GLushort* indices = (const GLushort*)data;
+            return *std::max_element(indices, indices + count);
+        }
+        const GLuint* indices = (const GLuint*)data;
+        return *std::max_element(indices, indices + count);
+    }
+
+    bool fail()
+    {
+        file.close();
+        meshViews.clear();
+        materialTextures.clear();
+        return false;
+    }
+};
+
+#endif
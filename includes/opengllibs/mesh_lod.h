@@ -0,0 +1,91 @@
+#ifndef MESH_LOD_H
+#define MESH_LOD_H
+
+#include <opengllibs/vertex_format.h>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+// Упрощение меша кластеризацией вершин (для уровней детализации, которые пишет mesh_cooker): пространство делится
+// на кубы со стороной cellSize, все вершины куба заменяются одной — ближайшей к среднему положению вершин куба,
+// треугольники, выродившиеся в отрезок или точку, и повторы отбрасываются. Вершины не добавляются: уровень —
+// новые индексы на те же вершины, дописанные в конец индексов обоих наборов IndexedGeometry (полного и глубины).
+// Атрибуты не учитываются, поэтому на швах текстурных координат возможны искажения — уровни предназначены прежде
+// всего для проходов глубины и теней.
+template <class Surface>
+MeshRange appendClusteredLod(IndexedGeometry<Surface>& geometry, const MeshRange& base, float cellSize)
+{
+    struct CellHash
+    {
+        size_t operator()(const glm::ivec3& c) const
+        {
+            return ((size_t)(uint32_t)c.x * 73856093u) ^ ((size_t)(uint32_t)c.y * 19349663u) ^ ((size_t)(uint32_t)c.z * 83492791u);
+        }
+    };
+    struct Cell
+    {
+        glm::vec3 sum = glm::vec3(0.0f);
+        int count = 0;
+        GLuint representative = 0;
+        float distance = INFINITY;
+    };
+
+    const GLuint end = base.firstIndex + (GLuint)base.count;
+    auto cellOf = [&](GLuint vertex) { return glm::ivec3(glm::floor(geometry.positions[vertex] / cellSize)); };
+
+    // среднее положение вершин каждого куба и вершина набора глубины для каждой вершины полного набора
+    std::unordered_map<glm::ivec3, Cell, CellHash> cells;
+    std::unordered_map<GLuint, GLuint> depthVertex;
+    for (GLuint i = base.firstIndex; i < end; ++i)
+    {
+        GLuint vertex = geometry.indices[i];
+        if (!depthVertex.emplace(vertex, geometry.depthIndices[i]).second)
+            continue;
+        Cell& cell = cells[cellOf(vertex)];
+        cell.sum += geometry.positions[vertex];
+        ++cell.count;
+    }
+    for (const auto& item : depthVertex)
+    {
+        Cell& cell = cells[cellOf(item.first)];
+        float distance = glm::length(geometry.positions[item.first] - cell.sum / (float)cell.count);
+        if (distance < cell.distance || (distance == cell.distance && item.first < cell.representative))
+        {
+            cell.distance = distance;
+            cell.representative = item.first;
+        }
+    }
+
+    MeshRange lod;
+    lod.firstIndex = (GLuint)geometry.indices.size();
+    std::set<std::array<GLuint, 3>> triangles;
+    for (GLuint i = base.firstIndex; i + 2 < end; i += 3)
+    {
+        GLuint corner[3];
+        for (int k = 0; k < 3; ++k)
+            corner[k] = cells[cellOf(geometry.indices[i + k])].representative;
+        if (corner[0] == corner[1] || corner[1] == corner[2] || corner[0] == corner[2])
+            continue;
+        // повтор — тот же треугольник с той же ориентацией (начиная с наименьшей вершины)
+        int first = (int)(std::min_element(corner, corner + 3) - corner);
+        std::array<GLuint, 3> key = { corner[first], corner[(first + 1) % 3], corner[(first + 2) % 3] };
+        if (!triangles.insert(key).second)
+            continue;
+        for (int k = 0; k < 3; ++k)
+        {
+            geometry.indices.push_back(corner[k]);
+            geometry.depthIndices.push_back(depthVertex[corner[k]]);
+        }
+        lod.count += 3;
+    }
+    return lod;
+}
+
+#endif
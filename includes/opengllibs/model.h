@@ -11,13 +11,20 @@
 #include <assimp/postprocess.h>
 
 #include <opengllibs/mesh.h>
+#include <opengllibs/mesh_container.h>
 #include <opengllibs/shader.h>
+#include <opengllibs/texture_cache.h>
+#include <opengllibs/texture_streamer.h>
 
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <algorithm>
+#include <atomic>
 #include <map>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 using namespace std;
 
@@ -28,15 +35,176 @@ class Model
 {
 public:
     // Данные модели
-    vector<Texture> textures_loaded;  // хранят все загруженные текстуры, чтобы избежать повторной загрузки
+    unordered_map<string, Texture> textures_loaded; // текстуры модели по пути из материала (ссылки в TextureCache)
     vector<Mesh>    meshes;          // вектор всех мешей модели
     string directory;                 // директория, содержащая модель
     bool gammaCorrection;             // флаг коррекции гамма-цвета
+    TextureStreamer* streamer;        // потоковая загрузка текстур (nullptr — синхронно через TextureFromFile)
+    unsigned int threads;             // потоков преобразования мешей ASSIMP (см. convertMeshes)
+
+    // Флаги импорта ASSIMP (с ними же модели готовит mesh_cooker)
+    static const unsigned int IMPORT_FLAGS = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs |
+                                             aiProcess_CalcTangentSpace;
+
+    // Конструктор, который принимает путь к 3D модели; со streamer текстуры материалов рисуются заглушками,
+    // пока streamer->update() не загрузит их. Файл .cmesh (mesh_cooker) загружается без ASSIMP.
+    // convertThreads — потоков преобразования мешей (0 — по числу ядер)
+    Model(string const &path, bool gamma = false, TextureStreamer* textureStreamer = nullptr, unsigned int convertThreads = 0)
+        : gammaCorrection(gamma), streamer(textureStreamer),
+          threads(convertThreads != 0 ? convertThreads : max(1u, std::thread::hardware_concurrency()))
+    {
+        if (path.size() > 6 && path.compare(path.size() - 6, 6, ".cmesh") == 0)
+            loadCooked(path);
+        else
+            loadModel(path);  // загрузить модель при создании объекта
+    }
+
+    // текстуры общие с другими моделями через TextureCache: копия модели отпустила бы их дважды
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
 
-    // Конструктор, который принимает путь к 3D модели
-    Model(string const &path, bool gamma = false) : gammaCorrection(gamma)
+    ~Model()
     {
-        loadModel(path);  // загрузить модель при создании объекта
+        for (auto& loaded : textures_loaded)
+            TextureCache::get().release(loaded.second.id);
+        for (Mesh& mesh : meshes)
+            mesh.geometry.destroy();
+    }
+
+    // Вершина i меша ASSIMP (так же её читает mesh_cooker)
+    static Vertex readVertex(const aiMesh *mesh, unsigned int i)
+    {
+        Vertex vertex = {}; // нули там, где у ASSIMP нет данных (упаковка в setupMesh читает все поля)
+        glm::vec3 vector; // временный вектор для передачи данных из ASSIMP в glm::vec3
+        // Позиции
+        vector.x = mesh->mVertices[i].x;
+        vector.y = mesh->mVertices[i].y;
+        vector.z = mesh->mVertices[i].z;
+        vertex.Position = vector;
+
+        // Нормали
+        if (mesh->HasNormals())
+        {
+            vector.x = mesh->mNormals[i].x;
+            vector.y = mesh->mNormals[i].y;
+            vector.z = mesh->mNormals[i].z;
+            vertex.Normal = vector;
+        }
+
+        // Текстурные координаты
+        if(mesh->mTextureCoords[0]) // проверяем наличие текстурных координат
+        {
+            glm::vec2 vec;
+            // Мы предполагаем, что используем только первый набор текстурных координат
+            vec.x = mesh->mTextureCoords[0][i].x;
+            vec.y = mesh->mTextureCoords[0][i].y;
+            vertex.TexCoords = vec;
+
+            // Тангенты и битангенты
+            vector.x = mesh->mTangents[i].x;
+            vector.y = mesh->mTangents[i].y;
+            vector.z = mesh->mTangents[i].z;
+            vertex.Tangent = vector;
+
+            vector.x = mesh->mBitangents[i].x;
+            vector.y = mesh->mBitangents[i].y;
+            vector.z = mesh->mBitangents[i].z;
+            vertex.Bitangent = vector;
+        }
+        else
+            vertex.TexCoords = glm::vec2(0.0f, 0.0f); // если нет текстурных координат, задаём (0,0)
+
+        return vertex;
+    }
+
+    // Треугольников в части меша, которую упаковывает один поток (см. convertMeshes)
+    static const size_t PACK_CHUNK_TRIANGLES = 65536;
+
+    // Меши сцены в порядке обхода узлов, преобразованные в MeshData (вершины, индексы, упакованная геометрия)
+    // в threads потоках; OpenGL не используется. Три этапа, каждый раздаёт задания потокам по одному:
+    //  чтение — вершины и индексы мешей ASSIMP, начиная с самых больших мешей;
+    //  упаковка — части по PACK_CHUNK_TRIANGLES треугольников, так что и модель из одного большого меша
+    //             делится между потоками; меш из одной части упаковывается сразу в MeshData::packed;
+    //  сборка — части каждого меша по порядку (IndexedGeometry::append): результат не зависит от числа потоков
+    //           и совпадает с MeshData::pack().
+    static vector<MeshData> convertMeshes(const aiScene *scene, unsigned int threads)
+    {
+        vector<const aiMesh*> sources;
+        collectMeshes(scene->mRootNode, scene, sources);
+        vector<size_t> order(sources.size());
+        for (size_t i = 0; i < order.size(); ++i)
+            order[i] = i;
+        std::stable_sort(order.begin(), order.end(),
+                         [&](size_t a, size_t b) { return sources[a]->mNumFaces > sources[b]->mNumFaces; });
+
+        vector<MeshData> converted(sources.size());
+        parallelFor(order.size(), threads, [&](size_t i) { readMesh(sources[order[i]], converted[order[i]]); });
+
+        struct Chunk
+        {
+            size_t mesh, first, last;
+            IndexedGeometry<PackedTangentSurface> part;
+            AABB bounds;
+        };
+        const size_t chunkIndices = PACK_CHUNK_TRIANGLES * 3;
+        vector<Chunk> chunks;
+        vector<size_t> firstChunk(converted.size() + 1);
+        for (size_t m = 0; m < converted.size(); ++m)
+        {
+            firstChunk[m] = chunks.size();
+            const size_t count = converted[m].indices.size();
+            for (size_t first = 0; first < count || first == 0; first += chunkIndices)
+                chunks.push_back({ m, first, min(first + chunkIndices, count), {}, {} });
+        }
+        firstChunk[converted.size()] = chunks.size();
+        parallelFor(chunks.size(), threads, [&](size_t c)
+        {
+            Chunk &chunk = chunks[c];
+            MeshData &data = converted[chunk.mesh];
+            bool whole = firstChunk[chunk.mesh + 1] - firstChunk[chunk.mesh] == 1;
+            IndexedGeometry<PackedTangentSurface> &out = whole ? data.packed : chunk.part;
+            out.beginMesh();
+            data.packRange(chunk.first, chunk.last, out, whole ? data.bounds : chunk.bounds);
+            if (whole)
+                data.range = out.endMesh();
+        });
+
+        parallelFor(converted.size(), threads, [&](size_t m)
+        {
+            MeshData &data = converted[m];
+            if (firstChunk[m + 1] - firstChunk[m] == 1)
+                return;
+            data.packed.beginMesh();
+            data.bounds = chunks[firstChunk[m]].bounds;
+            for (size_t c = firstChunk[m]; c < firstChunk[m + 1]; ++c)
+            {
+                data.packed.append(chunks[c].part);
+                chunks[c].part = IndexedGeometry<PackedTangentSurface>();
+                data.bounds.min = glm::min(data.bounds.min, chunks[c].bounds.min);
+                data.bounds.max = glm::max(data.bounds.max, chunks[c].bounds.max);
+            }
+            data.range = data.packed.endMesh();
+        });
+        return converted;
+    }
+
+    // Текстуры материала ASSIMP: тип (texture_diffuse, texture_specular, texture_normal, texture_height) и путь
+    static vector<CookedMesh::MaterialTexture> readMaterial(const aiMaterial *material)
+    {
+        static const pair<aiTextureType, const char*> types[] = {
+            { aiTextureType_DIFFUSE, "texture_diffuse" },
+            { aiTextureType_SPECULAR, "texture_specular" },
+            { aiTextureType_HEIGHT, "texture_normal" },
+            { aiTextureType_AMBIENT, "texture_height" } };
+        vector<CookedMesh::MaterialTexture> textures;
+        for (const auto& type : types)
+            for(unsigned int i = 0; i < material->GetTextureCount(type.first); i++)
+            {
+                aiString str;
+                material->GetTexture(type.first, i, &str);
+                textures.push_back({ type.second, str.C_Str() });
+            }
+        return textures;
     }
 
     // Метод для рисования модели (всех её мешей)
@@ -52,7 +220,7 @@ private:
     {
         // Чтение файла с помощью ASSIMP
         Assimp::Importer importer;
-        const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+        const aiScene* scene = importer.ReadFile(path, IMPORT_FLAGS);
 
         // Проверка на ошибки
         if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // если ошибка
@@ -62,151 +230,127 @@ private:
         }
 
         // Получение директории файла
-        directory = path.substr(0, path.find_last_of('/'));
-
-        // Рекурсивная обработка корневого узла ASSIMP
-        processNode(scene->mRootNode, scene);
+        directory = path.find_last_of('/') == string::npos ? string(".") : path.substr(0, path.find_last_of('/'));
+
+        // Преобразование мешей в потоках, затем в этом потоке (OpenGL) — текстуры материалов и буферы
+        vector<MeshData> converted = convertMeshes(scene, threads);
+        vector<vector<Texture>> materials(scene->mNumMaterials);
+        vector<bool> materialLoaded(scene->mNumMaterials, false);
+        meshes.reserve(converted.size());
+        for (MeshData &data : converted)
+        {
+            const unsigned int material = data.material;
+            if (!materialLoaded[material])
+            {
+                // Загрузка текстур для различных типов (диффузные, спекулярные, нормальные, высоты)
+                materials[material] = loadMaterialTextures(readMaterial(scene->mMaterials[material]));
+                materialLoaded[material] = true;
+            }
+            meshes.emplace_back(std::move(data), materials[material]);
+        }
     }
 
-    // Рекурсивный метод обработки узлов. Обрабатывает каждый меш на текущем узле и повторяет для дочерних узлов
-    void processNode(aiNode *node, const aiScene *scene)
+    // Рекурсивный обход узлов: меши текущего узла, затем дочерних
+    static void collectMeshes(const aiNode *node, const aiScene *scene, vector<const aiMesh*> &sources)
     {
-        // Обработка всех мешей на текущем узле
         for(unsigned int i = 0; i < node->mNumMeshes; i++)
-        {
-            // Индекс меша в сцене
-            aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-            meshes.push_back(processMesh(mesh, scene));  // обрабатываем меш и добавляем его в модель
-        }
-
-        // Рекурсивно обрабатываем дочерние узлы
+            sources.push_back(scene->mMeshes[node->mMeshes[i]]);
         for(unsigned int i = 0; i < node->mNumChildren; i++)
-        {
-            processNode(node->mChildren[i], scene);
-        }
+            collectMeshes(node->mChildren[i], scene, sources);
     }
 
-    // Метод для обработки меша: извлекает данные из ASSIMP и создаёт объект Mesh
-    Mesh processMesh(aiMesh *mesh, const aiScene *scene)
+    // Вершины и индексы одного меша: массивы выделяются сразу нужного размера
+    static void readMesh(const aiMesh *mesh, MeshData &data)
     {
-        // Данные для заполнения
-        vector<Vertex> vertices;
-        vector<unsigned int> indices;
-        vector<Texture> textures;
-
-        // Обработка каждого вертекса меша
+        data.material = mesh->mMaterialIndex;
+        data.vertices.resize(mesh->mNumVertices);
         for(unsigned int i = 0; i < mesh->mNumVertices; i++)
-        {
-            Vertex vertex;
-            glm::vec3 vector; // временный вектор для передачи данных из ASSIMP в glm::vec3
-            // Позиции
-            vector.x = mesh->mVertices[i].x;
-            vector.y = mesh->mVertices[i].y;
-            vector.z = mesh->mVertices[i].z;
-            vertex.Position = vector;
-
-            // Нормали
-            if (mesh->HasNormals())
-            {
-                vector.x = mesh->mNormals[i].x;
-                vector.y = mesh->mNormals[i].y;
-                vector.z = mesh->mNormals[i].z;
-                vertex.Normal = vector;
-            }
-
-            // Текстурные координаты
-            if(mesh->mTextureCoords[0]) // проверяем наличие текстурных координат
-            {
-                glm::vec2 vec;
-                // Мы предполагаем, что используем только первый набор текстурных координат
-                vec.x = mesh->mTextureCoords[0][i].x;
-                vec.y = mesh->mTextureCoords[0][i].y;
-                vertex.TexCoords = vec;
-
-                // Тангенты и битангенты
-                vector.x = mesh->mTangents[i].x;
-                vector.y = mesh->mTangents[i].y;
-                vector.z = mesh->mTangents[i].z;
-                vertex.Tangent = vector;
-
-                vector.x = mesh->mBitangents[i].x;
-                vector.y = mesh->mBitangents[i].y;
-                vector.z = mesh->mBitangents[i].z;
-                vertex.Bitangent = vector;
-            }
-            else
-                vertex.TexCoords = glm::vec2(0.0f, 0.0f); // если нет текстурных координат, задаём (0,0)
+            data.vertices[i] = readVertex(mesh, i);
 
-            vertices.push_back(vertex);  // добавляем вертекс в массив
-        }
-
-        // Обработка лиц (граней) меша (каждое лицо — это треугольник)
+        // Обработка лиц (граней) меша (после aiProcess_Triangulate каждое лицо — треугольник, но точки и линии
+        // остаются, поэтому размер считается по лицам)
+        size_t indexCount = 0;
+        for(unsigned int i = 0; i < mesh->mNumFaces; i++)
+            indexCount += mesh->mFaces[i].mNumIndices;
+        data.indices.reserve(indexCount);
         for(unsigned int i = 0; i < mesh->mNumFaces; i++)
         {
-            aiFace face = mesh->mFaces[i];
-            // Получаем индексы для каждого лица и добавляем их в массив индексов
-            for(unsigned int j = 0; j < face.mNumIndices; j++)
-                indices.push_back(face.mIndices[j]);
+            const aiFace &face = mesh->mFaces[i];
+            data.indices.insert(data.indices.end(), face.mIndices, face.mIndices + face.mNumIndices);
         }
+    }
 
-        // Обработка материалов
-        aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
-
-        // Загрузка текстур для различных типов (диффузные, спекулярные, нормальные, высоты)
-        vector<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
-        textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
-
-        vector<Texture> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
-        textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
-
-        std::vector<Texture> normalMaps = loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal");
-        textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
-
-        std::vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
-        textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
+    // function(i) для i из [0, count) в threads потоках (один из них — вызывающий); задания раздаются по одному
+    template <class Function>
+    static void parallelFor(size_t count, unsigned int threads, Function function)
+    {
+        std::atomic<size_t> next(0);
+        auto work = [&]()
+        {
+            for (size_t i = next++; i < count; i = next++)
+                function(i);
+        };
+        threads = (unsigned int)min((size_t)max(threads, 1u), max(count, (size_t)1));
+        vector<std::thread> workers;
+        for (unsigned int t = 1; t < threads; ++t)
+            workers.emplace_back(work);
+        work();
+        for (std::thread &worker : workers)
+            worker.join();
+    }
 
-        // Возвращаем объект Mesh, созданный из извлечённых данных
-        return Mesh(vertices, indices, textures);
+    // Загрузка подготовленной модели (.cmesh, см. CookedMesh): потоки мешей из отображённого в память файла
+    // сразу уходят в буферы GPU, без импорта и упаковки вершин
+    void loadCooked(string const &path)
+    {
+        CookedMesh cooked;
+        if (!cooked.open(path))
+        {
+            cout << "ERROR::COOKED_MESH:: cannot load " << path << endl;
+            return;
+        }
+        directory = path.find_last_of('/') == string::npos ? string(".") : path.substr(0, path.find_last_of('/'));
+        vector<vector<Texture>> materials;
+        for (int m = 0; m < cooked.materialCount(); ++m)
+            materials.push_back(loadMaterialTextures(cooked.material(m)));
+        for (int i = 0; i < cooked.meshCount(); ++i)
+        {
+            const CookedMesh::MeshView& view = cooked.mesh(i);
+            meshes.push_back(Mesh(view.streams, view.lods, view.bounds, materials[view.material]));
+        }
     }
 
-    // Метод для загрузки текстур из материала
-    vector<Texture> loadMaterialTextures(aiMaterial *mat, aiTextureType type, string typeName)
+    // Метод для загрузки текстур материала (тип и путь относительно директории модели)
+    vector<Texture> loadMaterialTextures(const vector<CookedMesh::MaterialTexture> &material)
     {
         vector<Texture> textures;
-        for(unsigned int i = 0; i < mat->GetTextureCount(type); i++)
+        for (const CookedMesh::MaterialTexture &entry : material)
         {
-            aiString str;
-            mat->GetTexture(type, i, &str);
-
-            // Проверка, была ли уже загружена текстура с таким путём
-            bool skip = false;
-            for(unsigned int j = 0; j < textures_loaded.size(); j++)
+            // Текстура с таким путём уже есть у модели — берём её
+            auto loaded = textures_loaded.find(entry.second);
+            if(loaded != textures_loaded.end())
             {
-                if(std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-                {
-                    textures.push_back(textures_loaded[j]);
-                    skip = true;  // если текстура уже загружена, пропускаем её загрузку
-                    break;
-                }
+                textures.push_back(loaded->second);
+                continue;
             }
-            if(!skip)
+            // Иначе — из общего кэша: файл, уже загруженный другой моделью (или с тем же содержимым), не загружается
+            Texture texture;
+            texture.id = TextureCache::get().acquire(this->directory + '/' + entry.second, [&](const string& file)
             {
-                // Если текстура не была загружена, загружаем её
-                Texture texture;
-                texture.id = TextureFromFile(str.C_Str(), this->directory);
-                texture.type = typeName;
-                texture.path = str.C_Str();
-                textures.push_back(texture);
-                textures_loaded.push_back(texture);  // сохраняем её как загруженную
-            }
+                return streamer != nullptr ? streamer->request(file) : TextureFromFile(entry.second.c_str(), this->directory);
+            }, streamer);
+            texture.type = entry.first;
+            texture.path = entry.second;
+            textures.push_back(texture);
+            textures_loaded[texture.path] = texture;  // сохраняем её как загруженную
         }
         return textures;
     }
 };
 
 
-// Функция для загрузки текстуры из файла
-unsigned int TextureFromFile(const char *path, const string &directory, bool gamma)
+// Функция для загрузки текстуры из файла (inline: заголовок включается из нескольких единиц трансляции)
+inline unsigned int TextureFromFile(const char *path, const string &directory, bool gamma)
 {
     // Создание полного пути к файлу текстуры
     string filename = string(path);
@@ -0,0 +1,185 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Дисковый кэш двоичных программ (glGetProgramBinary / glProgramBinary, OpenGL 4.1). Ключ программы —
+// 64-битный хэш FNV-1a исходников всех стадий (уже после подстановки #include и #define) и строк
+// GL_VENDOR, GL_RENDERER, GL_VERSION: другой драйвер или изменённый шейдер дают другой файл.
+// Драйвер вправе отвергнуть двоичную программу (например, после обновления) — тогда программа
+// компилируется из исходников как обычно, а файл перезаписывается. Включается enable() после загрузки GLAD,
+// до создания первой программы; заодно копит время создания программ (холодный и тёплый запуск).
+class ProgramBinaryCache
+{
+public:
+    static ProgramBinaryCache& get()
+    {
+        static ProgramBinaryCache instance;
+        return instance;
+    }
+
+    // кэш в директории directory (создаётся при необходимости); пустая строка — кэш выключен
+    void enable(const std::string& directory)
+    {
+        cacheDirectory.clear();
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        if (directory.empty() || formats == 0)
+            return;
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        if (error)
+        {
+            std::cout << "ERROR::PROGRAM_CACHE::CANNOT_CREATE_DIRECTORY: " << directory << std::endl;
+            return;
+        }
+        cacheDirectory = directory;
+        driver.clear();
+        for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+        {
+            const char* value = (const char*)glGetString(name);
+            driver += std::string(value != nullptr ? value : "") + "\n";
+        }
+    }
+
+    bool enabled() const { return !cacheDirectory.empty(); }
+
+    // ключ программы из исходников её стадий (пустые строки — отсутствующие стадии)
+    uint64_t key(const std::vector<std::string>& sources) const
+    {
+        uint64_t hash = 14695981039346656037ull;
+        auto mix = [&hash](const std::string& text) {
+            for (unsigned char c : text)
+                hash = (hash ^ c) * 1099511628211ull;
+            // разделитель, чтобы "ab" + "c" и "a" + "bc" не совпадали
+            hash = (hash ^ 0xFFu) * 1099511628211ull;
+        };
+        for (const std::string& source : sources)
+            mix(source);
+        mix(driver);
+        return hash;
+    }
+
+    // загрузить программу по ключу; при промахе или отказе драйвера program заменяется новой пустой программой
+    bool load(GLuint& program, uint64_t programKey)
+    {
+        if (!enabled())
+            return false;
+        std::ifstream file(path(programKey), std::ios::binary);
+        Header header;
+        std::vector<char> binary;
+        if (file && file.read((char*)&header, sizeof(header)) && header.magic == MAGIC && header.key == programKey)
+        {
+            binary.resize(header.length);
+            if (!file.read(binary.data(), binary.size()))
+                binary.clear();
+        }
+        if (binary.empty())
+        {
+            ++misses;
+            return false;
+        }
+        glProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size());
+        GLint linked = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!linked)
+        {
+            ++rejected;
+            glDeleteProgram(program);
+            program = glCreateProgram();
+            return false;
+        }
+        ++hits;
+        return true;
+    }
+
+    // перед линковкой программы, которую потом сохранит store()
+    void prepare(GLuint program) const
+    {
+        if (enabled())
+            glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    // сохранить слинкованную программу под ключом
+    void store(GLuint program, uint64_t programKey)
+    {
+        if (!enabled())
+            return;
+        GLint linked = 0, length = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (!linked || length <= 0)
+            return;
+        std::vector<char> binary(length);
+        Header header;
+        header.key = programKey;
+        glGetProgramBinary(program, length, &length, &header.format, binary.data());
+        header.length = (uint32_t)length;
+        // запись во временный файл и переименование: прерванная запись не оставит битый файл под ключом
+        std::string target = path(programKey);
+        std::string temporary = target + ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            if (!file.write((const char*)&header, sizeof(header)) || !file.write(binary.data(), length))
+                return;
+        }
+        std::error_code error;
+        std::filesystem::rename(temporary, target, error);
+        if (!error)
+            ++stored;
+    }
+
+    // время создания программы (чтение исходников, компиляция или загрузка, линковка)
+    void recordSetup(double seconds) { setupSeconds += seconds; ++programs; }
+
+    int programCount() const { return programs; }
+    int hitCount() const { return hits; }
+    int missCount() const { return misses; }
+    int rejectedCount() const { return rejected; }
+    int storedCount() const { return stored; }
+    double setupTime() const { return setupSeconds; }
+    // "off", "cold" (всё скомпилировано), "warm" (всё из кэша) или "mixed"
+    std::string state() const
+    {
+        if (!enabled())
+            return "off";
+        if (hits == 0)
+            return "cold";
+        return hits == programs ? "warm" : "mixed";
+    }
+
+private:
+    static const uint32_t MAGIC = 0x43425350; // "PSBC"
+
+    struct Header
+    {
+        uint32_t magic = MAGIC;
+        GLenum format = 0;
+        uint32_t length = 0;
+        uint64_t key = 0;
+    };
+
+    std::string cacheDirectory;
+    std::string driver;
+    int programs = 0, hits = 0, misses = 0, rejected = 0, stored = 0;
+    double setupSeconds = 0.0;
+
+    ProgramBinaryCache() {}
+
+    std::string path(uint64_t programKey) const
+    {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)programKey);
+        return (std::filesystem::path(cacheDirectory) / name).string();
+    }
+};
+
+#endif
@@ -0,0 +1,264 @@
+#ifndef SCENE_SUBMIT_H
+#define SCENE_SUBMIT_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <opengllibs/vertex_format.h>
+
+#include <cstddef>
+#include <vector>
+
+// Данные одного экземпляра: матрица модели и целочисленные параметры (x — грань кубической карты
+// для слоистого прохода теней, остальное свободно)
+struct InstanceData
+{
+    glm::mat4 model;
+    glm::ivec4 params;
+};
+
+// Партия отрисовки: непрерывный диапазон команд, рисуемых в одном состоянии конвейера
+struct DrawBatch
+{
+    GLuint firstCommand = 0;
+    GLsizei commandCount = 0;
+
+    bool empty() const { return commandCount == 0; }
+};
+
+// Способ отправки партии:
+//  DIRECT    — вызов отрисовки на каждый объект (как рисовалась сцена раньше, для сравнения);
+//  INSTANCED — один glDrawElementsInstanced на каждую команду (меш + непрерывный диапазон экземпляров);
+//  INDIRECT  — одна glMultiDrawElementsIndirect на всю партию, команды лежат в GL_DRAW_INDIRECT_BUFFER.
+enum SubmitMode
+{
+    SUBMIT_DIRECT,
+    SUBMIT_INSTANCED,
+    SUBMIT_INDIRECT,
+    SUBMIT_MODE_COUNT
+};
+
+// Отправка сцены партиями экземпляров. За кадр все партии всех проходов сначала собираются на CPU
+// (beginBatch/add/endBatch), затем upload() загружает экземпляры и команды в буферы OpenGL одним
+// обновлением каждого, и только после этого партии рисуются (draw). Количество вызовов отрисовки
+// зависит от количества партий и мешей, а не от количества объектов.
+//
+// Меши — диапазоны индексов одного из GeometryBuffers (create, addGeometry; у каждого свои формат индексов и
+// VAO, например буферы подготовленной модели, созданные прямо из отображённого файла). Партия рисуется из потока
+// глубины или из полного потока (GeometryBuffers::Stream), команды при этом одни и те же; подряд идущие
+// команды одних буферов рисуются вместе, на каждую смену буферов — своя привязка VAO (и свой вызов INDIRECT).
+// Матрица модели и параметры экземпляра — атрибуты экземпляра (glVertexAttribDivisor = 1) в локациях
+// firstLocation..firstLocation + 3 (mat4) и firstLocation + 4 (ivec4) обоих VAO. Начальный экземпляр команды
+// задаётся через baseInstance (OpenGL 4.2); без него атрибуты перенастраиваются на начало диапазона.
+class SceneSubmitter
+{
+public:
+    struct DrawElementsIndirectCommand
+    {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+
+    ~SceneSubmitter()
+    {
+        if (instanceVBO != 0)
+            glDeleteBuffers(1, &instanceVBO);
+        if (commandBuffer != 0)
+            glDeleteBuffers(1, &commandBuffer);
+    }
+
+    SceneSubmitter() {}
+    SceneSubmitter(const SceneSubmitter&) = delete;
+    SceneSubmitter& operator=(const SceneSubmitter&) = delete;
+
+    // meshes — буферы мешей (индекс 0 в add()); в оба её VAO добавляются атрибуты экземпляров
+    void create(const GeometryBuffers& meshes, GLuint firstLocation)
+    {
+        location = firstLocation;
+        baseInstanceSupported = GLAD_GL_VERSION_4_2 && glDrawElementsInstancedBaseInstance != NULL;
+        indirectSupported = GLAD_GL_VERSION_4_3 && glMultiDrawElementsIndirect != NULL;
+
+        glGenBuffers(1, &instanceVBO);
+        glGenBuffers(1, &commandBuffer);
+        addGeometry(meshes);
+    }
+
+    // ещё одни буферы мешей (после create); возвращает их индекс для add(). Локации атрибутов экземпляров
+    // в формате буферов должны быть свободны
+    int addGeometry(const GeometryBuffers& meshes)
+    {
+        geometries.push_back(meshes);
+        const GeometryBuffers::Stream streams[] = { GeometryBuffers::DEPTH, GeometryBuffers::SURFACE };
+        for (GeometryBuffers::Stream stream : streams)
+        {
+            glBindVertexArray(meshes.vao(stream));
+            for (GLuint column = 0; column < 5; ++column)
+            {
+                glEnableVertexAttribArray(location + column);
+                glVertexAttribDivisor(location + column, 1);
+            }
+            pointInstances(0);
+        }
+        glBindVertexArray(0);
+        return (int)geometries.size() - 1;
+    }
+
+    bool indirectAvailable() const { return indirectSupported; }
+
+    // начать сборку кадра
+    void beginFrame()
+    {
+        instances.clear();
+        commands.clear();
+        commandGeometry.clear();
+    }
+
+    void beginBatch()
+    {
+        batch.firstCommand = (GLuint)commands.size();
+        batch.commandCount = 0;
+    }
+
+    // добавить экземпляр меша из буферов geometry в текущую партию; подряд идущие экземпляры одного меша —
+    // одна команда
+    void add(const MeshRange& mesh, const InstanceData& instance, int geometry = 0)
+    {
+        if (batch.commandCount == 0 || !(commandMesh(commands.back()) == mesh) || commandGeometry.back() != geometry)
+        {
+            DrawElementsIndirectCommand command;
+            command.count = (GLuint)mesh.count;
+            command.instanceCount = 0;
+            command.firstIndex = mesh.firstIndex;
+            command.baseVertex = 0;
+            command.baseInstance = (GLuint)instances.size();
+            commands.push_back(command);
+            commandGeometry.push_back(geometry);
+            ++batch.commandCount;
+        }
+        ++commands.back().instanceCount;
+        instances.push_back(instance);
+    }
+
+    DrawBatch endBatch()
+    {
+        return batch;
+    }
+
+    // загрузить экземпляры и команды кадра (орфанинг старого хранилища, при нехватке места — рост буфера)
+    void upload()
+    {
+        uploadBuffer(GL_ARRAY_BUFFER, instanceVBO, instanceCapacity, instances.data(), instances.size() * sizeof(InstanceData));
+        uploadBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer, commandCapacity, commands.data(),
+                     commands.size() * sizeof(DrawElementsIndirectCommand));
+    }
+
+    // нарисовать партию из потока stream; программа и состояние конвейера уже установлены
+    void draw(const DrawBatch& drawBatch, SubmitMode mode, GeometryBuffers::Stream stream)
+    {
+        if (drawBatch.empty())
+            return;
+        if (mode == SUBMIT_INDIRECT && !indirectSupported)
+            mode = SUBMIT_INSTANCED;
+        const GLuint end = drawBatch.firstCommand + (GLuint)drawBatch.commandCount;
+        for (GLuint first = drawBatch.firstCommand, last; first < end; first = last)
+        {
+            // команды одних и тех же буферов подряд
+            last = first + 1;
+            while (last < end && commandGeometry[last] == commandGeometry[first])
+                ++last;
+            const GeometryBuffers& geometry = geometries[commandGeometry[first]];
+            glBindVertexArray(geometry.vao(stream));
+            if (mode == SUBMIT_INDIRECT)
+            {
+                glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+                glMultiDrawElementsIndirect(GL_TRIANGLES, geometry.indexType,
+                                            (const void*)(first * sizeof(DrawElementsIndirectCommand)),
+                                            (GLsizei)(last - first), 0);
+                glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+                ++drawCalls;
+                continue;
+            }
+            for (GLuint c = first; c < last; ++c)
+            {
+                const DrawElementsIndirectCommand& command = commands[c];
+                if (mode == SUBMIT_INSTANCED)
+                    drawInstances(geometry, command.firstIndex, command.count, command.baseInstance, command.instanceCount);
+                else
+                    for (GLuint i = 0; i < command.instanceCount; ++i)
+                        drawInstances(geometry, command.firstIndex, command.count, command.baseInstance + i, 1);
+            }
+        }
+        // VAO остаётся привязанным: следующая партия того же потока не перепривязывает его
+    }
+
+    // статистика: экземпляров в кадре и вызовов отрисовки с последнего resetDrawCalls()
+    size_t instanceCount() const { return instances.size(); }
+    unsigned long long drawCallCount() const { return drawCalls; }
+    void resetDrawCalls() { drawCalls = 0; }
+
+private:
+    std::vector<GeometryBuffers> geometries;
+    GLuint location = 0;
+    unsigned int instanceVBO = 0;
+    unsigned int commandBuffer = 0;
+    size_t instanceCapacity = 0;
+    size_t commandCapacity = 0;
+    bool baseInstanceSupported = false;
+    bool indirectSupported = false;
+    std::vector<InstanceData> instances;
+    std::vector<DrawElementsIndirectCommand> commands;
+    std::vector<int> commandGeometry; // буферы каждой команды (индекс в geometries)
+    DrawBatch batch;
+    unsigned long long drawCalls = 0;
+
+    static MeshRange commandMesh(const DrawElementsIndirectCommand& command)
+    {
+        MeshRange mesh;
+        mesh.firstIndex = command.firstIndex;
+        mesh.count = (GLsizei)command.count;
+        return mesh;
+    }
+
+    static void uploadBuffer(GLenum target, unsigned int buffer, size_t& capacity, const void* data, size_t size)
+    {
+        if (size == 0)
+            return;
+        glBindBuffer(target, buffer);
+        if (size > capacity)
+            capacity = size + size / 2;
+        glBufferData(target, capacity, NULL, GL_STREAM_DRAW);
+        glBufferSubData(target, 0, size, data);
+        glBindBuffer(target, 0);
+    }
+
+    // атрибуты экземпляров начинаются с экземпляра base (VAO привязан)
+    void pointInstances(GLuint base) const
+    {
+        const size_t offset = base * sizeof(InstanceData);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        for (GLuint column = 0; column < 4; ++column)
+            glVertexAttribPointer(location + column, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+                                  (void*)(offset + offsetof(InstanceData, model) + column * sizeof(glm::vec4)));
+        glVertexAttribIPointer(location + 4, 4, GL_INT, sizeof(InstanceData), (void*)(offset + offsetof(InstanceData, params)));
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void drawInstances(const GeometryBuffers& geometry, GLuint firstIndex, GLuint count, GLuint baseInstance, GLuint instanceCount)
+    {
+        const void* indices = (const void*)(firstIndex * geometry.indexSize());
+        if (baseInstanceSupported)
+            glDrawElementsInstancedBaseInstance(GL_TRIANGLES, (GLsizei)count, geometry.indexType, indices, (GLsizei)instanceCount,
+                                                baseInstance);
+        else
+        {
+            pointInstances(baseInstance);
+            glDrawElementsInstanced(GL_TRIANGLES, (GLsizei)count, geometry.indexType, indices, (GLsizei)instanceCount);
+        }
+        ++drawCalls;
+    }
+};
+
+#endif
@@ -4,19 +4,54 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <opengllibs/program_cache.h>
+
+#include <chrono>
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <unordered_map>
+#include <vector>
+
+// GL_KHR_parallel_shader_compile / GL_ARB_parallel_shader_compile (в сгенерированном GLAD их нет)
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+// макросы варианта программы: "NAME" или "NAME VALUE", подставляются строками #define сразу после #version
+typedef std::vector<std::string> ShaderDefines;
 
 class Shader
 {
 public:
     unsigned int ID;
-    // конструктор генерирует шейдер на лету
+
+    // Типизированный дескриптор униформы: положение, полученное один раз после линковки.
+    // Дескрипторы запрашиваются через uniform<T>() вне цикла рендеринга и передаются в set() —
+    // тогда в горячем цикле нет ни работы со строками, ни вызовов glGetUniformLocation.
+    // Невалидный дескриптор (униформы нет или она выброшена компилятором) set() молча пропускает.
+    template <typename T>
+    struct Uniform
+    {
+        GLint location = -1;
+        GLint count = 0; // размер массива (1 для обычной униформы)
+
+        bool valid() const { return location >= 0; }
+    };
+
+    // конструктор генерирует шейдер на лету (или загружает программу из ProgramBinaryCache, если она там есть)
     // ------------------------------------------------------------------------
     Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr)
+        : Shader(vertexPath, fragmentPath, geometryPath, ShaderDefines(), false)
+    {
+    }
+    // вариант программы с макросами defines. async: компиляция и линковка только запускаются, результат
+    // проверяет finish() (его же вызывает use()); пока программа не завершена, униформ в таблице нет
+    // ------------------------------------------------------------------------
+    Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath, const ShaderDefines &defines, bool async)
     {
+        auto setupStart = std::chrono::steady_clock::now();
         // 1. извлечение исходного кода вершинного/фрагментного шейдера из filePath
         std::string vertexCode; // содержимое вершинного шейдера
         std::string fragmentCode; // содержимое фрагментного шейдера
@@ -43,6 +78,9 @@ public:
             // преобразовать поток в строку
             vertexCode = vShaderStream.str();
             fragmentCode = fShaderStream.str();			
+            // подставить макросы варианта и файлы из директив #include "file" (пути относительно включающего файла)
+            vertexCode = expandIncludes(injectDefines(vertexCode, defines), vertexPath, 0);
+            fragmentCode = expandIncludes(injectDefines(fragmentCode, defines), fragmentPath, 0);
             // если путь к геометрическому шейдеру указан, загрузить также геометрический шейдер
             if(geometryPath != nullptr)
             {
@@ -51,122 +89,404 @@ public:
                 gShaderStream << gShaderFile.rdbuf();
                 gShaderFile.close();
                 geometryCode = gShaderStream.str();
+                geometryCode = expandIncludes(injectDefines(geometryCode, defines), geometryPath, 0);
             }
         }
         catch (std::ifstream::failure& e)
         {
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
         }
-        // преобразование строки в char*
-        const char* vShaderCode = vertexCode.c_str();
-        const char * fShaderCode = fragmentCode.c_str();
-        // 2. компилирование шейдеров
-        unsigned int vertex, fragment;
-        // вершинный шейдер
-        vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vShaderCode, NULL);
-        glCompileShader(vertex);
-        checkCompileErrors(vertex, "VERTEX");
-        // фрагментный шейдер
-        fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderCode, NULL);
-        glCompileShader(fragment);
-        checkCompileErrors(fragment, "FRAGMENT");
-        // если геометрический шейдер задан, скомпилировать геометрический шейдер
-        unsigned int geometry;
-        if(geometryPath != nullptr)
+        // shader Program
+        ID = glCreateProgram();
+        // 2. двоичная программа из кэша: компиляция и линковка не нужны
+        ProgramBinaryCache& cache = ProgramBinaryCache::get();
+        const uint64_t cacheKey = cache.key({ vertexCode, fragmentCode, geometryCode });
+        pendingKey = cacheKey;
+        if (!cache.load(ID, cacheKey))
+            compileAndLink(vertexCode, fragmentCode, geometryPath != nullptr ? &geometryCode : nullptr);
+        setupSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - setupStart).count();
+        // 3. проверка результата и таблица положений всех активных униформ
+        if (!async || pendingStages.empty())
+            finish();
+    }
+    // вычислительная программа из одного файла (OpenGL 4.3 или GL_ARB_compute_shader)
+    // ------------------------------------------------------------------------
+    explicit Shader(const char* computePath)
+    {
+        auto setupStart = std::chrono::steady_clock::now();
+        std::string computeCode;
+        std::ifstream cShaderFile;
+        cShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
+        try
         {
-            const char * gShaderCode = geometryCode.c_str();
-            geometry = glCreateShader(GL_GEOMETRY_SHADER);
-            glShaderSource(geometry, 1, &gShaderCode, NULL);
-            glCompileShader(geometry);
-            checkCompileErrors(geometry, "GEOMETRY");
+            cShaderFile.open(computePath);
+            std::stringstream cShaderStream;
+            cShaderStream << cShaderFile.rdbuf();
+            cShaderFile.close();
+            computeCode = expandIncludes(cShaderStream.str(), computePath, 0);
+        }
+        catch (std::ifstream::failure& e)
+        {
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
         }
-        // shader Program
         ID = glCreateProgram();
-        // привязка шейдера к нашей программе (ID - объект программы, к которому будет присоединен объект шейдера).
-        // shader (vertex) - объект шейдера, который должен быть присоединен.
-        glAttachShader(ID, vertex);
-        glAttachShader(ID, fragment);
-        if(geometryPath != nullptr)
-            glAttachShader(ID, geometry);
-        // линковка шейдера
-        glLinkProgram(ID);
-        checkCompileErrors(ID, "PROGRAM");
-        // удалить шейдеры, так как они уже связаны с нашей программой и больше не нужны
-        glDeleteShader(vertex);
-        glDeleteShader(fragment);
-        if(geometryPath != nullptr)
-            glDeleteShader(geometry);
-
+        ProgramBinaryCache& cache = ProgramBinaryCache::get();
+        // стадия в ключе помечена, чтобы вычислительная программа не совпала с графической
+        const uint64_t cacheKey = cache.key({ "compute", computeCode });
+        pendingKey = cacheKey;
+        if (!cache.load(ID, cacheKey))
+        {
+            compileStage(GL_COMPUTE_SHADER, computeCode, "COMPUTE");
+            glAttachShader(ID, pendingStages.back());
+            cache.prepare(ID);
+            glLinkProgram(ID);
+        }
+        setupSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - setupStart).count();
+        finish();
     }
     // активировать шейдер
     // ------------------------------------------------------------------------
     void use()
     {
+        finish();
         glUseProgram(ID);
     }
+    // асинхронная программа: закончили ли драйверные потоки компиляцию и линковку (без ожидания).
+    // Без GL_KHR_parallel_shader_compile узнать это нельзя, и незавершённая программа считается неготовой
+    // ------------------------------------------------------------------------
+    bool compileFinished() const
+    {
+        if (!pending)
+            return true;
+        if (!parallelCompile())
+            return false;
+        GLint complete = 0;
+        glGetProgramiv(ID, GL_COMPLETION_STATUS_KHR, &complete);
+        return complete != 0;
+    }
+    bool finished() const { return !pending; }
+    // проверить компиляцию и линковку (при необходимости дождавшись их), сохранить программу в кэш,
+    // заполнить таблицу униформ; для завершённой программы ничего не делает
+    // ------------------------------------------------------------------------
+    void finish()
+    {
+        if (!pending)
+            return;
+        pending = false;
+        auto finishStart = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < pendingStages.size(); ++i)
+        {
+            checkCompileErrors(pendingStages[i], pendingStageTypes[i]);
+            glDeleteShader(pendingStages[i]);
+        }
+        if (!pendingStages.empty())
+        {
+            checkCompileErrors(ID, "PROGRAM");
+            ProgramBinaryCache::get().store(ID, pendingKey);
+        }
+        pendingStages.clear();
+        pendingStageTypes.clear();
+        introspectUniforms();
+        setupSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - finishStart).count();
+        ProgramBinaryCache::get().recordSetup(setupSeconds);
+    }
+    // драйвер компилирует программы в своих потоках (GL_KHR_parallel_shader_compile включено)
+    static bool& parallelCompile()
+    {
+        static bool enabled = false;
+        return enabled;
+    }
+    // дескриптор униформы name типа T; для массива name — имя без индекса (или "name[i]" для элемента)
+    // ------------------------------------------------------------------------
+    template <typename T>
+    Uniform<T> uniform(const std::string &name) const
+    {
+        Uniform<T> handle;
+        auto it = uniforms.find(name);
+        if (it == uniforms.end())
+            return handle;
+        if (!typeMatches(it->second.type, (const T*)nullptr))
+        {
+            std::cout << "ERROR::SHADER::UNIFORM_TYPE_MISMATCH: " << name << std::endl;
+            return handle;
+        }
+        handle.location = it->second.location;
+        handle.count = it->second.count;
+        return handle;
+    }
+    // привязать блок униформ name к точке привязки binding (если блок есть в программе)
+    // ------------------------------------------------------------------------
+    void bindUniformBlock(const std::string &name, GLuint binding) const
+    {
+        GLuint index = glGetUniformBlockIndex(ID, name.c_str());
+        if (index != GL_INVALID_INDEX)
+            glUniformBlockBinding(ID, index, binding);
+    }
+    // установка значений по дескрипторам
+    // ------------------------------------------------------------------------
+    void set(Uniform<int> u, int value) const
+    {
+        if (u.valid())
+            glUniform1i(u.location, value);
+    }
+    void set(Uniform<float> u, float value) const
+    {
+        if (u.valid())
+            glUniform1f(u.location, value);
+    }
+    void set(Uniform<glm::vec2> u, const glm::vec2 &value) const
+    {
+        if (u.valid())
+            glUniform2fv(u.location, 1, &value[0]);
+    }
+    void set(Uniform<glm::vec3> u, const glm::vec3 &value) const
+    {
+        if (u.valid())
+            glUniform3fv(u.location, 1, &value[0]);
+    }
+    void set(Uniform<glm::vec4> u, const glm::vec4 &value) const
+    {
+        if (u.valid())
+            glUniform4fv(u.location, 1, &value[0]);
+    }
+    void set(Uniform<glm::mat3> u, const glm::mat3 &mat) const
+    {
+        if (u.valid())
+            glUniformMatrix3fv(u.location, 1, GL_FALSE, &mat[0][0]);
+    }
+    void set(Uniform<glm::mat4> u, const glm::mat4 &mat) const
+    {
+        if (u.valid())
+            glUniformMatrix4fv(u.location, 1, GL_FALSE, &mat[0][0]);
+    }
+    // массив матриц одним вызовом (не больше размера массива в шейдере)
+    void set(Uniform<glm::mat4> u, const glm::mat4 *mats, int count) const
+    {
+        if (u.valid())
+            glUniformMatrix4fv(u.location, count < u.count ? count : u.count, GL_FALSE, &mats[0][0][0]);
+    }
+
     // вспомогательные функции для униформ, для установки их значений, которые будут использоваться в шейдере
+    // (поиск по имени в таблице униформ; в горячем цикле лучше использовать дескрипторы)
     // ------------------------------------------------------------------------
     void setBool(const std::string &name, bool value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+        glUniform1i(location(name), (int)value);
     }
 
     // ------------------------------------------------------------------------
     void setInt(const std::string &name, int value) const
     { 
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
+        glUniform1i(location(name), value); 
     }
     // ------------------------------------------------------------------------
     void setFloat(const std::string &name, float value) const
     { 
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
+        glUniform1f(location(name), value); 
     }
     // ------------------------------------------------------------------------
     void setVec2(const std::string &name, const glm::vec2 &value) const
     { 
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        glUniform2fv(location(name), 1, &value[0]); 
     }
     void setVec2(const std::string &name, float x, float y) const
     { 
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y); 
+        glUniform2f(location(name), x, y); 
     }
     // ------------------------------------------------------------------------
     void setVec3(const std::string &name, const glm::vec3 &value) const
     { 
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        glUniform3fv(location(name), 1, &value[0]); 
     }
     void setVec3(const std::string &name, float x, float y, float z) const
     { 
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z); 
+        glUniform3f(location(name), x, y, z); 
     }
     // ------------------------------------------------------------------------
     void setVec4(const std::string &name, const glm::vec4 &value) const
     { 
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        glUniform4fv(location(name), 1, &value[0]); 
     }
     void setVec4(const std::string &name, float x, float y, float z, float w) 
     { 
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w); 
+        glUniform4f(location(name), x, y, z, w); 
     }
     // ------------------------------------------------------------------------
     void setMat2(const std::string &name, const glm::mat2 &mat) const
     {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix2fv(location(name), 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
     void setMat3(const std::string &name, const glm::mat3 &mat) const
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix3fv(location(name), 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
     void setMat4(const std::string &name, const glm::mat4 &mat) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix4fv(location(name), 1, GL_FALSE, &mat[0][0]);
+    }
+
+    // положение униформы по имени (-1, если её нет); без обращения к OpenGL
+    GLint location(const std::string &name) const
+    {
+        auto it = uniforms.find(name);
+        return it == uniforms.end() ? -1 : it->second.location;
     }
 
 private:
+    bool pending = true;                       // программа ещё не проверена (см. finish)
+    std::vector<unsigned int> pendingStages;   // объекты стадий до проверки компиляции
+    std::vector<std::string> pendingStageTypes;
+    uint64_t pendingKey = 0;                   // ключ программы в ProgramBinaryCache
+    double setupSeconds = 0.0;                 // время основного потока на создание программы
+
+    // запуск компиляции стадий и линковки программы ID; результат проверяет finish(), поэтому с параллельной
+    // компиляцией драйвера эти вызовы не ждут её окончания
+    void compileAndLink(const std::string &vertexCode, const std::string &fragmentCode, const std::string *geometryCode)
+    {
+        compileStage(GL_VERTEX_SHADER, vertexCode, "VERTEX");
+        compileStage(GL_FRAGMENT_SHADER, fragmentCode, "FRAGMENT");
+        // если геометрический шейдер задан, скомпилировать геометрический шейдер
+        if (geometryCode != nullptr)
+            compileStage(GL_GEOMETRY_SHADER, *geometryCode, "GEOMETRY");
+        // привязка шейдеров к нашей программе (ID - объект программы, к которому будет присоединен объект шейдера)
+        for (unsigned int stage : pendingStages)
+            glAttachShader(ID, stage);
+        // линковка шейдера (с разрешением забрать двоичную программу для кэша)
+        ProgramBinaryCache::get().prepare(ID);
+        glLinkProgram(ID);
+    }
+
+    void compileStage(GLenum type, const std::string &code, const char* typeName)
+    {
+        const char* source = code.c_str();
+        unsigned int stage = glCreateShader(type);
+        glShaderSource(stage, 1, &source, NULL);
+        glCompileShader(stage);
+        pendingStages.push_back(stage);
+        pendingStageTypes.push_back(typeName);
+    }
+
+    // строки #define для defines сразу после строки #version (или в начало, если её нет)
+    static std::string injectDefines(const std::string &code, const ShaderDefines &defines)
+    {
+        if (defines.empty())
+            return code;
+        std::string lines;
+        for (const std::string &define : defines)
+            lines += "#define " + define + "\n";
+        size_t version = code.find("#version");
+        if (version == std::string::npos)
+            return lines + code;
+        size_t lineEnd = code.find('\n', version);
+        if (lineEnd == std::string::npos)
+            return code + "\n" + lines;
+        return code.substr(0, lineEnd + 1) + lines + code.substr(lineEnd + 1);
+    }
+
+    // Подстановка директив #include "file" (в GLSL без расширений их нет): строка директивы заменяется
+    // содержимым файла, путь берётся относительно директории включающего файла, вложенность ограничена.
+    // Общий код нескольких программ (например, фильтры теней) живёт в одном файле .glsl
+    static std::string expandIncludes(const std::string &code, const std::string &path, int depth)
+    {
+        const std::string directive = "#include";
+        std::string directory;
+        size_t slash = path.find_last_of("/\\");
+        if (slash != std::string::npos)
+            directory = path.substr(0, slash + 1);
+        std::istringstream lines(code);
+        std::string result, line;
+        while (std::getline(lines, line))
+        {
+            size_t start = line.find_first_not_of(" \t");
+            size_t open = line.find('"');
+            size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+            if (start == std::string::npos || line.compare(start, directive.size(), directive) != 0 ||
+                close == std::string::npos)
+            {
+                result += line + "\n";
+                continue;
+            }
+            std::string includePath = directory + line.substr(open + 1, close - open - 1);
+            std::ifstream file(includePath);
+            if (!file || depth >= 8)
+            {
+                std::cout << "ERROR::SHADER::INCLUDE_NOT_READ: " << includePath << std::endl;
+                continue;
+            }
+            std::stringstream stream;
+            stream << file.rdbuf();
+            result += expandIncludes(stream.str(), includePath, depth + 1);
+        }
+        return result;
+    }
+
+    struct UniformInfo
+    {
+        GLint location;
+        GLenum type;
+        GLint count;
+    };
+    std::unordered_map<std::string, UniformInfo> uniforms;
+
+    // заполнить таблицу униформ по активным униформам слинкованной программы (glGetActiveUniform);
+    // массив регистрируется под именем без индекса и под именем каждого элемента "name[i]"
+    // ------------------------------------------------------------------------
+    void introspectUniforms()
+    {
+        GLint active = 0, maxLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &active);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::vector<GLchar> buffer(maxLength > 0 ? maxLength : 1);
+        for (GLint i = 0; i < active; ++i)
+        {
+            GLsizei length = 0;
+            GLint count = 0;
+            GLenum type = 0;
+            glGetActiveUniform(ID, (GLuint)i, (GLsizei)buffer.size(), &length, &count, &type, buffer.data());
+            std::string name(buffer.data(), length);
+            GLint loc = glGetUniformLocation(ID, name.c_str());
+            if (loc < 0)
+                continue; // член блока униформ — задаётся через буфер, а не glUniform*
+            if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+            {
+                std::string base = name.substr(0, name.size() - 3);
+                uniforms[base] = { loc, type, count };
+                for (GLint element = 0; element < count; ++element)
+                {
+                    std::string elementName = base + "[" + std::to_string(element) + "]";
+                    GLint elementLoc = element == 0 ? loc : glGetUniformLocation(ID, elementName.c_str());
+                    uniforms[elementName] = { elementLoc, type, count - element };
+                }
+            }
+            else
+                uniforms[name] = { loc, type, count };
+        }
+    }
+
+    // соответствие типа C++ типу униформы GLSL
+    // ------------------------------------------------------------------------
+    static bool typeMatches(GLenum type, const int*)
+    {
+        switch (type)
+        {
+        case GL_INT: case GL_BOOL:
+        case GL_SAMPLER_2D: case GL_SAMPLER_CUBE: case GL_SAMPLER_2D_SHADOW: case GL_SAMPLER_CUBE_SHADOW:
+        case GL_SAMPLER_CUBE_MAP_ARRAY: case GL_SAMPLER_CUBE_MAP_ARRAY_SHADOW: case GL_SAMPLER_2D_ARRAY:
+        case GL_SAMPLER_BUFFER: case GL_INT_SAMPLER_BUFFER: case GL_UNSIGNED_INT_SAMPLER_BUFFER:
+            return true;
+        default:
+            return false;
+        }
+    }
+    static bool typeMatches(GLenum type, const float*) { return type == GL_FLOAT; }
+    static bool typeMatches(GLenum type, const glm::vec2*) { return type == GL_FLOAT_VEC2; }
+    static bool typeMatches(GLenum type, const glm::vec3*) { return type == GL_FLOAT_VEC3; }
+    static bool typeMatches(GLenum type, const glm::vec4*) { return type == GL_FLOAT_VEC4; }
+    static bool typeMatches(GLenum type, const glm::mat3*) { return type == GL_FLOAT_MAT3; }
+    static bool typeMatches(GLenum type, const glm::mat4*) { return type == GL_FLOAT_MAT4; }
+
     // вспомогательная функция для проверки ошибок компиляции/линковки шейдера
     // ------------------------------------------------------------------------
     void checkCompileErrors(GLuint shader, std::string type)
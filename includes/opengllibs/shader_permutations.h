@@ -0,0 +1,107 @@
+#ifndef SHADER_PERMUTATIONS_H
+#define SHADER_PERMUTATIONS_H
+
+#include <glad/glad.h>
+
+#include <opengllibs/shader.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Варианты (специализации) одной программы: общие файлы стадий, у каждого варианта свой набор #define.
+// Все варианты запускаются на компиляцию сразу (add), а poll() раз в кадр забирает готовые без ожидания:
+// с GL_KHR_parallel_shader_compile драйвер компилирует их в своих потоках, без расширения poll() завершает
+// не больше одного варианта за вызов, чтобы ожидание компиляции распределялось по кадрам. Пока вариант
+// не готов, get() возвращает nullptr и вызывающий код рисует запасной программой.
+class ShaderPermutations
+{
+public:
+    ShaderPermutations(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr)
+        : vertex(vertexPath), fragment(fragmentPath), geometry(geometryPath != nullptr ? geometryPath : "")
+    {
+    }
+
+    // включить параллельную компиляцию драйвера (GL_KHR_parallel_shader_compile или
+    // GL_ARB_parallel_shader_compile): функции расширения берутся через загрузчик контекста
+    static bool enableParallelCompile(GLADloadproc loader)
+    {
+        typedef void (APIENTRYP MaxShaderCompilerThreadsProc)(GLuint count);
+        MaxShaderCompilerThreadsProc maxThreads = (MaxShaderCompilerThreadsProc)loader("glMaxShaderCompilerThreadsKHR");
+        if (maxThreads == nullptr)
+            maxThreads = (MaxShaderCompilerThreadsProc)loader("glMaxShaderCompilerThreadsARB");
+        if (maxThreads == nullptr)
+            return false;
+        // 0xFFFFFFFF — количество потоков выбирает драйвер
+        maxThreads(0xFFFFFFFFu);
+        Shader::parallelCompile() = true;
+        return true;
+    }
+
+    // запустить компиляцию варианта с макросами defines; возвращает номер варианта
+    int add(const ShaderDefines& defines)
+    {
+        variants.emplace_back(new Shader(vertex.c_str(), fragment.c_str(), geometry.empty() ? nullptr : geometry.c_str(),
+                                         defines, true));
+        announced.push_back(false);
+        return (int)variants.size() - 1;
+    }
+
+    // завершить готовые варианты; возвращает номера вариантов, ставших доступными в этом вызове
+    std::vector<int> poll()
+    {
+        std::vector<int> ready;
+        bool mayWait = !Shader::parallelCompile();
+        for (size_t i = 0; i < variants.size(); ++i)
+        {
+            if (announced[i])
+                continue;
+            if (!variants[i]->finished() && !variants[i]->compileFinished())
+            {
+                if (!mayWait)
+                    continue;
+                mayWait = false;
+            }
+            variants[i]->finish();
+            announced[i] = true;
+            ready.push_back((int)i);
+        }
+        return ready;
+    }
+
+    // дождаться всех вариантов (например, перед замером, который не должен застать запасную программу)
+    std::vector<int> finishAll()
+    {
+        std::vector<int> ready;
+        for (size_t i = 0; i < variants.size(); ++i)
+            if (!announced[i])
+            {
+                variants[i]->finish();
+                announced[i] = true;
+                ready.push_back((int)i);
+            }
+        return ready;
+    }
+
+    // готовый вариант или nullptr
+    Shader* get(int variant) const
+    {
+        return announced[variant] ? variants[variant].get() : nullptr;
+    }
+
+    int size() const { return (int)variants.size(); }
+    int pendingCount() const
+    {
+        int pending = 0;
+        for (bool done : announced)
+            pending += done ? 0 : 1;
+        return pending;
+    }
+
+private:
+    std::string vertex, fragment, geometry;
+    std::vector<std::unique_ptr<Shader>> variants;
+    std::vector<bool> announced; // вариант отдан вызывающему коду через poll() или finishAll()
+};
+
+#endif
@@ -0,0 +1,439 @@
+#ifndef SHADOW_ATLAS_H
+#define SHADOW_ATLAS_H
+
+#include <glad/glad.h>
+
+#include <opengllibs/glcaps.h>
+
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+// анизотропная фильтрация: ядро с OpenGL 4.6 или GL_ARB/EXT_texture_filter_anisotropic (в GLAD до 4.5 констант нет)
+#ifndef GL_TEXTURE_MAX_ANISOTROPY
+#define GL_TEXTURE_MAX_ANISOTROPY 0x84FE
+#endif
+#ifndef GL_MAX_TEXTURE_MAX_ANISOTROPY
+#define GL_MAX_TEXTURE_MAX_ANISOTROPY 0x84FF
+#endif
+
+// Хранение карт теней. Проход теней не пишет gl_FragDepth, поэтому ранняя проверка глубины (early-Z) работает
+// во всех режимах:
+//  DEPTH16, DEPTH32       — только аппаратная перспективная глубина граней (GL_DEPTH_COMPONENT16 / 32F);
+//                           расстояние до источника восстанавливается из неё при чтении;
+//  DISTANCE16, DISTANCE32 — расстояние до источника в долях far_plane в цветовом массиве GL_R16F / GL_R32F,
+//                           перспективная глубина — в отдельном массиве только для проверки глубины.
+// 16-битные режимы вдвое уменьшают объём выборок из карт теней. Аппаратное сравнение (сэмплер со сравнением)
+// возможно только для текстур глубины, т.е. в режимах DEPTH*.
+enum ShadowStorage
+{
+    SHADOW_STORAGE_DEPTH16,
+    SHADOW_STORAGE_DEPTH32,
+    SHADOW_STORAGE_DISTANCE16,
+    SHADOW_STORAGE_DISTANCE32,
+    SHADOW_STORAGE_COUNT
+};
+const char* const shadowStorageNames[SHADOW_STORAGE_COUNT] = { "depth16", "depth32", "r16f", "r32f" };
+
+inline bool storesDistance(ShadowStorage storage)
+{
+    return storage == SHADOW_STORAGE_DISTANCE16 || storage == SHADOW_STORAGE_DISTANCE32;
+}
+
+// Слот карты теней: ярус атласа и номер кубической карты в массиве яруса
+struct ShadowSlot
+{
+    int tier = -1;
+    int index = -1;
+
+    bool valid() const { return tier >= 0; }
+    // первый слой массива кубических карт, занятый слотом (6 слоёв на кубическую карту)
+    int layerBase() const { return index * 6; }
+    bool operator==(const ShadowSlot& other) const { return tier == other.tier && index == other.index; }
+    bool operator!=(const ShadowSlot& other) const { return !(*this == other); }
+};
+
+// Атлас теней точечных источников: несколько ярусов, каждый — массив кубических карт глубины или расстояния
+// (GL_TEXTURE_CUBE_MAP_ARRAY, см. ShadowStorage) одного разрешения. Ярусы идут от большего разрешения к меньшему;
+// allocate() раздаёт слоты по значимости источников: самые заметные на экране получают большие карты.
+class ShadowAtlas
+{
+public:
+    struct Tier
+    {
+        int resolution = 0;
+        int capacity = 0;           // количество кубических карт в ярусе
+        unsigned int texture = 0;   // GL_TEXTURE_CUBE_MAP_ARRAY, слой = index * 6 + грань
+        unsigned int depthBuffer = 0; // буфер глубины той же формы (только в режимах DISTANCE*)
+        unsigned int layeredFBO = 0; // весь массив как слоистое вложение (gl_Layer выбирает слой)
+        // фильтруемое представление (VSM/EVSM, см. setMomentFormat): массив кубических карт моментов
+        // с мип-уровнями и одна промежуточная кубическая карта для разделимого размытия
+        unsigned int momentTexture = 0;
+        unsigned int momentScratch = 0;
+    };
+
+    // tiers — пары (разрешение, количество кубических карт), от большего разрешения к меньшему
+    explicit ShadowAtlas(const std::vector<std::pair<int, int>>& tierDescs, ShadowStorage storage = SHADOW_STORAGE_DEPTH32)
+    {
+        glGenFramebuffers(1, &faceFBO);
+        for (const auto& desc : tierDescs)
+        {
+            Tier tier;
+            tier.resolution = desc.first;
+            tier.capacity = desc.second;
+            tiers.push_back(tier);
+        }
+        setStorage(storage);
+
+        // объект сэмплера для аппаратного сравнения глубины: привязанный к блоку, он заменяет параметры
+        // текстуры, поэтому одна и та же текстура читается и как глубина (GL_NEAREST), и со сравнением.
+        // GL_LINEAR + GL_COMPARE_REF_TO_TEXTURE — одна выборка сравнивает 4 texel'а и фильтрует результаты
+        glGenSamplers(1, &compareSampler);
+        glSamplerParameteri(compareSampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glSamplerParameteri(compareSampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glSamplerParameteri(compareSampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glSamplerParameteri(compareSampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glSamplerParameteri(compareSampler, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        glSamplerParameteri(compareSampler, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glSamplerParameteri(compareSampler, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    }
+
+    ~ShadowAtlas()
+    {
+        releaseStorage();
+        glDeleteFramebuffers(1, &faceFBO);
+        glDeleteSamplers(1, &compareSampler);
+        setMomentFormat(GL_NONE);
+        if (momentFBO != 0)
+            glDeleteFramebuffers(1, &momentFBO);
+    }
+
+    ShadowAtlas(const ShadowAtlas&) = delete;
+    ShadowAtlas& operator=(const ShadowAtlas&) = delete;
+
+    // Пересоздать карты ярусов в формате storage; их содержимое после этого недействительно
+    void setStorage(ShadowStorage newStorage)
+    {
+        releaseStorage();
+        storage = newStorage;
+        const bool distance = storesDistance(storage);
+        GLenum depthFormat = GL_DEPTH_COMPONENT16;
+        if (storage == SHADOW_STORAGE_DEPTH32)
+            depthFormat = GL_DEPTH_COMPONENT32F;
+        else if (storage == SHADOW_STORAGE_DISTANCE32)
+            depthFormat = GL_DEPTH_COMPONENT24; // глубина нужна только для упорядочивания поверхностей
+        for (Tier& tier : tiers)
+        {
+            // создание массива кубических карт
+            // --------------------------------
+            // GL_TEXTURE_CUBE_MAP_ARRAY хранит capacity кубических карт, т.е. capacity * 6 слоёв; слой для грани
+            // face кубической карты index — это index * 6 + face (порядок граней как у GL_TEXTURE_CUBE_MAP_POSITIVE_X + i)
+            if (distance)
+            {
+                tier.texture = createArray(tier, storage == SHADOW_STORAGE_DISTANCE16 ? GL_R16F : GL_R32F, GL_RED);
+                tier.depthBuffer = createArray(tier, depthFormat, GL_DEPTH_COMPONENT);
+            }
+            else
+                tier.texture = createArray(tier, depthFormat, GL_DEPTH_COMPONENT);
+
+            // слоистое вложение: рисуем во все слои, конкретный слой задаёт gl_Layer в шейдере
+            glGenFramebuffers(1, &tier.layeredFBO);
+            glBindFramebuffer(GL_FRAMEBUFFER, tier.layeredFBO);
+            if (distance)
+            {
+                glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, tier.texture, 0);
+                glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, tier.depthBuffer, 0);
+                glDrawBuffer(GL_COLOR_ATTACHMENT0);
+            }
+            else
+            {
+                glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, tier.texture, 0);
+                // цветовых буферов нет — в карту теней пишется только глубина
+                glDrawBuffer(GL_NONE);
+            }
+            glReadBuffer(GL_NONE);
+            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+                std::cout << "ERROR::SHADOW_ATLAS:: layered framebuffer is not complete" << std::endl;
+        }
+        glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, faceFBO);
+        glDrawBuffer(distance ? GL_COLOR_ATTACHMENT0 : GL_NONE);
+        glReadBuffer(GL_NONE);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    ShadowStorage getStorage() const { return storage; }
+
+    // байт на texel карты, читаемой шейдерами, и объём всех массивов атласа (с буферами глубины) в байтах
+    int bytesPerTexel() const
+    {
+        return storage == SHADOW_STORAGE_DEPTH16 || storage == SHADOW_STORAGE_DISTANCE16 ? 2 : 4;
+    }
+    size_t memoryBytes() const
+    {
+        // буфер глубины режима DISTANCE32 (GL_DEPTH_COMPONENT24) обычно занимает 4 байта на texel
+        size_t perTexel = bytesPerTexel() + (storesDistance(storage) ? bytesPerTexel() : 0);
+        size_t total = 0;
+        for (const Tier& tier : tiers)
+            total += (size_t)tier.resolution * tier.resolution * tier.capacity * 6 * perTexel;
+        return total;
+    }
+
+    int tierCount() const { return (int)tiers.size(); }
+    const Tier& tier(int index) const { return tiers[index]; }
+
+    int capacity() const
+    {
+        int total = 0;
+        for (const Tier& tier : tiers)
+            total += tier.capacity;
+        return total;
+    }
+
+    // Распределить слоты между источниками. importance[i] — экранная значимость источника i
+    // (<= 0 — источник без тени), slots — назначения с прошлого кадра, обновляются на месте.
+    // Источники сортируются по убыванию значимости и заполняют ярусы по порядку. Источник, который остался
+    // в том же ярусе, сохраняет свой слот, чтобы кэш его граней оставался действительным.
+    void allocate(const std::vector<float>& importance, std::vector<ShadowSlot>& slots) const
+    {
+        size_t count = importance.size();
+        slots.resize(count);
+        std::vector<size_t> order(count);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(),
+                         [&importance](size_t a, size_t b) { return importance[a] > importance[b]; });
+
+        // желаемый ярус по рангу источника
+        std::vector<int> desired(count, -1);
+        int tierIndex = 0, used = 0;
+        for (size_t rank = 0; rank < count; ++rank)
+        {
+            size_t light = order[rank];
+            while (tierIndex < (int)tiers.size() && used == tiers[tierIndex].capacity)
+            {
+                ++tierIndex;
+                used = 0;
+            }
+            if (importance[light] <= 0.0f || tierIndex == (int)tiers.size())
+                break;
+            desired[light] = tierIndex;
+            ++used;
+        }
+
+        // сохраняем слоты источников, оставшихся в своём ярусе
+        std::vector<std::vector<bool>> occupied(tiers.size());
+        for (size_t t = 0; t < tiers.size(); ++t)
+            occupied[t].assign(tiers[t].capacity, false);
+        std::vector<bool> placed(count, false);
+        for (size_t light = 0; light < count; ++light)
+        {
+            const ShadowSlot& slot = slots[light];
+            if (desired[light] >= 0 && slot.tier == desired[light] && slot.index < tiers[slot.tier].capacity &&
+                !occupied[slot.tier][slot.index])
+            {
+                occupied[slot.tier][slot.index] = true;
+                placed[light] = true;
+            }
+        }
+        // остальным — первый свободный слот желаемого яруса
+        for (size_t light = 0; light < count; ++light)
+        {
+            if (placed[light])
+                continue;
+            ShadowSlot slot;
+            if (desired[light] >= 0)
+            {
+                std::vector<bool>& free = occupied[desired[light]];
+                slot.tier = desired[light];
+                slot.index = (int)(std::find(free.begin(), free.end(), false) - free.begin());
+                free[slot.index] = true;
+            }
+            slots[light] = slot;
+        }
+    }
+
+    // очистить глубину (и расстояние — до far_plane) граней faces (маска) кубической карты slot
+    void clearFaces(const ShadowSlot& slot, unsigned int faces) const
+    {
+        const GLfloat farDistance[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+        for (int face = 0; face < 6; ++face)
+        {
+            if ((faces & (1u << face)) == 0)
+                continue;
+            bindFace(slot, face);
+            glClear(GL_DEPTH_BUFFER_BIT);
+            // glClearBuffer не трогает цвет очистки основного прохода
+            if (storesDistance(storage))
+                glClearBufferfv(GL_COLOR, 0, farDistance);
+        }
+    }
+
+    // FBO для рисования в одну грань кубической карты slot (без gl_Layer)
+    void bindFace(const ShadowSlot& slot, int face) const
+    {
+        const Tier& t = tiers[slot.tier];
+        const int layer = slot.layerBase() + face;
+        glBindFramebuffer(GL_FRAMEBUFFER, faceFBO);
+        // вложения переназначаются оба: FBO общий для всех ярусов и режимов хранения
+        if (storesDistance(storage))
+        {
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, t.texture, 0, layer);
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, t.depthBuffer, 0, layer);
+        }
+        else
+        {
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, 0, 0, 0);
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, t.texture, 0, layer);
+        }
+    }
+
+    // слоистый FBO яруса slot: слой выбирается в шейдере как slot.layerBase() + грань
+    void bindLayered(const ShadowSlot& slot) const
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, tiers[slot.tier].layeredFBO);
+    }
+
+    // привязать текстуры ярусов к текстурным блокам firstUnit, firstUnit + 1, ...
+    void bindTextures(int firstUnit) const
+    {
+        for (size_t t = 0; t < tiers.size(); ++t)
+        {
+            glActiveTexture(GL_TEXTURE0 + firstUnit + (GLenum)t);
+            glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, tiers[t].texture);
+        }
+    }
+
+    // привязать текстуры ярусов с сэмплером сравнения к блокам firstUnit, firstUnit + 1, ... (samplerCubeArrayShadow);
+    // в режимах DISTANCE* сравнивать нечего — шейдер не читает эти блоки
+    void bindCompareTextures(int firstUnit) const
+    {
+        if (storesDistance(storage))
+            return;
+        bindTextures(firstUnit);
+        for (size_t t = 0; t < tiers.size(); ++t)
+            glBindSampler(firstUnit + (GLuint)t, compareSampler);
+    }
+
+    // Формат карт моментов (GL_RG32F для VSM, GL_RGBA16F/GL_RGBA32F для EVSM); GL_NONE — без них.
+    // Текстуры пересоздаются при смене формата, их содержимое после этого недействительно.
+    void setMomentFormat(GLenum format)
+    {
+        if (format == momentFormat)
+            return;
+        for (Tier& tier : tiers)
+        {
+            if (tier.momentTexture != 0)
+            {
+                glDeleteTextures(1, &tier.momentTexture);
+                glDeleteTextures(1, &tier.momentScratch);
+                tier.momentTexture = tier.momentScratch = 0;
+            }
+        }
+        momentFormat = format;
+        if (format == GL_NONE)
+            return;
+        if (momentFBO == 0)
+            glGenFramebuffers(1, &momentFBO);
+
+        float anisotropy = 1.0f;
+        if (GLCaps::get().atLeast(4, 6) || GLCaps::get().has("GL_ARB_texture_filter_anisotropic") ||
+            GLCaps::get().has("GL_EXT_texture_filter_anisotropic"))
+            glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &anisotropy);
+        for (Tier& tier : tiers)
+        {
+            // моменты фильтруются аппаратно: трилинейно по мип-уровням и анизотропно
+            glGenTextures(1, &tier.momentTexture);
+            glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, tier.momentTexture);
+            glTexImage3D(GL_TEXTURE_CUBE_MAP_ARRAY, 0, format, tier.resolution, tier.resolution, tier.capacity * 6, 0, GL_RGBA,
+                         GL_FLOAT, NULL);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            if (anisotropy > 1.0f)
+                glTexParameterf(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_MAX_ANISOTROPY, std::min(anisotropy, 8.0f));
+            glGenerateMipmap(GL_TEXTURE_CUBE_MAP_ARRAY); // выделить мип-уровни
+
+            // промежуточная карта читается в центрах texel'ов, фильтрация не нужна
+            glGenTextures(1, &tier.momentScratch);
+            glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, tier.momentScratch);
+            glTexImage3D(GL_TEXTURE_CUBE_MAP_ARRAY, 0, format, tier.resolution, tier.resolution, 6, 0, GL_RGBA, GL_FLOAT, NULL);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            for (GLenum wrap : { GL_TEXTURE_WRAP_S, GL_TEXTURE_WRAP_T, GL_TEXTURE_WRAP_R })
+                glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, wrap, GL_CLAMP_TO_EDGE);
+        }
+        glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, 0);
+    }
+
+    bool hasMoments() const { return momentFormat != GL_NONE; }
+
+    // FBO для записи грани face промежуточной карты яруса tier (scratch) или кубической карты slot в карте моментов
+    void bindMomentScratchFace(int tierIndex, int face) const
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, momentFBO);
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, tiers[tierIndex].momentScratch, 0, face);
+    }
+    void bindMomentFace(const ShadowSlot& slot, int face) const
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, momentFBO);
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, tiers[slot.tier].momentTexture, 0,
+                                  slot.layerBase() + face);
+    }
+
+    // пересчитать мип-уровни карты моментов яруса (после записи моментов его источников)
+    void generateMomentMipmaps(int tierIndex) const
+    {
+        glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, tiers[tierIndex].momentTexture);
+        glGenerateMipmap(GL_TEXTURE_CUBE_MAP_ARRAY);
+        glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, 0);
+    }
+
+    // привязать карты моментов ярусов к блокам firstUnit, firstUnit + 1, ...
+    void bindMomentTextures(int firstUnit) const
+    {
+        for (size_t t = 0; t < tiers.size(); ++t)
+        {
+            glActiveTexture(GL_TEXTURE0 + firstUnit + (GLenum)t);
+            glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, tiers[t].momentTexture);
+        }
+    }
+
+private:
+    std::vector<Tier> tiers;
+    ShadowStorage storage = SHADOW_STORAGE_DEPTH32;
+    unsigned int faceFBO = 0; // переиспользуемый FBO для одной грани (очистка и проход по граням)
+    unsigned int compareSampler = 0;
+    GLenum momentFormat = GL_NONE;
+    unsigned int momentFBO = 0;
+
+    // пустой массив кубических карт яруса без фильтрации: GL_NEAREST — без интерполяции,
+    // GL_CLAMP_TO_EDGE — без повторения на границах граней
+    static unsigned int createArray(const Tier& tier, GLenum internalFormat, GLenum format)
+    {
+        unsigned int texture = 0;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, texture);
+        glTexImage3D(GL_TEXTURE_CUBE_MAP_ARRAY, 0, internalFormat, tier.resolution, tier.resolution, tier.capacity * 6, 0,
+                     format, GL_FLOAT, NULL); // NULL — пустая текстура, заполняется проходом теней
+        glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        return texture;
+    }
+
+    void releaseStorage()
+    {
+        for (Tier& tier : tiers)
+        {
+            glDeleteTextures(1, &tier.texture);
+            if (tier.depthBuffer != 0)
+                glDeleteTextures(1, &tier.depthBuffer);
+            glDeleteFramebuffers(1, &tier.layeredFBO);
+            tier.texture = tier.depthBuffer = tier.layeredFBO = 0;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef SHADOW_CACHE_H
+#define SHADOW_CACHE_H
+
+#include <glm/glm.hpp>
+
+#include <opengllibs/bounds.h>
+
+#include <vector>
+
+// Кэш граней кубической карты теней одного точечного источника.
+// Грань нужно перерисовать ("грязная"), если:
+//  - сдвинулся источник света или изменился far_plane — тогда грязные все 6 граней;
+//  - объект изменил матрицу модели — тогда грязные грани, в которые он попадал до и после изменения;
+//  - изменилось количество объектов — все грани.
+// Остальные грани остаются в текстуре с прошлых кадров и не перерисовываются.
+//
+// Порядок использования на кадр: setLight(), setObjectCount(), setObject() для каждого объекта,
+// затем dirtyFaces() — маска граней для рендеринга, и markClean() после их отрисовки.
+class ShadowFaceCache
+{
+public:
+    // пометить все грани грязными (например, после пересоздания текстуры)
+    void invalidate()
+    {
+        dirty = CUBE_FACE_ALL;
+    }
+
+    void setLight(const glm::vec3& position, float farPlane)
+    {
+        if (!valid || position != lightPos || farPlane != lightFar)
+            dirty = CUBE_FACE_ALL;
+        lightPos = position;
+        lightFar = farPlane;
+        valid = true;
+    }
+
+    void setObjectCount(size_t count)
+    {
+        if (count != objects.size())
+        {
+            objects.assign(count, CachedObject());
+            dirty = CUBE_FACE_ALL;
+        }
+    }
+
+    // сообщить текущее состояние объекта index; вызывается после setLight()
+    void setObject(size_t index, const glm::mat4& model, const AABB& bounds)
+    {
+        CachedObject& cached = objects[index];
+        if (cached.known && cached.model == model)
+            return;
+        // объект исчез из граней, где был, и появился в новых: обе группы нужно перерисовать
+        if (cached.known)
+            dirty |= cubeFaceMask(cached.bounds, lightPos, lightFar);
+        dirty |= cubeFaceMask(bounds, lightPos, lightFar);
+        cached.model = model;
+        cached.bounds = bounds;
+        cached.known = true;
+    }
+
+    unsigned int dirtyFaces() const
+    {
+        return dirty;
+    }
+
+    void markClean(unsigned int faces)
+    {
+        dirty &= ~faces;
+    }
+
+private:
+    struct CachedObject
+    {
+        glm::mat4 model = glm::mat4(1.0f);
+        AABB bounds;
+        bool known = false;
+    };
+
+    std::vector<CachedObject> objects;
+    glm::vec3 lightPos = glm::vec3(0.0f);
+    float lightFar = 0.0f;
+    bool valid = false;
+    unsigned int dirty = CUBE_FACE_ALL;
+};
+
+#endif
@@ -0,0 +1,213 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <glad/glad.h>
+#include <stb_image.h>
+
+#include <opengllibs/texture_streamer.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Общий для процесса кэш 2D-текстур. Ключ — содержимое файла (64-битный FNV-1a): один и тот же файл под разными
+// путями и одинаковые копии загружаются один раз. Хэш файла запоминается по каноническому пути вместе с размером
+// и временем изменения, так что повторный запрос того же файла его не читает.
+// acquire() увеличивает счётчик ссылок, release() уменьшает. Текстура без ссылок остаётся в видеопамяти (следующий
+// acquire() — попадание без загрузки), пока занятые байты не превысят бюджет: тогда удаляются текстуры без ссылок,
+// давно не использованные первыми (LRU). Текстуры со ссылками не удаляются никогда, даже сверх бюджета.
+// Параметры текстуры (повторение, фильтры) задаёт загрузчик первого запроса: одинаковое содержимое с разными
+// параметрами — одна текстура.
+class TextureCache
+{
+public:
+    // загрузчик: полный путь -> имя текстуры (0 — не загрузилась, в кэш не попадает)
+    typedef std::function<GLuint(const std::string& path)> Loader;
+
+    static TextureCache& get()
+    {
+        static TextureCache instance;
+        return instance;
+    }
+
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+
+    // текстура файла path: из кэша или через load. streamer — если load ставит файл в его очередь: пока текстура
+    // загружается, она не удаляется (streamer должен жить, пока в кэше есть его текстуры, см. clear())
+    GLuint acquire(const std::string& path, const Loader& load, const TextureStreamer* streamer = nullptr)
+    {
+        std::error_code error;
+        std::string canonical = std::filesystem::weakly_canonical(path, error).string();
+        if (error)
+            canonical = path;
+        uint64_t hash = contentHash(canonical);
+
+        auto found = entries.find(hash);
+        if (found != entries.end())
+        {
+            Entry& entry = found->second;
+            if (entry.refs++ == 0)
+                idle.erase(entry.idlePosition);
+            ++hitCount;
+            return entry.texture;
+        }
+
+        ++missCount;
+        GLuint texture = load(path);
+        if (texture == 0)
+            return 0;
+        Entry& entry = entries[hash];
+        entry.texture = texture;
+        entry.bytes = estimateBytes(canonical, texture);
+        entry.refs = 1;
+        entry.streamer = streamer;
+        textureHashes[texture] = hash;
+        residentBytes += entry.bytes;
+        trim();
+        return texture;
+    }
+
+    // снять ссылку; текстура без ссылок становится кандидатом на удаление
+    void release(GLuint texture)
+    {
+        auto hash = textureHashes.find(texture);
+        if (hash == textureHashes.end())
+            return;
+        Entry& entry = entries[hash->second];
+        if (entry.refs == 0 || --entry.refs > 0)
+            return;
+        idle.push_front(hash->second);
+        entry.idlePosition = idle.begin();
+        trim();
+    }
+
+    // бюджет видеопамяти кэша (байт); уменьшение сразу удаляет лишние текстуры без ссылок
+    void setBudget(size_t bytes)
+    {
+        budget = bytes;
+        trim();
+    }
+
+    // удалить все текстуры (перед уничтожением контекста или TextureStreamer, через который они загружались)
+    void clear()
+    {
+        for (auto& item : entries)
+            glDeleteTextures(1, &item.second.texture);
+        entries.clear();
+        textureHashes.clear();
+        idle.clear();
+        pathHashes.clear();
+        residentBytes = 0;
+    }
+
+    // статистика: попадания, промахи, удалённые по бюджету текстуры, байт в видеопамяти (оценка)
+    unsigned long long hits() const { return hitCount; }
+    unsigned long long misses() const { return missCount; }
+    unsigned long long evictions() const { return evictionCount; }
+    size_t bytesResident() const { return residentBytes; }
+    size_t budgetBytes() const { return budget; }
+    size_t textureCount() const { return entries.size(); }
+
+private:
+    struct Entry
+    {
+        GLuint texture = 0;
+        size_t bytes = 0;
+        int refs = 0;
+        const TextureStreamer* streamer = nullptr;
+        std::list<uint64_t>::iterator idlePosition; // место в idle, пока refs == 0
+    };
+
+    // хэш содержимого по каноническому пути; изменение размера или времени файла — повод прочитать его заново
+    struct FileStamp
+    {
+        uintmax_t size = 0;
+        std::filesystem::file_time_type time;
+        uint64_t hash = 0;
+    };
+
+    std::unordered_map<uint64_t, Entry> entries;      // хэш содержимого -> текстура
+    std::unordered_map<GLuint, uint64_t> textureHashes;
+    std::unordered_map<std::string, FileStamp> pathHashes;
+    std::list<uint64_t> idle;                         // текстуры без ссылок, в начале — последняя отпущенная
+    size_t budget = (size_t)256 * 1024 * 1024;
+    size_t residentBytes = 0;
+    unsigned long long hitCount = 0, missCount = 0, evictionCount = 0;
+
+    TextureCache() {}
+
+    static uint64_t fnv1a(const char* data, size_t size, uint64_t hash = 14695981039346656037ull)
+    {
+        for (size_t i = 0; i < size; ++i)
+            hash = (hash ^ (unsigned char)data[i]) * 1099511628211ull;
+        return hash;
+    }
+
+    // файл, который не читается, различается по пути: загрузчик сам сообщит об ошибке
+    uint64_t contentHash(const std::string& canonical)
+    {
+        std::error_code error;
+        FileStamp stamp;
+        stamp.size = std::filesystem::file_size(canonical, error);
+        if (!error)
+            stamp.time = std::filesystem::last_write_time(canonical, error);
+        if (error)
+            return fnv1a(canonical.data(), canonical.size());
+        auto known = pathHashes.find(canonical);
+        if (known != pathHashes.end() && known->second.size == stamp.size && known->second.time == stamp.time)
+            return known->second.hash;
+
+        std::ifstream file(canonical, std::ios::binary);
+        std::vector<char> buffer(64 * 1024);
+        stamp.hash = 14695981039346656037ull;
+        while (file)
+        {
+            file.read(buffer.data(), (std::streamsize)buffer.size());
+            stamp.hash = fnv1a(buffer.data(), (size_t)file.gcount(), stamp.hash);
+        }
+        pathHashes[canonical] = stamp;
+        return stamp.hash;
+    }
+
+    // байт в видеопамяти с мип-уровнями: изображения — RGBA8 по размерам из заголовка (до декодирования,
+    // текстура может ещё загружаться), сжатые форматы — по размеру уровня 0 у драйвера
+    static size_t estimateBytes(const std::string& path, GLuint texture)
+    {
+        int width = 0, height = 0, channels = 0;
+        if (stbi_info(path.c_str(), &width, &height, &channels))
+            return (size_t)width * height * 4 * 4 / 3;
+        GLint compressed = GL_FALSE, size = 0;
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED, &compressed);
+        if (compressed == GL_TRUE)
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &size);
+        return (size_t)size * 4 / 3;
+    }
+
+    // удалить давно не использованные текстуры без ссылок, пока занято больше бюджета
+    void trim()
+    {
+        auto candidate = idle.end();
+        while (residentBytes > budget && candidate != idle.begin())
+        {
+            --candidate;
+            Entry& entry = entries[*candidate];
+            if (entry.streamer != nullptr && entry.streamer->loading(entry.texture))
+                continue;
+            glDeleteTextures(1, &entry.texture);
+            residentBytes -= entry.bytes;
+            ++evictionCount;
+            textureHashes.erase(entry.texture);
+            entries.erase(*candidate);
+            candidate = idle.erase(candidate);
+        }
+    }
+};
+
+#endif
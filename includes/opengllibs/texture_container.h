@@ -0,0 +1,156 @@
+#ifndef TEXTURE_CONTAINER_H
+#define TEXTURE_CONTAINER_H
+
+#include <opengllibs/block_compression.h>
+#include <opengllibs/mapped_file.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Контейнер сжатой текстуры (.ctex) по образцу KTX2: заголовок, индекс уровней (смещение, длина, размеры),
+// затем блоки всех мип-уровней от 0 до последнего, каждый уровень выровнен на 16 байт. Содержимое уровня —
+// ровно то, что принимает glCompressedTexImage2D, поэтому файл отображается в память (MappedFile) и уровни
+// передаются драйверу без копирования и декодирования. Пишет его texture_cooker, читает демо.
+class CookedTexture
+{
+public:
+    static const uint32_t MAGIC = 0x58455443; // "CTEX"
+    static const uint32_t VERSION = 1;
+    // флаги: исходное изображение с альфой (демо ставит ему GL_CLAMP_TO_EDGE, как loadTexture)
+    static const uint32_t FLAG_ALPHA = 1;
+
+    struct Level
+    {
+        const uint8_t* data;
+        size_t bytes;
+        int width, height;
+    };
+
+    // записать уровни levels[i] (уже сжатые, размеры sizes[i]) во временный файл и переименовать
+    static bool write(const std::string& path, BlockFormat format, uint32_t flags,
+                      const std::vector<std::pair<int, int>>& sizes, const std::vector<std::vector<uint8_t>>& levels)
+    {
+        Header header;
+        header.format = (uint32_t)format;
+        header.flags = flags;
+        header.width = (uint32_t)sizes[0].first;
+        header.height = (uint32_t)sizes[0].second;
+        header.levels = (uint32_t)levels.size();
+        std::vector<LevelEntry> index(levels.size());
+        uint64_t offset = align(sizeof(Header) + index.size() * sizeof(LevelEntry));
+        for (size_t i = 0; i < levels.size(); ++i)
+        {
+            index[i].offset = offset;
+            index[i].bytes = levels[i].size();
+            index[i].width = (uint32_t)sizes[i].first;
+            index[i].height = (uint32_t)sizes[i].second;
+            offset = align(offset + levels[i].size());
+        }
+
+        std::string temporary = path + ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            file.write((const char*)&header, sizeof(header));
+            file.write((const char*)index.data(), index.size() * sizeof(LevelEntry));
+            for (size_t i = 0; i < levels.size(); ++i)
+            {
+                const char padding[16] = {};
+                file.write(padding, (std::streamsize)(index[i].offset - (uint64_t)file.tellp()));
+                file.write((const char*)levels[i].data(), levels[i].size());
+            }
+            if (!file)
+            {
+                file.close();
+                std::remove(temporary.c_str());
+                return false;
+            }
+        }
+        // неудачная запись или переименование не оставляет временный файл рядом с результатом
+        std::error_code error;
+        std::filesystem::rename(temporary, path, error);
+        if (error)
+            std::remove(temporary.c_str());
+        return !error;
+    }
+
+    // отобразить файл и проверить заголовок и индекс уровней
+    bool open(const std::string& path)
+    {
+        levelTable.clear();
+        if (!file.open(path) || file.size() < sizeof(Header))
+            return false;
+        const Header* header = (const Header*)file.data();
+        if (header->magic != MAGIC || header->version != VERSION || header->format >= BLOCK_FORMAT_COUNT ||
+            header->levels == 0 || file.size() < sizeof(Header) + header->levels * sizeof(LevelEntry))
+            return fail();
+        blockFormat = (BlockFormat)header->format;
+        headerFlags = header->flags;
+        const LevelEntry* index = (const LevelEntry*)(file.data() + sizeof(Header));
+        for (uint32_t i = 0; i < header->levels; ++i)
+        {
+            const LevelEntry& entry = index[i];
+            if (entry.offset + entry.bytes > file.size() || entry.width == 0 || entry.height == 0 ||
+                entry.bytes != BlockCompression::levelBytes(blockFormat, (int)entry.width, (int)entry.height))
+                return fail();
+            levelTable.push_back({ file.data() + entry.offset, (size_t)entry.bytes, (int)entry.width, (int)entry.height });
+        }
+        return true;
+    }
+
+    BlockFormat format() const { return blockFormat; }
+    uint32_t flags() const { return headerFlags; }
+    int levelCount() const { return (int)levelTable.size(); }
+    const Level& level(int i) const { return levelTable[i]; }
+    int width() const { return levelTable[0].width; }
+    int height() const { return levelTable[0].height; }
+
+    // байт всех уровней (столько же займёт текстура в видеопамяти)
+    size_t dataBytes() const
+    {
+        size_t total = 0;
+        for (const Level& l : levelTable)
+            total += l.bytes;
+        return total;
+    }
+
+private:
+    struct Header
+    {
+        uint32_t magic = MAGIC;
+        uint32_t version = VERSION;
+        uint32_t format = 0;
+        uint32_t flags = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t levels = 0;
+        uint32_t reserved = 0;
+    };
+
+    struct LevelEntry
+    {
+        uint64_t offset = 0;
+        uint64_t bytes = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+    };
+
+    MappedFile file;
+    BlockFormat blockFormat = BLOCK_BC1;
+    uint32_t headerFlags = 0;
+    std::vector<Level> levelTable;
+
+    static uint64_t align(uint64_t offset) { return (offset + 15) & ~(uint64_t)15; }
+
+    bool fail()
+    {
+        file.close();
+        levelTable.clear();
+        return false;
+    }
+};
+
+#endif
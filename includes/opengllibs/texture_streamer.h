@@ -0,0 +1,350 @@
+#ifndef TEXTURE_STREAMER_H
+#define TEXTURE_STREAMER_H
+
+#include <glad/glad.h>
+#include <stb_image.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Потоковая загрузка 2D-текстур. request() сразу возвращает имя текстуры с заглушкой 1x1 и ставит файл в очередь
+// декодирования; потоки-работники декодируют изображения (stbi_load, без OpenGL), а update() раз в кадр
+// загружает декодированные пиксели полосами строк через кольцо PBO, не больше budget байт за кадр.
+// Пока уровень 0 загружается, текстура остаётся полной и показывает заглушку: она записана в последний
+// мип-уровень, а GL_TEXTURE_BASE_LEVEL указывает на него. После последней полосы базовый уровень
+// возвращается к 0 и строятся мип-уровни. Имя текстуры не меняется — его можно сразу отдавать мешам.
+class TextureStreamer
+{
+public:
+    // threads — потоков декодирования, frameBudget — байт загрузки за кадр, stagingBuffers — PBO в кольце
+    TextureStreamer(unsigned int threads, size_t frameBudget, int stagingBuffers = 3)
+        : budget(std::max(frameBudget, (size_t)1)), staging(std::max(stagingBuffers, 1))
+    {
+        for (Staging& buffer : staging)
+        {
+            glGenBuffers(1, &buffer.buffer);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.buffer);
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, budget, NULL, GL_STREAM_DRAW);
+            buffer.capacity = budget;
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        threads = std::max(threads, 1u);
+        for (unsigned int t = 0; t < threads; ++t)
+            workers.emplace_back([this]() { decodeLoop(); });
+    }
+
+    ~TextureStreamer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        workAvailable.notify_all();
+        for (std::thread& worker : workers)
+            worker.join();
+        for (Decoded& image : decoded)
+            stbi_image_free(image.pixels);
+        if (uploading.pixels != nullptr)
+            stbi_image_free(uploading.pixels);
+        for (Staging& buffer : staging)
+        {
+            if (buffer.fence != 0)
+                glDeleteSync(buffer.fence);
+            glDeleteBuffers(1, &buffer.buffer);
+        }
+    }
+
+    // потоков декодирования по умолчанию: ядра, кроме потока рендеринга, не больше четырёх
+    static unsigned int defaultThreads()
+    {
+        unsigned int cores = std::thread::hardware_concurrency();
+        return std::max(1u, std::min(cores > 1 ? cores - 1 : 1u, 4u));
+    }
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    // поставить файл в очередь; clampTransparent — для изображений с альфой GL_CLAMP_TO_EDGE вместо GL_REPEAT
+    // (как в loadTexture демо). Возвращает имя текстуры, которое можно привязывать сразу
+    GLuint request(const std::string& path, bool clampTransparent = false)
+    {
+        GLuint texture = 0;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, PLACEHOLDER);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back({ texture, path, clampTransparent });
+            ++requested;
+        }
+        workAvailable.notify_one();
+        return texture;
+    }
+
+    // загрузка кадра: полосы декодированных изображений в пределах бюджета. Полоса идёт в следующий PBO кольца,
+    // только если GPU уже прочитал его прошлое содержимое, поэтому update() не ждёт ни декодирования, ни GPU
+    void update()
+    {
+        auto start = std::chrono::steady_clock::now();
+        frameBytes = 0;
+        size_t remaining = budget;
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        while (remaining > 0)
+        {
+            if (uploading.pixels == nullptr && !nextImage())
+                break;
+            const size_t rowBytes = (size_t)uploading.width * uploading.channels;
+            // строка длиннее бюджета загружается одна, но только первой в кадре
+            if (rowBytes > remaining && frameBytes > 0)
+                break;
+            Staging& buffer = staging[nextStaging];
+            if (buffer.fence != 0)
+            {
+                if (glClientWaitSync(buffer.fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+                    break;
+                glDeleteSync(buffer.fence);
+                buffer.fence = 0;
+            }
+            int rows = (int)std::min((size_t)(uploading.height - uploading.row), std::max(remaining / rowBytes, (size_t)1));
+            size_t bytes = rows * rowBytes;
+
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.buffer);
+            if (buffer.capacity < bytes)
+            {
+                glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, NULL, GL_STREAM_DRAW);
+                buffer.capacity = bytes;
+            }
+            void* target = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes,
+                                            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+            if (target != nullptr)
+            {
+                std::memcpy(target, uploading.pixels + uploading.row * rowBytes, bytes);
+                glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+                glBindTexture(GL_TEXTURE_2D, uploading.texture);
+                glTexSubImage2D(GL_TEXTURE_2D, 0, 0, uploading.row, uploading.width, rows, uploading.format,
+                                GL_UNSIGNED_BYTE, (const void*)0);
+                buffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            }
+            else
+            {
+                // отображение не удалось: полоса загружается прямо из памяти процесса
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                glBindTexture(GL_TEXTURE_2D, uploading.texture);
+                glTexSubImage2D(GL_TEXTURE_2D, 0, 0, uploading.row, uploading.width, rows, uploading.format,
+                                GL_UNSIGNED_BYTE, uploading.pixels + uploading.row * rowBytes);
+            }
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            nextStaging = (nextStaging + 1) % staging.size();
+            uploading.row += rows;
+            remaining -= std::min(bytes, remaining);
+            frameBytes += bytes;
+            uploadedBytes += bytes;
+            if (uploading.row == uploading.height)
+                completeImage();
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        lastUpdateSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // загрузить всё запрошенное, ожидая декодирование (например, перед замером или при выключенном стриминге)
+    void finish()
+    {
+        while (!idle())
+        {
+            update();
+            if (!idle() && frameBytes == 0)
+            {
+                // ни одной полосы: ждём работников или GPU
+                std::unique_lock<std::mutex> lock(mutex);
+                imageDecoded.wait_for(lock, std::chrono::milliseconds(1), [this]() { return !decoded.empty(); });
+            }
+        }
+    }
+
+    // все запрошенные текстуры загружены (или не загрузились)
+    bool idle() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return resident + failed == requested;
+    }
+
+    // текстура ещё в очереди или загружается (удалять её нельзя: update() будет в неё писать)
+    bool loading(GLuint texture) const
+    {
+        if (uploading.pixels != nullptr && uploading.texture == texture)
+            return true;
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const Job& job : jobs)
+            if (job.texture == texture)
+                return true;
+        for (const Decoded& image : decoded)
+            if (image.texture == texture)
+                return true;
+        return false;
+    }
+
+    int requestedCount() const { std::lock_guard<std::mutex> lock(mutex); return requested; }
+    int residentCount() const { std::lock_guard<std::mutex> lock(mutex); return resident; }
+    int failedCount() const { std::lock_guard<std::mutex> lock(mutex); return failed; }
+    int pendingCount() const { std::lock_guard<std::mutex> lock(mutex); return requested - resident - failed; }
+    // байт загружено последним update() и всего
+    size_t lastFrameBytes() const { return frameBytes; }
+    size_t totalBytes() const { return uploadedBytes; }
+    // CPU-время последнего update() и суммарное время декодирования во всех потоках
+    double lastUpdateTime() const { return lastUpdateSeconds; }
+    double decodeTime() const { std::lock_guard<std::mutex> lock(mutex); return decodeSeconds; }
+    size_t frameBudget() const { return budget; }
+    unsigned int threadCount() const { return (unsigned int)workers.size(); }
+
+private:
+    // заглушка: нейтральный серый
+    static constexpr unsigned char PLACEHOLDER[4] = { 128, 128, 128, 255 };
+
+    struct Job
+    {
+        GLuint texture;
+        std::string path;
+        bool clampTransparent;
+    };
+
+    struct Decoded
+    {
+        GLuint texture = 0;
+        std::string path;
+        bool clampTransparent = false;
+        unsigned char* pixels = nullptr; // nullptr в очереди — файл не декодировался
+        int width = 0, height = 0, channels = 0;
+        GLenum format = GL_RGBA;
+        int row = 0;       // загружено строк уровня 0
+        int lastLevel = 0; // уровень с заглушкой
+    };
+
+    struct Staging
+    {
+        GLuint buffer = 0;
+        size_t capacity = 0;
+        GLsync fence = 0; // GPU ещё читает полосу из буфера
+    };
+
+    size_t budget;
+    std::vector<Staging> staging;
+    size_t nextStaging = 0;
+    Decoded uploading; // изображение, которое загружается полосами (pixels == nullptr — никакое)
+    size_t frameBytes = 0, uploadedBytes = 0;
+    double lastUpdateSeconds = 0.0;
+
+    // общие с работниками данные под mutex
+    mutable std::mutex mutex;
+    std::condition_variable workAvailable, imageDecoded;
+    std::deque<Job> jobs;
+    std::deque<Decoded> decoded;
+    bool stopping = false;
+    int requested = 0, resident = 0, failed = 0;
+    double decodeSeconds = 0.0;
+    std::vector<std::thread> workers;
+
+    void decodeLoop()
+    {
+        for (;;)
+        {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                workAvailable.wait(lock, [this]() { return stopping || !jobs.empty(); });
+                if (stopping)
+                    return;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            auto start = std::chrono::steady_clock::now();
+            Decoded image;
+            image.texture = job.texture;
+            image.path = std::move(job.path);
+            image.clampTransparent = job.clampTransparent;
+            image.pixels = stbi_load(image.path.c_str(), &image.width, &image.height, &image.channels, 0);
+            if (image.pixels != nullptr && (image.channels == 2 || image.width <= 0 || image.height <= 0))
+            {
+                // двухканальные изображения loadTexture тоже не поддерживает
+                stbi_image_free(image.pixels);
+                image.pixels = nullptr;
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                decodeSeconds += seconds;
+                decoded.push_back(std::move(image));
+            }
+            imageDecoded.notify_one();
+        }
+    }
+
+    // взять следующее декодированное изображение и подготовить текстуру; false — очередь пуста
+    bool nextImage()
+    {
+        for (;;)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (decoded.empty())
+                    return false;
+                uploading = std::move(decoded.front());
+                decoded.pop_front();
+                if (uploading.pixels == nullptr)
+                {
+                    ++failed;
+                    std::cout << "Texture failed to load at path: " << uploading.path << std::endl;
+                    continue;
+                }
+            }
+            beginImage();
+            return true;
+        }
+    }
+
+    // хранилище всех мип-уровней и заглушка в последнем; текстура рисуется заглушкой до completeImage()
+    void beginImage()
+    {
+        Decoded& image = uploading;
+        image.format = image.channels == 1 ? GL_RED : image.channels == 3 ? GL_RGB : GL_RGBA;
+        image.row = 0;
+        image.lastLevel = 0;
+        while ((std::max(image.width, image.height) >> image.lastLevel) > 1)
+            ++image.lastLevel;
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glBindTexture(GL_TEXTURE_2D, image.texture);
+        for (int level = 0; level <= image.lastLevel; ++level)
+            glTexImage2D(GL_TEXTURE_2D, level, image.format, std::max(image.width >> level, 1),
+                         std::max(image.height >> level, 1), 0, image.format, GL_UNSIGNED_BYTE, NULL);
+        glTexSubImage2D(GL_TEXTURE_2D, image.lastLevel, 0, 0, 1, 1, image.format, GL_UNSIGNED_BYTE, PLACEHOLDER);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, image.lastLevel);
+    }
+
+    void completeImage()
+    {
+        Decoded& image = uploading;
+        glBindTexture(GL_TEXTURE_2D, image.texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        GLint wrap = image.clampTransparent && image.format == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT;
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        stbi_image_free(image.pixels);
+        image.pixels = nullptr;
+        std::lock_guard<std::mutex> lock(mutex);
+        ++resident;
+    }
+};
+
+#endif
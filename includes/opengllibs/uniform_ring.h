@@ -0,0 +1,184 @@
+#ifndef UNIFORM_RING_H
+#define UNIFORM_RING_H
+
+#include <glad/glad.h>
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// Кольцевой буфер униформ для данных, которые меняются каждый кадр (камера, источники, матрицы теней).
+// Буфер разбит на FRAMES сегментов — по одному на кадр "в полёте". За кадр все блоки записываются
+// в сегмент кадра (push), затем flush() делает их видимыми GPU, а bind() привязывает диапазон
+// сегмента к точке привязки блока (glBindBufferRange).
+//
+// Два режима:
+//  PERSISTENT — буфер с постоянным отображением (glBufferStorage + MAP_PERSISTENT | MAP_COHERENT,
+//               OpenGL 4.4): push() пишет прямо в память буфера, перед переиспользованием сегмента
+//               ждём забор (fence) кадра, который писал в него FRAMES кадров назад;
+//  ORPHAN     — без постоянного отображения: push() пишет в копию на CPU, flush() отдаёт драйверу старое
+//               хранилище (glBufferData с NULL) и загружает сегмент одним glBufferSubData.
+class UniformRing
+{
+public:
+    enum Mode
+    {
+        PERSISTENT,
+        ORPHAN
+    };
+    static const int FRAMES = 3;
+
+    ~UniformRing()
+    {
+        destroy();
+    }
+
+    UniformRing() {}
+    UniformRing(const UniformRing&) = delete;
+    UniformRing& operator=(const UniformRing&) = delete;
+
+    // frameBytes — сколько байт данных может понадобиться за кадр, blocksPerFrame — сколько блоков
+    // (каждый блок выравнивается по GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT)
+    bool create(size_t frameBytes, int blocksPerFrame, Mode requested)
+    {
+        GLint alignmentValue = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignmentValue);
+        alignment = alignmentValue > 0 ? (size_t)alignmentValue : 256;
+        segmentSize = align(frameBytes + blocksPerFrame * (alignment - 1));
+
+        // постоянное отображение требует OpenGL 4.4 (GLAD загружает glBufferStorage только с ядром 4.4)
+        mode = (requested == PERSISTENT && GLAD_GL_VERSION_4_4 && glBufferStorage != NULL) ? PERSISTENT : ORPHAN;
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        if (mode == PERSISTENT)
+        {
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_UNIFORM_BUFFER, segmentSize * FRAMES, NULL, flags);
+            mapped = (unsigned char*)glMapBufferRange(GL_UNIFORM_BUFFER, 0, segmentSize * FRAMES, flags);
+            if (mapped == NULL)
+            {
+                std::cout << "ERROR::UNIFORM_RING:: failed to map persistent uniform buffer" << std::endl;
+                glBindBuffer(GL_UNIFORM_BUFFER, 0);
+                destroy();
+                return false;
+            }
+        }
+        else
+        {
+            glBufferData(GL_UNIFORM_BUFFER, segmentSize, NULL, GL_STREAM_DRAW);
+            staging.resize(segmentSize);
+        }
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        return true;
+    }
+
+    void destroy()
+    {
+        for (GLsync& fence : fences)
+        {
+            if (fence != 0)
+                glDeleteSync(fence);
+            fence = 0;
+        }
+        if (buffer != 0)
+        {
+            if (mapped != NULL)
+            {
+                glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+                glUnmapBuffer(GL_UNIFORM_BUFFER);
+                glBindBuffer(GL_UNIFORM_BUFFER, 0);
+            }
+            glDeleteBuffers(1, &buffer);
+        }
+        buffer = 0;
+        mapped = NULL;
+    }
+
+    Mode currentMode() const { return mode; }
+    const char* modeName() const { return mode == PERSISTENT ? "persistent" : "orphan"; }
+
+    // начать запись сегмента нового кадра
+    void beginFrame()
+    {
+        segment = (segment + 1) % FRAMES;
+        used = 0;
+        if (mode == PERSISTENT && fences[segment] != 0)
+        {
+            // GPU мог ещё не дочитать сегмент, записанный FRAMES кадров назад
+            GLenum result = glClientWaitSync(fences[segment], 0, 0);
+            while (result == GL_TIMEOUT_EXPIRED)
+                result = glClientWaitSync(fences[segment], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+            glDeleteSync(fences[segment]);
+            fences[segment] = 0;
+        }
+    }
+
+    // записать блок size байт; возвращает смещение блока в буфере для bind()
+    size_t push(const void* data, size_t size)
+    {
+        if (used + size > segmentSize)
+        {
+            std::cout << "ERROR::UNIFORM_RING:: frame segment overflow" << std::endl;
+            return 0;
+        }
+        size_t offset = used;
+        std::memcpy(segmentData() + offset, data, size);
+        used = align(used + size);
+        return bufferOffset(offset);
+    }
+
+    template <typename T>
+    size_t push(const T& block)
+    {
+        return push(&block, sizeof(T));
+    }
+
+    // сделать записанные блоки видимыми GPU (вызывать до первой отрисовки, читающей их)
+    void flush()
+    {
+        if (mode == ORPHAN && used > 0)
+        {
+            glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+            glBufferData(GL_UNIFORM_BUFFER, segmentSize, NULL, GL_STREAM_DRAW); // орфанинг старого хранилища
+            glBufferSubData(GL_UNIFORM_BUFFER, 0, used, staging.data());
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        }
+        // в режиме PERSISTENT отображение когерентное: записи видны командам, отправленным после них
+    }
+
+    // завершить кадр: забор отмечает, когда GPU закончит читать сегмент
+    void endFrame()
+    {
+        if (mode == PERSISTENT)
+            fences[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    // привязать блок (смещение из push) к точке привязки binding
+    void bind(GLuint binding, size_t offset, size_t size) const
+    {
+        glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, (GLintptr)offset, (GLsizeiptr)size);
+    }
+
+    // сколько байт записано в текущий кадр
+    size_t frameBytes() const { return used; }
+
+private:
+    Mode mode = ORPHAN;
+    unsigned int buffer = 0;
+    unsigned char* mapped = NULL;
+    std::vector<unsigned char> staging;
+    GLsync fences[FRAMES] = {};
+    size_t alignment = 256;
+    size_t segmentSize = 0;
+    int segment = 0;
+    size_t used = 0;
+
+    size_t align(size_t value) const { return (value + alignment - 1) / alignment * alignment; }
+
+    unsigned char* segmentData() { return mode == PERSISTENT ? mapped + segment * segmentSize : staging.data(); }
+
+    // в режиме ORPHAN у буфера один сегмент, в PERSISTENT — FRAMES сегментов подряд
+    size_t bufferOffset(size_t offset) const { return mode == PERSISTENT ? segment * segmentSize + offset : offset; }
+};
+
+#endif
@@ -0,0 +1,359 @@
+#ifndef VERTEX_FORMAT_H
+#define VERTEX_FORMAT_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include <cstddef>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+// Компактные форматы вершин. Позиция хранится отдельным потоком (vec3, 12 байт), остальные атрибуты —
+// вторым, упакованным потоком:
+//  нормали, тангенты, битангенты — 10:10:10:2 со знаком (GL_INT_2_10_10_10_REV, нормализованные), 4 байта;
+//  текстурные координаты — две половинные точности (GL_HALF_FLOAT), 4 байта.
+// Проход теней читает только поток позиций, поэтому на вершину выбирается 12 байт вместо полной вершины.
+
+// упаковать единичный вектор в 10:10:10:2 (w = 0)
+inline GLuint packNormal(const glm::vec3& n)
+{
+    return glm::packSnorm3x10_1x2(glm::vec4(glm::clamp(n, glm::vec3(-1.0f), glm::vec3(1.0f)), 0.0f));
+}
+
+// упаковать текстурные координаты в две половинки (x — младшие 16 бит)
+inline GLuint packTexCoords(const glm::vec2& uv)
+{
+    return glm::packHalf2x16(uv);
+}
+
+// Атрибуты поверхности без тангентов (куб сцены): 8 байт
+struct PackedSurface
+{
+    GLuint normal;
+    GLuint texCoords;
+};
+
+// Атрибуты поверхности с тангентным базисом (меши моделей): 16 байт
+struct PackedTangentSurface
+{
+    GLuint normal;
+    GLuint texCoords;
+    GLuint tangent;
+    GLuint bitangent;
+};
+
+// Описание одного атрибута в потоке вершин
+struct VertexAttribute
+{
+    GLuint location;
+    GLint size;
+    GLenum type;
+    GLboolean normalized;
+    size_t offset;
+};
+
+// Формат потока вершин: шаг и атрибуты. apply() настраивает атрибуты привязанного VAO на буфер
+struct VertexFormat
+{
+    GLsizei stride = 0;
+    std::vector<VertexAttribute> attributes;
+
+    void apply(GLuint buffer) const
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        for (const VertexAttribute& attribute : attributes)
+        {
+            glEnableVertexAttribArray(attribute.location);
+            glVertexAttribPointer(attribute.location, attribute.size, attribute.type, attribute.normalized, stride,
+                                  (void*)attribute.offset);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    // поток позиций: атрибут 0, vec3
+    static VertexFormat position()
+    {
+        VertexFormat format;
+        format.stride = sizeof(glm::vec3);
+        format.attributes.push_back({ 0, 3, GL_FLOAT, GL_FALSE, 0 });
+        return format;
+    }
+
+    // атрибуты PackedSurface: 1 — нормаль, 2 — текстурные координаты
+    static VertexFormat surface()
+    {
+        VertexFormat format;
+        format.stride = sizeof(PackedSurface);
+        format.attributes.push_back({ 1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, offsetof(PackedSurface, normal) });
+        format.attributes.push_back({ 2, 2, GL_HALF_FLOAT, GL_FALSE, offsetof(PackedSurface, texCoords) });
+        return format;
+    }
+
+    // атрибуты PackedTangentSurface: 1 — нормаль, 2 — текстурные координаты, 3 — тангент, 4 — битангент
+    static VertexFormat tangentSurface()
+    {
+        VertexFormat format;
+        format.stride = sizeof(PackedTangentSurface);
+        format.attributes.push_back({ 1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, offsetof(PackedTangentSurface, normal) });
+        format.attributes.push_back({ 2, 2, GL_HALF_FLOAT, GL_FALSE, offsetof(PackedTangentSurface, texCoords) });
+        format.attributes.push_back({ 3, 4, GL_INT_2_10_10_10_REV, GL_TRUE, offsetof(PackedTangentSurface, tangent) });
+        format.attributes.push_back({ 4, 4, GL_INT_2_10_10_10_REV, GL_TRUE, offsetof(PackedTangentSurface, bitangent) });
+        return format;
+    }
+
+    // атрибуты PackedTangentSurface без тангентного базиса: 1 — нормаль, 2 — текстурные координаты (меши моделей
+    // в сцене SceneSubmitter, где локации 3.. заняты атрибутами экземпляров)
+    static VertexFormat tangentSurfaceWithoutBasis()
+    {
+        VertexFormat format = tangentSurface();
+        format.attributes.resize(2);
+        return format;
+    }
+};
+
+// Диапазон индексов одного меша в общем индексном буфере. Индексы абсолютные (baseVertex не нужен),
+// поэтому один и тот же диапазон рисует меш и в потоке глубины, и в полном потоке.
+struct MeshRange
+{
+    GLuint firstIndex = 0;
+    GLsizei count = 0;
+
+    bool operator==(const MeshRange& other) const { return firstIndex == other.firstIndex && count == other.count; }
+};
+
+// Индексированная геометрия на CPU с удалением повторяющихся вершин. Строится по треугольникам
+// (addVertex на каждую вершину каждого треугольника) и одновременно ведёт два набора:
+//  полный — уникальные пары (позиция, атрибуты) и индексы на них;
+//  глубины — только уникальные позиции и свои индексы (у куба 8 вершин вместо 24).
+// Количество индексов в обоих наборах одинаковое, поэтому MeshRange общий.
+template <class Surface>
+class IndexedGeometry
+{
+public:
+    std::vector<glm::vec3> positions;     // позиции полного набора
+    std::vector<Surface> surfaces;        // упакованные атрибуты полного набора, параллельно positions
+    std::vector<GLuint> indices;
+    std::vector<glm::vec3> depthPositions;
+    std::vector<GLuint> depthIndices;
+
+    void beginMesh()
+    {
+        mesh.firstIndex = (GLuint)indices.size();
+        mesh.count = 0;
+    }
+
+    void addVertex(const glm::vec3& position, const Surface& surface)
+    {
+        indices.push_back(find(vertexMap, position, &surface, [&]() {
+            positions.push_back(position);
+            surfaces.push_back(surface);
+            return (GLuint)(positions.size() - 1);
+        }));
+        depthIndices.push_back(find(depthMap, position, nullptr, [&]() {
+            depthPositions.push_back(position);
+            return (GLuint)(depthPositions.size() - 1);
+        }));
+        ++mesh.count;
+    }
+
+    MeshRange endMesh()
+    {
+        return mesh;
+    }
+
+    // дописать геометрию, построенную отдельно из следующих треугольников того же меша: новые вершины part
+    // добавляются в её порядке, индексы пересчитываются. Результат тот же, что у addVertex по всем треугольникам
+    // подряд, поэтому меш можно строить частями в разных потоках и собирать по порядку
+    void append(const IndexedGeometry& part)
+    {
+        std::vector<GLuint> remap(part.positions.size()), depthRemap(part.depthPositions.size());
+        for (size_t v = 0; v < part.positions.size(); ++v)
+            remap[v] = find(vertexMap, part.positions[v], &part.surfaces[v], [&]() {
+                positions.push_back(part.positions[v]);
+                surfaces.push_back(part.surfaces[v]);
+                return (GLuint)(positions.size() - 1);
+            });
+        for (size_t v = 0; v < part.depthPositions.size(); ++v)
+            depthRemap[v] = find(depthMap, part.depthPositions[v], nullptr, [&]() {
+                depthPositions.push_back(part.depthPositions[v]);
+                return (GLuint)(depthPositions.size() - 1);
+            });
+        for (GLuint index : part.indices)
+            indices.push_back(remap[index]);
+        for (GLuint index : part.depthIndices)
+            depthIndices.push_back(depthRemap[index]);
+        mesh.count += (GLsizei)part.indices.size();
+    }
+
+private:
+    // ключ вершины — её байты (позиция и, для полного набора, упакованные атрибуты)
+    struct Key
+    {
+        unsigned char bytes[sizeof(glm::vec3) + sizeof(Surface)];
+        bool operator==(const Key& other) const { return std::memcmp(bytes, other.bytes, sizeof(bytes)) == 0; }
+    };
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const
+        {
+            // FNV-1a
+            size_t hash = 14695981039346656037ull;
+            for (unsigned char byte : key.bytes)
+                hash = (hash ^ byte) * 1099511628211ull;
+            return hash;
+        }
+    };
+
+    std::unordered_map<Key, GLuint, KeyHash> vertexMap;
+    std::unordered_map<Key, GLuint, KeyHash> depthMap;
+    MeshRange mesh;
+
+    template <class Append>
+    static GLuint find(std::unordered_map<Key, GLuint, KeyHash>& map, const glm::vec3& position, const Surface* surface, Append append)
+    {
+        Key key;
+        std::memset(key.bytes, 0, sizeof(key.bytes));
+        std::memcpy(key.bytes, &position, sizeof(glm::vec3));
+        if (surface != nullptr)
+            std::memcpy(key.bytes + sizeof(glm::vec3), surface, sizeof(Surface));
+        auto found = map.find(key);
+        if (found != map.end())
+            return found->second;
+        GLuint index = append();
+        map.emplace(key, index);
+        return index;
+    }
+};
+
+// Потоки индексированной геометрии в окончательном виде для GPU: байты каждого буфера и формат индексов.
+// Заполняется из IndexedGeometry или прямо из отображённого в память файла (CookedMesh) — без копирования
+struct GeometryStreams
+{
+    const void* depthPositions = nullptr;
+    size_t depthPositionBytes = 0;
+    const void* depthIndices = nullptr;
+    size_t depthIndexBytes = 0;
+    const void* positions = nullptr;
+    size_t positionBytes = 0;
+    const void* surfaces = nullptr;
+    size_t surfaceBytes = 0;
+    const void* indices = nullptr;
+    size_t indexBytes = 0;
+    GLenum indexType = GL_UNSIGNED_INT;
+
+    // 16-битные индексы, если их хватает обоим наборам
+    template <class Surface>
+    static GLenum indexTypeFor(const IndexedGeometry<Surface>& geometry)
+    {
+        return geometry.positions.size() <= 0xFFFF && geometry.depthPositions.size() <= 0xFFFF ? GL_UNSIGNED_SHORT
+                                                                                               : GL_UNSIGNED_INT;
+    }
+};
+
+// Буферы индексированной геометрии на GPU и два VAO над ними:
+//  depthVAO   — только поток позиций набора глубины (проходы теней);
+//  surfaceVAO — поток позиций и поток упакованных атрибутов полного набора (основной проход).
+// Индексы хранятся 16-битными, если вершин не больше 65535. Объект — набор дескрипторов без владения
+// (копируется вместе с Mesh), буферы освобождает destroy().
+struct GeometryBuffers
+{
+    enum Stream
+    {
+        DEPTH,
+        SURFACE
+    };
+
+    unsigned int depthVAO = 0;
+    unsigned int surfaceVAO = 0;
+    GLenum indexType = GL_UNSIGNED_INT;
+
+    template <class Surface>
+    void create(const IndexedGeometry<Surface>& geometry, const VertexFormat& surfaceFormat)
+    {
+        GeometryStreams streams;
+        streams.indexType = GeometryStreams::indexTypeFor(geometry);
+        std::vector<GLushort> shortDepthIndices, shortIndices;
+        streams.depthPositions = geometry.depthPositions.data();
+        streams.depthPositionBytes = geometry.depthPositions.size() * sizeof(glm::vec3);
+        streams.positions = geometry.positions.data();
+        streams.positionBytes = geometry.positions.size() * sizeof(glm::vec3);
+        streams.surfaces = geometry.surfaces.data();
+        streams.surfaceBytes = geometry.surfaces.size() * sizeof(Surface);
+        if (streams.indexType == GL_UNSIGNED_SHORT)
+        {
+            shortDepthIndices.assign(geometry.depthIndices.begin(), geometry.depthIndices.end());
+            shortIndices.assign(geometry.indices.begin(), geometry.indices.end());
+            streams.depthIndices = shortDepthIndices.data();
+            streams.indices = shortIndices.data();
+        }
+        else
+        {
+            streams.depthIndices = geometry.depthIndices.data();
+            streams.indices = geometry.indices.data();
+        }
+        streams.depthIndexBytes = geometry.depthIndices.size() * indexSize(streams.indexType);
+        streams.indexBytes = geometry.indices.size() * indexSize(streams.indexType);
+        create(streams, surfaceFormat);
+    }
+
+    void create(const GeometryStreams& streams, const VertexFormat& surfaceFormat)
+    {
+        glGenVertexArrays(1, &depthVAO);
+        glGenVertexArrays(1, &surfaceVAO);
+        glGenBuffers(BUFFER_COUNT, buffers);
+        indexType = streams.indexType;
+
+        glBindVertexArray(depthVAO);
+        upload(GL_ARRAY_BUFFER, buffers[DEPTH_POSITIONS], streams.depthPositions, streams.depthPositionBytes);
+        VertexFormat::position().apply(buffers[DEPTH_POSITIONS]);
+        upload(GL_ELEMENT_ARRAY_BUFFER, buffers[DEPTH_INDICES], streams.depthIndices, streams.depthIndexBytes);
+
+        glBindVertexArray(surfaceVAO);
+        upload(GL_ARRAY_BUFFER, buffers[POSITIONS], streams.positions, streams.positionBytes);
+        VertexFormat::position().apply(buffers[POSITIONS]);
+        upload(GL_ARRAY_BUFFER, buffers[SURFACES], streams.surfaces, streams.surfaceBytes);
+        surfaceFormat.apply(buffers[SURFACES]);
+        upload(GL_ELEMENT_ARRAY_BUFFER, buffers[INDICES], streams.indices, streams.indexBytes);
+
+        // привязка GL_ELEMENT_ARRAY_BUFFER — часть состояния VAO, поэтому сначала отвязываем VAO
+        glBindVertexArray(0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+
+    void destroy()
+    {
+        if (depthVAO == 0)
+            return;
+        glDeleteVertexArrays(1, &depthVAO);
+        glDeleteVertexArrays(1, &surfaceVAO);
+        glDeleteBuffers(BUFFER_COUNT, buffers);
+        depthVAO = surfaceVAO = 0;
+    }
+
+    unsigned int vao(Stream stream) const { return stream == DEPTH ? depthVAO : surfaceVAO; }
+    size_t indexSize() const { return indexSize(indexType); }
+    static size_t indexSize(GLenum type) { return type == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint); }
+
+private:
+    enum
+    {
+        DEPTH_POSITIONS,
+        DEPTH_INDICES,
+        POSITIONS,
+        SURFACES,
+        INDICES,
+        BUFFER_COUNT
+    };
+    unsigned int buffers[BUFFER_COUNT] = {};
+
+    // индексный буфер остаётся привязанным к текущему VAO
+    static void upload(GLenum target, unsigned int buffer, const void* data, size_t bytes)
+    {
+        glBindBuffer(target, buffer);
+        glBufferData(target, (GLsizeiptr)bytes, data, GL_STATIC_DRAW);
+    }
+};
+
+#endif
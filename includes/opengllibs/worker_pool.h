@@ -0,0 +1,108 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Постоянные потоки для работы, которая повторяется каждый кадр: потоки создаются один раз, а run() только
+// будит их, поэтому запуск стоит двух переключений вместо создания и завершения потоков. Вызывающий поток
+// тоже выполняет задания, так что пул из threads потоков держит threads - 1 фоновых.
+class WorkerPool
+{
+public:
+    explicit WorkerPool(unsigned int threads)
+    {
+        threads = std::max(threads, 1u);
+        for (unsigned int t = 1; t < threads; ++t)
+            workers.emplace_back([this]() { workerLoop(); });
+    }
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers)
+            worker.join();
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // потоков, считая вызывающий
+    unsigned int size() const { return (unsigned int)workers.size() + 1; }
+
+    // выполнить task(i) для i из [0, count) и дождаться всех; задания раздаются по одному
+    void run(size_t count, const std::function<void(size_t)>& task)
+    {
+        if (workers.empty() || count <= 1)
+        {
+            for (size_t i = 0; i < count; ++i)
+                task(i);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            current = &task;
+            taskCount = count;
+            next = 0;
+            active = (unsigned int)workers.size();
+            ++generation;
+        }
+        wake.notify_all();
+        work(task, count);
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this]() { return active == 0; });
+        current = nullptr;
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    const std::function<void(size_t)>* current = nullptr;
+    size_t taskCount = 0;
+    std::atomic<size_t> next{ 0 };
+    unsigned int active = 0;           // фоновых потоков, ещё не закончивших текущий run()
+    unsigned long long generation = 0; // номер run(): поток просыпается только на новый
+    bool stopping = false;
+
+    void work(const std::function<void(size_t)>& task, size_t count)
+    {
+        for (size_t i = next++; i < count; i = next++)
+            task(i);
+    }
+
+    void workerLoop()
+    {
+        unsigned long long seen = 0;
+        for (;;)
+        {
+            const std::function<void(size_t)>* task;
+            size_t count;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&]() { return stopping || generation != seen; });
+                if (stopping)
+                    return;
+                seen = generation;
+                task = current;
+                count = taskCount;
+            }
+            work(*task, count);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--active == 0)
+                done.notify_one();
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,314 @@
+// mesh_cooker — офлайн-подготовка моделей для демо: модель (OBJ, glTF, FBX, ... — всё, что читает ASSIMP)
+// импортируется один раз с теми же флагами, что и в Model, вершины упаковываются и индексируются так же, как
+// в Mesh::setupMesh, и результат вместе с границами, материалами и уровнями детализации записывается в .cmesh
+// (см. CookedMesh). Model загружает .cmesh без ASSIMP: файл отображается в память, потоки уходят в буферы GPU.
+// Пути текстур материалов записываются относительно выходного файла, а не входа.
+//
+// mesh_cooker [--lods N] [--threads N] [--bench] [--bench-threads] [--runs N] (-o FILE | --out-dir DIR) INPUT...
+// --lods N       уровней детализации на меш, считая полный (1..4, по умолчанию 3); уровни строятся кластеризацией
+//                вершин со стороной куба 1/64, 1/32, 1/16 диагонали меша, пока уменьшают число треугольников
+//                хотя бы на четверть
+// --threads N    потоков преобразования мешей (Model::convertMeshes; по умолчанию — по числу ядер)
+// -o FILE        выходной файл (только для одного входа)
+// --out-dir DIR  выходные файлы DIR/<имя входа>.cmesh
+// --bench        замер загрузки каждого входа в контексте OpenGL без окна (HeadlessContext): Model(вход) —
+//                импорт ASSIMP, преобразование и загрузка в буферы — против Model(.cmesh) — отображение файла и
+//                glBufferData прямо из него; оба до glFinish, лучшее из --runs прогонов, файлы — в кэше ОС,
+//                текстуры материалов — из TextureCache (загружаются один раз до замера)
+// --bench-threads пропускная способность преобразования мешей (треугольников в секунду) при 1, 2, 4, ... потоках
+//                до числа ядер; импорт ASSIMP однопоточный и замеряется отдельно
+// --runs N       прогонов замера (по умолчанию 5)
+// -----------------------------------------------------------------------------------------------------------
+#include <opengllibs/headless.h>
+#include <opengllibs/mesh_container.h>
+#include <opengllibs/mesh_lod.h>
+#include <opengllibs/model.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct CookerOptions
+{
+    int lods = 3;
+    unsigned int threads = 0; // 0 — по числу ядер
+    bool bench = false;
+    bool benchThreads = false;
+    int runs = 5;
+    std::string output;
+    std::string outputDirectory;
+    std::vector<std::string> inputs;
+};
+
+static bool parseArguments(int argc, char** argv, CookerOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--lods" && hasValue)
+            options.lods = std::max(1, std::min(std::atoi(argv[++i]), CookedMesh::MAX_LODS));
+        else if (arg == "--threads" && hasValue)
+            options.threads = (unsigned int)std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--bench")
+            options.bench = true;
+        else if (arg == "--bench-threads")
+            options.benchThreads = true;
+        else if (arg == "--runs" && hasValue)
+            options.runs = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "-o" && hasValue)
+            options.output = argv[++i];
+        else if (arg == "--out-dir" && hasValue)
+            options.outputDirectory = argv[++i];
+        else if (!arg.empty() && arg[0] != '-')
+            options.inputs.push_back(arg);
+        else
+        {
+            std::cout << "Unknown argument: " << arg << std::endl;
+            return false;
+        }
+    }
+    if (options.inputs.empty() || (options.output.empty() && options.outputDirectory.empty()) ||
+        (!options.output.empty() && options.inputs.size() > 1))
+    {
+        std::cout << "Usage: mesh_cooker [--lods N] [--threads N] [--bench] [--bench-threads] [--runs N]"
+                     " (-o FILE | --out-dir DIR) INPUT..." << std::endl;
+        return false;
+    }
+    if (options.threads == 0)
+        options.threads = std::max(1u, std::thread::hardware_concurrency());
+    return true;
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// меши сцены, преобразованные так же, как в Model (Model::convertMeshes), в записываемом виде
+static void convertScene(const aiScene* scene, unsigned int threads, std::vector<CookedMesh::SourceMesh>& meshes)
+{
+    std::vector<MeshData> converted = Model::convertMeshes(scene, threads);
+    meshes.clear();
+    meshes.resize(converted.size());
+    for (size_t i = 0; i < converted.size(); ++i)
+    {
+        meshes[i].geometry = std::move(converted[i].packed);
+        meshes[i].lods.assign(1, converted[i].range);
+        meshes[i].bounds = converted[i].bounds;
+        meshes[i].material = converted[i].material;
+    }
+}
+
+// уровни детализации 1..lods-1; уровень, который почти не упрощает меш, не записывается
+static void buildLods(CookedMesh::SourceMesh& mesh, int lods)
+{
+    const float diagonal = glm::length(mesh.bounds.max - mesh.bounds.min);
+    for (int level = 1; level < lods && diagonal > 0.0f; ++level)
+    {
+        MeshRange lod = appendClusteredLod(mesh.geometry, mesh.lods[0], diagonal * CookedMesh::lodCellFraction(level));
+        if (lod.count == 0 || lod.count > mesh.lods.back().count * 3 / 4)
+        {
+            mesh.geometry.indices.resize(lod.firstIndex);
+            mesh.geometry.depthIndices.resize(lod.firstIndex);
+            break;
+        }
+        mesh.lods.push_back(lod);
+    }
+}
+
+// директория файла path; пустая (файл в текущей директории) — "."
+static std::filesystem::path directoryOf(const std::string& path)
+{
+    std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    return parent.empty() ? std::filesystem::path(".") : parent;
+}
+
+// путь текстуры материала относительно директории входа -> относительно директории .cmesh: Model::loadCooked
+// ищет текстуры от файла модели, а выход может лежать в другой директории (-o, --out-dir)
+static std::string rebaseTexturePath(const std::string& path, const std::filesystem::path& inputDirectory,
+                                     const std::filesystem::path& outputDirectory)
+{
+    std::error_code error;
+    std::filesystem::path rebased = std::filesystem::relative(inputDirectory / path, outputDirectory, error);
+    return error || rebased.empty() ? path : rebased.generic_string();
+}
+
+// импорт и преобразование мешей; false — ASSIMP не прочитал файл
+static bool importModel(const std::string& input, unsigned int threads, std::vector<CookedMesh::SourceMesh>& meshes,
+                        std::vector<std::vector<CookedMesh::MaterialTexture>>* materials, double& importSeconds,
+                        double& convertSeconds)
+{
+    auto start = std::chrono::steady_clock::now();
+    Assimp::Importer importer;
+    const aiScene* scene = importer.ReadFile(input, Model::IMPORT_FLAGS);
+    importSeconds = secondsSince(start);
+    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+    {
+        std::cout << "Cannot import " << input << ": " << importer.GetErrorString() << std::endl;
+        return false;
+    }
+    start = std::chrono::steady_clock::now();
+    convertScene(scene, threads, meshes);
+    convertSeconds = secondsSince(start);
+    if (materials != nullptr)
+        for (unsigned int m = 0; m < scene->mNumMaterials; ++m)
+            materials->push_back(Model::readMaterial(scene->mMaterials[m]));
+    return true;
+}
+
+// время создания Model(path) вместе с загрузкой в GPU; false — модель не загрузилась
+static bool loadModel(const std::string& path, unsigned int threads, double& seconds, size_t& triangles)
+{
+    auto start = std::chrono::steady_clock::now();
+    Model model(path, false, nullptr, threads);
+    glFinish();
+    seconds = secondsSince(start);
+    triangles = 0;
+    for (const Mesh& mesh : model.meshes)
+        triangles += mesh.lods[0].count / 3;
+    return !model.meshes.empty();
+}
+
+static void benchmarkModel(const std::string& input, const std::string& output, unsigned int threads, int runs)
+{
+    HeadlessContext context;
+    if (!context.create(4, 1) || !gladLoadGLLoader(context.loader()))
+    {
+        std::cout << "  no OpenGL context, load benchmark skipped" << std::endl;
+        return;
+    }
+    {
+        // текстуры материалов попадают в TextureCache, оба пути дальше получают их из кэша
+        double seconds = 0.0;
+        size_t assimpTriangles = 0, cookedTriangles = 0;
+        if (!loadModel(output, threads, seconds, cookedTriangles) || !loadModel(input, threads, seconds, assimpTriangles) ||
+            assimpTriangles != cookedTriangles)
+        {
+            std::cout << "  " << output << " does not load as " << input << std::endl;
+            TextureCache::get().clear();
+            context.destroy();
+            return;
+        }
+        double bestAssimp = 1e30, bestCooked = 1e30;
+        for (int run = 0; run < runs; ++run)
+        {
+            loadModel(input, threads, seconds, assimpTriangles);
+            bestAssimp = std::min(bestAssimp, seconds);
+            loadModel(output, threads, seconds, cookedTriangles);
+            bestCooked = std::min(bestCooked, seconds);
+        }
+        std::error_code error;
+        char line[256];
+        std::snprintf(line, sizeof(line), "  assimp %9.2f ms, %10ju bytes\n  cooked %9.2f ms, %10ju bytes, %.1fx faster (%zu triangles)",
+                      bestAssimp * 1000.0, (uintmax_t)std::filesystem::file_size(input, error), bestCooked * 1000.0,
+                      (uintmax_t)std::filesystem::file_size(output, error), bestAssimp / bestCooked, cookedTriangles);
+        std::cout << line << std::endl;
+    }
+    TextureCache::get().clear();
+    context.destroy();
+}
+
+// преобразование мешей одной и той же импортированной сцены при 1, 2, 4, ... потоках и при числе ядер
+static void benchmarkThreads(const std::string& input, int runs)
+{
+    auto start = std::chrono::steady_clock::now();
+    Assimp::Importer importer;
+    const aiScene* scene = importer.ReadFile(input, Model::IMPORT_FLAGS);
+    double importSeconds = secondsSince(start);
+    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+        return;
+    size_t triangles = 0;
+    for (unsigned int m = 0; m < scene->mNumMeshes; ++m)
+        triangles += scene->mMeshes[m]->mNumFaces;
+    const unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned int> counts;
+    for (unsigned int threads = 1; threads < cores; threads *= 2)
+        counts.push_back(threads);
+    counts.push_back(cores);
+
+    char line[256];
+    std::snprintf(line, sizeof(line), "  %zu triangles in %u meshes, import %.2f ms (%.2f Mtri/s, one thread)", triangles,
+                  scene->mNumMeshes, importSeconds * 1000.0, triangles / importSeconds / 1e6);
+    std::cout << line << std::endl;
+    double single = 0.0;
+    for (unsigned int threads : counts)
+    {
+        double best = 1e30;
+        for (int run = 0; run < runs; ++run)
+        {
+            start = std::chrono::steady_clock::now();
+            std::vector<MeshData> converted = Model::convertMeshes(scene, threads);
+            best = std::min(best, secondsSince(start));
+        }
+        if (threads == 1)
+            single = best;
+        std::snprintf(line, sizeof(line), "  threads %3u: convert %9.2f ms, %7.2f Mtri/s (%.2fx), with import %7.2f Mtri/s",
+                      threads, best * 1000.0, triangles / best / 1e6, single / best, triangles / (importSeconds + best) / 1e6);
+        std::cout << line << std::endl;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    CookerOptions options;
+    if (!parseArguments(argc, argv, options))
+        return 1;
+
+    int failures = 0;
+    for (const std::string& input : options.inputs)
+    {
+        std::vector<CookedMesh::SourceMesh> meshes;
+        std::vector<std::vector<CookedMesh::MaterialTexture>> materials;
+        double importSeconds = 0.0, convertSeconds = 0.0;
+        if (!importModel(input, options.threads, meshes, &materials, importSeconds, convertSeconds))
+        {
+            ++failures;
+            continue;
+        }
+        size_t triangles = 0, vertices = 0, lodTriangles = 0;
+        for (CookedMesh::SourceMesh& mesh : meshes)
+        {
+            buildLods(mesh, options.lods);
+            triangles += mesh.lods[0].count / 3;
+            vertices += mesh.geometry.positions.size();
+            lodTriangles += mesh.lods.back().count / 3;
+        }
+
+        std::string output = options.output;
+        if (output.empty())
+            output = (std::filesystem::path(options.outputDirectory) / std::filesystem::path(input).stem()).string() + ".cmesh";
+        std::error_code error;
+        std::filesystem::path parent = std::filesystem::path(output).parent_path();
+        if (!parent.empty())
+            std::filesystem::create_directories(parent, error);
+        // текстуры — относительно .cmesh; ненайденная от выхода текстура не загрузится и в Model
+        for (std::vector<CookedMesh::MaterialTexture>& material : materials)
+            for (CookedMesh::MaterialTexture& texture : material)
+            {
+                texture.second = rebaseTexturePath(texture.second, directoryOf(input), directoryOf(output));
+                if (!std::filesystem::exists(directoryOf(output) / texture.second, error))
+                    std::cout << "Warning: texture " << texture.second << " of " << output << " does not exist" << std::endl;
+            }
+        if (!CookedMesh::write(output, meshes, materials))
+        {
+            std::cout << "Cannot write " << output << std::endl;
+            ++failures;
+            continue;
+        }
+        std::cout << input << " -> " << output << " (" << meshes.size() << " meshes, " << materials.size()
+                  << " materials, " << vertices << " vertices, " << triangles << " triangles, coarsest lod "
+                  << lodTriangles << " triangles)" << std::endl;
+
+        if (options.bench)
+            benchmarkModel(input, output, options.threads, options.runs);
+        if (options.benchThreads)
+            benchmarkThreads(input, options.runs);
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,679 @@
+#include "point_shadows_soft.h"
+
+// микробенчмарки и проверки демо, которые выполняются вместо цикла рендеринга (--bench-*, --shadow-precision,
+// --verify-clusters); отчёт каждого — через writeReport
+
+void writeReport(const std::string &report)
+{
+    if (options.jsonPath.empty())
+    {
+        std::cout << report;
+        return;
+    }
+    std::ofstream file(options.jsonPath);
+    file << report;
+    if (!file)
+        std::cout << "Failed to write report: " << options.jsonPath << std::endl;
+}
+
+void writeReport(const Benchmark &benchmark)
+{
+    std::ostringstream report;
+    benchmark.writeJson(report);
+    writeReport(report.str());
+}
+
+// микробенчмарк установки униформ (--bench-uniforms): данные одного кадра с одним источником —
+// проход теней через геометрический шейдер и основной проход, модель и reverse_normals каждого объекта —
+// передаются тремя способами:
+//  by_name — обычные униформы, строка имени и glGetUniformLocation на каждый вызов set*;
+//  handles — обычные униформы через дескрипторы Shader::Uniform, матрицы граней одним вызовом;
+//  ubo     — текущий путь: блоки Camera и ShadowPass в кольцевом буфере, матрицы моделей обоих проходов —
+//            одной загрузкой буфера экземпляров (SceneSubmitter).
+// Для by_name и handles используется отдельная программа point_shadows_uniform_bench с обычными униформами.
+// Один "кадр" бенчмарка — все способы подряд; отчёт содержит CPU-время и число вызовов OpenGL каждого.
+// ----------------------------------------------------------------------------------------------------
+void runUniformBenchmark(const PassProgram &lit, const PassProgram &depth, UniformRing &ring, SceneSubmitter &submitter)
+{
+    GLCallCounter &calls = GLCallCounter::get();
+    Shader benchShader("point_shadows_uniform_bench.vs", "point_shadows_uniform_bench.fs");
+    const Shader::Uniform<glm::mat4> uProjection = benchShader.uniform<glm::mat4>("projection");
+    const Shader::Uniform<glm::mat4> uView = benchShader.uniform<glm::mat4>("view");
+    const Shader::Uniform<glm::mat4> uModel = benchShader.uniform<glm::mat4>("model");
+    const Shader::Uniform<glm::mat4> uShadowMatrices = benchShader.uniform<glm::mat4>("shadowMatrices");
+    const Shader::Uniform<glm::vec3> uLightPos = benchShader.uniform<glm::vec3>("lightPos");
+    const Shader::Uniform<glm::vec3> uViewPos = benchShader.uniform<glm::vec3>("viewPos");
+    const Shader::Uniform<float> uFarPlane = benchShader.uniform<float>("far_plane");
+    const Shader::Uniform<int> uFaceMask = benchShader.uniform<int>("faceMask");
+    const Shader::Uniform<int> uLayerBase = benchShader.uniform<int>("layerBase");
+    const Shader::Uniform<int> uReverseNormals = benchShader.uniform<int>("reverse_normals");
+    const Shader::Uniform<int> uShadows = benchShader.uniform<int>("shadows");
+
+    PointLight light;
+    light.slot.tier = 0;
+    light.slot.index = 0;
+    GpuShadowPass shadowBlock;
+    prepareLightShadow(light, shadowBlock);
+    const glm::mat4 *shadowTransforms = shadowBlock.shadowMatrices;
+    const glm::vec3 lightPos = light.position;
+    const float far_plane = light.farPlane;
+    GpuCamera cameraBlock;
+    cameraBlock.projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, CAMERA_NEAR, CAMERA_FAR);
+    cameraBlock.view = camera.GetViewMatrix();
+    cameraBlock.viewPos = glm::vec4(camera.Position, 1.0f);
+    cameraBlock.inverseViewProjection = glm::inverse(cameraBlock.projection * cameraBlock.view);
+    const glm::mat4 &projection = cameraBlock.projection;
+    const glm::mat4 &view = cameraBlock.view;
+
+    Benchmark benchmark;
+    int byNamePass = benchmark.addPass("by_name");
+    int handlesPass = benchmark.addPass("handles");
+    int uboPass = benchmark.addPass("ubo");
+    const int iterations = options.warmup + options.frames;
+    for (int iteration = 0; iteration < iterations; ++iteration)
+    {
+        benchmark.setRecording(iteration >= options.warmup);
+        benchmark.beginFrame();
+
+        // by_name: поиск положения по строке на каждый вызов
+        calls.reset();
+        benchmark.beginPass(byNamePass);
+        unsigned int program = benchShader.ID;
+        glUseProgram(program);
+        for (unsigned int i = 0; i < 6; ++i)
+            glUniformMatrix4fv(glGetUniformLocation(program, ("shadowMatrices[" + std::to_string(i) + "]").c_str()), 1, GL_FALSE, &shadowTransforms[i][0][0]);
+        glUniform1f(glGetUniformLocation(program, std::string("far_plane").c_str()), far_plane);
+        glUniform3fv(glGetUniformLocation(program, std::string("lightPos").c_str()), 1, &lightPos[0]);
+        glUniform1i(glGetUniformLocation(program, std::string("faceMask").c_str()), (int)CUBE_FACE_ALL);
+        glUniform1i(glGetUniformLocation(program, std::string("layerBase").c_str()), 0);
+        for (int passIndex = 0; passIndex < 2; ++passIndex)
+        {
+            if (passIndex == 1)
+            {
+                glUseProgram(program);
+                glUniformMatrix4fv(glGetUniformLocation(program, std::string("projection").c_str()), 1, GL_FALSE, &projection[0][0]);
+                glUniformMatrix4fv(glGetUniformLocation(program, std::string("view").c_str()), 1, GL_FALSE, &view[0][0]);
+                glUniform3fv(glGetUniformLocation(program, std::string("viewPos").c_str()), 1, &camera.Position[0]);
+                glUniform1i(glGetUniformLocation(program, std::string("shadows").c_str()), (int)shadows);
+            }
+            for (const SceneObject &object : scene)
+            {
+                glUniformMatrix4fv(glGetUniformLocation(program, std::string("model").c_str()), 1, GL_FALSE, &object.model[0][0]);
+                if (object.insideOut)
+                {
+                    glUniform1i(glGetUniformLocation(program, std::string("reverse_normals").c_str()), 1);
+                    glUniform1i(glGetUniformLocation(program, std::string("reverse_normals").c_str()), 0);
+                }
+            }
+        }
+        benchmark.endPass(byNamePass);
+        benchmark.setCounter("by_name_gl_calls", (double)calls.total());
+        benchmark.setCounter("by_name_uniform_location_queries", (double)calls.count("glGetUniformLocation"));
+
+        // handles: те же униформы через дескрипторы
+        calls.reset();
+        benchmark.beginPass(handlesPass);
+        benchShader.use();
+        benchShader.set(uShadowMatrices, shadowTransforms, 6);
+        benchShader.set(uFarPlane, far_plane);
+        benchShader.set(uLightPos, lightPos);
+        benchShader.set(uFaceMask, (int)CUBE_FACE_ALL);
+        benchShader.set(uLayerBase, 0);
+        for (int passIndex = 0; passIndex < 2; ++passIndex)
+        {
+            if (passIndex == 1)
+            {
+                benchShader.use();
+                benchShader.set(uProjection, projection);
+                benchShader.set(uView, view);
+                benchShader.set(uViewPos, camera.Position);
+                benchShader.set(uShadows, (int)shadows);
+            }
+            for (const SceneObject &object : scene)
+            {
+                benchShader.set(uModel, object.model);
+                if (object.insideOut)
+                {
+                    benchShader.set(uReverseNormals, 1);
+                    benchShader.set(uReverseNormals, 0);
+                }
+            }
+        }
+        benchmark.endPass(handlesPass);
+        benchmark.setCounter("handles_gl_calls", (double)calls.total());
+        benchmark.setCounter("handles_uniform_location_queries", (double)calls.count("glGetUniformLocation"));
+
+        // ubo: данные кадра одной записью в кольцевой буфер, привязка диапазонов, матрицы моделей — экземпляры
+        calls.reset();
+        benchmark.beginPass(uboPass);
+        ring.beginFrame();
+        size_t cameraOffset = ring.push(cameraBlock);
+        size_t shadowOffset = ring.push(shadowBlock);
+        ring.flush();
+        ring.bind(CAMERA_UBO_BINDING, cameraOffset, sizeof(GpuCamera));
+        ring.bind(SHADOW_PASS_UBO_BINDING, shadowOffset, sizeof(GpuShadowPass));
+        submitter.beginFrame();
+        queueScene(submitter, nullptr, CUBE_FACE_ALL, false);
+        queueScene(submitter, nullptr, CUBE_FACE_ALL, false);
+        submitter.upload();
+        for (int passIndex = 0; passIndex < 2; ++passIndex)
+        {
+            const PassProgram &pass = passIndex == 0 ? depth : lit;
+            pass.shader->use();
+            if (passIndex == 1)
+                lit.shader->set(lit.shadows, (int)shadows);
+            // как в drawScene: reverse_normals на время партии объектов, рисуемых изнутри
+            pass.shader->set(pass.reverseNormals, 1);
+            pass.shader->set(pass.reverseNormals, 0);
+        }
+        ring.endFrame();
+        benchmark.endPass(uboPass);
+        benchmark.setCounter("ubo_gl_calls", (double)calls.total());
+        benchmark.setCounter("ubo_uniform_location_queries", (double)calls.count("glGetUniformLocation"));
+        benchmark.endFrame();
+    }
+    benchmark.finish();
+    benchmark.setInfo("renderer", (const char*)glGetString(GL_RENDERER));
+    benchmark.setInfo("benchmark", "uniforms");
+    benchmark.setInfo("objects", std::to_string(scene.size()));
+    benchmark.setInfo("ubo_mode", ring.modeName());
+    writeReport(benchmark);
+}
+
+// отчёт о точности хранения карт теней (--shadow-precision): кубическая карта источника в центре комнаты строится
+// в каждом режиме ShadowStorage, читается обратно и сравнивается с эталоном — расстоянием до сцены, посчитанным
+// на CPU в float пересечением луча через центр каждого texel'а с кубами сцены (кубы не повёрнуты, поэтому их AABB
+// точны). Ошибка — |восстановленное расстояние - эталон| в мировых единицах, texels_above_bias — доля texel'ов,
+// где она больше смещения глубины основного прохода. Для каждого режима также замеряется проход теней
+// (warmup + frames кадров) и объём атласа. Отчёт — массив JSON по режимам.
+// ---------------------------------------------------------------------------------------------------------------
+void runPrecisionReport(ShadowAtlas &atlas, const DepthPrograms &programs, UniformRing &ring, SceneSubmitter &submitter)
+{
+    const float near_plane = 1.0f; // совпадает с prepareLightShadow
+    const float bias = 0.15f;      // совпадает со смещением в ShadowCalculation (point_shadows.fs)
+    PointLight light;
+    light.slot.tier = 0;
+    light.slot.index = 0;
+    const float far_plane = light.farPlane;
+    const int resolution = atlas.tier(0).resolution;
+
+    // эталон: расстояние от источника до ближайшей поверхности вдоль луча через центр каждого texel'а 6 граней
+    // (порядок как у слоёв массива: грань, строка, столбец)
+    std::vector<glm::vec3> directions((size_t)6 * resolution * resolution);
+    std::vector<float> reference(directions.size());
+    for (int face = 0; face < 6; ++face)
+        for (int y = 0; y < resolution; ++y)
+            for (int x = 0; x < resolution; ++x)
+            {
+                size_t i = ((size_t)face * resolution + y) * resolution + x;
+                glm::vec2 st = (glm::vec2((float)x, (float)y) + 0.5f) / (float)resolution * 2.0f - 1.0f;
+                directions[i] = cubeFaceDirection(face, st);
+                glm::vec3 ray = glm::normalize(directions[i]);
+                float nearest = far_plane;
+                for (const SceneObject &object : scene)
+                {
+                    float tNear, tFar;
+                    if (!object.bounds.intersectRay(light.position, ray, tNear, tFar))
+                        continue;
+                    // комната видна изнутри (выход луча), остальные кубы — снаружи (вход)
+                    float t = object.insideOut ? tFar : tNear;
+                    if (t > 0.0f)
+                        nearest = std::min(nearest, t);
+                }
+                reference[i] = nearest;
+            }
+
+    std::ostringstream reports;
+    for (int mode = 0; mode < SHADOW_STORAGE_COUNT; ++mode)
+    {
+        const ShadowStorage storage = (ShadowStorage)mode;
+        atlas.setStorage(storage);
+
+        Benchmark benchmark;
+        int shadowPass = benchmark.addPass("shadow");
+        const int iterations = options.warmup + options.frames;
+        for (int iteration = 0; iteration < iterations; ++iteration)
+        {
+            benchmark.setRecording(iteration >= options.warmup);
+            benchmark.beginFrame();
+            ring.beginFrame();
+            light.cache.invalidate(); // каждый кадр — все 6 граней, независимо от --shadow-cache
+            GpuShadowPass shadowBlock;
+            unsigned int renderFaces = prepareLightShadow(light, shadowBlock);
+            size_t shadowOffset = ring.push(shadowBlock);
+            ring.flush();
+            ring.bind(SHADOW_PASS_UBO_BINDING, shadowOffset, sizeof(GpuShadowPass));
+            submitter.beginFrame();
+            LightShadowBatches batches = queueLightShadow(light, renderFaces, atlas.tier(light.slot.tier).resolution, submitter);
+            submitter.upload();
+            benchmark.beginPass(shadowPass);
+            renderLightShadow(light, renderFaces, batches, atlas, programs, submitter);
+            benchmark.endPass(shadowPass);
+            ring.endFrame();
+            benchmark.endFrame();
+        }
+        benchmark.finish();
+
+        // чтение яруса целиком (первые 6 слоёв — кубическая карта источника) и ошибка каждого texel'а
+        const ShadowAtlas::Tier &tier = atlas.tier(0);
+        std::vector<float> stored((size_t)tier.resolution * tier.resolution * tier.capacity * 6);
+        glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, tier.texture);
+        glGetTexImage(GL_TEXTURE_CUBE_MAP_ARRAY, 0, storesDistance(storage) ? GL_RED : GL_DEPTH_COMPONENT, GL_FLOAT,
+                      stored.data());
+        glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, 0);
+        std::vector<double> errors(reference.size());
+        double sum = 0.0, sumSquares = 0.0;
+        size_t aboveBias = 0;
+        for (size_t i = 0; i < reference.size(); ++i)
+        {
+            // то же восстановление, что StoredToDistance в point_shadows.fs (наибольшая координата направления — 1)
+            float distance = stored[i] * far_plane;
+            if (!storesDistance(storage))
+                distance = near_plane * far_plane / (far_plane - stored[i] * (far_plane - near_plane)) * glm::length(directions[i]);
+            errors[i] = std::fabs((double)distance - reference[i]);
+            sum += errors[i];
+            sumSquares += errors[i] * errors[i];
+            aboveBias += errors[i] > bias ? 1 : 0;
+        }
+        // p99 отделяет ошибку формата от единичных texel'ов на силуэтах, где растеризация и луч расходятся
+        std::vector<double>::iterator p99 = errors.begin() + (size_t)(0.99 * (errors.size() - 1));
+        std::nth_element(errors.begin(), p99, errors.end());
+        double p99Error = *p99;
+        double maxError = *std::max_element(errors.begin(), errors.end());
+
+        benchmark.setCounter("error_mean", sum / errors.size());
+        benchmark.setCounter("error_rms", std::sqrt(sumSquares / errors.size()));
+        benchmark.setCounter("error_p99", p99Error);
+        benchmark.setCounter("error_max", maxError);
+        benchmark.setCounter("texels_above_bias", (double)aboveBias / errors.size());
+        benchmark.setCounter("bytes_per_texel", (double)atlas.bytesPerTexel());
+        benchmark.setCounter("atlas_mb", (double)atlas.memoryBytes() / (1024.0 * 1024.0));
+        benchmark.setInfo("renderer", (const char*)glGetString(GL_RENDERER));
+        benchmark.setInfo("benchmark", "shadow_precision");
+        benchmark.setInfo("shadow_storage", shadowStorageNames[storage]);
+        benchmark.setInfo("shadow_path", shadowPathNames[shadowPath]);
+        benchmark.setInfo("face_resolution", std::to_string(resolution));
+        benchmark.setInfo("objects", std::to_string(scene.size()));
+        if (mode > 0)
+            reports << ",\n";
+        benchmark.writeJson(reports);
+    }
+    atlas.setStorage(options.shadowStorage);
+
+    std::string report = "[\n" + reports.str() + "]\n";
+    writeReport(report);
+}
+
+// сжатая копия source для микробенчмарка: то же, что делает texture_cooker с форматом auto
+// ------------------------------------------------------------------------------------------
+static bool cookBenchmarkTexture(const std::string& source, const std::string& target)
+{
+    int width = 0, height = 0, channels = 0;
+    unsigned char* data = stbi_load(source.c_str(), &width, &height, &channels, 4);
+    if (data == nullptr)
+        return false;
+    RGBAImage image(width, height);
+    std::copy(data, data + image.pixels.size(), image.pixels.begin());
+    stbi_image_free(data);
+    std::vector<RGBAImage> mips = image.mipChain();
+    BlockFormat format = BlockCompression::automaticFormat(channels);
+    std::vector<std::vector<uint8_t>> levels(mips.size());
+    std::vector<std::pair<int, int>> sizes;
+    for (size_t i = 0; i < mips.size(); ++i)
+    {
+        BlockCompression::encode(format, mips[i], levels[i]);
+        sizes.push_back({ mips[i].width, mips[i].height });
+    }
+    return CookedTexture::write(target, format, channels == 4 ? CookedTexture::FLAG_ALPHA : 0, sizes, levels);
+}
+
+// микробенчмарк загрузки текстур (--bench-textures): синтетическая директория texture_bench из options.textureCount
+// копий текстур resources/textures (PNG и JPEG, декодирование настоящее) загружается TEXTURE_BENCH_RUNS раз двумя
+// способами:
+//  sync     — loadTexture() подряд в потоке рендеринга, как при старте демо без стриминга;
+//  streamed — TextureStreamer: все запросы, затем "кадры" update() в пределах бюджета до загрузки всех текстур;
+//  cooked   — loadCookedTexture() тех же текстур, сжатых заранее (cookBenchmarkTexture, по формату на источник);
+//  cached   — loadTexture() через TextureCache: копии с одинаковым содержимым загружаются один раз.
+// Первый прогон — прогрев (файловый кэш ОС). Отчёт — время до первого кадра (синхронно — вся загрузка,
+// со стримингом — только запросы), время до загрузки всех текстур, число кадров загрузки и худший update(),
+// а также занятая текстурами видеопамять без сжатия и со сжатием.
+// ----------------------------------------------------------------------------------------------------------
+void runTextureBenchmark()
+{
+    const int TEXTURE_BENCH_RUNS = 5;
+    const std::string directory = "texture_bench";
+    const std::string sources[] = { FileSystem::getPath("resources/textures/wood.png"),
+                                    FileSystem::getPath("resources/textures/grass.jpeg") };
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    std::string cookedSources[2];
+    for (int i = 0; i < 2; ++i)
+    {
+        cookedSources[i] = (std::filesystem::path(directory) / std::filesystem::path(sources[i]).stem()).string() + ".ctex";
+        if (!std::filesystem::exists(cookedSources[i]) && !cookBenchmarkTexture(sources[i], cookedSources[i]))
+        {
+            std::cout << "Cannot cook " << sources[i] << std::endl;
+            return;
+        }
+    }
+    std::vector<std::string> files, cookedFiles;
+    for (int i = 0; i < options.textureCount; ++i)
+    {
+        const std::string& source = sources[i % 2];
+        char name[32];
+        std::snprintf(name, sizeof(name), "texture_%04d", i);
+        std::string file = (std::filesystem::path(directory) / name).string() + std::filesystem::path(source).extension().string();
+        std::string cookedFile = (std::filesystem::path(directory) / name).string() + ".ctex";
+        if (!std::filesystem::exists(file))
+            std::filesystem::copy_file(source, file, error);
+        if (!error && !std::filesystem::exists(cookedFile))
+            std::filesystem::copy_file(cookedSources[i % 2], cookedFile, error);
+        if (error)
+        {
+            std::cout << "Cannot create " << file << ": " << error.message() << std::endl;
+            return;
+        }
+        files.push_back(file);
+        cookedFiles.push_back(cookedFile);
+    }
+
+    // видеопамять: несжатая текстура — RGBA8 (драйверы хранят GL_RGB в 4 байтах) с мип-уровнями, сжатая — уровни файла
+    double sourceBytes = 0.0, cookedBytes = 0.0;
+    for (int i = 0; i < options.textureCount; ++i)
+    {
+        CookedTexture cooked;
+        if (!cooked.open(cookedFiles[i]))
+            continue;
+        for (int l = 0; l < cooked.levelCount(); ++l)
+            sourceBytes += 4.0 * cooked.level(l).width * cooked.level(l).height;
+        cookedBytes += (double)cooked.dataBytes();
+    }
+
+    const size_t budget = (size_t)options.textureBudgetKB * 1024;
+    const unsigned int threads = TextureStreamer::defaultThreads();
+    Benchmark benchmark;
+    int syncPass = benchmark.addPass("sync");
+    int streamedPass = benchmark.addPass("streamed");
+    int cookedPass = benchmark.addPass("cooked");
+    int cachedPass = benchmark.addPass("cached");
+    std::vector<GLuint> textures;
+    for (int run = 0; run <= TEXTURE_BENCH_RUNS; ++run)
+    {
+        benchmark.setRecording(run > 0);
+        benchmark.beginFrame();
+
+        // синхронно: первый кадр ждёт все текстуры
+        benchmark.beginPass(syncPass);
+        auto start = std::chrono::steady_clock::now();
+        textures.clear();
+        for (const std::string& file : files)
+            textures.push_back(loadTexture(file.c_str()));
+        glFinish();
+        double syncSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        benchmark.endPass(syncPass);
+        glDeleteTextures((GLsizei)textures.size(), textures.data());
+
+        // потоково: первый кадр ждёт только запросы, дальше по бюджету за кадр
+        benchmark.beginPass(streamedPass);
+        start = std::chrono::steady_clock::now();
+        TextureStreamer streamer(threads, budget);
+        textures.clear();
+        for (const std::string& file : files)
+            textures.push_back(streamer.request(file));
+        double requestSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        int uploadFrames = 0;
+        double worstUpdate = 0.0;
+        while (!streamer.idle())
+        {
+            streamer.update();
+            glFlush();
+            worstUpdate = std::max(worstUpdate, streamer.lastUpdateTime());
+            if (streamer.lastFrameBytes() > 0)
+                ++uploadFrames;
+            else
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        glFinish();
+        double streamSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        benchmark.endPass(streamedPass);
+
+        glDeleteTextures((GLsizei)textures.size(), textures.data());
+
+        // сжатые заранее: первый кадр ждёт только передачу блоков драйверу
+        benchmark.beginPass(cookedPass);
+        start = std::chrono::steady_clock::now();
+        textures.clear();
+        int cookedFailed = 0;
+        for (const std::string& file : cookedFiles)
+        {
+            textures.push_back(loadCookedTexture(file));
+            cookedFailed += textures.back() == 0 ? 1 : 0;
+        }
+        glFinish();
+        double cookedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        benchmark.endPass(cookedPass);
+        glDeleteTextures((GLsizei)textures.size(), textures.data());
+
+        // через кэш: загружаются только различные файлы, остальное — попадания
+        TextureCache& cache = TextureCache::get();
+        const unsigned long long hitsBefore = cache.hits(), missesBefore = cache.misses();
+        benchmark.beginPass(cachedPass);
+        start = std::chrono::steady_clock::now();
+        textures.clear();
+        for (const std::string& file : files)
+            textures.push_back(cache.acquire(file, [](const std::string& path) { return loadTexture(path.c_str()); }));
+        glFinish();
+        double cachedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        benchmark.endPass(cachedPass);
+        benchmark.setCounter("cache_first_frame_ms", cachedSeconds * 1000.0);
+        benchmark.setCounter("cache_hits", (double)(cache.hits() - hitsBefore));
+        benchmark.setCounter("cache_misses", (double)(cache.misses() - missesBefore));
+        benchmark.setCounter("cache_resident_mb", cache.bytesResident() / (1024.0 * 1024.0));
+        for (GLuint texture : textures)
+            cache.release(texture);
+        // следующий прогон снова загружает с диска
+        cache.clear();
+        textures.clear();
+
+        benchmark.setCounter("sync_first_frame_ms", syncSeconds * 1000.0);
+        benchmark.setCounter("stream_first_frame_ms", requestSeconds * 1000.0);
+        benchmark.setCounter("stream_resident_ms", streamSeconds * 1000.0);
+        benchmark.setCounter("stream_upload_frames", uploadFrames);
+        benchmark.setCounter("stream_max_update_ms", worstUpdate * 1000.0);
+        benchmark.setCounter("stream_decode_ms", streamer.decodeTime() * 1000.0);
+        benchmark.setCounter("uploaded_mb", streamer.totalBytes() / (1024.0 * 1024.0));
+        benchmark.setCounter("failed", streamer.failedCount());
+        benchmark.setCounter("cooked_first_frame_ms", cookedSeconds * 1000.0);
+        benchmark.setCounter("cooked_failed", cookedFailed);
+        benchmark.setCounter("source_vram_mb", sourceBytes / (1024.0 * 1024.0));
+        benchmark.setCounter("cooked_vram_mb", cookedBytes / (1024.0 * 1024.0));
+        benchmark.endFrame();
+    }
+    benchmark.finish();
+    benchmark.setInfo("benchmark", "texture_loading");
+    benchmark.setInfo("renderer", (const char*)glGetString(GL_RENDERER));
+    benchmark.setInfo("textures", std::to_string(files.size()));
+    benchmark.setInfo("texture_budget_kb", std::to_string(options.textureBudgetKB));
+    benchmark.setInfo("texture_threads", std::to_string(threads));
+    writeReport(benchmark);
+}
+
+// микробенчмарк отсечения теневых объектов (--bench-culling): options.cullObjects случайных AABB вокруг источника
+// (часть — дальше far_plane) проверяются на одном ядре скалярным cubeFaceMask по массиву AABB и CasterCuller
+// по структуре массивов; источник смещается каждую итерацию. Отчёт — CPU-время обоих способов, нс на объект
+// и число расхождений масок (должно быть 0: тест один и тот же).
+// ----------------------------------------------------------------------------------------------------------
+void runCullingBenchmark()
+{
+    const size_t count = (size_t)options.cullObjects;
+    const float farPlane = 25.0f;
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> position(-40.0f, 40.0f);
+    std::uniform_real_distribution<float> halfSize(0.05f, 1.0f);
+    std::vector<AABB> boxes(count);
+    CasterCuller culler;
+    culler.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        glm::vec3 center(position(random), position(random), position(random));
+        glm::vec3 extents(halfSize(random), halfSize(random), halfSize(random));
+        boxes[i].min = center - extents;
+        boxes[i].max = center + extents;
+        culler.setBounds(i, boxes[i]);
+    }
+
+    std::vector<unsigned int> scalarMasks(count);
+    Benchmark benchmark;
+    int scalarPass = benchmark.addPass("scalar");
+    int simdPass = benchmark.addPass("simd");
+    const int iterations = options.warmup + options.frames;
+    for (int iteration = 0; iteration < iterations; ++iteration)
+    {
+        glm::vec3 lightPos(std::sin(iteration * 0.1f) * 3.0f, std::cos(iteration * 0.07f) * 2.0f, 0.0f);
+        benchmark.setRecording(iteration >= options.warmup);
+        benchmark.beginFrame();
+
+        auto start = std::chrono::steady_clock::now();
+        benchmark.beginPass(scalarPass);
+        for (size_t i = 0; i < count; ++i)
+            scalarMasks[i] = cubeFaceMask(boxes[i], lightPos, farPlane);
+        benchmark.endPass(scalarPass);
+        auto middle = std::chrono::steady_clock::now();
+        benchmark.beginPass(simdPass);
+        const std::vector<unsigned int> &masks = culler.cull(lightPos, farPlane);
+        benchmark.endPass(simdPass);
+        auto end = std::chrono::steady_clock::now();
+
+        size_t mismatches = 0, visible = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            mismatches += masks[i] != scalarMasks[i] ? 1 : 0;
+            visible += masks[i] != 0 ? 1 : 0;
+        }
+        double scalarNs = std::chrono::duration<double, std::nano>(middle - start).count();
+        double simdNs = std::chrono::duration<double, std::nano>(end - middle).count();
+        benchmark.setCounter("scalar_ns_per_object", scalarNs / count);
+        benchmark.setCounter("simd_ns_per_object", simdNs / count);
+        benchmark.setCounter("speedup", scalarNs / simdNs);
+        benchmark.setCounter("mismatches", (double)mismatches);
+        benchmark.setCounter("visible_objects", (double)visible);
+        benchmark.endFrame();
+    }
+    benchmark.finish();
+    benchmark.setInfo("benchmark", "caster_culling");
+    benchmark.setInfo("objects", std::to_string(count));
+    benchmark.setInfo("instruction_set", CasterCuller::instructionSet());
+    benchmark.setInfo("lanes", std::to_string(CasterCuller::LANES));
+    writeReport(benchmark);
+}
+
+// проверка кластерных списков (--verify-clusters): вычислительный шейдер и LightClusters строят списки для
+// одних и тех же источников и камеры, списки GPU читаются обратно и сравниваются по кластерам. Число источников
+// идёт по кругу 1, 2, 4 ... MAX_LIGHTS, камера обходит комнату. Смещения в общем списке у GPU зависят от порядка
+// атомарных операций, поэтому сравниваются сами списки кластеров; кластер, обрезанный концом буфера индексов,
+// должен совпасть с началом списка CPU. Отчёт — расхождения по кадрам (должно быть 0) и время обоих способов.
+// -------------------------------------------------------------------------------------------------------------
+bool runClusterVerification(ClusteredLighting &clusters, UniformRing &ring)
+{
+    if (clusters.getMode() != LIGHT_CULLING_COMPUTE)
+    {
+        std::cout << "Cluster verification needs compute light culling (OpenGL 4.3)" << std::endl;
+        return false;
+    }
+    GpuCamera cameraBlock;
+    cameraBlock.projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, CAMERA_NEAR, CAMERA_FAR);
+    LightClusters reference;
+    reference.setProjection(cameraBlock.projection, CAMERA_NEAR, CAMERA_FAR);
+    const uint32_t capacity = (uint32_t)clusters.indexBufferCapacity();
+    int lightSteps = 1;
+    while ((1 << (lightSteps - 1)) < MAX_LIGHTS)
+        ++lightSteps;
+
+    Benchmark benchmark;
+    int cpuPass = benchmark.addPass("cpu");
+    int computePass = benchmark.addPass("compute");
+    std::vector<glm::vec4> spheres;
+    std::vector<glm::uvec2> grid;
+    std::vector<uint32_t> indices;
+    size_t totalMismatches = 0;
+    const int iterations = options.warmup + options.frames;
+    for (int iteration = 0; iteration < iterations; ++iteration)
+    {
+        std::vector<PointLight> frameLights = makeLights(std::min(1 << (iteration % lightSteps), MAX_LIGHTS));
+        float angle = iteration * 0.37f;
+        glm::vec3 eye(std::sin(angle) * 3.0f, std::sin(iteration * 0.23f) * 1.5f, std::cos(angle) * 3.0f);
+        cameraBlock.view = glm::lookAt(eye, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        cameraBlock.viewPos = glm::vec4(eye, 1.0f);
+        cameraBlock.inverseViewProjection = glm::inverse(cameraBlock.projection * cameraBlock.view);
+        GpuLightBlock lightBlock;
+        lightBlock.lightCount = glm::ivec4((int)frameLights.size(), 0, 0, 0);
+        for (size_t i = 0; i < frameLights.size(); ++i)
+        {
+            lightBlock.lights[i].position = glm::vec4(frameLights[i].position, frameLights[i].farPlane);
+            lightBlock.lights[i].color = glm::vec4(frameLights[i].color, frameLights[i].radius);
+            lightBlock.lights[i].shadow = glm::ivec4(-1, 0, -1, 0);
+        }
+        ring.beginFrame();
+        size_t cameraOffset = ring.push(cameraBlock);
+        size_t lightsOffset = ring.push(lightBlock);
+        ring.flush();
+        ring.bind(CAMERA_UBO_BINDING, cameraOffset, sizeof(GpuCamera));
+        ring.bind(LIGHTS_UBO_BINDING, lightsOffset, sizeof(GpuLightBlock));
+
+        benchmark.setRecording(iteration >= options.warmup);
+        benchmark.beginFrame();
+        benchmark.beginPass(computePass);
+        clusters.update(cameraBlock.projection, cameraBlock.view, frameLights);
+        benchmark.endPass(computePass);
+        ring.endFrame();
+        benchmark.beginPass(cpuPass);
+        ClusteredLighting::viewSpheres(cameraBlock.view, frameLights, spheres);
+        reference.assign(spheres, clusters.threadCount());
+        benchmark.endPass(cpuPass);
+        clusters.readBack(grid, indices);
+
+        // списки обеих сторон идут по возрастанию индекса источника: расхождения считаются слиянием
+        size_t mismatched = 0, missing = 0, extra = 0, truncated = 0;
+        for (int cluster = 0; cluster < LightClusters::CLUSTER_COUNT; ++cluster)
+        {
+            const glm::uvec2 expected = reference.grid()[cluster];
+            const glm::uvec2 actual = grid[cluster];
+            const uint32_t *cpu = reference.indices().data() + expected.x;
+            const uint32_t *gpu = indices.data() + std::min(actual.x, capacity);
+            uint32_t cpuCount = expected.y, gpuCount = actual.y;
+            if (actual.x + actual.y >= capacity && gpuCount < cpuCount)
+            {
+                cpuCount = gpuCount;
+                ++truncated;
+            }
+            size_t a = 0, b = 0, differences = 0;
+            while (a < cpuCount || b < gpuCount)
+            {
+                if (b == gpuCount || (a < cpuCount && cpu[a] < gpu[b]))
+                    ++missing, ++differences, ++a;
+                else if (a == cpuCount || gpu[b] < cpu[a])
+                    ++extra, ++differences, ++b;
+                else
+                    ++a, ++b;
+            }
+            mismatched += differences != 0 ? 1 : 0;
+        }
+        if (iteration >= options.warmup)
+            totalMismatches += mismatched;
+        benchmark.setCounter("lights", (double)frameLights.size());
+        benchmark.setCounter("light_refs", (double)reference.indices().size());
+        benchmark.setCounter("mismatched_clusters", (double)mismatched);
+        benchmark.setCounter("missing_refs", (double)missing);
+        benchmark.setCounter("extra_refs", (double)extra);
+        benchmark.setCounter("truncated_clusters", (double)truncated);
+        benchmark.endFrame();
+    }
+    benchmark.finish();
+    benchmark.setInfo("benchmark", "cluster_verification");
+    benchmark.setInfo("cluster_grid", std::to_string(LightClusters::TILES_X) + "x" + std::to_string(LightClusters::TILES_Y) +
+                                      "x" + std::to_string(LightClusters::SLICES));
+    benchmark.setInfo("cluster_threads", std::to_string(clusters.threadCount()));
+    benchmark.setInfo("mismatched_clusters_total", std::to_string(totalMismatches));
+    writeReport(benchmark);
+    return totalMismatches == 0;
+}
@@ -0,0 +1,245 @@
+#ifndef CLUSTERED_LIGHTS_H
+#define CLUSTERED_LIGHTS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <opengllibs/light_clusters.h>
+#include <opengllibs/shader.h>
+
+#include "point_lights.h"
+
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Отсечение источников по кластерам для освещения (--light-culling):
+//  NONE    — каждый фрагмент перебирает все источники;
+//  CPU     — списки кластеров строит LightClusters в нескольких потоках, результат загружается в буферы;
+//  COMPUTE — списки строит вычислительный шейдер point_shadows_clusters.cs (OpenGL 4.3) прямо в буферах.
+enum LightCullingMode
+{
+    LIGHT_CULLING_NONE,
+    LIGHT_CULLING_CPU,
+    LIGHT_CULLING_COMPUTE,
+    LIGHT_CULLING_MODE_COUNT
+};
+const char* const lightCullingNames[LIGHT_CULLING_MODE_COUNT] = { "none", "cpu", "compute" };
+
+// Текстурные блоки кластерных списков (после атласа теней, карт моментов и целей отложенного пути)
+const int CLUSTER_GRID_UNIT = 16;
+const int CLUSTER_LIGHTS_UNIT = 17;
+
+// Буферы кластерных списков: сетка (смещение, количество) на кластер и общий список индексов источников.
+// Вычислительный шейдер пишет их как SSBO, фрагментные шейдеры читают как текстурные буферы (в контексте 4.1
+// SSBO во фрагментном шейдере нет). Список индексов ограничен GL_MAX_TEXTURE_BUFFER_SIZE; кластеры,
+// не поместившиеся в него или в MAX_LIGHTS_PER_CLUSTER, теряют часть источников и учитываются в overflowed().
+class ClusteredLighting
+{
+public:
+    // вычислительная программа (только в режиме COMPUTE); блоки Camera и Lights к ней привязывает вызывающий код
+    std::unique_ptr<Shader> assignment;
+
+    ClusteredLighting(LightCullingMode cullingMode, float nearPlane, float farPlane)
+        : mode(cullingMode), zNear(nearPlane), zFar(farPlane)
+    {
+        GLint maxTexels = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+        indexCapacity = std::min(LightClusters::CLUSTER_COUNT * AVERAGE_LIGHTS_PER_CLUSTER, (int)maxTexels);
+        threads = std::max(1u, std::min(std::thread::hardware_concurrency(), 8u));
+
+        glGenBuffers(1, &gridBuffer);
+        glBindBuffer(GL_TEXTURE_BUFFER, gridBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, LightClusters::CLUSTER_COUNT * sizeof(glm::uvec2), NULL, GL_DYNAMIC_DRAW);
+        glGenBuffers(1, &indexBuffer);
+        glBindBuffer(GL_TEXTURE_BUFFER, indexBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, indexCapacity * sizeof(uint32_t), NULL, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        glGenTextures(1, &gridTexture);
+        glBindTexture(GL_TEXTURE_BUFFER, gridTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32UI, gridBuffer);
+        glGenTextures(1, &indexTexture);
+        glBindTexture(GL_TEXTURE_BUFFER, indexTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, indexBuffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+        if (mode == LIGHT_CULLING_COMPUTE)
+        {
+            glGenBuffers(1, &counterBuffer);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, counterBuffer);
+            glBufferData(GL_SHADER_STORAGE_BUFFER, 2 * sizeof(GLuint), NULL, GL_DYNAMIC_COPY);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+            glGenBuffers(1, &readbackBuffer);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, readbackBuffer);
+            glBufferData(GL_COPY_WRITE_BUFFER, 2 * sizeof(GLuint), NULL, GL_STREAM_READ);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            assignment.reset(new Shader("point_shadows_clusters.cs"));
+            assignment->use();
+            assignment->setVec2("clusterDepthRange", glm::vec2(zNear, zFar));
+            assignment->setInt("clusterIndexCapacity", indexCapacity);
+        }
+    }
+
+    ~ClusteredLighting()
+    {
+        glDeleteTextures(1, &gridTexture);
+        glDeleteTextures(1, &indexTexture);
+        glDeleteBuffers(1, &gridBuffer);
+        glDeleteBuffers(1, &indexBuffer);
+        if (counterBuffer != 0)
+            glDeleteBuffers(1, &counterBuffer);
+        if (readbackBuffer != 0)
+            glDeleteBuffers(1, &readbackBuffer);
+        if (counterFence != 0)
+            glDeleteSync(counterFence);
+    }
+
+    ClusteredLighting(const ClusteredLighting&) = delete;
+    ClusteredLighting& operator=(const ClusteredLighting&) = delete;
+
+    // униформы кластеров программы освещения (программа активна)
+    void configure(Shader& program, int screenWidth, int screenHeight) const
+    {
+        program.setBool("clusteredLights", mode != LIGHT_CULLING_NONE);
+        program.setInt("clusterGrid", CLUSTER_GRID_UNIT);
+        program.setInt("clusterLightIndices", CLUSTER_LIGHTS_UNIT);
+        program.setVec2("clusterScreenSize", glm::vec2((float)screenWidth, (float)screenHeight));
+        program.setVec2("clusterDepthRange", glm::vec2(zNear, zFar));
+    }
+
+    // списки кадра. Для COMPUTE блоки Camera и Lights кадра уже привязаны; источники берутся из блока Lights
+    void update(const glm::mat4& projection, const glm::mat4& view, const std::vector<PointLight>& lights)
+    {
+        if (mode == LIGHT_CULLING_CPU)
+            assignOnCPU(projection, view, lights);
+        else if (mode == LIGHT_CULLING_COMPUTE)
+            dispatch();
+    }
+
+    // привязать списки к текстурным блокам для освещения
+    void bindTextures() const
+    {
+        glActiveTexture(GL_TEXTURE0 + CLUSTER_GRID_UNIT);
+        glBindTexture(GL_TEXTURE_BUFFER, gridTexture);
+        glActiveTexture(GL_TEXTURE0 + CLUSTER_LIGHTS_UNIT);
+        glBindTexture(GL_TEXTURE_BUFFER, indexTexture);
+    }
+
+    LightCullingMode getMode() const { return mode; }
+    // занятых элементов списка индексов и кластеров с отброшенными источниками (для COMPUTE — результат
+    // одного из предыдущих кадров, читается без ожидания)
+    int assignedLights() const { return assigned; }
+    int overflowed() const { return overflow; }
+    double averageLightsPerCluster() const { return (double)assigned / LightClusters::CLUSTER_COUNT; }
+    unsigned int threadCount() const { return threads; }
+
+    // сферы влияния источников в координатах вида: центр (xyz) и far_plane (w), как их проверяет point_shadows_clusters.cs
+    static void viewSpheres(const glm::mat4& view, const std::vector<PointLight>& lights, std::vector<glm::vec4>& spheres)
+    {
+        spheres.resize(lights.size());
+        for (size_t i = 0; i < lights.size(); ++i)
+            spheres[i] = glm::vec4(glm::vec3(view * glm::vec4(lights[i].position, 1.0f)), lights[i].farPlane);
+    }
+
+    // прочитать списки последнего update() из буферов (ждёт GPU, только для проверки --verify-clusters)
+    void readBack(std::vector<glm::uvec2>& gridOut, std::vector<uint32_t>& indicesOut) const
+    {
+        gridOut.resize(LightClusters::CLUSTER_COUNT);
+        indicesOut.resize(indexCapacity);
+        glBindBuffer(GL_COPY_READ_BUFFER, gridBuffer);
+        glGetBufferSubData(GL_COPY_READ_BUFFER, 0, gridOut.size() * sizeof(glm::uvec2), gridOut.data());
+        glBindBuffer(GL_COPY_READ_BUFFER, indexBuffer);
+        glGetBufferSubData(GL_COPY_READ_BUFFER, 0, indicesOut.size() * sizeof(uint32_t), indicesOut.data());
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    }
+
+    int indexBufferCapacity() const { return indexCapacity; }
+
+private:
+    // средняя вместимость кластера в общем списке индексов
+    static const int AVERAGE_LIGHTS_PER_CLUSTER = 64;
+    static const GLuint GRID_BINDING = 0, INDICES_BINDING = 1, COUNTER_BINDING = 2;
+
+    LightCullingMode mode;
+    float zNear, zFar;
+    int indexCapacity = 0;
+    unsigned int threads = 1;
+    GLuint gridBuffer = 0, indexBuffer = 0, counterBuffer = 0, readbackBuffer = 0;
+    GLuint gridTexture = 0, indexTexture = 0;
+    GLsync counterFence = 0; // копия счётчиков в readbackBuffer ещё не готова
+    int assigned = 0;
+    int overflow = 0;
+    LightClusters clusters;
+    std::vector<glm::vec4> spheres;
+    std::vector<glm::uvec2> grid;
+
+    void assignOnCPU(const glm::mat4& projection, const glm::mat4& view, const std::vector<PointLight>& lights)
+    {
+        clusters.setProjection(projection, zNear, zFar);
+        viewSpheres(view, lights, spheres);
+        clusters.assign(spheres, threads);
+
+        // список длиннее буфера: кластеры за его концом теряют источники
+        grid = clusters.grid();
+        overflow = clusters.overflowed();
+        for (glm::uvec2& cell : grid)
+        {
+            unsigned int available = cell.x < (unsigned int)indexCapacity ? (unsigned int)indexCapacity - cell.x : 0u;
+            if (cell.y > available)
+            {
+                cell.y = available;
+                ++overflow;
+            }
+        }
+        assigned = (int)std::min(clusters.indices().size(), (size_t)indexCapacity);
+        glBindBuffer(GL_TEXTURE_BUFFER, gridBuffer);
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, grid.size() * sizeof(glm::uvec2), grid.data());
+        if (assigned > 0)
+        {
+            glBindBuffer(GL_TEXTURE_BUFFER, indexBuffer);
+            glBufferSubData(GL_TEXTURE_BUFFER, 0, assigned * sizeof(uint32_t), clusters.indices().data());
+        }
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    void dispatch()
+    {
+        // счётчики одного из прошлых запусков: копия читается, только когда GPU до неё уже дошёл
+        if (counterFence != 0 && glClientWaitSync(counterFence, 0, 0) != GL_TIMEOUT_EXPIRED)
+        {
+            GLuint counters[2] = { 0, 0 };
+            glBindBuffer(GL_COPY_READ_BUFFER, readbackBuffer);
+            glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(counters), counters);
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+            assigned = (int)std::min(counters[0], (GLuint)indexCapacity);
+            overflow = (int)counters[1];
+            glDeleteSync(counterFence);
+            counterFence = 0;
+        }
+
+        const GLuint zero[2] = { 0, 0 };
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, counterBuffer);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(zero), zero);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, GRID_BINDING, gridBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INDICES_BINDING, indexBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COUNTER_BINDING, counterBuffer);
+        assignment->use();
+        glDispatchCompute((LightClusters::CLUSTER_COUNT + 63) / 64, 1, 1);
+        // освещение читает списки как текстурные буферы, копия счётчиков — через буфер
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+        if (counterFence == 0)
+        {
+            glBindBuffer(GL_COPY_READ_BUFFER, counterBuffer);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, readbackBuffer);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, 2 * sizeof(GLuint));
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            counterFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+    }
+};
+
+#endif
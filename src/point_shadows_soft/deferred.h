@@ -0,0 +1,197 @@
+#ifndef DEFERRED_H
+#define DEFERRED_H
+
+#include <glad/glad.h>
+
+#include <opengllibs/shader.h>
+
+#include <iostream>
+
+// Способ освещения сцены (--renderer):
+//  FORWARD  — point_shadows.fs освещает и фильтрует тени каждого растеризованного фрагмента;
+//  DEFERRED — G-буфер (цвет, нормаль, глубина), затем по полноэкранному проходу маски теней на источник
+//             (point_shadows_mask.fs) и полноэкранное освещение по маскам (point_shadows_deferred.fs).
+enum RenderPath
+{
+    RENDER_FORWARD,
+    RENDER_DEFERRED,
+    RENDER_PATH_COUNT
+};
+const char* const renderPathNames[RENDER_PATH_COUNT] = { "forward", "deferred" };
+
+// Текстурные блоки отложенного пути: 1..3 * SHADOW_TIERS заняты атласом теней (проход маски читает и его)
+const int GBUFFER_ALBEDO_UNIT = 0;
+const int GBUFFER_NORMAL_UNIT = 13;
+const int GBUFFER_DEPTH_UNIT = 14;
+const int SHADOW_MASK_UNIT = 15;
+
+// Цели и программы отложенного пути. Маски теней — массив текстур GL_R8, по слою на источник с тенью,
+// в полном или половинном разрешении (halfResolution); массив растёт до нужного количества слоёв.
+// Программы рисуют полноэкранный треугольник из пустого VAO (point_shadows_fullscreen.vs), кроме G-буфера,
+// который рисует сцену вершинным шейдером основного прохода.
+class DeferredRenderer
+{
+public:
+    Shader gbuffer;
+    Shader mask;
+    Shader lighting;
+
+    DeferredRenderer(int screenWidth, int screenHeight, bool halfResolution)
+        : gbuffer("point_shadows.vs", "point_shadows_gbuffer.fs"),
+          mask("point_shadows_fullscreen.vs", "point_shadows_mask.fs"),
+          lighting("point_shadows_fullscreen.vs", "point_shadows_deferred.fs"),
+          width(screenWidth), height(screenHeight), maskScale(halfResolution ? 2 : 1)
+    {
+        maskWidth = (width + maskScale - 1) / maskScale;
+        maskHeight = (height + maskScale - 1) / maskScale;
+        glGenVertexArrays(1, &emptyVAO);
+
+        glGenTextures(1, &albedoTexture);
+        glGenTextures(1, &normalTexture);
+        glGenTextures(1, &depthTexture);
+        createTexture(albedoTexture, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+        createTexture(normalTexture, GL_RGB10_A2, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV);
+        createTexture(depthTexture, GL_DEPTH_COMPONENT32F, GL_DEPTH_COMPONENT, GL_FLOAT);
+        glGenFramebuffers(1, &gbufferFBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, gbufferFBO);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, albedoTexture, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, normalTexture, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+        const GLenum buffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+        glDrawBuffers(2, buffers);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "G-buffer framebuffer is not complete" << std::endl;
+        glGenFramebuffers(1, &maskFBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        gbuffer.use();
+        gbuffer.setInt("diffuseTexture", GBUFFER_ALBEDO_UNIT);
+        mask.use();
+        mask.setInt("gDepth", GBUFFER_DEPTH_UNIT);
+        mask.setInt("maskScale", maskScale);
+        maskLightIndex = mask.uniform<int>("lightIndex");
+        lighting.use();
+        lighting.setInt("gAlbedo", GBUFFER_ALBEDO_UNIT);
+        lighting.setInt("gNormal", GBUFFER_NORMAL_UNIT);
+        lighting.setInt("gDepth", GBUFFER_DEPTH_UNIT);
+        lighting.setInt("shadowMask", SHADOW_MASK_UNIT);
+        lighting.setInt("maskScale", maskScale);
+        lightingShadows = lighting.uniform<int>("shadows");
+    }
+
+    ~DeferredRenderer()
+    {
+        glDeleteFramebuffers(1, &gbufferFBO);
+        glDeleteFramebuffers(1, &maskFBO);
+        glDeleteTextures(1, &albedoTexture);
+        glDeleteTextures(1, &normalTexture);
+        glDeleteTextures(1, &depthTexture);
+        if (maskTexture != 0)
+            glDeleteTextures(1, &maskTexture);
+        glDeleteVertexArrays(1, &emptyVAO);
+    }
+
+    DeferredRenderer(const DeferredRenderer&) = delete;
+    DeferredRenderer& operator=(const DeferredRenderer&) = delete;
+
+    // 1. G-буфер: цель привязана и очищена, дальше сцена рисуется программой gbuffer
+    void beginGeometry()
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, gbufferFBO);
+        glViewport(0, 0, width, height);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    }
+
+    // 2. маски теней: массив масок не меньше layers слоёв, программа mask активна (атлас теней уже привязан)
+    void beginMasks(int layers)
+    {
+        if (layers > maskLayers)
+            createMasks(layers);
+        glBindFramebuffer(GL_FRAMEBUFFER, maskFBO);
+        glViewport(0, 0, maskWidth, maskHeight);
+        glDisable(GL_DEPTH_TEST);
+        glActiveTexture(GL_TEXTURE0 + GBUFFER_DEPTH_UNIT);
+        glBindTexture(GL_TEXTURE_2D, depthTexture);
+        mask.use();
+        glBindVertexArray(emptyVAO);
+    }
+
+    // маска источника lightIndex блока Lights в слой layer
+    void renderMask(int lightIndex, int layer)
+    {
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, maskTexture, 0, layer);
+        mask.set(maskLightIndex, lightIndex);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+
+    void endMasks()
+    {
+        glEnable(GL_DEPTH_TEST);
+    }
+
+    // 3. освещение в привязанную цель (viewport во весь экран); фон остаётся цветом очистки цели
+    void light(bool shadows)
+    {
+        glViewport(0, 0, width, height);
+        glDisable(GL_DEPTH_TEST);
+        glActiveTexture(GL_TEXTURE0 + GBUFFER_ALBEDO_UNIT);
+        glBindTexture(GL_TEXTURE_2D, albedoTexture);
+        glActiveTexture(GL_TEXTURE0 + GBUFFER_NORMAL_UNIT);
+        glBindTexture(GL_TEXTURE_2D, normalTexture);
+        glActiveTexture(GL_TEXTURE0 + GBUFFER_DEPTH_UNIT);
+        glBindTexture(GL_TEXTURE_2D, depthTexture);
+        glActiveTexture(GL_TEXTURE0 + SHADOW_MASK_UNIT);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, maskTexture);
+        lighting.use();
+        lighting.set(lightingShadows, (int)(shadows && maskTexture != 0));
+        glBindVertexArray(emptyVAO);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glEnable(GL_DEPTH_TEST);
+    }
+
+    int getMaskScale() const { return maskScale; }
+
+    // объём G-буфера и масок в байтах
+    size_t memoryBytes() const
+    {
+        size_t pixels = (size_t)width * height;
+        return pixels * (4 + 4 + 4) + (size_t)maskWidth * maskHeight * maskLayers;
+    }
+
+private:
+    int width, height;
+    int maskScale;
+    int maskWidth = 0, maskHeight = 0;
+    int maskLayers = 0;
+    unsigned int gbufferFBO = 0, maskFBO = 0;
+    unsigned int albedoTexture = 0, normalTexture = 0, depthTexture = 0;
+    unsigned int maskTexture = 0;
+    unsigned int emptyVAO = 0;
+    Shader::Uniform<int> maskLightIndex, lightingShadows;
+
+    void createTexture(unsigned int texture, GLint internalFormat, GLenum format, GLenum type)
+    {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    void createMasks(int layers)
+    {
+        if (maskTexture != 0)
+            glDeleteTextures(1, &maskTexture);
+        maskLayers = layers;
+        glGenTextures(1, &maskTexture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, maskTexture);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R8, maskWidth, maskHeight, maskLayers, 0, GL_RED, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+};
+
+#endif
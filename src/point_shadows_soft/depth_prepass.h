@@ -0,0 +1,129 @@
+#ifndef DEPTH_PREPASS_H
+#define DEPTH_PREPASS_H
+
+#include <glad/glad.h>
+
+// Предварительный проход глубины (Z-prepass) перед основным проходом:
+//  OFF  — основной проход сам пишет глубину, затенённые и потом перекрытые фрагменты оплачиваются полностью;
+//  ON   — сначала глубина из потока позиций (point_shadows_prepass.*), затем освещение с GL_EQUAL и без записи
+//         глубины: тяжёлый фрагментный шейдер выполняется ровно один раз на видимый пиксель;
+//  AUTO — проход включается, только когда измеренная перерисовка выше порога (см. OverdrawMonitor).
+enum DepthPrepassMode
+{
+    DEPTH_PREPASS_OFF,
+    DEPTH_PREPASS_ON,
+    DEPTH_PREPASS_AUTO,
+    DEPTH_PREPASS_MODE_COUNT
+};
+const char* const depthPrepassNames[DEPTH_PREPASS_MODE_COUNT] = { "off", "on", "auto" };
+
+// Перерисовка основного прохода по запросам GL_SAMPLES_PASSED: сколько фрагментов прошло тест глубины,
+// т. е. было затенено. Кадры без предварительного прохода дают число затенённых фрагментов, кадры с ним —
+// число видимых (закрытых геометрией) пикселей; перерисовка — их отношение (пока видимых нет — доля экрана).
+// Результаты читаются без ожидания, когда запрос готов (GL_QUERY_RESULT_AVAILABLE), с задержкой в несколько кадров.
+// В режиме AUTO проход включается при перерисовке выше threshold; раз в PROBE_INTERVAL кадров решение
+// на один кадр меняется на противоположное, чтобы обновить измерение другой стороны.
+class OverdrawMonitor
+{
+public:
+    static const int LATENCY = 4;
+    static const int PROBE_INTERVAL = 60;
+
+    OverdrawMonitor()
+    {
+        glGenQueries(LATENCY, queries);
+    }
+
+    ~OverdrawMonitor()
+    {
+        glDeleteQueries(LATENCY, queries);
+    }
+
+    OverdrawMonitor(const OverdrawMonitor&) = delete;
+    OverdrawMonitor& operator=(const OverdrawMonitor&) = delete;
+
+    // прочитать готовые результаты и решить, нужен ли предварительный проход в этом кадре;
+    // pixels — размер цели основного прохода
+    bool beginFrame(DepthPrepassMode mode, float threshold, double pixels)
+    {
+        fresh = false;
+        for (int i = 1; i <= LATENCY; ++i)
+            resolve((slot + i) % LATENCY, false);
+        slot = (slot + 1) % LATENCY;
+        // слот кольца переиспользуется: его запрос (если ещё не прочитан) дочитывается с ожиданием
+        resolve(slot, true);
+        screenPixels = pixels;
+
+        bool prepass = mode == DEPTH_PREPASS_ON;
+        if (mode == DEPTH_PREPASS_AUTO)
+        {
+            // пока нет измерения без прохода — измеряем, затем решение по порогу с пробными кадрами
+            if (shadedSamples == 0)
+                prepass = false;
+            else
+            {
+                prepass = overdraw() > threshold;
+                if (++frame % PROBE_INTERVAL == 0)
+                    prepass = !prepass;
+            }
+        }
+        slotPrepass[slot] = prepass;
+        return prepass;
+    }
+
+    // рамка вокруг отрисовки основного прохода
+    void beginQuery()
+    {
+        glBeginQuery(GL_SAMPLES_PASSED, queries[slot]);
+    }
+
+    void endQuery()
+    {
+        glEndQuery(GL_SAMPLES_PASSED);
+        pending[slot] = true;
+    }
+
+    bool measured() const { return shadedSamples != 0; }
+    // затенённых фрагментов на видимый пиксель
+    double overdraw() const
+    {
+        double visible = coveredSamples != 0 ? (double)coveredSamples : screenPixels;
+        return visible > 0.0 ? (double)shadedSamples / visible : 0.0;
+    }
+    // прочитан ли в этом beginFrame новый результат и его значение
+    bool hasFreshResult() const { return fresh; }
+    double lastFragments() const { return (double)lastSamples; }
+
+private:
+    GLuint queries[LATENCY];
+    bool pending[LATENCY] = {};
+    bool slotPrepass[LATENCY] = {};
+    int slot = 0;
+    long long frame = 0;
+    GLuint64 shadedSamples = 0;  // последний кадр без предварительного прохода
+    GLuint64 coveredSamples = 0; // последний кадр с ним
+    GLuint64 lastSamples = 0;
+    double screenPixels = 0.0;
+    bool fresh = false;
+
+    void resolve(int index, bool wait)
+    {
+        if (!pending[index])
+            return;
+        if (!wait)
+        {
+            GLuint available = 0;
+            glGetQueryObjectuiv(queries[index], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                return;
+        }
+        GLuint64 value = 0;
+        glGetQueryObjectui64v(queries[index], GL_QUERY_RESULT, &value);
+        pending[index] = false;
+        (slotPrepass[index] ? coveredSamples : shadedSamples) = value;
+        lastSamples = value;
+        fresh = true;
+    }
+};
+
+#endif
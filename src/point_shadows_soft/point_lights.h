@@ -0,0 +1,104 @@
+#ifndef POINT_LIGHTS_H
+#define POINT_LIGHTS_H
+
+#include <glm/glm.hpp>
+
+#include <opengllibs/camera.h>
+#include <opengllibs/shadow_atlas.h>
+#include <opengllibs/shadow_cache.h>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+// Максимальное количество источников света (совпадает с MAX_LIGHTS в point_shadows_lights.glsl). Блок Lights
+// из MAX_LIGHTS источников — 12 КБ, в пределах гарантированных 16 КБ блока униформ; тени получает только часть
+// источников (сколько вмещают ярусы атласа)
+const int MAX_LIGHTS = 256;
+// Точка привязки буфера униформ Lights
+const unsigned int LIGHTS_UBO_BINDING = 0;
+// Точка привязки блока ShadowPass (данные прохода теней одного источника)
+const unsigned int SHADOW_PASS_UBO_BINDING = 2;
+
+// Ярусы атласа теней: (разрешение, количество кубических карт). Ярус 0 совпадает с прежней единственной картой
+// 1024x1024, остальные достаются менее заметным источникам. Количество ярусов совпадает с SHADOW_TIERS в point_shadows.fs
+const int SHADOW_TIERS = 4;
+const std::vector<std::pair<int, int>> SHADOW_TIER_LAYOUT = { {1024, 2}, {512, 6}, {256, 24}, {128, 32} };
+
+// Точечный источник света со своей картой теней
+struct PointLight
+{
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::vec3 color = glm::vec3(0.3f);
+    float farPlane = 25.0f;     // дальность карты теней и радиус влияния источника
+    float radius = 0.2f;        // радиус источника: размер полутени в режиме PCSS
+    ShadowSlot slot;            // место в атласе теней (невалидный слот — источник без тени)
+    ShadowFaceCache cache;      // какие грани его кубической карты нужно перерисовать
+};
+
+// Представление источника в буфере униформ (раскладка std140 совпадает с PointLight в point_shadows.fs)
+struct GpuPointLight
+{
+    glm::vec4 position; // xyz — позиция, w — far_plane
+    glm::vec4 color;    // rgb — цвет, w — радиус источника
+    glm::ivec4 shadow;  // x — ярус атласа (-1 — без тени), y — номер кубической карты в ярусе, z — слой маски теней
+};
+
+// Содержимое блока Lights
+struct GpuLightBlock
+{
+    glm::ivec4 lightCount;
+    GpuPointLight lights[MAX_LIGHTS];
+};
+
+// Блок ShadowPass шейдеров глубины (раскладка std140): данные прохода теней одного источника
+struct GpuShadowPass
+{
+    glm::mat4 shadowMatrices[6]; // матрицы теневой проекции граней
+    glm::vec4 lightPosFar;       // xyz — позиция источника, w — far_plane
+    glm::ivec4 shadowFaces;      // x — маска перерисовываемых граней, y — первый слой кубической карты в массиве
+};
+
+// Создать count источников: источник 0 в центре комнаты (как в исходной сцене), остальные равномерно по
+// направлениям (спираль Фибоначчи) на расстоянии 1.5..4 от центра комнаты. Суммарная яркость не зависит
+// от количества источников. Радиус влияния дополнительных источников уменьшается с их количеством (объём на
+// источник постоянный), иначе каждый источник освещал бы всю комнату и кластерам нечего было бы отсекать.
+inline std::vector<PointLight> makeLights(int count)
+{
+    std::vector<PointLight> lights(count);
+    const float goldenAngle = 2.39996323f;
+    const float reach = std::max(4.0f, lights[0].farPlane / std::cbrt((float)count));
+    for (int i = 1; i < count; ++i)
+    {
+        float y = 1.0f - 2.0f * (i - 0.5f) / (count - 1);
+        float r = std::sqrt(std::max(0.0f, 1.0f - y * y));
+        float phi = goldenAngle * i;
+        // расстояние от центра по золотому сечению, чтобы источники заполняли объём, а не одну сферу
+        float distance = 1.5f + 2.5f * std::fmod(i * 0.618034f, 1.0f);
+        lights[i].position = glm::vec3(std::cos(phi) * r, y, std::sin(phi) * r) * distance;
+        lights[i].farPlane = reach;
+        // оттенок по кругу: красный, зелёный, синий и смеси
+        glm::vec3 tint(0.5f + 0.5f * std::cos(phi), 0.5f + 0.5f * std::cos(phi + 2.094f), 0.5f + 0.5f * std::cos(phi + 4.189f));
+        lights[i].color = tint;
+    }
+    lights[0].color = glm::vec3(1.0f);
+    for (PointLight& light : lights)
+        light.color *= 0.3f / count;
+    return lights;
+}
+
+// Экранная значимость источника для распределения атласа: насколько крупно выглядит область его влияния
+// (сфера радиусом far_plane) с поправкой на то, находится ли источник перед камерой
+inline float lightImportance(const PointLight& light, const Camera& camera)
+{
+    glm::vec3 toLight = light.position - camera.Position;
+    float distance = std::max(glm::length(toLight), 0.001f);
+    float importance = light.farPlane / distance;
+    // тени источников за спиной камеры видны реже
+    if (glm::dot(toLight, camera.Front) < 0.0f)
+        importance *= 0.5f;
+    return importance;
+}
+
+#endif
@@ -15,28 +15,43 @@ out VS_OUT {
     vec2 TexCoords; // Текстурные координаты фрагмента
 } vs_out;
 
-// Матрицы проекции, вида и модели для преобразования вершин
-uniform mat4 projection;  // Матрица проекции
-uniform mat4 view;        // Матрица вида (камеры)
-uniform mat4 model;       // Матрица модели (позиция и ориентация объекта)
-
-// Флаг для инвертирования нормалей
+// Данные камеры, общие для всех объектов кадра (раскладка std140 совпадает с GpuCamera на стороне C++)
+layout (std140) uniform Camera {
+    mat4 projection;  // Матрица проекции
+    mat4 view;        // Матрица вида (камеры)
+    vec4 viewPos;     // xyz — позиция камеры
+    mat4 inverseViewProjection; // обратная к projection * view: мировая позиция по глубине экрана
+};
+
+// Матрица модели (позиция и ориентация объекта) — атрибут экземпляра
+layout (location = 3) in mat4 aModel;
+
+// Флаг для инвертирования нормалей: в специализации программы (REVERSE_NORMALS 0 или 1) — константа,
+// и ветвление ниже исчезает при компиляции, иначе — униформа
+#ifdef REVERSE_NORMALS
+const bool reverse_normals = REVERSE_NORMALS != 0;
+#else
 uniform bool reverse_normals;
+#endif
+
+// Позиция считается так же, как в point_shadows_prepass.vs: с предварительным проходом глубины основной проход
+// рисуется с GL_EQUAL, и глубина обоих проходов должна совпадать побитово
+invariant gl_Position;
 
 void main()
 {
     // Преобразуем позицию вершины в мировые координаты и передаем её во фрагментный шейдер
-    vs_out.FragPos = vec3(model * vec4(aPos, 1.0));
+    vs_out.FragPos = vec3(aModel * vec4(aPos, 1.0));
 
     // Преобразуем нормаль в мировые координаты, с учетом возможного инвертирования
     if(reverse_normals) // Хак для отображения освещения "изнутри" большого куба
-        vs_out.Normal = transpose(inverse(mat3(model))) * (-1.0 * aNormal); // Инвертируем нормаль
+        vs_out.Normal = transpose(inverse(mat3(aModel))) * (-1.0 * aNormal); // Инвертируем нормаль
     else
-        vs_out.Normal = transpose(inverse(mat3(model))) * aNormal; // Преобразуем нормаль без инверсии
+        vs_out.Normal = transpose(inverse(mat3(aModel))) * aNormal; // Преобразуем нормаль без инверсии
 
     // Передаем текстурные координаты
     vs_out.TexCoords = aTexCoords;
 
     // Преобразуем позицию вершины в экранные координаты
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    gl_Position = projection * view * aModel * vec4(aPos, 1.0);
 }
@@ -0,0 +1,79 @@
+#version 430 core
+// Назначение источников кластерам (OpenGL 4.3): вызов на кластер строит AABB кластера в координатах вида
+// (так же, как LightClusters::setProjection на стороне C++), проверяет сферы влияния всех источников
+// и записывает найденные индексы в общий список; место в списке выделяется атомарным счётчиком.
+// Фрагментные шейдеры читают результат как текстурные буферы clusterGrid и clusterLightIndices.
+
+#include "point_shadows_lights.glsl"
+
+layout (local_size_x = 64) in;
+
+layout (std430, binding = 0) writeonly buffer ClusterGridOut {
+    uvec2 gridOut[];          // смещение и количество индексов кластера
+};
+layout (std430, binding = 1) writeonly buffer ClusterIndicesOut {
+    uint indicesOut[];        // индексы источников подряд по кластерам
+};
+layout (std430, binding = 2) buffer ClusterCounter {
+    uint assignedLights;      // занято в indicesOut (обнуляется перед запуском)
+    uint overflowedClusters;  // кластеров, не вместивших все свои источники
+};
+
+uniform int clusterIndexCapacity; // длина indicesOut
+
+// начало среза глубины slice
+float SliceDepth(int slice)
+{
+    return clusterDepthRange.x * pow(clusterDepthRange.y / clusterDepthRange.x, float(slice) / float(CLUSTER_SLICES));
+}
+
+void main()
+{
+    int cluster = int(gl_GlobalInvocationID.x);
+    if (cluster >= CLUSTER_COUNT)
+        return;
+    int x = cluster % CLUSTER_TILES_X;
+    int y = (cluster / CLUSTER_TILES_X) % CLUSTER_TILES_Y;
+    int slice = cluster / (CLUSTER_TILES_X * CLUSTER_TILES_Y);
+
+    // плитка в NDC; на глубине d точка NDC (nx, ny) лежит в (nx * d / P00, ny * d / P11, -d)
+    float d0 = SliceDepth(slice);
+    float d1 = SliceDepth(slice + 1);
+    vec2 ndc0 = vec2(-1.0) + 2.0 * vec2(x, y) / vec2(CLUSTER_TILES_X, CLUSTER_TILES_Y);
+    vec2 ndc1 = vec2(-1.0) + 2.0 * vec2(x + 1, y + 1) / vec2(CLUSTER_TILES_X, CLUSTER_TILES_Y);
+    vec2 scale = vec2(projection[0][0], projection[1][1]);
+    vec3 boxMin = vec3(min(ndc0 * d0, ndc0 * d1) / scale, -d1);
+    vec3 boxMax = vec3(max(ndc1 * d0, ndc1 * d1) / scale, -d0);
+
+    uint found[MAX_LIGHTS_PER_CLUSTER];
+    uint count = 0u;
+    bool overflow = false;
+    for (int i = 0; i < lightCount.x; ++i)
+    {
+        vec3 center = (view * vec4(lights[i].position.xyz, 1.0)).xyz;
+        vec3 d = max(max(boxMin - center, center - boxMax), vec3(0.0));
+        float radius = lights[i].position.w;
+        if (dot(d, d) > radius * radius)
+            continue;
+        if (count == uint(MAX_LIGHTS_PER_CLUSTER))
+        {
+            overflow = true;
+            break;
+        }
+        found[count++] = uint(i);
+    }
+
+    // кластеры за концом списка теряют источники, как и переполненные
+    uint offset = atomicAdd(assignedLights, count);
+    uint capacity = uint(clusterIndexCapacity);
+    if (offset + count > capacity)
+    {
+        count = offset < capacity ? capacity - offset : 0u;
+        overflow = true;
+    }
+    if (overflow)
+        atomicAdd(overflowedClusters, 1u);
+    gridOut[cluster] = uvec2(offset, count);
+    for (uint n = 0u; n < count; ++n)
+        indicesOut[offset + n] = found[n];
+}
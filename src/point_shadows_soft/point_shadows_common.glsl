@@ -0,0 +1,259 @@
+// Общий код программ, освещающих сцену точечными источниками с тенями (point_shadows.fs, проходы маски теней
+// и освещения отложенного пути): источники и камера (point_shadows_lights.glsl), ярусы атласа и фильтры мягких теней.
+// Подключается директивой #include "point_shadows_common.glsl" после #version (см. Shader::expandIncludes)
+
+#include "point_shadows_lights.glsl"
+
+// Количество ярусов атласа теней (совпадает с SHADOW_TIERS на стороне C++)
+#define SHADOW_TIERS 4
+
+// Ярусы атласа теней (текстурные блоки задаются на стороне C++)
+uniform samplerCubeArray shadowTiers[SHADOW_TIERS]; // Ярусы атласа теней (массивы кубических карт)
+// Те же ярусы через сэмплер со сравнением глубины (GL_COMPARE_REF_TO_TEXTURE, GL_LINEAR): одна выборка
+// сравнивает 4 соседних texel'а и возвращает билинейно отфильтрованную долю освещённости
+uniform samplerCubeArrayShadow shadowTiersCompare[SHADOW_TIERS];
+// Карты моментов ярусов (VSM/EVSM): размытые, с мип-уровнями, фильтруются аппаратно
+uniform samplerCubeArray momentTiers[SHADOW_TIERS];
+
+// Фильтр мягких теней (совпадает с ShadowFilter на стороне C++)
+#define SHADOW_FILTER_GRID    0 // исходные 20 выборок по gridSamplingDisk
+#define SHADOW_FILTER_POISSON 1 // диск Пуассона с поворотом на пиксель
+#define SHADOW_FILTER_PCSS    2 // поиск блокеров + диск Пуассона радиуса полутени (percentage-closer soft shadows)
+#define SHADOW_FILTER_VSM     3 // одна трилинейная выборка карты моментов (d, d^2), неравенство Чебышёва
+#define SHADOW_FILTER_EVSM    4 // то же для экспоненциально искажённой глубины (две пары моментов)
+uniform int shadowFilter;
+uniform int shadowSamples;      // количество выборок диска Пуассона (4, 8, 16 или 32)
+uniform int shadowProbes;       // пробные выборки для раннего выхода (0 — без раннего выхода)
+uniform bool shadowHardwarePCF; // выборки через shadowTiersCompare
+uniform int shadowBlockerSamples; // PCSS: выборок поиска блокеров (не больше 32)
+uniform float shadowMaxRadius;    // PCSS: предел радиуса поиска и фильтрации на расстоянии фрагмента
+uniform float shadowBleedReduction; // VSM/EVSM: доля p_max, отсекаемая против просвечивания (light bleeding)
+uniform float shadowMinVariance;    // VSM/EVSM: нижняя граница дисперсии
+uniform vec2 shadowEvsmExponents;   // EVSM: показатели c+ и c- (совпадают с проходом моментов)
+
+// Ближняя плоскость проекции кубических карт теней (совпадает с near_plane на стороне C++)
+#define SHADOW_NEAR_PLANE 1.0
+
+// Что хранят ярусы атласа (совпадает с ShadowStorage на стороне C++)
+#define SHADOW_STORAGE_DEPTH    0 // перспективная глубина грани (GL_DEPTH_COMPONENT16/32F)
+#define SHADOW_STORAGE_DISTANCE 1 // расстояние до источника в долях far_plane (GL_R16F/R32F)
+uniform int shadowStorage;
+
+// Массив направлений смещения для выборки (sampling) теней
+vec3 gridSamplingDisk[20] = vec3[](
+   vec3(1, 1,  1), vec3( 1, -1,  1), vec3(-1, -1,  1), vec3(-1, 1,  1),
+   vec3(1, 1, -1), vec3( 1, -1, -1), vec3(-1, -1, -1), vec3(-1, 1, -1),
+   vec3(1, 1,  0), vec3( 1, -1,  0), vec3(-1, -1,  0), vec3(-1, 1,  0),
+   vec3(1, 0,  1), vec3(-1,  0,  1), vec3( 1,  0, -1), vec3(-1, 0, -1),
+   vec3(0, 1,  1), vec3( 0, -1,  1), vec3( 0, -1, -1), vec3( 0, 1, -1)
+);
+
+// Диск Пуассона в единичном круге. Порядок важен: первые 4 точки лежат на внешнем кольце (пробные выборки),
+// а каждый префикс из 8, 16 и 32 точек сам по себе равномерно покрывает круг (выборка "лучший кандидат")
+const vec2 poissonDisk[32] = vec2[](
+    vec2( 0.4875,  0.6963), vec2(-0.6963,  0.4875), vec2(-0.4875, -0.6963), vec2( 0.6963, -0.4875),
+    vec2( 0.0089,  0.0124), vec2( 0.9600,  0.1474), vec2(-0.1481,  0.9352), vec2(-0.9555, -0.1641),
+    vec2( 0.1637, -0.9710), vec2(-0.4693, -0.0368), vec2( 0.0470,  0.4911), vec2( 0.1267, -0.4675),
+    vec2( 0.4950,  0.2307), vec2( 0.3969, -0.1493), vec2(-0.3245,  0.3623), vec2(-0.1597, -0.8414),
+    vec2( 0.8245,  0.5036), vec2(-0.5020,  0.8041), vec2(-0.9731,  0.2138), vec2( 0.3945, -0.6915),
+    vec2( 0.2157,  0.9708), vec2( 0.7151, -0.0842), vec2(-0.2575, -0.3949), vec2(-0.8245, -0.4506),
+    vec2( 0.9360, -0.3046), vec2(-0.6711,  0.2024), vec2(-0.6394, -0.2626), vec2(-0.1749,  0.6515),
+    vec2( 0.0866,  0.7502), vec2( 0.2518,  0.0929), vec2(-0.1069, -0.5957), vec2(-0.0098, -0.2453)
+);
+
+// Выборка глубины из кубической карты layer яруса tier
+// (выбор сэмплера через ветвление, а не динамический индекс массива сэмплеров)
+float SampleShadowTier(int tier, vec3 direction, int layer)
+{
+    vec4 coord = vec4(direction, float(layer));
+    if (tier == 0)
+        return texture(shadowTiers[0], coord).r;
+    else if (tier == 1)
+        return texture(shadowTiers[1], coord).r;
+    else if (tier == 2)
+        return texture(shadowTiers[2], coord).r;
+    return texture(shadowTiers[3], coord).r;
+}
+
+// Глубина вдоль оси грани кубической карты, которую выбирает направление v (наибольшая по модулю координата)
+float MajorAxis(vec3 v)
+{
+    vec3 a = abs(v);
+    return max(a.x, max(a.y, a.z));
+}
+
+// Расстояние от источника до поверхности, сохранённой в карте в направлении direction
+float StoredToDistance(float stored, vec3 direction, float far_plane)
+{
+    if (shadowStorage == SHADOW_STORAGE_DISTANCE)
+        return stored * far_plane;
+    // перспективная глубина [0, 1] -> линейная глубина вдоль оси грани -> расстояние вдоль направления
+    float z = SHADOW_NEAR_PLANE * far_plane / (far_plane - stored * (far_plane - SHADOW_NEAR_PLANE));
+    return z * length(direction) / MajorAxis(direction);
+}
+
+// Обратное преобразование: значение карты для точки на расстоянии distance в направлении direction
+float DistanceToStored(float distance, vec3 direction, float far_plane)
+{
+    if (shadowStorage == SHADOW_STORAGE_DISTANCE)
+        return distance / far_plane;
+    float z = max(distance * MajorAxis(direction) / length(direction), 1e-4);
+    return (far_plane - SHADOW_NEAR_PLANE * far_plane / z) / (far_plane - SHADOW_NEAR_PLANE);
+}
+
+// Аппаратное сравнение со значением карты reference: доля освещённых texel'ов вокруг направления
+float CompareShadowTier(int tier, vec3 direction, int layer, float reference)
+{
+    vec4 coord = vec4(direction, float(layer));
+    if (tier == 0)
+        return texture(shadowTiersCompare[0], coord, reference);
+    else if (tier == 1)
+        return texture(shadowTiersCompare[1], coord, reference);
+    else if (tier == 2)
+        return texture(shadowTiersCompare[2], coord, reference);
+    return texture(shadowTiersCompare[3], coord, reference);
+}
+
+// Выборка карты моментов кубической карты layer яруса tier
+vec4 SampleMomentTier(int tier, vec3 direction, int layer)
+{
+    vec4 coord = vec4(direction, float(layer));
+    if (tier == 0)
+        return texture(momentTiers[0], coord);
+    else if (tier == 1)
+        return texture(momentTiers[1], coord);
+    else if (tier == 2)
+        return texture(momentTiers[2], coord);
+    return texture(momentTiers[3], coord);
+}
+
+// Верхняя оценка доли освещённости по неравенству Чебышёва для моментов (m, m^2) и глубины t.
+// Против просвечивания значения p_max ниже shadowBleedReduction считаются полной тенью, остальные растягиваются
+float Chebyshev(vec2 moments, float t, float minVariance)
+{
+    if (t <= moments.x)
+        return 1.0;
+    float variance = max(moments.y - moments.x * moments.x, minVariance);
+    float d = t - moments.x;
+    float pMax = variance / (variance + d * d);
+    return clamp((pMax - shadowBleedReduction) / (1.0 - shadowBleedReduction), 0.0, 1.0);
+}
+
+// Тень по карте моментов: depth — глубина фрагмента в долях far_plane
+float MomentShadow(int tier, vec3 direction, int layer, float depth)
+{
+    vec4 moments = SampleMomentTier(tier, direction, layer);
+    if (shadowFilter == SHADOW_FILTER_VSM)
+        return 1.0 - Chebyshev(moments.xy, depth, shadowMinVariance);
+    // EVSM: оценка по положительной и отрицательной экспоненте, берётся меньшая освещённость.
+    // Минимальная дисперсия масштабируется производной искажения, чтобы смещение было одинаковым по глубине
+    float positive = exp(shadowEvsmExponents.x * depth);
+    float negative = -exp(-shadowEvsmExponents.y * depth);
+    vec2 scale = shadowEvsmExponents * vec2(positive, negative);
+    float litPositive = Chebyshev(moments.xy, positive, shadowMinVariance * scale.x * scale.x);
+    float litNegative = Chebyshev(moments.zw, negative, shadowMinVariance * scale.y * scale.y);
+    return 1.0 - min(litPositive, litNegative);
+}
+
+// Одна выборка фильтра: 1 — направление в тени, 0 — освещено (при аппаратном сравнении — доля между ними).
+// Аппаратное сравнение есть только у текстур глубины
+float ShadowTap(int tier, vec3 direction, int layer, float currentDepth, float far_plane)
+{
+    if (shadowHardwarePCF && shadowStorage == SHADOW_STORAGE_DEPTH)
+        return 1.0 - CompareShadowTier(tier, direction, layer, DistanceToStored(currentDepth, direction, far_plane));
+    // Преобразуем значение карты в расстояние до источника
+    float closestDepth = StoredToDistance(SampleShadowTier(tier, direction, layer), direction, far_plane);
+    return currentDepth > closestDepth ? 1.0 : 0.0;
+}
+
+// Функция для вычисления теней от источника light
+float ShadowCalculation(vec3 fragPos, PointLight light)
+{
+    vec3 lightPos = light.position.xyz;
+    float far_plane = light.position.w;
+    int tier = light.shadow.x;
+    int layer = light.shadow.y;
+
+    // Получаем вектор от позиции фрагмента (точки на поверхности объекта) до позиции источника света
+    vec3 fragToLight = fragPos - lightPos;
+
+    // Текущая линейная глубина фрагмента — расстояние между фрагментом и источником света — за вычетом смещения,
+    // используемого для устранения артефактов, таких как "попутные тени"
+    float bias = 0.15;
+    float currentDepth = length(fragToLight) - bias;
+
+    float viewDistance = length(viewPos.xyz - fragPos); // Расстояние от камеры до фрагмента
+    float diskRadius = (1.0 + (viewDistance / far_plane)) / 25.0; // Радиус диска для сэмплирования, зависящий от расстояния
+
+    // VSM/EVSM: фильтрация уже сделана размытием карты и аппаратной трилинейной/анизотропной выборкой
+    if (shadowFilter == SHADOW_FILTER_VSM || shadowFilter == SHADOW_FILTER_EVSM)
+        return MomentShadow(tier, fragToLight, layer, currentDepth / far_plane);
+
+    if (shadowFilter == SHADOW_FILTER_GRID)
+    {
+        // Процесс сэмплирования по диску, чтобы смягчить тени (PCF)
+        float shadow = 0.0;
+        for (int i = 0; i < 20; ++i)
+            shadow += ShadowTap(tier, fragToLight + gridSamplingDisk[i] * diskRadius, layer, currentDepth, far_plane);
+        return shadow / 20.0;
+    }
+
+    // Диск Пуассона в плоскости, перпендикулярной направлению на фрагмент. Смещения, как и у сетки,
+    // добавляются к ненормированному fragToLight, поэтому угловой размер ядра тот же
+    vec3 axis = normalize(fragToLight);
+    vec3 tangent = normalize(cross(abs(axis.y) < 0.99 ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0), axis));
+    vec3 bitangent = cross(axis, tangent);
+    // поворот диска на пиксель (interleaved gradient noise) превращает полосы недостаточной выборки в шум
+    float angle = 6.2831853 * fract(52.9829189 * fract(dot(gl_FragCoord.xy, vec2(0.06711056, 0.00583715))));
+    mat2 rotation = mat2(cos(angle), sin(angle), -sin(angle), cos(angle));
+
+    if (shadowFilter == SHADOW_FILTER_PCSS)
+    {
+        // 1. поиск блокеров: средняя глубина того, что ближе фрагмента, в области, откуда заслоняется источник
+        // радиуса lightRadius (для блокеров не ближе ближней плоскости карты), но не шире shadowMaxRadius
+        float lightRadius = light.color.w;
+        float receiver = length(fragToLight);
+        float searchRadius = clamp(lightRadius * (receiver - SHADOW_NEAR_PLANE) / SHADOW_NEAR_PLANE, 0.0, shadowMaxRadius);
+        int blockerSamples = clamp(shadowBlockerSamples, 1, 32);
+        float blockerDepth = 0.0;
+        int blockers = 0;
+        for (int i = 0; i < blockerSamples; ++i)
+        {
+            vec2 offset = rotation * poissonDisk[i] * searchRadius;
+            vec3 direction = fragToLight + tangent * offset.x + bitangent * offset.y;
+            float depth = StoredToDistance(SampleShadowTier(tier, direction, layer), direction, far_plane);
+            if (depth < currentDepth)
+            {
+                blockerDepth += depth;
+                ++blockers;
+            }
+        }
+        // блокеров нет — фрагмент освещён, фильтрация не нужна
+        if (blockers == 0)
+            return 0.0;
+        blockerDepth /= float(blockers);
+
+        // 2. ширина полутени на расстоянии фрагмента (подобные треугольники источник — блокер — фрагмент)
+        float penumbra = lightRadius * (receiver - blockerDepth) / blockerDepth;
+
+        // 3. фильтрация диском радиуса полутени; количество выборок ограничено shadowSamples
+        diskRadius = min(penumbra, shadowMaxRadius);
+    }
+
+    tangent *= diskRadius;
+    bitangent *= diskRadius;
+
+    int samples = clamp(shadowSamples, 1, 32);
+    int probes = min(shadowProbes, samples);
+    float shadow = 0.0;
+    for (int i = 0; i < samples; ++i)
+    {
+        // ранний выход: если все пробные выборки согласны (полностью освещено или полностью в тени),
+        // остальная часть ядра ничего не изменит; probes == 0 — без раннего выхода (иначе деление 0 / 0)
+        if (probes > 0 && i == probes && probes < samples && (shadow == 0.0 || shadow == float(probes)))
+            return shadow / float(probes);
+        vec2 offset = rotation * poissonDisk[i];
+        shadow += ShadowTap(tier, fragToLight + tangent * offset.x + bitangent * offset.y, layer, currentDepth, far_plane);
+    }
+    return shadow / float(samples);
+}
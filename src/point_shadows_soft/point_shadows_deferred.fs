@@ -0,0 +1,78 @@
+#version 400 core
+// Освещение отложенного пути: полноэкранный проход по G-буферу. Модель освещения та же, что в point_shadows.fs,
+// но доля тени каждого источника берётся из его слоя маски теней, а не фильтруется здесь.
+// Маска половинного разрешения восстанавливается с учётом глубины: из четырёх ближайших texel'ов маски
+// сильнее учитываются те, чья глубина ближе к глубине пикселя, поэтому тени не расползаются через края объектов.
+// Источники, как и в прямом пути, берутся из кластера пикселя (LightRange).
+
+#include "point_shadows_common.glsl"
+
+out vec4 FragColor;
+
+uniform sampler2D gAlbedo;
+uniform sampler2D gNormal;
+uniform sampler2D gDepth;
+uniform sampler2DArray shadowMask; // по слою GL_R8 на источник с тенью (слой — lights[i].shadow.z)
+uniform int maskScale;             // 1 — маска в полном разрешении, 2 — в половинном
+uniform bool shadows;
+
+// расстояние вдоль оси взгляда по значению буфера глубины (перспективная проекция)
+float LinearDepth(float depth)
+{
+    return projection[3][2] / (depth * 2.0 - 1.0 + projection[2][2]);
+}
+
+// доля тени источника в пикселе pixel с линейной глубиной viewDepth
+float MaskShadow(int layer, ivec2 pixel, float viewDepth)
+{
+    if (maskScale == 1)
+        return texelFetch(shadowMask, ivec3(pixel, layer), 0).r;
+    // texel маски t считался для пикселя t * maskScale, отсюда положение пикселя в texel'ах маски
+    // и четыре ближайших texel'а
+    ivec2 maskSize = textureSize(shadowMask, 0).xy;
+    vec2 position = vec2(pixel) / float(maskScale);
+    ivec2 base = ivec2(floor(position));
+    vec2 f = position - vec2(base);
+    float shadow = 0.0;
+    float weightSum = 0.0;
+    for (int i = 0; i < 4; ++i)
+    {
+        ivec2 offset = ivec2(i & 1, i >> 1);
+        ivec2 texel = clamp(base + offset, ivec2(0), maskSize - 1);
+        // глубина, для которой считался texel маски (пиксель экрана texel * maskScale)
+        float texelDepth = LinearDepth(texelFetch(gDepth, texel * maskScale, 0).r);
+        vec2 bilinear = mix(vec2(1.0) - f, f, vec2(offset));
+        float weight = bilinear.x * bilinear.y / (1e-3 + abs(texelDepth - viewDepth) / viewDepth);
+        shadow += weight * texelFetch(shadowMask, ivec3(texel, layer), 0).r;
+        weightSum += weight;
+    }
+    return shadow / max(weightSum, 1e-6);
+}
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gDepth, pixel, 0).r;
+    if (depth >= 1.0)
+        discard;
+    vec2 size = vec2(textureSize(gDepth, 0));
+    vec3 ndc = vec3(gl_FragCoord.xy / size, depth) * 2.0 - 1.0;
+    vec4 world = inverseViewProjection * vec4(ndc, 1.0);
+    vec3 fragPos = world.xyz / world.w;
+
+    vec3 color = texelFetch(gAlbedo, pixel, 0).rgb;
+    vec3 normal = normalize(texelFetch(gNormal, pixel, 0).xyz * 2.0 - 1.0);
+    float viewDepth = LinearDepth(depth);
+
+    vec3 ambient = 0.3 * vec3(0.3);
+    vec3 viewDir = normalize(viewPos.xyz - fragPos);
+    vec3 lighting = ambient;
+    uvec2 range = LightRange(gl_FragCoord.xy, viewDepth);
+    for (uint n = 0u; n < range.y; ++n)
+    {
+        int i = LightAt(range, n);
+        float shadow = (shadows && lights[i].shadow.x >= 0) ? MaskShadow(lights[i].shadow.z, pixel, viewDepth) : 0.0;
+        lighting += (1.0 - shadow) * LightContribution(lights[i], fragPos, normal, viewDir);
+    }
+    FragColor = vec4(lighting * color, 1.0);
+}
@@ -1,24 +1,27 @@
 #version 330 core
+// Фрагментный шейдер прохода теней. Глубина фрагмента не переписывается (gl_FragDepth не используется),
+// поэтому видеокарта отбрасывает закрытые фрагменты до запуска шейдера (early-Z). В режимах хранения DEPTH*
+// цветового вложения нет и запись Distance отбрасывается: в карту попадает аппаратная перспективная глубина,
+// а расстояние до источника восстанавливается при чтении. В режимах DISTANCE* Distance пишется в массив R16F/R32F.
 
 // Входной фрагментный атрибут, представляющий позицию фрагмента в мировых координатах (4 компоненты: x, y, z, w)
 in vec4 FragPos;
 
-// Позиция источника света
-uniform vec3 lightPos;
+// Расстояние до источника в долях far_plane (цветовое вложение 0)
+layout (location = 0) out float Distance;
 
-// Дальний предел для проекции (используется для нормализации глубины)
-uniform float far_plane;
+// Данные прохода теней одного источника (раскладка std140 совпадает с GpuShadowPass на стороне C++)
+layout (std140) uniform ShadowPass {
+    mat4 shadowMatrices[6]; // Матрицы теневой проекции для каждой из 6 граней кубической карты
+    vec4 lightPosFar;       // xyz — позиция источника света, w — far_plane
+    ivec4 shadowFaces;      // x — маска перерисовываемых граней, y — первый слой кубической карты в массиве
+};
 
 void main()
 {
-    // Вычисляем расстояние от фрагмента до источника света
-    float lightDistance = length(FragPos.xyz - lightPos);
+    vec3 lightPos = lightPosFar.xyz;  // Позиция источника света
+    float far_plane = lightPosFar.w;  // Дальний предел для проекции (используется для нормализации расстояния)
 
-    // Нормализуем расстояние, деля его на far_plane
-    // Это преобразует расстояние в диапазон [0, 1], который будет использован для глубины
-    lightDistance = lightDistance / far_plane;
-
-    // Устанавливаем глубину фрагмента в качестве значения в шейдере
-    // Используется для теней: чем дальше от света, тем глубже фрагмент
-    gl_FragDepth = lightDistance;
+    // Расстояние от фрагмента до источника света, нормализованное в диапазон [0, 1]
+    Distance = length(FragPos.xyz - lightPos) / far_plane;
 }
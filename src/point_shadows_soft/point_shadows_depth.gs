@@ -7,8 +7,12 @@ layout (triangles) in;
 // одного примитива — 18.
 layout (triangle_strip, max_vertices=18) out;
 
-// Массив матриц теневой проекции для каждой из 6 граней кубической тени
-uniform mat4 shadowMatrices[6];
+// Данные прохода теней одного источника (раскладка std140 совпадает с GpuShadowPass на стороне C++)
+layout (std140) uniform ShadowPass {
+    mat4 shadowMatrices[6]; // Матрицы теневой проекции для каждой из 6 граней кубической карты
+    vec4 lightPosFar;       // xyz — позиция источника света, w — far_plane
+    ivec4 shadowFaces;      // x — маска перерисовываемых граней, y — первый слой кубической карты в массиве
+};
 
 // Выходная переменная, представляющая позицию фрагмента для каждой вершины
 out vec4 FragPos;
@@ -18,8 +22,12 @@ void main()
     // Перебираем все 6 граней куба, на которые будем проецировать тени
     for(int face = 0; face < 6; ++face)
     {
+        // Пропускаем грани, которые не перерисовываются (они остались в кубической карте с прошлых кадров)
+        if((shadowFaces.x & (1 << face)) == 0)
+            continue;
+
         // Устанавливаем номер текущей грани для записи в соответствующий слой
-        gl_Layer = face; // Встроенная переменная, которая указывает, на какой слой рендерится текущая грань.
+        gl_Layer = shadowFaces.y + face; // Встроенная переменная, которая указывает, на какой слой рендерится текущая грань.
 
         // Для каждой вершины треугольника
         for(int i = 0; i < 3; ++i)
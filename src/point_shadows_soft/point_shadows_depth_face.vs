@@ -0,0 +1,28 @@
+#version 330 core
+// Рендеринг одной грани кубической карты за проход: грань выбирается на CPU (отдельный FBO на грань),
+// а в неё рисуются только объекты, чьи границы попадают в пирамиду видимости грани.
+
+// Входной атрибут для позиции вершины
+layout (location = 0) in vec3 aPos;
+
+// Матрица модели объекта — атрибут экземпляра
+layout (location = 3) in mat4 aModel;
+
+// Данные прохода теней одного источника (раскладка std140 совпадает с GpuShadowPass на стороне C++)
+layout (std140) uniform ShadowPass {
+    mat4 shadowMatrices[6]; // Матрицы теневой проекции для каждой из 6 граней кубической карты
+    vec4 lightPosFar;       // xyz — позиция источника света, w — far_plane
+    ivec4 shadowFaces;      // x — маска перерисовываемых граней, y — первый слой кубической карты в массиве
+};
+
+// Текущая грань кубической карты
+uniform int face;
+
+// Позиция вершины в мировых координатах для фрагментного шейдера
+out vec4 FragPos;
+
+void main()
+{
+    FragPos = aModel * vec4(aPos, 1.0);
+    gl_Position = shadowMatrices[face] * FragPos;
+}
@@ -0,0 +1,35 @@
+#version 330 core
+// Однопроходный рендеринг в кубическую карту без геометрического шейдера: номер слоя (грани) задаётся прямо
+// из вершинного шейдера, а каждая пара (объект, грань) — отдельный экземпляр (instance) с гранью в атрибуте.
+#extension GL_ARB_shader_viewport_layer_array : enable
+#extension GL_AMD_vertex_shader_layer : enable
+
+// Входной атрибут для позиции вершины
+layout (location = 0) in vec3 aPos;
+
+// Матрица модели объекта — атрибут экземпляра
+layout (location = 3) in mat4 aModel;
+
+// Параметры экземпляра: x — грань кубической карты, в которую рисуется этот экземпляр
+layout (location = 7) in ivec4 aParams;
+
+// Данные прохода теней одного источника (раскладка std140 совпадает с GpuShadowPass на стороне C++)
+layout (std140) uniform ShadowPass {
+    mat4 shadowMatrices[6]; // Матрицы теневой проекции для каждой из 6 граней кубической карты
+    vec4 lightPosFar;       // xyz — позиция источника света, w — far_plane
+    ivec4 shadowFaces;      // x — маска перерисовываемых граней, y — первый слой кубической карты в массиве
+};
+
+// Позиция вершины в мировых координатах для фрагментного шейдера
+out vec4 FragPos;
+
+void main()
+{
+    // Экземпляры создаются на CPU только для граней, в пирамиды видимости которых попадает объект
+    int face = aParams.x;
+
+    FragPos = aModel * vec4(aPos, 1.0);
+    gl_Position = shadowMatrices[face] * FragPos;
+    // Встроенная переменная, которая указывает, на какой слой рендерится текущая вершина
+    gl_Layer = shadowFaces.y + face;
+}
@@ -0,0 +1,9 @@
+#version 400 core
+// Полноэкранный треугольник без вершинного буфера: три вершины из gl_VertexID покрывают весь viewport
+// (рисуется glDrawArrays(GL_TRIANGLES, 0, 3) с пустым VAO)
+
+void main()
+{
+    vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,20 @@
+#version 400 core
+// G-буфер отложенного пути: вершины из point_shadows.vs, во вложения пишутся цвет поверхности и нормаль,
+// глубина — в текстуру глубины. Освещение и тени считаются потом, один раз на пиксель экрана.
+
+layout (location = 0) out vec4 Albedo; // rgb — цвет из текстуры объекта
+layout (location = 1) out vec4 Normal; // xyz — мировая нормаль, упакованная в [0, 1] (GL_RGB10_A2)
+
+in VS_OUT {
+    vec3 FragPos;
+    vec3 Normal;
+    vec2 TexCoords;
+} fs_in;
+
+uniform sampler2D diffuseTexture;
+
+void main()
+{
+    Albedo = vec4(texture(diffuseTexture, fs_in.TexCoords).rgb, 1.0);
+    Normal = vec4(normalize(fs_in.Normal) * 0.5 + 0.5, 1.0);
+}
@@ -0,0 +1,97 @@
+// Источники света и камера: блоки Lights и Camera, кластерные списки источников и модель освещения.
+// Подключается и программами освещения (через point_shadows_common.glsl), и вычислительным шейдером
+// кластеров point_shadows_clusters.cs, поэтому здесь нет ничего, что требует фрагментного шейдера.
+
+// Максимальное количество источников света (совпадает с MAX_LIGHTS на стороне C++)
+#define MAX_LIGHTS 256
+
+// Точечный источник света (раскладка std140 совпадает с GpuPointLight на стороне C++)
+struct PointLight {
+    vec4 position;  // xyz — позиция источника, w — far_plane (дальность карты теней и радиус влияния)
+    vec4 color;     // rgb — цвет источника, w — радиус источника (размер полутени в режиме PCSS)
+    ivec4 shadow;   // x — ярус атласа (-1 — источник без тени), y — номер кубической карты в ярусе,
+                    // z — слой маски теней отложенного пути
+};
+
+// Список источников света, общий для всех фрагментов
+layout (std140) uniform Lights {
+    ivec4 lightCount;              // x — количество источников
+    PointLight lights[MAX_LIGHTS];
+};
+
+// Данные камеры, общие для всех объектов кадра (раскладка std140 совпадает с GpuCamera на стороне C++)
+layout (std140) uniform Camera {
+    mat4 projection;  // Матрица проекции
+    mat4 view;        // Матрица вида (камеры)
+    vec4 viewPos;     // xyz — позиция камеры
+    mat4 inverseViewProjection; // обратная к projection * view: мировая позиция по глубине экрана
+};
+
+// Сетка кластеров (совпадает с LightClusters на стороне C++): экранные плитки и срезы глубины,
+// границы срезов — геометрическая прогрессия от clusterDepthRange.x (near) до clusterDepthRange.y (far)
+#define CLUSTER_TILES_X 16
+#define CLUSTER_TILES_Y 9
+#define CLUSTER_SLICES 24
+#define CLUSTER_COUNT (CLUSTER_TILES_X * CLUSTER_TILES_Y * CLUSTER_SLICES)
+#define MAX_LIGHTS_PER_CLUSTER 128
+
+uniform vec2 clusterDepthRange;
+// Кластерные списки источников: clusterGrid (RG32UI) — смещение и количество индексов кластера,
+// clusterLightIndices (R32UI) — индексы источников подряд по кластерам
+uniform bool clusteredLights;         // false — каждый фрагмент перебирает все источники
+uniform usamplerBuffer clusterGrid;
+uniform usamplerBuffer clusterLightIndices;
+uniform vec2 clusterScreenSize;       // размер экрана в пикселях
+
+// кластер пикселя fragCoord (в пикселях) с глубиной viewDepth (расстояние вдоль оси взгляда)
+int ClusterIndex(vec2 fragCoord, float viewDepth)
+{
+    ivec2 tile = clamp(ivec2(fragCoord / clusterScreenSize * vec2(CLUSTER_TILES_X, CLUSTER_TILES_Y)),
+                       ivec2(0), ivec2(CLUSTER_TILES_X - 1, CLUSTER_TILES_Y - 1));
+    int slice = int(floor(log(max(viewDepth, clusterDepthRange.x) / clusterDepthRange.x) /
+                          log(clusterDepthRange.y / clusterDepthRange.x) * float(CLUSTER_SLICES)));
+    slice = clamp(slice, 0, CLUSTER_SLICES - 1);
+    return (slice * CLUSTER_TILES_Y + tile.y) * CLUSTER_TILES_X + tile.x;
+}
+
+// источники, которые перебирает пиксель: (смещение в clusterLightIndices, количество) или все источники
+uvec2 LightRange(vec2 fragCoord, float viewDepth)
+{
+    if (!clusteredLights)
+        return uvec2(0u, uint(lightCount.x));
+    return texelFetch(clusterGrid, ClusterIndex(fragCoord, viewDepth)).xy;
+}
+
+// n-й источник диапазона range
+int LightAt(uvec2 range, uint n)
+{
+    if (!clusteredLights)
+        return int(n);
+    return int(texelFetch(clusterLightIndices, int(range.x + n)).r);
+}
+
+// Вклад источника light в освещение точки fragPos (Blinn-Phong) без учёта тени. Вклад плавно спадает до нуля
+// к far_plane источника, поэтому источник не влияет на точки за пределами своей сферы (и своих кластеров)
+vec3 LightContribution(PointLight light, vec3 fragPos, vec3 normal, vec3 viewDir)
+{
+    // Определяем цвет света
+    vec3 lightColor = light.color.rgb;
+    vec3 lightPos = light.position.xyz;
+
+    // Окно дальности: (1 - (d/r)^4)^2 — почти 1 вблизи источника и ровно 0 на границе сферы влияния
+    float distanceRatio = length(lightPos - fragPos) / light.position.w;
+    float window = clamp(1.0 - distanceRatio * distanceRatio * distanceRatio * distanceRatio, 0.0, 1.0);
+    lightColor *= window * window;
+
+    // Диффузное освещение: зависит от угла между нормалью и направлением на источник света
+    vec3 lightDir = normalize(lightPos - fragPos);
+    float diff = max(dot(lightDir, normal), 0.0);
+    vec3 diffuse = diff * lightColor;
+
+    // Спекулярное освещение: эффект блеска, когда камера и источник света направлены в одну точку
+    vec3 halfwayDir = normalize(lightDir + viewDir);
+    float spec = pow(max(dot(normal, halfwayDir), 0.0), 64.0); // Используем модель Blinn-Phong для спекулярного освещения
+    vec3 specular = spec * lightColor;
+
+    return diffuse + specular;
+}
@@ -0,0 +1,31 @@
+#version 400 core
+// Маска теней одного источника для отложенного пути: полноэкранный проход, который по глубине G-буфера
+// восстанавливает мировую позицию пикселя и пишет долю тени (тот же фильтр, что в point_shadows.fs)
+// в слой lights[lightIndex].shadow.z массива масок GL_R8. Цена фильтра зависит только от разрешения маски,
+// а не от количества объектов и перерисовки. При половинном разрешении texel маски (x, y) считается
+// для пикселя экрана (2x, 2y); освещение восстанавливает полное разрешение с учётом глубины.
+
+#include "point_shadows_common.glsl"
+
+layout (location = 0) out float Shadow;
+
+uniform sampler2D gDepth;   // глубина G-буфера полного разрешения
+uniform int lightIndex;     // источник в блоке Lights
+uniform int maskScale;      // 1 — маска в полном разрешении, 2 — в половинном
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy) * maskScale;
+    ivec2 size = textureSize(gDepth, 0);
+    pixel = min(pixel, size - 1);
+    float depth = texelFetch(gDepth, pixel, 0).r;
+    // фон (геометрии нет)
+    if (depth >= 1.0)
+    {
+        Shadow = 0.0;
+        return;
+    }
+    vec3 ndc = vec3((vec2(pixel) + 0.5) / vec2(size), depth) * 2.0 - 1.0;
+    vec4 world = inverseViewProjection * vec4(ndc, 1.0);
+    Shadow = ShadowCalculation(world.xyz / world.w, lights[lightIndex]);
+}
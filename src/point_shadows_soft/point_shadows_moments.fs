@@ -0,0 +1,82 @@
+#version 400 core
+// Один проход разделимого размытия карты моментов (VSM/EVSM) в грани кубической карты.
+// Выборки делаются по направлениям, а не по 2D-координатам грани: смещение вдоль оси грани, вышедшее за её край,
+// попадает в соседнюю грань, поэтому размытие не оставляет швов на рёбрах куба.
+// Первый проход (fromDepth) читает глубину из атласа теней и переводит каждую выборку в моменты,
+// второй — размывает результат первого вдоль другой оси.
+
+out vec4 Moments;
+
+// Моменты (совпадает с ShadowFilter на стороне C++)
+#define MOMENTS_VSM  0 // (d, d^2)
+#define MOMENTS_EVSM 1 // (e^(c+ d), e^(2 c+ d), -e^(-c- d), e^(-2 c- d))
+
+uniform samplerCubeArray source; // ярус атласа глубины (fromDepth) или промежуточная карта моментов
+uniform int sourceLayer;         // номер кубической карты в source
+uniform bool fromDepth;
+uniform bool hardwareDepth;      // source — перспективная глубина граней (ShadowStorage DEPTH*), а не расстояние
+uniform float farPlane;          // far_plane источника (для восстановления расстояния из глубины)
+uniform int face;                // грань, в которую пишем (порядок GL_TEXTURE_CUBE_MAP_POSITIVE_X + i)
+uniform int axis;                // 0 — размытие вдоль s, 1 — вдоль t
+uniform int resolution;          // размер грани в texel'ах
+uniform int blurRadius;          // выборок в каждую сторону (0 — без размытия)
+uniform int momentMode;
+uniform vec2 evsmExponents;      // c+ и c-
+
+// направление кубической карты для координат грани sc, tc в [-1, 1] (таблица выбора грани из спецификации OpenGL)
+vec3 FaceDirection(vec2 st)
+{
+    float sc = st.x;
+    float tc = st.y;
+    if (face == 0) return vec3( 1.0, -tc, -sc);
+    if (face == 1) return vec3(-1.0, -tc,  sc);
+    if (face == 2) return vec3( sc,  1.0,  tc);
+    if (face == 3) return vec3( sc, -1.0, -tc);
+    if (face == 4) return vec3( sc, -tc,  1.0);
+    return vec3(-sc, -tc, -1.0);
+}
+
+// Ближняя плоскость проекции кубических карт теней (совпадает с near_plane на стороне C++)
+#define SHADOW_NEAR_PLANE 1.0
+
+// расстояние до источника в долях far_plane по значению карты в направлении direction
+float StoredToDepth(float stored, vec3 direction)
+{
+    if (!hardwareDepth)
+        return stored;
+    vec3 a = abs(direction);
+    float z = SHADOW_NEAR_PLANE / (farPlane - stored * (farPlane - SHADOW_NEAR_PLANE));
+    return z * length(direction) / max(a.x, max(a.y, a.z));
+}
+
+vec4 ToMoments(float depth)
+{
+    if (momentMode == MOMENTS_VSM)
+        return vec4(depth, depth * depth, 0.0, 0.0);
+    float positive = exp(evsmExponents.x * depth);
+    float negative = -exp(-evsmExponents.y * depth);
+    return vec4(positive, positive * positive, negative, negative * negative);
+}
+
+void main()
+{
+    vec2 st = gl_FragCoord.xy / float(resolution) * 2.0 - 1.0;
+    vec3 direction = FaceDirection(st);
+    // шаг в один texel вдоль оси размытия в пространстве направлений
+    vec2 texelStep = axis == 0 ? vec2(2.0 / float(resolution), 0.0) : vec2(0.0, 2.0 / float(resolution));
+    vec3 step = FaceDirection(st + texelStep) - direction;
+
+    // гауссово ядро: сигма — половина радиуса
+    float sigma = max(float(blurRadius) * 0.5, 0.5);
+    vec4 sum = vec4(0.0);
+    float weightSum = 0.0;
+    for (int i = -blurRadius; i <= blurRadius; ++i)
+    {
+        float weight = exp(-0.5 * float(i * i) / (sigma * sigma));
+        vec3 sampleDirection = direction + step * float(i);
+        vec4 value = texture(source, vec4(sampleDirection, float(sourceLayer)));
+        sum += weight * (fromDepth ? ToMoments(StoredToDepth(value.r, sampleDirection)) : value);
+        weightSum += weight;
+    }
+    Moments = sum / weightSum;
+}
@@ -0,0 +1,7 @@
+#version 330 core
+// Фрагментный шейдер предварительного прохода глубины: запись цвета выключена (glColorMask),
+// в буфер попадает только глубина, поэтому шейдер пустой.
+
+void main()
+{
+}
@@ -0,0 +1,24 @@
+#version 330 core
+// Вершинный шейдер предварительного прохода глубины (Z-prepass): только позиция из потока глубины.
+// gl_Position вычисляется тем же выражением, что в point_shadows.vs, и оба объявлены invariant,
+// поэтому основной проход с GL_EQUAL получает в точности ту же глубину.
+
+layout (location = 0) in vec3 aPos;
+
+// Данные камеры (раскладка std140 совпадает с GpuCamera на стороне C++)
+layout (std140) uniform Camera {
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos;
+    mat4 inverseViewProjection; // обратная к projection * view: мировая позиция по глубине экрана
+};
+
+// Матрица модели — атрибут экземпляра (локации 3..6)
+layout (location = 3) in mat4 aModel;
+
+invariant gl_Position;
+
+void main()
+{
+    gl_Position = projection * view * aModel * vec4(aPos, 1.0);
+}
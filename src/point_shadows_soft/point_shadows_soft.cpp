@@ -1,323 +1,1529 @@
-#include <glad/glad.h>
-#include <GLFW/glfw3.h>
-#include <stb_image.h>
-
-#include <glm/glm.hpp>
-#include <glm/gtc/matrix_transform.hpp>
-
-#include <opengllibs/filesystem.h>
-#include <opengllibs/shader.h>
-#include <opengllibs/camera.h>
-#include <opengllibs/model.h>
-
-#include <iostream>
-
-void framebuffer_size_callback(GLFWwindow* window, int width, int height);
-void mouse_callback(GLFWwindow* window, double xpos, double ypos);
-void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
-void processInput(GLFWwindow *window);
-unsigned int loadTexture(const char *path);
-void renderScene(const Shader &shader);
-void renderCube();
-
-// settings
-const unsigned int SCR_WIDTH = 1800;
-const unsigned int SCR_HEIGHT = 1600;
+#include "point_shadows_soft.h"
+
+// глобальное состояние демо (описание — в point_shadows_soft.h)
+// ---------------------------------------------------------------
+unsigned int SCR_WIDTH = 1800;
+unsigned int SCR_HEIGHT = 1600;
 bool shadows = true;
 bool shadowsKeyPressed = false;
-
-// camera
+const char* shadowPathNames[SHADOW_PATH_COUNT] = { "gs", "layer", "faces" };
+ShadowPath shadowPath = SHADOW_PATH_GEOMETRY;
+bool layeredSupported = false; // есть ли gl_Layer в вершинном шейдере
+bool shadowPathKeyPressed = false;
+bool prepassKeyPressed = false;
+std::vector<SceneObject> scene;
+CookedMesh sceneModel;
+CasterCuller casterCuller;
+BoundsBVH sceneBVH;
+std::vector<PointLight> lights;
 Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
 float lastX = (float)SCR_WIDTH / 2.0;
 float lastY = (float)SCR_HEIGHT / 2.0;
 bool firstMouse = true;
-
-// timing
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
+const char* submitModeNames[SUBMIT_MODE_COUNT] = { "direct", "instanced", "indirect" };
+RunOptions options;
 
-int main()
+int main(int argc, char** argv)
 {
-    // glfw: initialize and configure
-    // ------------------------------
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    if (!parseArguments(argc, argv))
+        return -1;
+
+    GLFWwindow* window = NULL;
+    HeadlessContext headless;
+    GLADloadproc loader = (GLADloadproc)glfwGetProcAddress;
+    if (options.headless)
+    {
+        // headless: контекст без окна (EGL surfaceless или скрытое окно GLFW)
+        // ----------------------------------------------------------------
+        if (!headless.create(4, 1))
+        {
+            std::cout << "Failed to create headless OpenGL context" << std::endl;
+            return -1;
+        }
+        loader = headless.loader();
+    }
+    else
+    {
+        // glfw: initialize and configure
+        // ------------------------------
+        glfwInit();
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
 #ifdef __APPLE__
-    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
 
-    // glfw window creation
-    // --------------------
-    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "PointShadow", NULL, NULL);
-    if (window == NULL)
-    {
-        std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-        return -1;
-    }
-    glfwMakeContextCurrent(window);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-    glfwSetCursorPosCallback(window, mouse_callback);
-    glfwSetScrollCallback(window, scroll_callback);
+        // glfw window creation
+        // --------------------
+        window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "PointShadow", NULL, NULL);
+        if (window == NULL)
+        {
+            std::cout << "Failed to create GLFW window" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
+        glfwMakeContextCurrent(window);
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+        glfwSetCursorPosCallback(window, mouse_callback);
+        glfwSetScrollCallback(window, scroll_callback);
 
-    // tell GLFW to capture our mouse
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        // tell GLFW to capture our mouse
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    }
 
     // glad: load all OpenGL function pointers
     // ---------------------------------------
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    if (!gladLoadGLLoader(loader))
     {
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
 
+    // счётчик вызовов OpenGL ставится до создания ресурсов, чтобы охватить все обёрнутые функции
+    if (options.countGLCalls || options.benchUniforms)
+        GLCallCounter::get().install();
+    // кэш состояния — поверх счётчика, чтобы gl_calls считал только дошедшие до драйвера вызовы;
+    // микробенчмарк униформ сравнивает способы по числу вызовов и идёт без кэша
+    if (options.stateCache && !options.benchUniforms)
+        GLStateCache::get().install();
+
+    // кэш двоичных программ включается до создания первой программы
+    ProgramBinaryCache::get().enable(options.shaderCache);
+    // параллельная компиляция программ потоками драйвера, если есть расширение
+    const bool parallelCompile = (GLCaps::get().has("GL_KHR_parallel_shader_compile") ||
+                                  GLCaps::get().has("GL_ARB_parallel_shader_compile")) &&
+                                 ShaderPermutations::enableParallelCompile(loader);
+
     // настройка глобального состояния OpenGL
     // --------------------------------------
     // GL_DEPTH_TEST - проверка глубины, GL_CULL_FACE - отсечение поверхности
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_CULL_FACE);
+    // фильтрация кубических карт через рёбра граней (сравнение глубины, карты моментов и их мип-уровни)
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
 
     // сборка и компиляция шейдеров
     // ----------------------------
     Shader shader("point_shadows.vs",
                   "point_shadows.fs");
+    // специализации основного прохода: флаги SHADOWS и REVERSE_NORMALS — константы, ветвления по ним исчезают
+    // при компиляции. Варианты компилируются в фоне; пока нужная пара не готова, рисует shader (флаги — униформами)
+    ShaderPermutations litVariants("point_shadows.vs", "point_shadows.fs");
+    if (options.shaderPermutations)
+        for (int v = 0; v < LIT_VARIANT_COUNT; ++v)
+            litVariants.add({ "SHADOWS " + std::to_string(v >> 1), "REVERSE_NORMALS " + std::to_string(v & 1) });
     Shader simpleDepthShader("point_shadows_depth.vs",
                              "point_shadows_depth.fs",
                              "point_shadows_depth.gs");
+    Shader faceDepthShader("point_shadows_depth_face.vs",
+                           "point_shadows_depth.fs");
+    Shader prepassShader("point_shadows_prepass.vs",
+                         "point_shadows_prepass.fs");
+    // слой из вершинного шейдера есть не везде, поэтому программа создаётся только при поддержке расширения
+    std::unique_ptr<Shader> layeredDepthShader;
+    layeredSupported = GLCaps::get().has("GL_ARB_shader_viewport_layer_array") ||
+                       GLCaps::get().has("GL_AMD_vertex_shader_layer");
+    if (layeredSupported)
+        layeredDepthShader.reset(new Shader("point_shadows_depth_layer.vs",
+                                            "point_shadows_depth.fs"));
+    else if (shadowPath == SHADOW_PATH_LAYERED)
+    {
+        std::cout << "Vertex shader layer output is not supported, falling back to geometry shader path" << std::endl;
+        shadowPath = SHADOW_PATH_GEOMETRY;
+    }
 
-    // загрузка текстур
-    // ----------------
-    unsigned int grassTexture = loadTexture(FileSystem::getPath("resources/textures/grass.jpeg").c_str());
-
-    // настройка карты глубины FBO (Framebuffer Object)
-    // ------------------------------------------------
-    const unsigned int SHADOW_WIDTH = 1024, SHADOW_HEIGHT = 1024;
-    unsigned int depthMapFBO;
-    // создадим n (n = 1) кадров для карты глубины, где depthMapFBO - переменная, в которой хранится сгенерированное
-    // имя объекта буфера кадра (используется массив, если n > 1).
-    glGenFramebuffers(1, &depthMapFBO);
-    // создание текстуры кубической карты глубины
-    // ------------------------------------------
-    unsigned int depthCubemap;
-    // работает аналогично glGenFramebuffers, но генерирует имена текстур
-    glGenTextures(1, &depthCubemap);
-    // привязка текстуры кубической карты глубины, где GL_TEXTURE_CUBE_MAP - это тип привязываемой текстуры
-    glBindTexture(GL_TEXTURE_CUBE_MAP, depthCubemap);
-    for (unsigned int i = 0; i < 6; ++i)
-        // заполнение текстуры кубической карты глубины, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i - это индекс текстуры кубической карты глубины
-        // GL_DEPTH_COMPONENT - это формат текстуры (указываем что это компонент глубины)
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
-                     0,
-                     GL_DEPTH_COMPONENT,
-                     SHADOW_WIDTH,
-                     SHADOW_HEIGHT,
-                     0,
-                     GL_DEPTH_COMPONENT,
-                     GL_FLOAT, // GL_FLOAT - тип данных
-                     NULL); // NULL - указатель на данные (поскольку мы хотим создать пустую текстуру, мы передаем NULL)
-    // установка параметров текстуры кубической карты глубины
-    // ------------------------------------------------------
-    // GL_TEXTURE_CUBE_MAP - это тип привязываемой текстуры
-    // GL_TEXTURE_MIN_FILTER - это алгоритм интерполяции текстуры при уменьшении
-    // GL_TEXTURE_MAG_FILTER - это алгоритм интерполяции текстуры при увеличении
-    // GL_NEAREST - это алгоритм интерполяции
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    // GL_TEXTURE_WRAP_S, GL_TEXTURE_WRAP_T, GL_TEXTURE_WRAP_R - это алгоритм обработки границ текстуры
-    // GL_CLAMP_TO_EDGE - это алгоритм обработки границ текстуры
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
-    // Привязываем текстуру глубины в качестве буфера глубины FBO
-    // ----------------------------------------------------------
-    // GL_FRAMEBUFFER - это тип буфера кадра
-    // depthMapFBO - имя объекта буфера кадра, в котором хранится глубина
-    glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-    // GL_DEPTH_ATTACHMENT - это тип буфера кадра, в котором хранится глубина
-    // depthCubemap - имя текстуры кубической карты глубины
-    // 0 - указывает уровень MIP-карты(mipmap) объекта текстуры для присоединения, т.е. уровень 0.
-    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthCubemap, 0);
-    // GL_NONE - это индекс текстуры кубической карты глубины (поскольку мы не собираемся использовать эту текстуру
-    // для отрисовки, мы передаём GL_NONE)
-    glDrawBuffer(GL_NONE);
-    glReadBuffer(GL_NONE);
-    // GL_FRAMEBUFFER - это тип буфера кадра
-    // 0 - это индекс буфера кадра
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    buildScene();
+
+    // загрузка текстур: декодирование в потоках, загрузка в кадрах через PBO; до загрузки — заглушка
+    // -------------------------------------------------------------------------------------------------
+    TextureStreamer textureStreamer(TextureStreamer::defaultThreads(), (size_t)options.textureBudgetKB * 1024);
+    // все текстуры — через общий TextureCache: одинаковые файлы загружаются один раз.
+    // Сжатая заранее текстура (texture_cooker) загружается сразу: декодировать нечего, уровни уже готовы
+    TextureCache& textureCache = TextureCache::get();
+    textureCache.setBudget((size_t)options.textureCacheMB * 1024 * 1024);
+    const std::string grassPath = FileSystem::getPath("resources/textures/grass.jpeg");
+    unsigned int grassTexture = options.cookedTextures
+                              ? textureCache.acquire(FileSystem::getPath("resources/cooked/grass.ctex"), loadCookedTexture) : 0;
+    const bool grassCooked = grassTexture != 0;
+    if (!grassCooked)
+        grassTexture = textureCache.acquire(grassPath, [&](const std::string& path)
+        {
+            return options.textureStreaming ? textureStreamer.request(path, true) : loadTexture(path.c_str());
+        }, &textureStreamer);
+
+    // атлас теней: ярусы массивов кубических карт глубины (см. ShadowAtlas)
+    // ---------------------------------------------------------------------
+    if (!GLCaps::get().atLeast(4, 0) && !GLCaps::get().has("GL_ARB_texture_cube_map_array"))
+    {
+        std::cout << "Cube map arrays are not supported (OpenGL 4.0 or GL_ARB_texture_cube_map_array required)" << std::endl;
+        return -1;
+    }
+    ShadowAtlas atlas(SHADOW_TIER_LAYOUT, options.shadowStorage);
+    DepthPrograms depthPrograms;
+    // проходы теней читают только поток позиций
+    depthPrograms.geometry = PassProgram(&simpleDepthShader, GeometryBuffers::DEPTH);
+    depthPrograms.face = PassProgram(&faceDepthShader, GeometryBuffers::DEPTH);
+    depthPrograms.layered = PassProgram(layeredDepthShader.get(), GeometryBuffers::DEPTH);
+    PassProgram litProgram(&shader, GeometryBuffers::SURFACE);
+    // предварительный проход глубины читает тот же поток позиций, что и проходы теней
+    PassProgram prepassProgram(&prepassShader, GeometryBuffers::DEPTH);
+
+    // кольцевой буфер униформ кадра: Camera, Lights и ShadowPass каждого источника
+    // ----------------------------------------------------------------------------
+    UniformRing uniformRing;
+    if (!uniformRing.create(sizeof(GpuCamera) + sizeof(GpuLightBlock) + MAX_LIGHTS * sizeof(GpuShadowPass), 2 + MAX_LIGHTS,
+                            options.uboMode))
+        return -1;
+
+    // отправка сцены партиями экземпляров (атрибуты экземпляров — локации 3..7 обоих VAO геометрии сцены)
+    // -------------------------------------------------------------------------------------------------
+    SceneSubmitter submitter;
+    cubeMesh(); // создаёт буферы геометрии сцены
+    submitter.create(sceneGeometry, 3);
+    // буферы мешей подготовленной модели — по порядку, их индексы в submitter совпадают с SceneMesh::geometry
+    for (int m = 1; m < sceneMeshCount(); ++m)
+        submitter.addGeometry(sceneMesh(m).buffers);
+    if (options.submitMode == SUBMIT_INDIRECT && !submitter.indirectAvailable())
+    {
+        std::cout << "glMultiDrawElementsIndirect is not supported (OpenGL 4.3 required), falling back to instanced submission" << std::endl;
+        options.submitMode = SUBMIT_INSTANCED;
+    }
 
+    // цель основного прохода: экранный буфер (0) или внеэкранный FBO в headless-режиме
+    // --------------------------------------------------------------------------------
+    OffscreenTarget offscreen;
+    unsigned int sceneFBO = 0;
+    if (options.headless)
+    {
+        if (!offscreen.create(SCR_WIDTH, SCR_HEIGHT))
+            return -1;
+        sceneFBO = offscreen.FBO;
+    }
 
     // настройка шейдеров
     // ------------------
+    // текстурный блок 0 — диффузная текстура, блоки 1..SHADOW_TIERS — ярусы атласа теней,
+    // следующие SHADOW_TIERS блоков — те же ярусы с сэмплером сравнения глубины, за ними — карты моментов ярусов
     shader.use();
     shader.setInt("diffuseTexture", 0);
-    shader.setInt("depthMap", 1);
-
-    // местоположение источника света
-    // ------------------------------
-    glm::vec3 lightPos(0.0f, 0.0f, 0.0f);
-
-    // цикл рендеринга
-    // ---------------
-    while (!glfwWindowShouldClose(window))
-    {
-        // per-frame time logic (логика обработки времени в расчёте на кадр)
-        // -----------------------------------------------------------------
-        float currentFrame = static_cast<float>(glfwGetTime());
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
-
-        // ввод
-        // ----
-        processInput(window);
-
-        // перемещать позицию света со временем.
-        lightPos.z = static_cast<float>(sin(glfwGetTime() * 0.5) * 3.0);
-
-        // отрисовка
-        // ---------
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        // 0. создать матрицы преобразования кубической карты глубины
-        // ----------------------------------------------------------
-        // shadowProj - это матрица перспективы
-        // shadowTransforms - это вектор матриц преобразования
-        // каждая матрица преобразования - это матрица перспективы проекции кубической карты глубины на плоскость
-        // поверхности, всего их 6 штук, по 1 на каждую сторону проекции кубической карты глубины
-        // near_plane - это ближняя плоскость проекции кубической карты глубины
-        // far_plane - это дальняя плоскость проекции кубической карты глубины
-        float near_plane = 1.0f;
-        float far_plane = 25.0f;
-        glm::mat4 shadowProj = glm::perspective(glm::radians(90.0f), (float)SHADOW_WIDTH / (float)SHADOW_HEIGHT, near_plane, far_plane);
-        std::vector<glm::mat4> shadowTransforms;
-        shadowTransforms.push_back(shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f)));
-        shadowTransforms.push_back(shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f)));
-        shadowTransforms.push_back(shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f)));
-        shadowTransforms.push_back(shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f)));
-        shadowTransforms.push_back(shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, -1.0f, 0.0f)));
-        shadowTransforms.push_back(shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, -1.0f, 0.0f)));
-
-        // 1. рендеринг сцены в кубическую карту глубины
-        // ---------------------------------------------
-        glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
-        glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-        glClear(GL_DEPTH_BUFFER_BIT);
-        simpleDepthShader.use();
-        for (unsigned int i = 0; i < 6; ++i)
-            simpleDepthShader.setMat4("shadowMatrices[" + std::to_string(i) + "]", shadowTransforms[i]);
-        simpleDepthShader.setFloat("far_plane", far_plane);
-        simpleDepthShader.setVec3("lightPos", lightPos);
-        renderScene(simpleDepthShader);
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-        // 2. отрендерить сцену в обычном режиме
-        // -------------------------------------
-        glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    setShadowSamplers(shader);
+    shader.setBool("overdrawView", options.overdrawView);
+    const ShadowFilterUniforms filterUniforms(shader);
+    MomentPass momentPass;
+
+    // отложенный путь: G-буфер рисует сцену так же, как основной проход; маски теней фильтруют атлас тем же кодом
+    // (создаётся, только если какой-то прогон его использует)
+    std::unique_ptr<DeferredRenderer> deferred;
+    PassProgram gbufferProgram, maskProgram, deferredProgram;
+    ShadowFilterUniforms maskFilterUniforms;
+    if (options.renderPath == RENDER_DEFERRED || options.sweepRenderer)
+    {
+        deferred.reset(new DeferredRenderer(SCR_WIDTH, SCR_HEIGHT, options.halfResolutionMask));
+        // PassProgram привязывает блоки Camera и Lights; полноэкранные проходы вершины из буферов не читают
+        gbufferProgram = PassProgram(&deferred->gbuffer, GeometryBuffers::SURFACE);
+        maskProgram = PassProgram(&deferred->mask, GeometryBuffers::SURFACE);
+        deferredProgram = PassProgram(&deferred->lighting, GeometryBuffers::SURFACE);
+        deferred->mask.use();
+        setShadowSamplers(deferred->mask);
+        maskFilterUniforms = ShadowFilterUniforms(deferred->mask);
+    }
+
+    // кластерные списки источников: освещение обоих путей перебирает только источники кластера пикселя
+    // -----------------------------------------------------------------------------------------------
+    if (options.lightCulling == LIGHT_CULLING_COMPUTE && !GLCaps::get().atLeast(4, 3))
+    {
+        std::cout << "Compute shaders are not supported (OpenGL 4.3 required), falling back to CPU light culling" << std::endl;
+        options.lightCulling = LIGHT_CULLING_CPU;
+    }
+    ClusteredLighting clusters(options.lightCulling, CAMERA_NEAR, CAMERA_FAR);
+    // вычислительному шейдеру нужны те же блоки Camera и Lights, что и освещению
+    PassProgram clusterProgram(clusters.assignment.get(), GeometryBuffers::SURFACE);
+    shader.use();
+    clusters.configure(shader, SCR_WIDTH, SCR_HEIGHT);
+    if (deferred)
+    {
+        deferred->lighting.use();
+        clusters.configure(deferred->lighting, SCR_WIDTH, SCR_HEIGHT);
+    }
+    // готовый вариант основного прохода настраивается так же, как shader; фильтр теней — текущего прогона
+    PassProgram litVariantPasses[LIT_VARIANT_COUNT];
+    ShadowFilterUniforms litVariantFilters[LIT_VARIANT_COUNT];
+    auto setupLitVariant = [&](int v, const ShadowFilter &filter) {
+        Shader &program = *litVariants.get(v);
+        program.use();
+        program.setInt("diffuseTexture", 0);
+        setShadowSamplers(program);
+        program.setBool("overdrawView", options.overdrawView);
+        clusters.configure(program, SCR_WIDTH, SCR_HEIGHT);
+        litVariantFilters[v] = ShadowFilterUniforms(program);
+        litVariantFilters[v].apply(program, filter);
+        litVariantPasses[v] = PassProgram(&program, GeometryBuffers::SURFACE);
+    };
+
+    // время создания всех программ: холодный запуск компилирует, тёплый загружает двоичные программы из кэша
+    const ProgramBinaryCache& programCache = ProgramBinaryCache::get();
+    if (!options.headless)
+        std::cout << "Shader setup: " << programCache.setupTime() * 1000.0 << " ms, " << programCache.programCount()
+                  << " programs, cache " << programCache.state() << std::endl;
+
+    if (options.benchUniforms)
+    {
+        runUniformBenchmark(litProgram, depthPrograms.geometry, uniformRing, submitter);
+        headless.destroy();
+        return 0;
+    }
+    if (options.benchCulling)
+    {
+        runCullingBenchmark();
+        headless.destroy();
+        return 0;
+    }
+    if (options.benchTextures)
+    {
+        runTextureBenchmark();
+        headless.destroy();
+        return 0;
+    }
+    if (options.verifyClusters)
+    {
+        bool matched = runClusterVerification(clusters, uniformRing);
+        headless.destroy();
+        return matched ? 0 : 1;
+    }
+    if (options.shadowPrecision)
+    {
+        runPrecisionReport(atlas, depthPrograms, uniformRing, submitter);
+        headless.destroy();
+        return 0;
+    }
+
+    // количество источников для каждого прогона: одно значение или развёртка 1, 2, 4 ... MAX_LIGHTS
+    std::vector<int> lightCounts;
+    if (options.sweepLights)
+        for (int count = 1; count <= MAX_LIGHTS; count *= 2)
+            lightCounts.push_back(count);
+    else
+        lightCounts.push_back(options.lights);
+    // фильтр теней для каждого прогона: один или развёртка по уровням качества (сетка, 4..32 выборки диска и PCSS,
+    // VSM и EVSM)
+    std::vector<ShadowFilter> filters;
+    if (options.sweepFilter)
+    {
+        ShadowFilter grid = options.shadowFilter;
+        grid.mode = SHADOW_FILTER_GRID;
+        filters.push_back(grid);
+        for (int samples : SHADOW_FILTER_SAMPLE_COUNTS)
+        {
+            ShadowFilter poisson = options.shadowFilter;
+            poisson.mode = SHADOW_FILTER_POISSON;
+            poisson.samples = samples;
+            filters.push_back(poisson);
+        }
+        for (int samples : SHADOW_FILTER_SAMPLE_COUNTS)
+        {
+            ShadowFilter pcss = options.shadowFilter;
+            pcss.mode = SHADOW_FILTER_PCSS;
+            pcss.samples = samples;
+            filters.push_back(pcss);
+        }
+        for (ShadowFilterMode mode : { SHADOW_FILTER_VSM, SHADOW_FILTER_EVSM })
+        {
+            ShadowFilter moments = options.shadowFilter;
+            moments.mode = mode;
+            filters.push_back(moments);
+        }
+    }
+    else
+        filters.push_back(options.shadowFilter);
+    // способ освещения для каждого прогона: один или оба (прямой и отложенный)
+    std::vector<RenderPath> renderPaths;
+    if (options.sweepRenderer)
+        renderPaths = { RENDER_FORWARD, RENDER_DEFERRED };
+    else
+        renderPaths.push_back(options.renderPath);
+    const size_t runCount = lightCounts.size() * filters.size() * renderPaths.size();
+    std::ostringstream reports;
+
+    for (size_t run = 0; run < runCount; ++run)
+    {
+        // источники света и их слоты в атласе
+        // -----------------------------------
+        lights = makeLights(lightCounts[run / (filters.size() * renderPaths.size())]);
+        for (PointLight &light : lights)
+            light.radius = options.lightRadius;
+        const ShadowFilter &filter = filters[run / renderPaths.size() % filters.size()];
+        const RenderPath renderPath = renderPaths[run % renderPaths.size()];
         shader.use();
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-        glm::mat4 view = camera.GetViewMatrix();
-        shader.setMat4("projection", projection);
-        shader.setMat4("view", view);
-        // задать униформы освещения (set lighting uniforms)
-        shader.setVec3("lightPos", lightPos);
-        shader.setVec3("viewPos", camera.Position);
-        shader.setInt("shadows", shadows); // enable/disable shadows by pressing 'SPACE'
-        shader.setFloat("far_plane", far_plane);
-        // рендерим сцену
-        // -------------
-        // GL_TEXTURE0 - это индекс текущей текстуры
-        // GL_TEXTURE_2D - это тип текстуры (2D текстура)
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, grassTexture);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, depthCubemap);
-        renderScene(shader);
-        // GL_TEXTURE1 - индекс текущей текстуры
-        // GL_TEXTURE_CUBE_MAP - тип текстуры, которая является кубической картой глубины, она похожа на 2D текстуру,
-        // но имеет 6 слоев, которые соответствуют направлениям, каждый слой является квадратом.
-
-        // glfw: обменять буферы и обработать события ввода-вывода (нажатия/отпускания клавиш, движение мыши и т. д.).
-        // -------------------------------------------------------------------------------
-        // glSwapBuffers - это функция из библиотеки GLFW, используемая для управления двойной буферизацией при
-        // рендеринге в OpenGL. Она обменивает передний и задний буферы текущего контекста окна, позволяя обновить
-        // содержимое окна на экране.
-        // glfwPollEvents - это функция из библиотеки GLFW, которая обрабатывает все ожидающие события
-        // пользовательского ввода и обновляет внутренние состояния GLFW. Она предназначена для обработки событий без
-        // блокировки выполнения программы.
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        filterUniforms.apply(shader, filter);
+        for (int v = 0; v < litVariants.size(); ++v)
+            if (litVariants.get(v) != nullptr)
+            {
+                litVariants.get(v)->use();
+                litVariantFilters[v].apply(*litVariants.get(v), filter);
+            }
+        if (deferred)
+        {
+            deferred->mask.use();
+            maskFilterUniforms.apply(deferred->mask, filter);
+        }
+        // карты моментов есть только у VSM/EVSM; пересозданные карты заполняются заново, потому что новые
+        // источники начинают с пустым кэшем граней
+        atlas.setMomentFormat(filter.momentFormat());
+        if (filter.usesMoments())
+            momentPass.apply(filter);
+        std::vector<ShadowSlot> shadowSlots;
+        lastFrame = 0.0f;
+
+        // замер проходов: CPU-время и таймеры GPU
+        // ---------------------------------------
+        Benchmark benchmark;
+        int shadowPass = benchmark.addPass("shadow");
+        int prepassPass = benchmark.addPass("depth_prepass");
+        // построение кластерных списков источников (CPU-время — у режима cpu, GPU-время — у compute)
+        int cullingPass = benchmark.addPass("light_culling");
+        int lightingPass = benchmark.addPass("lighting");
+        // отложенный путь: G-буфер и маски теней всех источников
+        int gbufferPass = renderPath == RENDER_DEFERRED ? benchmark.addPass("gbuffer") : -1;
+        int maskPass = renderPath == RENDER_DEFERRED ? benchmark.addPass("shadow_mask") : -1;
+        // построение карт моментов (размытие и мип-уровни), только у VSM/EVSM
+        int momentsPass = filter.usesMoments() ? benchmark.addPass("moments") : -1;
+        // сколько треугольников реально растеризуется в кубические карты (у GS-пути — на выходе GS)
+        int shadowPrimitives = benchmark.addQueryCounter("shadow_primitives", GL_PRIMITIVES_GENERATED);
+        // в интерактивном режиме статистика не нужна, но замеры дёшевы и остаются включёнными
+        benchmark.setRecording(!options.headless);
+        // перерисовка основного прохода и решение о предварительном проходе глубины
+        OverdrawMonitor overdraw;
+
+        // цикл рендеринга
+        // ---------------
+        // в headless-режиме рисуем ровно warmup + frames кадров по детерминированной временной шкале
+        const int totalFrames = options.warmup + options.frames;
+        for (int frameIndex = 0; options.headless ? frameIndex < totalFrames : !glfwWindowShouldClose(window); ++frameIndex)
+        {
+            // per-frame time logic (логика обработки времени в расчёте на кадр)
+            // -----------------------------------------------------------------
+            float currentFrame = options.headless ? frameIndex * options.timeStep : static_cast<float>(glfwGetTime());
+            deltaTime = currentFrame - lastFrame;
+            lastFrame = currentFrame;
+            if (options.headless && frameIndex == options.warmup)
+            {
+                // замеряемые кадры рисуются загруженными текстурами, а не заглушками
+                textureStreamer.finish();
+                benchmark.setRecording(true);
+            }
+            GLCallCounter::get().reset();
+            GLStateCache::get().reset();
+            benchmark.beginFrame();
+
+            // ввод
+            // ----
+            if (window != NULL)
+                processInput(window);
+
+            // полосы текстур в пределах бюджета кадра
+            textureStreamer.update();
+
+            // специализации основного прохода, скомпилированные к этому кадру
+            for (int v : litVariants.poll())
+                setupLitVariant(v, filter);
+
+            // перемещать позицию основного источника света со временем, остальные неподвижны
+            if (!options.staticLight)
+                lights[0].position.z = static_cast<float>(sin(currentFrame * 0.5) * 3.0);
+            if (options.movingObject)
+                animateScene(currentFrame);
+
+            // распределение слотов атласа по экранной значимости источников
+            // --------------------------------------------------------------
+            std::vector<float> importance(lights.size());
+            for (size_t i = 0; i < lights.size(); ++i)
+                importance[i] = lightImportance(lights[i], camera);
+            atlas.allocate(importance, shadowSlots);
+            int shadowedLights = 0;
+            for (size_t i = 0; i < lights.size(); ++i)
+            {
+                // новый слот — старое содержимое кубической карты к источнику не относится
+                if (lights[i].slot != shadowSlots[i])
+                    lights[i].cache.invalidate();
+                lights[i].slot = shadowSlots[i];
+                shadowedLights += lights[i].slot.valid() ? 1 : 0;
+            }
+
+            // данные кадра в буфер униформ: камера, список источников и блоки проходов теней
+            // ------------------------------------------------------------------------------
+            uniformRing.beginFrame();
+            GpuCamera cameraBlock;
+            cameraBlock.projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, CAMERA_NEAR, CAMERA_FAR);
+            cameraBlock.view = camera.GetViewMatrix();
+            cameraBlock.viewPos = glm::vec4(camera.Position, 1.0f);
+            cameraBlock.inverseViewProjection = glm::inverse(cameraBlock.projection * cameraBlock.view);
+            size_t cameraOffset = uniformRing.push(cameraBlock);
+            GpuLightBlock lightBlock;
+            lightBlock.lightCount = glm::ivec4((int)lights.size(), 0, 0, 0);
+            // слои масок теней отложенного пути — по порядку источников с тенью
+            int maskLayers = 0;
+            for (size_t i = 0; i < lights.size(); ++i)
+            {
+                lightBlock.lights[i].position = glm::vec4(lights[i].position, lights[i].farPlane);
+                lightBlock.lights[i].color = glm::vec4(lights[i].color, lights[i].radius);
+                int maskLayer = lights[i].slot.valid() ? maskLayers++ : -1;
+                lightBlock.lights[i].shadow = glm::ivec4(lights[i].slot.tier, lights[i].slot.index, maskLayer, 0);
+            }
+            size_t lightsOffset = uniformRing.push(lightBlock);
+            // грани для перерисовки и блок ShadowPass каждого источника с тенью
+            std::vector<unsigned int> renderFaces(lights.size(), 0);
+            std::vector<size_t> shadowPassOffsets(lights.size(), 0);
+            for (size_t i = 0; i < lights.size(); ++i)
+            {
+                if (!lights[i].slot.valid())
+                    continue;
+                GpuShadowPass shadowBlock;
+                renderFaces[i] = prepareLightShadow(lights[i], shadowBlock);
+                if (renderFaces[i] != 0)
+                    shadowPassOffsets[i] = uniformRing.push(shadowBlock);
+            }
+            uniformRing.flush();
+            uniformRing.bind(CAMERA_UBO_BINDING, cameraOffset, sizeof(GpuCamera));
+            uniformRing.bind(LIGHTS_UBO_BINDING, lightsOffset, sizeof(GpuLightBlock));
+
+            // кластерные списки источников кадра (до прохода теней: вычислительный шейдер успеет закончить)
+            // ---------------------------------------------------------------------------------------------
+            benchmark.beginPass(cullingPass);
+            clusters.update(cameraBlock.projection, cameraBlock.view, lights);
+            benchmark.endPass(cullingPass);
+            if (clusters.getMode() != LIGHT_CULLING_NONE)
+            {
+                benchmark.setCounter("cluster_light_refs", clusters.assignedLights());
+                benchmark.setCounter("cluster_lights_avg", clusters.averageLightsPerCluster());
+                benchmark.setCounter("cluster_overflow", clusters.overflowed());
+            }
+
+            // партии экземпляров всех проходов кадра, одна загрузка буферов экземпляров и команд
+            // ---------------------------------------------------------------------------------
+            submitter.beginFrame();
+            submitter.resetDrawCalls();
+            std::vector<LightShadowBatches> shadowBatches(lights.size());
+            for (size_t i = 0; i < lights.size(); ++i)
+                if (renderFaces[i] != 0)
+                    shadowBatches[i] = queueLightShadow(lights[i], renderFaces[i], atlas.tier(lights[i].slot.tier).resolution,
+                                                        submitter);
+            VisibilityStats visibility;
+            std::vector<StateBatch> litBatches = queueVisibleScene(submitter, litProgram, cameraBlock, visibility);
+            submitter.upload();
+
+            // отрисовка
+            // ---------
+            glBindFramebuffer(GL_FRAMEBUFFER, sceneFBO);
+            glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            // 1. рендеринг сцены в кубические карты глубины всех источников с тенью
+            // ---------------------------------------------------------------------
+            benchmark.beginPass(shadowPass);
+            benchmark.beginQuery(shadowPrimitives);
+            int facesRendered = 0;
+            for (size_t i = 0; i < lights.size(); ++i)
+            {
+                if (renderFaces[i] == 0)
+                    continue;
+                uniformRing.bind(SHADOW_PASS_UBO_BINDING, shadowPassOffsets[i], sizeof(GpuShadowPass));
+                facesRendered += renderLightShadow(lights[i], renderFaces[i], shadowBatches[i], atlas, depthPrograms, submitter);
+            }
+            benchmark.endQuery(shadowPrimitives);
+            glBindFramebuffer(GL_FRAMEBUFFER, sceneFBO);
+            benchmark.endPass(shadowPass);
+            benchmark.setCounter("shadow_faces_rendered", facesRendered);
+            benchmark.setCounter("shadowed_lights", shadowedLights);
+            int shadowLodInstances = 0;
+            for (const LightShadowBatches &batches : shadowBatches)
+                shadowLodInstances += batches.lodInstances();
+            benchmark.setCounter("shadow_lod_instances", shadowLodInstances);
+
+            // 1a. карты моментов источников с перерисованными гранями и мип-уровни их ярусов
+            // ------------------------------------------------------------------------------
+            if (filter.usesMoments())
+            {
+                benchmark.beginPass(momentsPass);
+                std::vector<bool> tierUpdated(atlas.tierCount(), false);
+                for (size_t i = 0; i < lights.size(); ++i)
+                {
+                    if (renderFaces[i] == 0)
+                        continue;
+                    filterLightMoments(lights[i], atlas, momentPass);
+                    tierUpdated[lights[i].slot.tier] = true;
+                }
+                for (int t = 0; t < atlas.tierCount(); ++t)
+                    if (tierUpdated[t])
+                        atlas.generateMomentMipmaps(t);
+                glBindFramebuffer(GL_FRAMEBUFFER, sceneFBO);
+                benchmark.endPass(momentsPass);
+            }
+
+            glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            // GL_TEXTURE0 - это индекс текущей текстуры
+            // GL_TEXTURE_2D - это тип текстуры (2D текстура)
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, grassTexture);
+            // GL_TEXTURE1.. - ярусы атласа, GL_TEXTURE_CUBE_MAP_ARRAY - массив кубических карт глубины: как кубическая
+            // карта, но с дополнительной координатой — номером карты в массиве
+            atlas.bindTextures(1);
+            atlas.bindCompareTextures(1 + SHADOW_TIERS);
+            if (atlas.hasMoments())
+                atlas.bindMomentTextures(1 + 2 * SHADOW_TIERS);
+            clusters.bindTextures();
+
+            if (renderPath == RENDER_DEFERRED)
+            {
+                // 2. отложенный путь: G-буфер теми же отсортированными партиями, маска теней на источник
+                // и полноэкранное освещение
+                // ------------------------------------------------------------------------------------
+                benchmark.beginPass(gbufferPass);
+                deferred->beginGeometry();
+                deferred->gbuffer.use();
+                drawStateBatches(gbufferProgram, submitter, litBatches);
+                benchmark.endPass(gbufferPass);
+
+                benchmark.beginPass(maskPass);
+                if (shadows && maskLayers > 0)
+                {
+                    deferred->beginMasks(maskLayers);
+                    int layer = 0;
+                    for (size_t i = 0; i < lights.size(); ++i)
+                        if (lights[i].slot.valid())
+                            deferred->renderMask((int)i, layer++);
+                    deferred->endMasks();
+                }
+                benchmark.endPass(maskPass);
+
+                benchmark.beginPass(lightingPass);
+                glBindFramebuffer(GL_FRAMEBUFFER, sceneFBO);
+                deferred->light(shadows);
+                benchmark.endPass(lightingPass);
+            }
+            else
+            {
+                // 2a. предварительный проход глубины: те же отсортированные партии из потока позиций, без записи цвета
+                // --------------------------------------------------------------------------------------------------
+                bool prepass = overdraw.beginFrame(options.depthPrepass, options.prepassThreshold, (double)SCR_WIDTH * SCR_HEIGHT);
+                if (prepass)
+                {
+                    benchmark.beginPass(prepassPass);
+                    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+                    prepassShader.use();
+                    drawStateBatches(prepassProgram, submitter, litBatches);
+                    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+                    // основной проход затеняет только фрагменты, глубина которых совпала с записанной
+                    glDepthFunc(GL_EQUAL);
+                    glDepthMask(GL_FALSE);
+                    benchmark.endPass(prepassPass);
+                }
+
+                // 2. отрендерить сцену в обычном режиме: специализациями, если обе нужные готовы
+                // ------------------------------------------------------------------------------
+                PassProgram litPass = litProgram;
+                const int regularVariant = litVariant(shadows, false);
+                if (litVariants.size() > 0 && litVariants.get(regularVariant) != nullptr &&
+                    litVariants.get(regularVariant + 1) != nullptr)
+                {
+                    litPass = litVariantPasses[regularVariant];
+                    litPass.insideOut = &litVariantPasses[regularVariant + 1];
+                }
+                benchmark.beginPass(lightingPass);
+                if (options.overdrawView)
+                {
+                    glEnable(GL_BLEND);
+                    glBlendFunc(GL_ONE, GL_ONE);
+                }
+                // камера и источники уже в блоках Camera и Lights
+                litPass.shader->use();
+                litPass.shader->set(litPass.shadows, (int)shadows); // enable/disable shadows by pressing 'SPACE'
+                // рендерим сцену
+                // -------------
+                overdraw.beginQuery();
+                drawStateBatches(litPass, submitter, litBatches);
+                overdraw.endQuery();
+                if (prepass)
+                {
+                    glDepthFunc(GL_LESS);
+                    glDepthMask(GL_TRUE);
+                }
+                if (options.overdrawView)
+                    glDisable(GL_BLEND);
+                benchmark.endPass(lightingPass);
+                benchmark.setCounter("prepass", prepass ? 1.0 : 0.0);
+                benchmark.setCounter("lit_specialized", litPass.insideOut != nullptr ? 1.0 : 0.0);
+                benchmark.setCounter("shader_variants_pending", litVariants.pendingCount());
+                if (overdraw.hasFreshResult())
+                    benchmark.setCounter("lit_fragments", overdraw.lastFragments());
+                if (overdraw.measured())
+                    benchmark.setCounter("overdraw", overdraw.overdraw());
+            }
+            benchmark.setCounter("lit_draws", visibility.visible);
+            benchmark.setCounter("lit_draws_culled", visibility.culled);
+            benchmark.setCounter("lit_state_changes", visibility.stateChanges);
+            benchmark.setCounter("lit_state_changes_saved", visibility.stateChangesSaved);
+            benchmark.setCounter("bvh_nodes_tested", visibility.nodesTested);
+            benchmark.setCounter("draw_calls", (double)submitter.drawCallCount());
+            benchmark.setCounter("instances", (double)submitter.instanceCount());
+            benchmark.setCounter("texture_upload_bytes", (double)textureStreamer.lastFrameBytes());
+            benchmark.setCounter("textures_pending", textureStreamer.pendingCount());
+            uniformRing.endFrame();
+            benchmark.endFrame();
+            if (GLCallCounter::get().active())
+            {
+                const GLCallCounter& calls = GLCallCounter::get();
+                benchmark.setCounter("gl_calls", (double)calls.total());
+                benchmark.setCounter("gl_uniform_calls", (double)calls.count("glUniform"));
+                benchmark.setCounter("gl_uniform_location_queries", (double)calls.count("glGetUniformLocation"));
+            }
+            if (GLStateCache::get().active())
+            {
+                const GLStateCache& state = GLStateCache::get();
+                benchmark.setCounter("gl_state_issued", (double)state.issued());
+                benchmark.setCounter("gl_state_elided", (double)state.elided());
+                benchmark.setCounter("gl_state_elided_uniforms", (double)state.elided("glUniform"));
+            }
+
+            // glfw: обменять буферы и обработать события ввода-вывода (нажатия/отпускания клавиш, движение мыши и т. д.).
+            // -------------------------------------------------------------------------------
+            // glSwapBuffers - это функция из библиотеки GLFW, используемая для управления двойной буферизацией при
+            // рендеринге в OpenGL. Она обменивает передний и задний буферы текущего контекста окна, позволяя обновить
+            // содержимое окна на экране.
+            // glfwPollEvents - это функция из библиотеки GLFW, которая обрабатывает все ожидающие события
+            // пользовательского ввода и обновляет внутренние состояния GLFW. Она предназначена для обработки событий без
+            // блокировки выполнения программы.
+            if (window != NULL)
+            {
+                glfwSwapBuffers(window);
+                glfwPollEvents();
+            }
+        }
+
+        if (options.headless)
+        {
+            // отчёт о замерах прогона
+            // -----------------------
+            benchmark.finish();
+            benchmark.setInfo("renderer", (const char*)glGetString(GL_RENDERER));
+            benchmark.setInfo("version", (const char*)glGetString(GL_VERSION));
+            benchmark.setInfo("resolution", std::to_string(SCR_WIDTH) + "x" + std::to_string(SCR_HEIGHT));
+            std::string tiers;
+            for (int t = 0; t < atlas.tierCount(); ++t)
+                tiers += (t == 0 ? "" : ",") + std::to_string(atlas.tier(t).resolution) + "x" + std::to_string(atlas.tier(t).capacity);
+            benchmark.setInfo("shadow_tiers", tiers);
+            benchmark.setInfo("shadow_storage", shadowStorageNames[atlas.getStorage()]);
+            benchmark.setInfo("lights", std::to_string(lights.size()));
+            benchmark.setInfo("timestep", std::to_string(options.timeStep));
+            benchmark.setInfo("shadow_path", shadowPathNames[shadowPath]);
+            benchmark.setInfo("shadow_cache", options.shadowCache ? "on" : "off");
+            benchmark.setInfo("static_light", options.staticLight ? "on" : "off");
+            benchmark.setInfo("moving_object", options.movingObject ? "on" : "off");
+            benchmark.setInfo("gl_call_counter", options.countGLCalls ? "on" : "off");
+            benchmark.setInfo("state_cache", GLStateCache::get().active() ? "on" : "off");
+            benchmark.setInfo("texture_streaming", options.textureStreaming ? "on" : "off");
+            benchmark.setInfo("cooked_textures", grassCooked ? "on" : "off");
+            benchmark.setInfo("texture_cache_budget_mb", std::to_string(options.textureCacheMB));
+            benchmark.setInfo("texture_cache_hits", std::to_string(textureCache.hits()));
+            benchmark.setInfo("texture_cache_misses", std::to_string(textureCache.misses()));
+            benchmark.setInfo("texture_cache_resident_mb", std::to_string(textureCache.bytesResident() / (1024.0 * 1024.0)));
+            if (options.textureStreaming)
+            {
+                benchmark.setInfo("texture_budget_kb", std::to_string(options.textureBudgetKB));
+                benchmark.setInfo("texture_threads", std::to_string(textureStreamer.threadCount()));
+            }
+            benchmark.setInfo("ubo_mode", uniformRing.modeName());
+            benchmark.setInfo("submit_mode", submitModeNames[options.submitMode]);
+            benchmark.setInfo("objects", std::to_string(scene.size()));
+            benchmark.setInfo("model", options.modelPath.empty() ? "none" : options.modelPath);
+            benchmark.setInfo("visibility", options.visibility ? "on" : "off");
+            benchmark.setInfo("depth_prepass", depthPrepassNames[options.depthPrepass]);
+            benchmark.setInfo("overdraw_view", options.overdrawView ? "on" : "off");
+            benchmark.setInfo("render_path", renderPathNames[renderPath]);
+            benchmark.setInfo("light_culling", lightCullingNames[clusters.getMode()]);
+            benchmark.setInfo("shader_cache", programCache.state());
+            benchmark.setInfo("shader_programs", std::to_string(programCache.programCount()));
+            benchmark.setInfo("shader_setup_ms", std::to_string(programCache.setupTime() * 1000.0));
+            benchmark.setInfo("shader_cache_hits", std::to_string(programCache.hitCount()));
+            benchmark.setInfo("shader_cache_rejected", std::to_string(programCache.rejectedCount()));
+            benchmark.setInfo("shader_permutations", options.shaderPermutations ? "on" : "off");
+            benchmark.setInfo("parallel_compile", parallelCompile ? "on" : "off");
+            if (clusters.getMode() != LIGHT_CULLING_NONE)
+                benchmark.setInfo("cluster_grid", std::to_string(LightClusters::TILES_X) + "x" + std::to_string(LightClusters::TILES_Y) +
+                                                  "x" + std::to_string(LightClusters::SLICES));
+            if (clusters.getMode() == LIGHT_CULLING_CPU)
+                benchmark.setInfo("cluster_threads", std::to_string(clusters.threadCount()));
+            if (renderPath == RENDER_DEFERRED)
+            {
+                benchmark.setInfo("shadow_mask_scale", std::to_string(deferred->getMaskScale()));
+                benchmark.setInfo("deferred_mb", std::to_string((double)deferred->memoryBytes() / (1024.0 * 1024.0)));
+            }
+            benchmark.setInfo("shadow_filter", filter.name());
+            benchmark.setInfo("light_radius", std::to_string(options.lightRadius));
+            if (run > 0)
+                reports << ",\n";
+            benchmark.writeJson(reports);
+        }
+    }
+
+    if (options.headless)
+    {
+        // отчёт (при развёртке — массив отчётов по прогонам) и (по желанию) снимок последнего кадра
+        // -----------------------------------------------------------------------------------------
+        std::string report = runCount > 1 ? "[\n" + reports.str() + "]\n" : reports.str();
+        writeReport(report);
+        if (!options.dumpPath.empty() && !offscreen.writePPM(options.dumpPath))
+            std::cout << "Failed to write frame dump: " << options.dumpPath << std::endl;
+        offscreen.destroy();
+        headless.destroy();
+        return 0;
     }
 
     glfwTerminate();
     return 0;
 }
 
-// renders the 3D scene
-// --------------------
-void renderScene(const Shader &shader)
+// данные прохода теней одного источника для блока ShadowPass: матрицы граней, позиция, far_plane
+// и грани, которые нужно перерисовать (все или только грязные по кэшу); возвращает маску этих граней
+// ------------------------------------------------------------------------------------------------
+unsigned int prepareLightShadow(PointLight &light, GpuShadowPass &block)
+{
+    const glm::vec3 &lightPos = light.position;
+
+    // 0. создать матрицы преобразования кубической карты глубины
+    // ----------------------------------------------------------
+    // shadowProj - это матрица перспективы
+    // shadowMatrices - матрицы преобразования: каждая - матрица перспективы проекции кубической карты глубины на
+    // плоскость поверхности, всего их 6 штук, по 1 на каждую сторону проекции кубической карты глубины
+    // near_plane - это ближняя плоскость проекции кубической карты глубины
+    // far_plane - это дальняя плоскость проекции кубической карты глубины
+    float near_plane = 1.0f;
+    float far_plane = light.farPlane;
+    glm::mat4 shadowProj = glm::perspective(glm::radians(90.0f), 1.0f, near_plane, far_plane);
+    block.shadowMatrices[0] = shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f));
+    block.shadowMatrices[1] = shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f));
+    block.shadowMatrices[2] = shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+    block.shadowMatrices[3] = shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f));
+    block.shadowMatrices[4] = shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, -1.0f, 0.0f));
+    block.shadowMatrices[5] = shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, -1.0f, 0.0f));
+    block.lightPosFar = glm::vec4(lightPos, far_plane);
+
+    // 1. какие грани перерисовывать: все или только грязные по кэшу
+    // -------------------------------------------------------------
+    unsigned int renderFaces = CUBE_FACE_ALL;
+    if (options.shadowCache)
+    {
+        light.cache.setLight(lightPos, far_plane);
+        light.cache.setObjectCount(scene.size());
+        for (size_t i = 0; i < scene.size(); ++i)
+            light.cache.setObject(i, scene[i].model, scene[i].bounds);
+        renderFaces = light.cache.dirtyFaces();
+    }
+    block.shadowFaces = glm::ivec4((int)renderFaces, light.slot.layerBase(), 0, 0);
+    return renderFaces;
+}
+
+// партии прохода теней одного источника для граней renderFaces (зависят от способа построения кубической карты);
+// resolution — разрешение грани карты источника, по нему и расстоянию до источника выбираются уровни детализации
+// -----------------------------------------------------------------------------------------------------------
+LightShadowBatches queueLightShadow(const PointLight &light, unsigned int renderFaces, int resolution, SceneSubmitter &submitter)
+{
+    LightShadowBatches batches;
+    // маска граней, в пирамиды видимости которых попадает каждый объект (0 — объект дальше far_plane)
+    const std::vector<unsigned int> &faceMasks = casterCuller.cull(light.position, light.farPlane);
+    const ShadowLodView lodView = { light.position, resolution };
+    if (shadowPath == SHADOW_PATH_GEOMETRY)
+        // объект целиком, если он попадает хотя бы в одну перерисовываемую грань; грани выбирает геометрический шейдер
+        batches.scene = queueScene(submitter, &faceMasks, renderFaces, false, &lodView);
+    else if (shadowPath == SHADOW_PATH_LAYERED)
+        // экземпляр на каждую пару (объект, грань)
+        batches.scene = queueScene(submitter, &faceMasks, renderFaces, true, &lodView);
+    else
+        for (unsigned int face = 0; face < 6; ++face)
+            if ((renderFaces & (1u << face)) != 0)
+                batches.faces[face] = queueScene(submitter, &faceMasks, 1u << face, false, &lodView);
+    return batches;
+}
+
+// рендеринг граней renderFaces кубической карты теней одного источника в его слот атласа;
+// блок ShadowPass источника уже привязан. Возвращает количество перерисованных граней
+// -----------------------------------------------------------------------------------
+int renderLightShadow(PointLight &light, unsigned int renderFaces, const LightShadowBatches &batches,
+                      const ShadowAtlas &atlas, const DepthPrograms &programs, SceneSubmitter &submitter)
 {
+    const int resolution = atlas.tier(light.slot.tier).resolution;
+
+    glViewport(0, 0, resolution, resolution);
+    atlas.clearFaces(light.slot, renderFaces);
+    if (shadowPath == SHADOW_PATH_GEOMETRY)
+    {
+        // каждый треугольник уходит во все перерисовываемые грани через геометрический шейдер
+        const PassProgram &pass = programs.geometry;
+        atlas.bindLayered(light.slot);
+        pass.shader->use();
+        drawScene(pass, submitter, batches.scene);
+    }
+    else if (shadowPath == SHADOW_PATH_LAYERED)
+    {
+        // один проход: объект рисуется экземпляром на каждую свою грань
+        const PassProgram &pass = programs.layered;
+        atlas.bindLayered(light.slot);
+        pass.shader->use();
+        drawScene(pass, submitter, batches.scene);
+    }
+    else
+    {
+        // проход на грань: в грань рисуются только объекты, попавшие в её пирамиду видимости
+        const PassProgram &pass = programs.face;
+        pass.shader->use();
+        for (unsigned int face = 0; face < 6; ++face)
+        {
+            if ((renderFaces & (1u << face)) == 0)
+                continue;
+            atlas.bindFace(light.slot, face);
+            pass.shader->set(pass.face, (int)face);
+            drawScene(pass, submitter, batches.faces[face]);
+        }
+    }
+    light.cache.markClean(renderFaces);
+    return faceCount(renderFaces);
+}
+
+// карта моментов источника (VSM/EVSM) из его кубической карты глубины: на каждую грань два прохода
+// разделимого размытия — по оси x из глубины в промежуточную карту яруса, по оси y оттуда в карту моментов.
+// Выборки размытия берутся по направлениям кубической карты, поэтому ядро переходит через рёбра граней.
+// Пересчитываются все 6 граней: размытие перерисованной грани задевает соседние
+// ---------------------------------------------------------------------------------------------------
+void filterLightMoments(const PointLight &light, const ShadowAtlas &atlas, MomentPass &pass)
+{
+    const ShadowAtlas::Tier &tier = atlas.tier(light.slot.tier);
+
+    glViewport(0, 0, tier.resolution, tier.resolution);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+    pass.shader.use();
+    pass.shader.set(pass.resolution, tier.resolution);
+    pass.shader.set(pass.hardwareDepth, (int)!storesDistance(atlas.getStorage()));
+    pass.shader.set(pass.farPlane, light.farPlane);
+    glBindVertexArray(pass.emptyVAO);
+    glActiveTexture(GL_TEXTURE0);
+    for (int face = 0; face < 6; ++face)
+    {
+        pass.shader.set(pass.face, face);
+
+        atlas.bindMomentScratchFace(light.slot.tier, face);
+        glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, tier.texture);
+        pass.shader.set(pass.sourceLayer, light.slot.index);
+        pass.shader.set(pass.fromDepth, 1);
+        pass.shader.set(pass.axis, 0);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+
+        atlas.bindMomentFace(light.slot, face);
+        glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, tier.momentScratch);
+        pass.shader.set(pass.sourceLayer, 0);
+        pass.shader.set(pass.fromDepth, 0);
+        pass.shader.set(pass.axis, 1);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+    glBindVertexArray(0);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+}
+
+// разбор аргументов командной строки
+// ----------------------------------
+// --headless           рендеринг без окна (surfaceless-контекст EGL или скрытое окно GLFW)
+// --frames N           число замеряемых кадров (по умолчанию 600)
+// --warmup N           число кадров прогрева (по умолчанию 30)
+// --size WxH           разрешение основного прохода
+// --json FILE          записать отчёт в файл вместо stdout
+// --dump FILE.ppm      сохранить последний кадр
+// --shadow-path P      gs | layer | faces (см. ShadowPath)
+// --shadow-cache       перерисовывать только грязные грани кубической карты (ShadowFaceCache)
+// --static-light       неподвижный источник света
+// --moving-object      один из кубов движется
+// --lights N           количество точечных источников (1..MAX_LIGHTS)
+// --sweep-lights       стресс-тест: прогоны для 1, 2, 4 ... MAX_LIGHTS источников, отчёт — массив JSON
+// --count-gl-calls     счётчики вызовов OpenGL за кадр в отчёте (gl_calls, gl_uniform_calls, ...)
+// --bench-uniforms     микробенчмарк установки униформ (по имени, по дескрипторам, блоками) вместо рендеринга
+// --shadow-storage S   что хранят карты теней: depth32 (по умолчанию), depth16, r16f или r32f (см. ShadowStorage)
+// --shadow-precision   отчёт о точности и цене всех режимов хранения карт теней вместо рендеринга
+// --bench-culling      микробенчмарк отсечения теневых объектов (скалярный тест и SIMD CasterCuller) вместо рендеринга
+// --cull-objects N     количество объектов микробенчмарка отсечения (по умолчанию 100000)
+// --no-visibility      основной проход без отсечения пирамидой камеры и без сортировки (для сравнения)
+// --depth-prepass M    предварительный проход глубины: auto (по умолчанию, по измеренной перерисовке), on или off
+// --prepass-threshold X перерисовка (затенений на видимый пиксель), с которой auto включает проход (по умолчанию 1.5)
+// --overdraw           визуализация перерисовки: яркость пикселя — сколько раз он затенялся (счётчик overdraw в отчёте)
+// --renderer R         forward (по умолчанию) или deferred: G-буфер, маска теней GL_R8 на источник, освещение по маскам
+// --sweep-renderer     прогоны для прямого и отложенного пути, отчёт — массив JSON
+// --half-res-mask      маски теней отложенного пути в половинном разрешении (восстановление с учётом глубины)
+// --light-culling M    кластерное отсечение источников: compute (по умолчанию, OpenGL 4.3, иначе cpu), cpu или none
+// --verify-clusters    сравнить кластерные списки вычислительного шейдера с LightClusters (CPU) вместо рендеринга;
+//                      код выхода 1, если хоть один кластер разошёлся
+// --shader-cache DIR   директория кэша двоичных программ (по умолчанию shader_cache; время создания — shader_setup_ms)
+// --no-shader-cache    компилировать все программы из исходников
+// --no-permutations    основной проход без специализаций: флаги shadows и reverse_normals — униформами
+// --no-state-cache     передавать драйверу все вызовы, включая повторные привязки и униформы (см. GLStateCache)
+// --no-texture-streaming загружать текстуры синхронно до первого кадра (loadTexture)
+// --texture-budget KB  байт загрузки текстур за кадр (по умолчанию 4096 КБ; счётчик texture_upload_bytes)
+// --bench-textures     микробенчмарк загрузки синтетической директории текстур: синхронно и через TextureStreamer
+// --texture-count N    текстур в директории микробенчмарка (по умолчанию 128)
+// --no-cooked-textures не брать сжатые текстуры из resources/cooked (texture_cooker), загружать исходные изображения
+// --texture-cache-budget MB видеопамять общего кэша текстур (по умолчанию 256 МБ; сверх неё удаляются
+//                      текстуры без ссылок, давно не использованные первыми)
+// --ubo-mode M         обновление буфера униформ кадра: persistent (по умолчанию, OpenGL 4.4) или orphan
+// --submit M           отправка сцены: direct (вызов на объект), instanced (по умолчанию) или indirect (OpenGL 4.3)
+// --objects N          добавить в комнату N маленьких кубов (стресс-тест отправки сцены)
+// --model FILE.cmesh   поставить в комнату подготовленную модель (mesh_cooker); в проходе теней её уровень
+//                      детализации выбирается по расстоянию до источника (счётчик shadow_lod_instances)
+// --shadow-filter F    фильтр мягких теней: poisson (по умолчанию), grid (исходные 20 выборок), pcss, vsm или evsm
+// --shadow-samples N   выборок диска Пуассона: 4, 8, 16 (по умолчанию) или 32
+// --shadow-probes N    пробных выборок для раннего выхода (по умолчанию 4, 0 — без раннего выхода)
+// --no-hw-pcf          сравнение глубины в шейдере вместо сэмплера со сравнением
+// --sweep-filter       прогоны для сетки, для 4, 8, 16, 32 выборок диска и PCSS, для VSM и EVSM, отчёт — массив JSON
+// --light-radius R     радиус источников для PCSS (по умолчанию 0.2)
+// --blocker-samples N  выборок поиска блокеров PCSS (по умолчанию 8, не больше 32)
+// --pcss-max-radius R  предел радиуса поиска и полутени PCSS (по умолчанию 0.5)
+// --moment-blur N      радиус размытия карт моментов VSM/EVSM в texel'ах (по умолчанию 2, 0 — без размытия)
+// --vsm-bleed A        подавление просвечивания VSM/EVSM: доля p_max, считающаяся тенью (по умолчанию 0.2)
+// --vsm-min-variance V нижняя граница дисперсии VSM/EVSM (по умолчанию 1e-5)
+bool parseArguments(int argc, char** argv)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--headless")
+            options.headless = true;
+        else if (arg == "--frames" && hasValue)
+            options.frames = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--warmup" && hasValue)
+            options.warmup = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--size" && hasValue)
+        {
+            unsigned int w = 0, h = 0;
+            if (std::sscanf(argv[++i], "%ux%u", &w, &h) != 2 || w == 0 || h == 0)
+            {
+                std::cout << "Invalid --size, expected WxH" << std::endl;
+                return false;
+            }
+            SCR_WIDTH = w;
+            SCR_HEIGHT = h;
+        }
+        else if (arg == "--json" && hasValue)
+            options.jsonPath = argv[++i];
+        else if (arg == "--dump" && hasValue)
+            options.dumpPath = argv[++i];
+        else if (arg == "--shadow-path" && hasValue)
+        {
+            std::string name = argv[++i];
+            int path = 0;
+            while (path < SHADOW_PATH_COUNT && name != shadowPathNames[path])
+                ++path;
+            if (path == SHADOW_PATH_COUNT)
+            {
+                std::cout << "Unknown shadow path: " << name << std::endl;
+                return false;
+            }
+            shadowPath = (ShadowPath)path;
+        }
+        else if (arg == "--shadow-cache")
+            options.shadowCache = true;
+        else if (arg == "--static-light")
+            options.staticLight = true;
+        else if (arg == "--moving-object")
+            options.movingObject = true;
+        else if (arg == "--lights" && hasValue)
+            options.lights = std::min(MAX_LIGHTS, std::max(1, std::atoi(argv[++i])));
+        else if (arg == "--sweep-lights")
+            options.sweepLights = true;
+        else if (arg == "--count-gl-calls")
+            options.countGLCalls = true;
+        else if (arg == "--bench-uniforms")
+            options.benchUniforms = options.headless = true;
+        else if (arg == "--shadow-storage" && hasValue)
+        {
+            std::string name = argv[++i];
+            int storage = 0;
+            while (storage < SHADOW_STORAGE_COUNT && name != shadowStorageNames[storage])
+                ++storage;
+            if (storage == SHADOW_STORAGE_COUNT)
+            {
+                std::cout << "Unknown shadow storage: " << name << std::endl;
+                return false;
+            }
+            options.shadowStorage = (ShadowStorage)storage;
+        }
+        else if (arg == "--shadow-precision")
+            options.shadowPrecision = options.headless = true;
+        else if (arg == "--bench-culling")
+            options.benchCulling = options.headless = true;
+        else if (arg == "--verify-clusters")
+            options.verifyClusters = options.headless = true;
+        else if (arg == "--cull-objects" && hasValue)
+            options.cullObjects = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--no-visibility")
+            options.visibility = false;
+        else if (arg == "--depth-prepass" && hasValue)
+        {
+            std::string name = argv[++i];
+            int mode = 0;
+            while (mode < DEPTH_PREPASS_MODE_COUNT && name != depthPrepassNames[mode])
+                ++mode;
+            if (mode == DEPTH_PREPASS_MODE_COUNT)
+            {
+                std::cout << "Unknown depth prepass mode: " << name << std::endl;
+                return false;
+            }
+            options.depthPrepass = (DepthPrepassMode)mode;
+        }
+        else if (arg == "--prepass-threshold" && hasValue)
+            options.prepassThreshold = std::max(1.0f, (float)std::atof(argv[++i]));
+        else if (arg == "--overdraw")
+            options.overdrawView = true;
+        else if (arg == "--renderer" && hasValue)
+        {
+            std::string name = argv[++i];
+            int path = 0;
+            while (path < RENDER_PATH_COUNT && name != renderPathNames[path])
+                ++path;
+            if (path == RENDER_PATH_COUNT)
+            {
+                std::cout << "Unknown renderer: " << name << std::endl;
+                return false;
+            }
+            options.renderPath = (RenderPath)path;
+        }
+        else if (arg == "--sweep-renderer")
+            options.sweepRenderer = true;
+        else if (arg == "--half-res-mask")
+            options.halfResolutionMask = true;
+        else if (arg == "--light-culling" && hasValue)
+        {
+            std::string name = argv[++i];
+            int mode = 0;
+            while (mode < LIGHT_CULLING_MODE_COUNT && name != lightCullingNames[mode])
+                ++mode;
+            if (mode == LIGHT_CULLING_MODE_COUNT)
+            {
+                std::cout << "Unknown light culling mode: " << name << std::endl;
+                return false;
+            }
+            options.lightCulling = (LightCullingMode)mode;
+        }
+        else if (arg == "--shader-cache" && hasValue)
+            options.shaderCache = argv[++i];
+        else if (arg == "--no-shader-cache")
+            options.shaderCache.clear();
+        else if (arg == "--no-permutations")
+            options.shaderPermutations = false;
+        else if (arg == "--no-state-cache")
+            options.stateCache = false;
+        else if (arg == "--no-texture-streaming")
+            options.textureStreaming = false;
+        else if (arg == "--texture-budget" && hasValue)
+            options.textureBudgetKB = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--bench-textures")
+            options.benchTextures = options.headless = true;
+        else if (arg == "--texture-count" && hasValue)
+            options.textureCount = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--no-cooked-textures")
+            options.cookedTextures = false;
+        else if (arg == "--texture-cache-budget" && hasValue)
+            options.textureCacheMB = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--ubo-mode" && hasValue)
+        {
+            std::string mode = argv[++i];
+            if (mode != "persistent" && mode != "orphan")
+            {
+                std::cout << "Unknown UBO mode: " << mode << std::endl;
+                return false;
+            }
+            options.uboMode = mode == "persistent" ? UniformRing::PERSISTENT : UniformRing::ORPHAN;
+        }
+        else if (arg == "--submit" && hasValue)
+        {
+            std::string name = argv[++i];
+            int mode = 0;
+            while (mode < SUBMIT_MODE_COUNT && name != submitModeNames[mode])
+                ++mode;
+            if (mode == SUBMIT_MODE_COUNT)
+            {
+                std::cout << "Unknown submit mode: " << name << std::endl;
+                return false;
+            }
+            options.submitMode = (SubmitMode)mode;
+        }
+        else if (arg == "--objects" && hasValue)
+            options.extraObjects = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--model" && hasValue)
+            options.modelPath = argv[++i];
+        else if (arg == "--shadow-filter" && hasValue)
+        {
+            std::string name = argv[++i];
+            int mode = 0;
+            while (mode < SHADOW_FILTER_MODE_COUNT && name != shadowFilterNames[mode])
+                ++mode;
+            if (mode == SHADOW_FILTER_MODE_COUNT)
+            {
+                std::cout << "Unknown shadow filter: " << name << std::endl;
+                return false;
+            }
+            options.shadowFilter.mode = (ShadowFilterMode)mode;
+        }
+        else if (arg == "--shadow-samples" && hasValue)
+        {
+            int samples = std::atoi(argv[++i]);
+            if (std::find(std::begin(SHADOW_FILTER_SAMPLE_COUNTS), std::end(SHADOW_FILTER_SAMPLE_COUNTS), samples) ==
+                std::end(SHADOW_FILTER_SAMPLE_COUNTS))
+            {
+                std::cout << "Invalid --shadow-samples, expected 4, 8, 16 or 32" << std::endl;
+                return false;
+            }
+            options.shadowFilter.samples = samples;
+        }
+        else if (arg == "--shadow-probes" && hasValue)
+            options.shadowFilter.probes = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--no-hw-pcf")
+            options.shadowFilter.hardwarePCF = false;
+        else if (arg == "--sweep-filter")
+            options.sweepFilter = true;
+        else if (arg == "--light-radius" && hasValue)
+            options.lightRadius = std::max(0.0f, (float)std::atof(argv[++i]));
+        else if (arg == "--blocker-samples" && hasValue)
+            options.shadowFilter.blockerSamples = std::min(32, std::max(1, std::atoi(argv[++i])));
+        else if (arg == "--pcss-max-radius" && hasValue)
+            options.shadowFilter.maxRadius = std::max(0.0f, (float)std::atof(argv[++i]));
+        else if (arg == "--moment-blur" && hasValue)
+            options.shadowFilter.blurRadius = std::min(8, std::max(0, std::atoi(argv[++i])));
+        else if (arg == "--vsm-bleed" && hasValue)
+            options.shadowFilter.bleedReduction = std::min(0.99f, std::max(0.0f, (float)std::atof(argv[++i])));
+        else if (arg == "--vsm-min-variance" && hasValue)
+            options.shadowFilter.minVariance = std::max(0.0f, (float)std::atof(argv[++i]));
+        else
+        {
+            std::cout << "Unknown argument: " << arg << std::endl;
+            std::cout << "Usage: point_shadows_soft [--headless] [--frames N] [--warmup N] [--size WxH] [--json FILE] [--dump FILE.ppm]"
+                         " [--shadow-path gs|layer|faces] [--shadow-cache] [--static-light] [--moving-object]"
+                         " [--lights N] [--sweep-lights] [--count-gl-calls] [--bench-uniforms]"
+                         " [--shadow-storage depth16|depth32|r16f|r32f] [--shadow-precision]"
+                         " [--bench-culling] [--cull-objects N] [--no-visibility]"
+                         " [--depth-prepass auto|on|off] [--prepass-threshold X] [--overdraw]"
+                         " [--renderer forward|deferred] [--sweep-renderer] [--half-res-mask] [--light-culling compute|cpu|none]"
+                         " [--verify-clusters]"
+                         " [--shader-cache DIR] [--no-shader-cache] [--no-permutations] [--no-state-cache]"
+                         " [--no-texture-streaming] [--texture-budget KB] [--bench-textures] [--texture-count N]"
+                         " [--no-cooked-textures] [--texture-cache-budget MB]"
+                         " [--ubo-mode persistent|orphan] [--submit direct|instanced|indirect] [--objects N] [--model FILE.cmesh]"
+                         " [--shadow-filter grid|poisson|pcss|vsm|evsm] [--shadow-samples 4|8|16|32] [--shadow-probes N] [--no-hw-pcf]"
+                         " [--sweep-filter] [--light-radius R] [--blocker-samples N] [--pcss-max-radius R]"
+                         " [--moment-blur N] [--vsm-bleed A] [--vsm-min-variance V]" << std::endl;
+            return false;
+        }
+    }
+    // сэмплер со сравнением работает только с текстурами глубины
+    if (storesDistance(options.shadowStorage))
+        options.shadowFilter.hardwarePCF = false;
+    return true;
+}
+
+// сэмплеры атласа теней программы (программа уже активна): блоки 1..SHADOW_TIERS — ярусы атласа,
+// следующие SHADOW_TIERS блоков — те же ярусы с сэмплером сравнения глубины, за ними — карты моментов ярусов
+// -------------------------------------------------------------------------------------------------------
+void setShadowSamplers(Shader &program)
+{
+    for (int t = 0; t < SHADOW_TIERS; ++t)
+    {
+        program.setInt("shadowTiers[" + std::to_string(t) + "]", 1 + t);
+        program.setInt("shadowTiersCompare[" + std::to_string(t) + "]", 1 + SHADOW_TIERS + t);
+        program.setInt("momentTiers[" + std::to_string(t) + "]", 1 + 2 * SHADOW_TIERS + t);
+    }
+    program.setInt("shadowStorage", storesDistance(options.shadowStorage) ? 1 : 0);
+}
+
+// заполняет список объектов сцены: комната, пять кубов внутри неё и меши модели --model
+// ----------------------------------------------------------------------------------
+void buildScene()
+{
+    // границы единичного куба из cubeMesh() в локальных координатах
+    AABB unitCube;
+    unitCube.min = glm::vec3(-1.0f);
+    unitCube.max = glm::vec3(1.0f);
+
+    auto addCube = [&unitCube](const glm::vec3& position, float scale, bool insideOut) {
+        SceneObject object;
+        object.model = glm::mat4(1.0f);
+        object.model = glm::translate(object.model, position);
+        object.model = glm::scale(object.model, glm::vec3(scale));
+        object.bounds = unitCube.transformed(object.model);
+        object.insideOut = insideOut;
+        scene.push_back(object);
+    };
+
     // room cube
-    // -------
-    // присвоим единичную матрицу модели, чтобы рендерить куб в начале координат
-    glm::mat4 model = glm::mat4(1.0f);
-    model = glm::scale(model, glm::vec3(5.0f));
-    shader.setMat4("model", model);
+    addCube(glm::vec3(0.0f), 5.0f, true);
+    // cubes
+    addCube(glm::vec3(4.0f, -3.5f, 0.0f), 0.5f, false);
+    addCube(glm::vec3(2.0f, 3.0f, 1.0f), 0.75f, false);
+    addCube(glm::vec3(-3.0f, -1.0f, 0.0f), 0.5f, false);
+    addCube(glm::vec3(-1.5f, 1.0f, 1.5f), 0.5f, false);
+    addCube(glm::vec3(-1.5f, 2.0f, -3.0f), 0.75f, false);
+
+    // стресс-тест: решётка маленьких кубов, равномерно заполняющая комнату
+    if (options.extraObjects > 0)
+    {
+        int side = (int)std::ceil(std::cbrt((double)options.extraObjects));
+        float spacing = 8.0f / side;
+        for (int i = 0; i < options.extraObjects; ++i)
+        {
+            glm::vec3 cell((float)(i % side), (float)((i / side) % side), (float)(i / (side * side)));
+            addCube(glm::vec3(-4.0f) + (cell + 0.5f) * spacing, spacing * 0.2f, false);
+        }
+    }
+
+    // подготовленная модель: объект на каждый её меш, модель целиком вписана в куб 2x2x2 перед начальным положением камеры
+    if (!options.modelPath.empty())
+    {
+        if (sceneModel.open(options.modelPath) && sceneModel.meshCount() > 0)
+        {
+            const AABB &bounds = sceneModel.bounds();
+            const glm::vec3 halfExtent = (bounds.max - bounds.min) * 0.5f;
+            const float extent = std::max(halfExtent.x, std::max(halfExtent.y, halfExtent.z));
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -2.0f, -2.0f));
+            model = glm::scale(model, glm::vec3(extent > 0.0f ? 1.0f / extent : 1.0f));
+            model = glm::translate(model, -bounds.center());
+            for (int m = 0; m < sceneModel.meshCount(); ++m)
+            {
+                SceneObject object;
+                object.model = model;
+                object.bounds = sceneModel.mesh(m).bounds.transformed(model);
+                object.insideOut = false;
+                object.mesh = 1 + m;
+                scene.push_back(object);
+            }
+        }
+        else
+            std::cout << "Cannot load cooked model " << options.modelPath << std::endl;
+    }
+
+    casterCuller.resize(scene.size());
+    std::vector<AABB> bounds(scene.size());
+    for (size_t i = 0; i < scene.size(); ++i)
+    {
+        casterCuller.setBounds(i, scene[i].bounds);
+        bounds[i] = scene[i].bounds;
+    }
+    sceneBVH.build(bounds);
+}
+
+// двигает один из кубов вверх-вниз (--moving-object), чтобы в сцене были не только статичные объекты
+// -----------------------------------------------------------------------------------------------
+void animateScene(float time)
+{
+    SceneObject &object = scene[1];
+    object.model = glm::mat4(1.0f);
+    object.model = glm::translate(object.model, glm::vec3(4.0f, -3.5f + static_cast<float>(sin(time)) * 0.5f, 0.0f));
+    object.model = glm::scale(object.model, glm::vec3(0.5f));
+    AABB unitCube;
+    unitCube.min = glm::vec3(-1.0f);
+    unitCube.max = glm::vec3(1.0f);
+    object.bounds = unitCube.transformed(object.model);
+    casterCuller.setBounds(1, object.bounds);
+    sceneBVH.update(1, object.bounds);
+    sceneBVH.refit();
+}
+
+// уровень детализации объекта в проходе теней: самый грубый, у которого сторона куба кластеризации (см.
+// CookedMesh::lodCellFraction) в ближайшей к источнику точке объекта не больше LOD_SHADOW_TEXELS texel'ей.
+// Грань кубической карты видна под 90°, поэтому texel на расстоянии d покрывает 2d / resolution
+// ------------------------------------------------------------------------------------------------------
+int shadowLod(const SceneObject &object, const ShadowLodView &view)
+{
+    const std::vector<MeshRange> &lods = sceneMesh(object.mesh).lods;
+    const float distance = glm::length(glm::clamp(view.position, object.bounds.min, object.bounds.max) - view.position);
+    const float diagonal = glm::length(object.bounds.max - object.bounds.min);
+    const float texel = 2.0f * distance / (float)view.resolution;
+    int lod = 0;
+    while (lod + 1 < (int)lods.size() && CookedMesh::lodCellFraction(lod + 1) * diagonal <= LOD_SHADOW_TEXELS * texel)
+        ++lod;
+    return lod;
+}
+
+// собрать партии сцены для одного прохода: экземпляр на объект или, при perFace, на каждую пару (объект, грань)
+// с гранью в params.x. faceMasks (если задан) — грани, в которые попадает каждый объект; объекты, не попавшие
+// в faceFilter, пропускаются. Объекты, рисуемые изнутри, и обычные объекты — две партии с разным состоянием.
+// lodView (проход теней) — уровень детализации каждого объекта по расстоянию до источника, иначе полный меш.
+// ----------------------------------------------------------------------------------------------------------
+SceneBatches queueScene(SceneSubmitter &submitter, const std::vector<unsigned int> *faceMasks, unsigned int faceFilter, bool perFace,
+                        const ShadowLodView *lodView)
+{
+    SceneBatches batches;
+    for (int insideOut = 1; insideOut >= 0; --insideOut)
+    {
+        submitter.beginBatch();
+        for (size_t i = 0; i < scene.size(); ++i)
+        {
+            const SceneObject &object = scene[i];
+            if (object.insideOut != (insideOut == 1))
+                continue;
+            unsigned int mask = (faceMasks != nullptr ? (*faceMasks)[i] : CUBE_FACE_ALL) & faceFilter;
+            if (mask == 0)
+                continue;
+            const int lod = lodView != nullptr ? shadowLod(object, *lodView) : 0;
+            const SceneMesh &mesh = sceneMesh(object.mesh);
+            const MeshRange range = mesh.lods[lod];
+            InstanceData instance;
+            instance.model = object.model;
+            instance.params = glm::ivec4(0);
+            if (!perFace)
+            {
+                submitter.add(range, instance, mesh.geometry);
+                batches.lodInstances += lod > 0 ? 1 : 0;
+                continue;
+            }
+            for (int face = 0; face < 6; ++face)
+            {
+                if ((mask & (1u << face)) == 0)
+                    continue;
+                instance.params.x = face;
+                submitter.add(range, instance, mesh.geometry);
+                batches.lodInstances += lod > 0 ? 1 : 0;
+            }
+        }
+        (insideOut == 1 ? batches.insideOut : batches.regular) = submitter.endBatch();
+    }
+    return batches;
+}
+
+// нарисовать одну партию; объекты, рисуемые изнутри, — без отсечения граней и с инвертированными нормалями
+// -----------------------------------------------------------------------------------------------------
+void drawBatch(const PassProgram &pass, SceneSubmitter &submitter, const DrawBatch &batch, bool insideOut)
+{
+    if (batch.empty())
+        return;
+    if (!insideOut)
+    {
+        submitter.draw(batch, options.submitMode, pass.stream);
+        return;
+    }
     glDisable(GL_CULL_FACE); // обратите внимание, что мы отключаем отсечение здесь, так как рендерим «внутри» куба,
     // а не снаружи, что сбивает нормальные методы отсечения.
-    shader.setInt("reverse_normals", 1); // Небольшой хак для инвертирования нормалей при рендере куба изнутри, чтобы освещение всё равно работало.
-    renderCube();
-    shader.setInt("reverse_normals", 0); // и, конечно, отключим это
+    if (pass.insideOut != nullptr)
+    {
+        // специализация с инвертированными нормалями, затем обратно программа прохода
+        pass.insideOut->shader->use();
+        submitter.draw(batch, options.submitMode, pass.stream);
+        pass.shader->use();
+    }
+    else
+    {
+        pass.shader->set(pass.reverseNormals, 1); // Небольшой хак для инвертирования нормалей при рендере куба изнутри, чтобы освещение всё равно работало.
+        submitter.draw(batch, options.submitMode, pass.stream);
+        pass.shader->set(pass.reverseNormals, 0); // и, конечно, отключим это
+    }
     glEnable(GL_CULL_FACE);
-    // cubes
-    // -----
-    // снова зададим единичную матрицу модели, чтобы сбросить все предыдущие преобразования над матрицей модели (все
-    // параметры местоположения и поворота возвращаются к значениям по умолчанию), поскольку все преобразования
-    // модели применяются к текущей матрице модели.
-    model = glm::mat4(1.0f);
-    model = glm::translate(model, glm::vec3(4.0f, -3.5f, 0.0));
-    model = glm::scale(model, glm::vec3(0.5f));
-
-    shader.setMat4("model", model);
-    renderCube();
-    model = glm::mat4(1.0f);
-    model = glm::translate(model, glm::vec3(2.0f, 3.0f, 1.0));
-    model = glm::scale(model, glm::vec3(0.75f));
-
-    shader.setMat4("model", model);
-    renderCube();
-    model = glm::mat4(1.0f);
-    model = glm::translate(model, glm::vec3(-3.0f, -1.0f, 0.0));
-    model = glm::scale(model, glm::vec3(0.5f));
-
-    shader.setMat4("model", model);
-    renderCube();
-    model = glm::mat4(1.0f);
-    model = glm::translate(model, glm::vec3(-1.5f, 1.0f, 1.5));
-    model = glm::scale(model, glm::vec3(0.5f));
-
-    shader.setMat4("model", model);
-    renderCube();
-    model = glm::mat4(1.0f);
-    model = glm::translate(model, glm::vec3(-1.5f, 2.0f, -3.0));
-    model = glm::scale(model, glm::vec3(0.75f));
-
-    shader.setMat4("model", model);
-    renderCube();
 }
 
-// renderCube() рендерит 1x1 3D-куб в нормализованных координатах устройства (NDC).
-// -------------------------------------------------
-unsigned int cubeVAO = 0;
-unsigned int cubeVBO = 0;
-void renderCube()
+// нарисовать партии сцены программой прохода (программа уже активна)
+// -------------------------------------------------------------------
+void drawScene(const PassProgram &pass, SceneSubmitter &submitter, const SceneBatches &batches)
+{
+    drawBatch(pass, submitter, batches.insideOut, true);
+    drawBatch(pass, submitter, batches.regular, false);
+}
+
+// собрать партии основного прохода: объекты, пересекающие пирамиду камеры (BVH), сортируются по ключу DrawKey —
+// программа, материал (здесь единственное различие — рисуется ли объект изнутри), VAO, затем расстояние
+// до камеры. Обычные объекты идут спереди назад, комната — последней, и её фрагменты за кубами отбрасывает
+// ранний тест глубины. Новая партия начинается там, где меняются биты состояния ключа.
+// С --no-visibility — все объекты в порядке сцены.
+// -------------------------------------------------------------------------------------------------------
+std::vector<StateBatch> queueVisibleScene(SceneSubmitter &submitter, const PassProgram &pass, const GpuCamera &camera,
+                                          VisibilityStats &stats)
+{
+    std::vector<unsigned int> visible;
+    std::vector<std::pair<DrawKey, unsigned int>> draws;
+    std::vector<DrawKey> keys;
+    if (options.visibility)
+        stats.nodesTested = sceneBVH.cull(Frustum::fromMatrix(camera.projection * camera.view), visible);
+    else
+    {
+        visible.resize(scene.size());
+        for (size_t i = 0; i < scene.size(); ++i)
+            visible[i] = (unsigned int)i;
+    }
+    // порядок сцены (по индексам объектов) — для оценки сэкономленных переключений
+    std::sort(visible.begin(), visible.end());
+
+    const glm::vec3 eye(camera.viewPos);
+    draws.clear();
+    keys.clear();
+    for (unsigned int index : visible)
+    {
+        const SceneObject &object = scene[index];
+        DrawKey key = makeDrawKey(pass.shader->ID, object.insideOut ? 1 : 0, sceneMesh(object.mesh).buffers.surfaceVAO,
+                                  glm::length(object.bounds.center() - eye));
+        draws.push_back(std::make_pair(key, index));
+        keys.push_back(key);
+    }
+    int sceneOrderChanges = countStateChanges(keys);
+    if (options.visibility)
+    {
+        std::sort(draws.begin(), draws.end());
+        for (size_t i = 0; i < draws.size(); ++i)
+            keys[i] = draws[i].first;
+    }
+    stats.visible = (int)draws.size();
+    stats.culled = (int)(scene.size() - draws.size());
+    stats.stateChanges = countStateChanges(keys);
+    stats.stateChangesSaved = sceneOrderChanges - stats.stateChanges;
+
+    std::vector<StateBatch> batches;
+    for (size_t i = 0; i < draws.size(); ++i)
+    {
+        if (i == 0 || ((draws[i].first ^ draws[i - 1].first) & DRAW_KEY_STATE_MASK) != 0)
+        {
+            if (i > 0)
+                batches.back().batch = submitter.endBatch();
+            submitter.beginBatch();
+            batches.push_back(StateBatch());
+            batches.back().insideOut = drawKeyMaterial(draws[i].first) == 1;
+        }
+        const SceneObject &object = scene[draws[i].second];
+        InstanceData instance;
+        instance.model = object.model;
+        instance.params = glm::ivec4(0);
+        const SceneMesh &mesh = sceneMesh(object.mesh);
+        submitter.add(mesh.lods[0], instance, mesh.geometry);
+    }
+    if (!batches.empty())
+        batches.back().batch = submitter.endBatch();
+    return batches;
+}
+
+// нарисовать отсортированные партии основного прохода (программа уже активна)
+// ---------------------------------------------------------------------------
+void drawStateBatches(const PassProgram &pass, SceneSubmitter &submitter, const std::vector<StateBatch> &batches)
+{
+    for (const StateBatch &state : batches)
+        drawBatch(pass, submitter, state.batch, state.insideOut);
+}
+
+// cubeMesh() создаёт (при первом вызове) геометрию сцены — куб 1x1 в нормализованных координатах устройства (NDC)
+// и буферы мешей подготовленной модели — и возвращает диапазон индексов куба; рисуется всё через SceneSubmitter.
+// Потоки модели уходят в glBufferData прямо из отображённого файла (как в Model), без разбора и копирования
+// -----------------------------------------------------------------------------------------------------
+GeometryBuffers sceneGeometry;
+MeshRange cubeRange;
+std::vector<SceneMesh> sceneMeshes;
+MeshRange cubeMesh()
 {
     // инициализировать (если необходимо)
-    if (cubeVAO == 0)
+    if (sceneGeometry.depthVAO == 0)
     {
         float vertices[] = {
             // back face
@@ -363,53 +1569,48 @@ void renderCube()
             -1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f, // top-left
             -1.0f,  1.0f,  1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 0.0f  // bottom-left        
         };
-        glGenVertexArrays(1, &cubeVAO);
-        glGenBuffers(1, &cubeVBO);
-        // заполним буфер
-        // --------------
-        // привяжем объект буфера вершин (Vertex Buffer Object) к текущему контексту OpenGL
-        glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
-        // заполним буфер вершин данными, находящимися в массиве vertices
-        // glBufferData — заполняет буфер данными
-        // GL_ARRAY_BUFFER — указывает, что мы хотим заполнить буфер вершин
-        // sizeof(vertices) — указывает размер нашего массива вершин
-        // vertices — указатель на наш массив вершин
-        // GL_STATIC_DRAW — указывает, что мы хотим использовать наш буфер вершин только для чтения
-        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-        // привяжем атрибуты вершин
-        // ------------------------
-        // привяжем объект вершинного массива (Vertex Array Object) к текущему контексту OpenGL
-        glBindVertexArray(cubeVAO);
-        // включаем общий массив атрибутов вершин, указанный индексом (index = 0)
-        glEnableVertexAttribArray(0);
-        // указываем, какие данные соответствуют каждому атрибуту вершины
-        // атрибут 0: координаты вершин
-        // 3 значения (x, y, z), тип данных - float (GL_FLOAT), нормализация - false (GL_FALSE), шаг - 8 байт (sizeof(float) *
-        // 8), смещение - 0 байт
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(1);
-        // атрибут 1: нормали вершин
-        // 3 значения (x, y, z), тип данных - float (GL_FLOAT), нормализация - false (GL_FALSE), шаг - 8 байт (sizeof(float) *
-        // 8), смещение - 3 байта
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-        glEnableVertexAttribArray(2);
-        // атрибут 2: текстурные координаты вершин
-        // 2 значения (s, t), тип данных - float (GL_FLOAT), нормализация - false (GL_FALSE), шаг - 8 байт (sizeof(float) * 8),
-        // смещение - 6 байт
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-        // отключаем объект вершинного массива (0 - зарезервированный индекс, означающий обнуление буфера), который
-        // подключался ранее (cubeVBO)
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        // отключаем объект вершинного массива (cubeVAO)
-        glBindVertexArray(0);
-    }
-    // рендеринг куба
-    glBindVertexArray(cubeVAO);
-    // функция glDrawArrays рисует массив вершин в режиме треугольников (GL_TRIANGLES), начиная с индекса 0 и с
-    // числом вершин 36
-    glDrawArrays(GL_TRIANGLES, 0, 36);
-    // отключаем объект вершинного массива, после рендеринга
-    glBindVertexArray(0);
+        // 36 вершин треугольников сворачиваются в 24 уникальные вершины (позиция, нормаль, UV) с 16-битными
+        // индексами, а для проходов теней — в 8 углов куба: 12 байт позиции на вершину
+        IndexedGeometry<PackedSurface> geometry;
+        geometry.beginMesh();
+        for (int i = 0; i < 36; ++i)
+        {
+            const float* v = vertices + i * 8;
+            PackedSurface surface;
+            surface.normal = packNormal(glm::vec3(v[3], v[4], v[5]));
+            surface.texCoords = packTexCoords(glm::vec2(v[6], v[7]));
+            geometry.addVertex(glm::vec3(v[0], v[1], v[2]), surface);
+        }
+        cubeRange = geometry.endMesh();
+        sceneGeometry.create(geometry, VertexFormat::surface());
+        SceneMesh cube;
+        cube.buffers = sceneGeometry;
+        cube.lods.assign(1, cubeRange);
+        sceneMeshes.assign(1, cube);
+        // меши модели: свои буферы (формат PackedTangentSurface, тангенты не читаются), уровни — диапазоны в них
+        for (int m = 0; m < sceneModel.meshCount(); ++m)
+        {
+            const CookedMesh::MeshView &view = sceneModel.mesh(m);
+            SceneMesh mesh;
+            mesh.buffers.create(view.streams, VertexFormat::tangentSurfaceWithoutBasis());
+            mesh.geometry = 1 + m;
+            mesh.lods = view.lods;
+            sceneMeshes.push_back(mesh);
+        }
+    }
+    return cubeRange;
+}
+
+const SceneMesh &sceneMesh(int mesh)
+{
+    cubeMesh();
+    return sceneMeshes[mesh];
+}
+
+int sceneMeshCount()
+{
+    cubeMesh();
+    return (int)sceneMeshes.size();
 }
 
 // обработать весь ввод: запросить у GLFW, были ли соответствующие клавиши нажаты/отпущены в этом кадре, и
@@ -453,6 +1654,32 @@ void processInput(GLFWwindow *window)
     {
         shadowsKeyPressed = false;
     }
+
+    // переключаем способ построения карты теней при нажатии P (слоистый путь — только если поддерживается)
+    if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS && !shadowPathKeyPressed)
+    {
+        shadowPath = (ShadowPath)((shadowPath + 1) % SHADOW_PATH_COUNT);
+        if (shadowPath == SHADOW_PATH_LAYERED && !layeredSupported)
+            shadowPath = (ShadowPath)((shadowPath + 1) % SHADOW_PATH_COUNT);
+        shadowPathKeyPressed = true;
+        std::cout << "Shadow path: " << shadowPathNames[shadowPath] << std::endl;
+    }
+    if (glfwGetKey(window, GLFW_KEY_P) == GLFW_RELEASE)
+    {
+        shadowPathKeyPressed = false;
+    }
+
+    // переключаем режим предварительного прохода глубины при нажатии Z
+    if (glfwGetKey(window, GLFW_KEY_Z) == GLFW_PRESS && !prepassKeyPressed)
+    {
+        options.depthPrepass = (DepthPrepassMode)((options.depthPrepass + 1) % DEPTH_PREPASS_MODE_COUNT);
+        prepassKeyPressed = true;
+        std::cout << "Depth prepass: " << depthPrepassNames[options.depthPrepass] << std::endl;
+    }
+    if (glfwGetKey(window, GLFW_KEY_Z) == GLFW_RELEASE)
+    {
+        prepassKeyPressed = false;
+    }
 }
 
 // glfw: whenever the window size changed (by OS or user resize) this callback function executes
@@ -569,3 +1796,58 @@ unsigned int loadTexture(char const * path)
 
     return textureID;
 }
+
+// форматы S3TC (GL_EXT_texture_compression_s3tc) не входят в ядро, и GLAD их не объявляет
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+// загрузка сжатой текстуры из контейнера texture_cooker (.ctex): файл отображается в память, и все уровни
+// передаются glCompressedTexImage2D как есть — без декодирования и без glGenerateMipmap.
+// 0 — файла нет, он повреждён или драйвер не поддерживает его формат (тогда загружается исходное изображение)
+// ------------------------------------------------------------------------------------------------------------
+unsigned int loadCookedTexture(const std::string &path)
+{
+    CookedTexture cooked;
+    if (!cooked.open(path))
+        return 0;
+    const GLCaps& caps = GLCaps::get();
+    const bool s3tc = caps.has("GL_EXT_texture_compression_s3tc");
+    GLenum internalFormat = 0;
+    switch (cooked.format())
+    {
+    case BLOCK_BC1: internalFormat = s3tc ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : 0; break;
+    case BLOCK_BC3: internalFormat = s3tc ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : 0; break;
+    case BLOCK_BC4: internalFormat = GL_COMPRESSED_RED_RGTC1; break;
+    case BLOCK_BC5: internalFormat = GL_COMPRESSED_RG_RGTC2; break;
+    default:
+        if (caps.atLeast(4, 2) || caps.has("GL_ARB_texture_compression_bptc"))
+            internalFormat = GL_COMPRESSED_RGBA_BPTC_UNORM;
+        break;
+    }
+    if (internalFormat == 0)
+    {
+        std::cout << "Compressed format " << blockFormatNames[cooked.format()] << " is not supported, skipping " << path << std::endl;
+        return 0;
+    }
+
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    for (int i = 0; i < cooked.levelCount(); ++i)
+    {
+        const CookedTexture::Level& level = cooked.level(i);
+        glCompressedTexImage2D(GL_TEXTURE_2D, i, internalFormat, level.width, level.height, 0, (GLsizei)level.bytes, level.data);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, cooked.levelCount() - 1);
+    // как в loadTexture: изображения с альфой не повторяются
+    const bool alpha = (cooked.flags() & CookedTexture::FLAG_ALPHA) != 0;
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, alpha ? GL_CLAMP_TO_EDGE : GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, alpha ? GL_CLAMP_TO_EDGE : GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    return textureID;
+}
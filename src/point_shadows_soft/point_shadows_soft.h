@@ -0,0 +1,315 @@
+#ifndef POINT_SHADOWS_SOFT_H
+#define POINT_SHADOWS_SOFT_H
+
+// Общие объявления демо: блоки униформ, программы проходов, сцена, параметры запуска и глобальное состояние.
+// Цикл рендеринга и сцена — в point_shadows_soft.cpp, микробенчмарки и проверки вместо рендеринга — в
+// benchmark_modes.cpp
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <stb_image.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <opengllibs/filesystem.h>
+#include <opengllibs/shader.h>
+#include <opengllibs/camera.h>
+#include <opengllibs/model.h>
+#include <opengllibs/mesh_container.h>
+#include <opengllibs/headless.h>
+#include <opengllibs/benchmark.h>
+#include <opengllibs/glcaps.h>
+#include <opengllibs/glcalls.h>
+#include <opengllibs/gl_state.h>
+#include <opengllibs/program_cache.h>
+#include <opengllibs/bounds.h>
+#include <opengllibs/bvh.h>
+#include <opengllibs/caster_cull.h>
+#include <opengllibs/draw_sort.h>
+#include <opengllibs/shadow_cache.h>
+#include <opengllibs/shadow_atlas.h>
+#include <opengllibs/uniform_ring.h>
+#include <opengllibs/scene_submit.h>
+#include <opengllibs/shader_permutations.h>
+#include <opengllibs/texture_cache.h>
+#include <opengllibs/texture_container.h>
+#include <opengllibs/texture_streamer.h>
+#include <opengllibs/vertex_format.h>
+
+#include "clustered_lights.h"
+#include "deferred.h"
+#include "depth_prepass.h"
+#include "point_lights.h"
+#include "shadow_filter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <thread>
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void processInput(GLFWwindow *window);
+unsigned int loadTexture(const char *path);
+unsigned int loadCookedTexture(const std::string &path);
+bool parseArguments(int argc, char** argv);
+
+// блок униформ Camera (раскладка std140 совпадает с point_shadows.vs/.fs)
+// ----------------------------------------------------------------------
+const unsigned int CAMERA_UBO_BINDING = 1;
+struct GpuCamera
+{
+    glm::mat4 projection;
+    glm::mat4 view;
+    glm::vec4 viewPos; // xyz — позиция камеры
+    glm::mat4 inverseViewProjection; // мировая позиция по глубине экрана (проходы отложенного пути)
+};
+
+// программа прохода и дескрипторы её униформ, полученные один раз после линковки:
+// в цикле рендеринга униформы задаются без поиска по имени. Униформ, которых в программе нет,
+// дескрипторы невалидны, и Shader::set() их пропускает.
+// ---------------------------------------------------------------------------------------------
+// Данные кадра (камера, источники, матрицы теней) приходят из блоков униформ, матрицы моделей — из
+// атрибутов экземпляров (SceneSubmitter), здесь — только то, что задаётся переключателями.
+// ---------------------------------------------------------------------------------------------
+struct PassProgram
+{
+    Shader* shader = nullptr;
+    GeometryBuffers::Stream stream = GeometryBuffers::SURFACE; // поток вершин, который читает программа
+    Shader::Uniform<int> reverseNormals, face, shadows;
+    // специализация для объектов, рисуемых изнутри (REVERSE_NORMALS 1); без неё — униформа reverse_normals
+    const PassProgram* insideOut = nullptr;
+
+    PassProgram() {}
+    PassProgram(Shader* program, GeometryBuffers::Stream geometryStream) : shader(program), stream(geometryStream)
+    {
+        if (shader == nullptr)
+            return;
+        reverseNormals = shader->uniform<int>("reverse_normals");
+        face = shader->uniform<int>("face");
+        shadows = shader->uniform<int>("shadows");
+        // блоки униформ кадра; блоки, которых в программе нет, пропускаются
+        shader->bindUniformBlock("Lights", LIGHTS_UBO_BINDING);
+        shader->bindUniformBlock("Camera", CAMERA_UBO_BINDING);
+        shader->bindUniformBlock("ShadowPass", SHADOW_PASS_UBO_BINDING);
+    }
+};
+
+// специализации основного прохода (point_shadows.vs/.fs): SHADOWS x REVERSE_NORMALS
+const int LIT_VARIANT_COUNT = 4;
+inline int litVariant(bool shadows, bool reverseNormals)
+{
+    return (shadows ? 2 : 0) + (reverseNormals ? 1 : 0);
+}
+
+void buildScene();
+void animateScene(float time);
+MeshRange cubeMesh();
+extern GeometryBuffers sceneGeometry;
+
+// меш сцены: его буферы (индекс в SceneSubmitter) и диапазоны уровней детализации в них (уровень 0 — полный
+// меш; у куба он единственный)
+struct SceneMesh
+{
+    GeometryBuffers buffers;
+    int geometry = 0;
+    std::vector<MeshRange> lods;
+};
+const SceneMesh &sceneMesh(int mesh);
+int sceneMeshCount();
+
+// партии сцены для одного прохода: объекты, рисуемые изнутри (комната), и обычные объекты
+struct SceneBatches
+{
+    DrawBatch insideOut;
+    DrawBatch regular;
+    int lodInstances = 0; // экземпляров, нарисованных упрощённым уровнем детализации
+};
+// выбор уровня детализации в проходе теней: позиция источника и разрешение грани его кубической карты
+struct ShadowLodView
+{
+    glm::vec3 position;
+    int resolution;
+};
+// допустимое отклонение упрощённого уровня в проходе теней, texel'ей грани кубической карты
+const float LOD_SHADOW_TEXELS = 2.0f;
+SceneBatches queueScene(SceneSubmitter &submitter, const std::vector<unsigned int> *faceMasks, unsigned int faceFilter, bool perFace,
+                        const ShadowLodView *lodView = nullptr);
+void drawScene(const PassProgram &pass, SceneSubmitter &submitter, const SceneBatches &batches);
+
+// партия основного прохода после сортировки по ключу (DrawKey) и состояние, в котором она рисуется
+struct StateBatch
+{
+    DrawBatch batch;
+    bool insideOut;
+};
+// статистика отсечения и сортировки основного прохода за кадр
+struct VisibilityStats
+{
+    int visible = 0;
+    int culled = 0;
+    int nodesTested = 0;
+    int stateChanges = 0;      // переключений состояния в отсортированном порядке
+    int stateChangesSaved = 0; // на сколько меньше, чем в порядке сцены
+};
+std::vector<StateBatch> queueVisibleScene(SceneSubmitter &submitter, const PassProgram &pass, const GpuCamera &camera,
+                                          VisibilityStats &stats);
+void drawStateBatches(const PassProgram &pass, SceneSubmitter &submitter, const std::vector<StateBatch> &batches);
+
+// программы прохода теней для трёх способов построения кубической карты (см. ShadowPath)
+struct DepthPrograms
+{
+    PassProgram geometry;
+    PassProgram face;
+    PassProgram layered; // без программы, если слой из вершинного шейдера не поддерживается
+};
+// партии прохода теней одного источника: вся сцена (GS и слоистый путь) или по партии на грань
+struct LightShadowBatches
+{
+    SceneBatches scene;
+    SceneBatches faces[6];
+
+    int lodInstances() const
+    {
+        int count = scene.lodInstances;
+        for (const SceneBatches &face : faces)
+            count += face.lodInstances;
+        return count;
+    }
+};
+unsigned int prepareLightShadow(PointLight &light, GpuShadowPass &block);
+LightShadowBatches queueLightShadow(const PointLight &light, unsigned int renderFaces, int resolution, SceneSubmitter &submitter);
+int renderLightShadow(PointLight &light, unsigned int renderFaces, const LightShadowBatches &batches,
+                      const ShadowAtlas &atlas, const DepthPrograms &programs, SceneSubmitter &submitter);
+void filterLightMoments(const PointLight &light, const ShadowAtlas &atlas, MomentPass &pass);
+void runUniformBenchmark(const PassProgram &lit, const PassProgram &depth, UniformRing &ring, SceneSubmitter &submitter);
+void runPrecisionReport(ShadowAtlas &atlas, const DepthPrograms &programs, UniformRing &ring, SceneSubmitter &submitter);
+void runCullingBenchmark();
+bool runClusterVerification(ClusteredLighting &clusters, UniformRing &ring);
+void runTextureBenchmark();
+void setShadowSamplers(Shader &program);
+
+// settings
+extern unsigned int SCR_WIDTH;
+extern unsigned int SCR_HEIGHT;
+// ближняя и дальняя плоскости камеры (по ним же строятся срезы кластеров)
+const float CAMERA_NEAR = 0.1f;
+const float CAMERA_FAR = 100.0f;
+extern bool shadows;
+extern bool shadowsKeyPressed;
+
+// способ построения кубической карты теней (--shadow-path, клавиша P переключает по кругу)
+// GEOMETRY - геометрический шейдер размножает каждый треугольник во все перерисовываемые грани;
+// LAYERED  - инстансинг, грань = экземпляр, слой задаётся из вершинного шейдера, только попавшие грани;
+// FACES    - по проходу на грань, в грань рисуются только попавшие в неё объекты.
+// Во всех способах объекты вне сферы far_plane и вне перерисовываемых граней отбрасываются на CPU (CasterCuller).
+enum ShadowPath
+{
+    SHADOW_PATH_GEOMETRY,
+    SHADOW_PATH_LAYERED,
+    SHADOW_PATH_FACES,
+    SHADOW_PATH_COUNT
+};
+extern const char* shadowPathNames[SHADOW_PATH_COUNT];
+extern ShadowPath shadowPath;
+extern bool layeredSupported; // есть ли gl_Layer в вершинном шейдере
+extern bool shadowPathKeyPressed;
+extern bool prepassKeyPressed;
+
+// объект сцены: меш с матрицей модели и границами в мировых координатах
+// ---------------------------------------------------------------------
+struct SceneObject
+{
+    glm::mat4 model;
+    AABB bounds;
+    bool insideOut; // рисуется изнутри (комната): без отсечения граней и с инвертированными нормалями
+    int mesh = 0;   // индекс в sceneMeshes: 0 — куб, дальше — меши подготовленной модели (--model)
+};
+extern std::vector<SceneObject> scene;
+// подготовленная модель (--model), отображённая в память; буферы её мешей создаются прямо из файла (cubeMesh())
+extern CookedMesh sceneModel;
+// границы объектов сцены структурой массивов для отсечения по граням кубических карт (обновляются вместе с scene)
+extern CasterCuller casterCuller;
+// BVH над границами объектов сцены для отсечения пирамидой камеры в основном проходе
+extern BoundsBVH sceneBVH;
+
+// источники света (см. point_lights.h)
+extern std::vector<PointLight> lights;
+
+// camera
+extern Camera camera;
+extern float lastX;
+extern float lastY;
+extern bool firstMouse;
+
+// timing
+extern float deltaTime;
+extern float lastFrame;
+
+// параметры запуска из командной строки (см. parseArguments)
+// --headless: рендеринг без окна во внеэкранный FBO, фиксированное число кадров и отчёт в JSON
+struct RunOptions
+{
+    bool headless = false;
+    int frames = 600;           // число кадров, попадающих в отчёт
+    int warmup = 30;            // кадры прогрева перед замером
+    float timeStep = 1.0f / 60.0f; // шаг детерминированной временной шкалы в headless-режиме
+    std::string jsonPath;       // куда писать отчёт (пусто — в stdout)
+    std::string dumpPath;       // сохранить последний кадр в PPM
+    bool shadowCache = false;   // перерисовывать только изменившиеся грани кубической карты
+    bool staticLight = false;   // не двигать источник света
+    bool movingObject = false;  // двигать один из кубов (проверка кэша теней при движении объектов)
+    int lights = 1;             // количество точечных источников
+    bool sweepLights = false;   // прогнать замер для 1, 2, 4 ... MAX_LIGHTS источников
+    bool countGLCalls = false;  // считать вызовы OpenGL за кадр (см. GLCallCounter)
+    bool benchUniforms = false; // микробенчмарк: униформы по имени, по дескрипторам и через блоки униформ
+    UniformRing::Mode uboMode = UniformRing::PERSISTENT; // как обновляется кольцевой буфер униформ кадра
+    SubmitMode submitMode = SUBMIT_INSTANCED; // как отправляются партии сцены (см. SceneSubmitter)
+    int extraObjects = 0;       // дополнительные маленькие кубы в комнате (стресс-тест отправки сцены)
+    std::string modelPath;      // подготовленная модель (.cmesh, mesh_cooker) в комнате
+    ShadowFilter shadowFilter;  // фильтр мягких теней основного прохода
+    bool sweepFilter = false;   // прогнать замер для сетки и для каждого количества выборок диска Пуассона и PCSS
+    float lightRadius = 0.2f;   // радиус источников (размер полутени PCSS)
+    ShadowStorage shadowStorage = SHADOW_STORAGE_DEPTH32; // что хранят карты теней (см. ShadowStorage)
+    bool shadowPrecision = false; // отчёт о точности всех режимов хранения вместо рендеринга
+    bool benchCulling = false;  // микробенчмарк отсечения теневых объектов: скалярный тест и CasterCuller
+    int cullObjects = 100000;   // количество случайных AABB в микробенчмарке отсечения
+    bool visibility = true;     // отсечение пирамидой камеры и сортировка по ключу в основном проходе
+    DepthPrepassMode depthPrepass = DEPTH_PREPASS_AUTO; // предварительный проход глубины (клавиша Z переключает по кругу)
+    float prepassThreshold = 1.5f; // AUTO: перерисовка, начиная с которой проход включается
+    bool overdrawView = false;  // вместо освещения — яркость по количеству затенений пикселя
+    RenderPath renderPath = RENDER_FORWARD; // прямое или отложенное освещение (см. RenderPath)
+    bool sweepRenderer = false; // прогнать замер для прямого и отложенного пути
+    bool halfResolutionMask = false; // маски теней отложенного пути в половинном разрешении
+    LightCullingMode lightCulling = LIGHT_CULLING_COMPUTE; // кластерное отсечение источников (см. LightCullingMode)
+    bool verifyClusters = false; // сравнить списки вычислительного шейдера с LightClusters вместо рендеринга
+    std::string shaderCache = "shader_cache"; // директория кэша двоичных программ (пусто — без кэша)
+    bool shaderPermutations = true; // специализации основного прохода вместо ветвлений по униформам
+    bool stateCache = true;     // отбрасывать повторные привязки, переключения состояния и униформы (см. GLStateCache)
+    bool textureStreaming = true; // текстуры через TextureStreamer (иначе — loadTexture до первого кадра)
+    int textureBudgetKB = 4096; // байт загрузки текстур за кадр, КБ
+    bool benchTextures = false; // микробенчмарк загрузки текстур: синхронно и через TextureStreamer
+    int textureCount = 128;     // текстур в синтетической директории микробенчмарка
+    bool cookedTextures = true; // текстуры из resources/cooked (texture_cooker), если файл есть и формат поддерживается
+    int textureCacheMB = 256;   // бюджет видеопамяти TextureCache, МБ
+};
+extern const char* submitModeNames[SUBMIT_MODE_COUNT];
+extern RunOptions options;
+
+// отчёт в JSON: в файл --json или, без него, в stdout
+void writeReport(const std::string &report);
+void writeReport(const Benchmark &benchmark);
+
+#endif
@@ -0,0 +1,14 @@
+#version 330 core
+// Фрагментный шейдер микробенчмарка униформ (см. point_shadows_uniform_bench.vs)
+
+out vec4 FragColor;
+
+in vec4 FragPos;
+
+uniform vec3 viewPos;
+uniform bool shadows;
+
+void main()
+{
+    FragColor = vec4(viewPos, shadows ? 1.0 : 0.0) + FragPos;
+}
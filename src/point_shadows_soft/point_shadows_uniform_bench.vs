@@ -0,0 +1,30 @@
+#version 330 core
+// Программа микробенчмарка униформ (--bench-uniforms): униформы кадра, которые программы теней и освещения
+// раньше получали по отдельности, собраны в одном шейдере как обычные униформы. Программа ничего не рисует —
+// важно только, чтобы все униформы были активными и их загрузка была настоящей.
+
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 projection;
+uniform mat4 view;
+uniform mat4 model;
+uniform mat4 shadowMatrices[6];
+uniform vec3 lightPos;
+uniform float far_plane;
+uniform int faceMask;
+uniform int layerBase;
+uniform bool reverse_normals;
+
+out vec4 FragPos;
+
+void main()
+{
+    FragPos = model * vec4(aPos, 1.0);
+    vec4 position = projection * view * FragPos;
+    for (int face = 0; face < 6; ++face)
+        if ((faceMask & (1 << face)) != 0)
+            position += shadowMatrices[face] * FragPos;
+    if (reverse_normals)
+        position = -position;
+    gl_Position = position + vec4(lightPos, far_plane) + vec4(float(layerBase));
+}
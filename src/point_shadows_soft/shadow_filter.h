@@ -0,0 +1,157 @@
+#ifndef SHADOW_FILTER_H
+#define SHADOW_FILTER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <opengllibs/shader.h>
+
+#include <string>
+
+// Фильтр мягких теней основного прохода (значения совпадают с SHADOW_FILTER_* в point_shadows.fs):
+//  GRID    — исходные 20 выборок по фиксированной сетке направлений;
+//  POISSON — samples выборок диска Пуассона, повёрнутого на пиксель, с ранним выходом по probes пробным выборкам;
+//  PCSS    — blockerSamples выборок поиска блокеров, затем тот же диск радиуса полутени, которая зависит от
+//            радиуса источника и расстояния до блокеров. Радиусы поиска и фильтрации ограничены maxRadius,
+//            так что цена фрагмента ограничена blockerSamples + samples выборками;
+//  VSM     — карта моментов (d, d^2) в GL_RG32F, размытая разделимым фильтром и с мип-уровнями: одна
+//            трилинейная выборка и неравенство Чебышёва вместо ядра PCF;
+//  EVSM    — моменты экспоненциально искажённой глубины (две пары) в GL_RGBA16F, меньше просвечивания, чем у VSM.
+enum ShadowFilterMode
+{
+    SHADOW_FILTER_GRID,
+    SHADOW_FILTER_POISSON,
+    SHADOW_FILTER_PCSS,
+    SHADOW_FILTER_VSM,
+    SHADOW_FILTER_EVSM,
+    SHADOW_FILTER_MODE_COUNT
+};
+const char* const shadowFilterNames[SHADOW_FILTER_MODE_COUNT] = { "grid", "poisson", "pcss", "vsm", "evsm" };
+
+// Количества выборок диска Пуассона, которые можно выбрать (и которые перебирает --sweep-filter)
+const int SHADOW_FILTER_SAMPLE_COUNTS[] = { 4, 8, 16, 32 };
+
+struct ShadowFilter
+{
+    ShadowFilterMode mode = SHADOW_FILTER_POISSON;
+    int samples = 16;
+    int probes = 4;           // 0 — всегда полное ядро
+    bool hardwarePCF = true;  // выборки через сэмплер со сравнением (4 texel'а на выборку)
+    int blockerSamples = 8;   // PCSS: выборок поиска блокеров
+    float maxRadius = 0.5f;   // PCSS: предел радиуса поиска и полутени (в мировых единицах на расстоянии фрагмента)
+    int blurRadius = 2;       // VSM/EVSM: выборок размытия в каждую сторону (ядро 2 * blurRadius + 1 по каждой оси)
+    float bleedReduction = 0.2f; // VSM/EVSM: доля p_max, считающаяся тенью (против просвечивания)
+    float minVariance = 1e-5f;   // VSM/EVSM: нижняя граница дисперсии
+    // EVSM: показатели экспонент; в GL_RGBA16F квадрат e^(c d) должен помещаться в half, отсюда c <= 5.5
+    glm::vec2 evsmExponents = glm::vec2(5.0f, 5.0f);
+
+    bool usesMoments() const { return mode == SHADOW_FILTER_VSM || mode == SHADOW_FILTER_EVSM; }
+    // формат карт моментов атласа (GL_NONE — фильтр читает глубину напрямую)
+    GLenum momentFormat() const
+    {
+        if (mode == SHADOW_FILTER_VSM)
+            return GL_RG32F;
+        return mode == SHADOW_FILTER_EVSM ? GL_RGBA16F : GL_NONE;
+    }
+
+    // имя уровня качества для отчётов: "grid", "poisson16", "poisson16+hw", "pcss16/b8+hw", "vsm/blur2"...
+    std::string name() const
+    {
+        std::string result = shadowFilterNames[mode];
+        if (usesMoments())
+            return result + "/blur" + std::to_string(blurRadius);
+        if (mode != SHADOW_FILTER_GRID)
+            result += std::to_string(samples);
+        if (mode == SHADOW_FILTER_PCSS)
+            result += "/b" + std::to_string(blockerSamples);
+        if (mode != SHADOW_FILTER_GRID && probes > 0 && probes < samples)
+            result += "+probe" + std::to_string(probes);
+        if (hardwarePCF)
+            result += "+hw";
+        return result;
+    }
+};
+
+// Дескрипторы униформ фильтра в программе основного прохода
+struct ShadowFilterUniforms
+{
+    Shader::Uniform<int> mode, samples, probes, hardwarePCF, blockerSamples;
+    Shader::Uniform<float> maxRadius, bleedReduction, minVariance;
+    Shader::Uniform<glm::vec2> evsmExponents;
+
+    ShadowFilterUniforms() {}
+    explicit ShadowFilterUniforms(const Shader& shader)
+    {
+        mode = shader.uniform<int>("shadowFilter");
+        samples = shader.uniform<int>("shadowSamples");
+        probes = shader.uniform<int>("shadowProbes");
+        hardwarePCF = shader.uniform<int>("shadowHardwarePCF");
+        blockerSamples = shader.uniform<int>("shadowBlockerSamples");
+        maxRadius = shader.uniform<float>("shadowMaxRadius");
+        bleedReduction = shader.uniform<float>("shadowBleedReduction");
+        minVariance = shader.uniform<float>("shadowMinVariance");
+        evsmExponents = shader.uniform<glm::vec2>("shadowEvsmExponents");
+    }
+
+    // программа уже активна
+    void apply(const Shader& shader, const ShadowFilter& filter) const
+    {
+        shader.set(mode, (int)filter.mode);
+        shader.set(samples, filter.samples);
+        shader.set(probes, filter.probes);
+        shader.set(hardwarePCF, (int)filter.hardwarePCF);
+        shader.set(blockerSamples, filter.blockerSamples);
+        shader.set(maxRadius, filter.maxRadius);
+        shader.set(bleedReduction, filter.bleedReduction);
+        shader.set(minVariance, filter.minVariance);
+        shader.set(evsmExponents, filter.evsmExponents);
+    }
+};
+
+// Проход построения карт моментов (point_shadows_fullscreen.vs, point_shadows_moments.fs): два прохода
+// разделимого размытия на грань, первый переводит глубину атласа в моменты. Полноэкранный треугольник
+// рисуется из пустого VAO.
+struct MomentPass
+{
+    Shader shader;
+    unsigned int emptyVAO = 0;
+    Shader::Uniform<int> sourceLayer, fromDepth, hardwareDepth, face, axis, resolution, blurRadius, momentMode;
+    Shader::Uniform<float> farPlane;
+    Shader::Uniform<glm::vec2> evsmExponents;
+
+    MomentPass() : shader("point_shadows_fullscreen.vs", "point_shadows_moments.fs")
+    {
+        glGenVertexArrays(1, &emptyVAO);
+        sourceLayer = shader.uniform<int>("sourceLayer");
+        fromDepth = shader.uniform<int>("fromDepth");
+        hardwareDepth = shader.uniform<int>("hardwareDepth");
+        farPlane = shader.uniform<float>("farPlane");
+        face = shader.uniform<int>("face");
+        axis = shader.uniform<int>("axis");
+        resolution = shader.uniform<int>("resolution");
+        blurRadius = shader.uniform<int>("blurRadius");
+        momentMode = shader.uniform<int>("momentMode");
+        evsmExponents = shader.uniform<glm::vec2>("evsmExponents");
+        shader.use();
+        shader.setInt("source", 0);
+    }
+
+    ~MomentPass()
+    {
+        glDeleteVertexArrays(1, &emptyVAO);
+    }
+
+    MomentPass(const MomentPass&) = delete;
+    MomentPass& operator=(const MomentPass&) = delete;
+
+    // параметры фильтра (программа становится активной)
+    void apply(const ShadowFilter& filter)
+    {
+        shader.use();
+        shader.set(blurRadius, filter.blurRadius);
+        shader.set(momentMode, filter.mode == SHADOW_FILTER_EVSM ? 1 : 0);
+        shader.set(evsmExponents, filter.evsmExponents);
+    }
+};
+
+#endif
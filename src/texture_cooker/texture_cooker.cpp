@@ -0,0 +1,188 @@
+// texture_cooker — офлайн-подготовка текстур для демо: изображение (PNG, JPEG, ... — всё, что читает stb_image)
+// сжимается блочным форматом на CPU вместе со всеми мип-уровнями и записывается в контейнер .ctex
+// (см. CookedTexture), который демо отображает в память и отдаёт glCompressedTexImage2D без декодирования.
+//
+// texture_cooker [--format F] [--report] (-o FILE | --out-dir DIR) INPUT...
+// texture_cooker [--format F] --report INPUT...
+// --format F     auto (по умолчанию), bc1, bc3, bc4, bc5 или bc7;
+//                auto: RGB -> bc1, RGBA -> bc3, один канал -> bc4, два канала -> bc5
+// -o FILE        выходной файл (только для одного входа)
+// --out-dir DIR  выходные файлы DIR/<имя входа>.ctex
+// --report       отчёт о размере и качестве: для каждого входа — все подходящие его каналам форматы,
+//                PSNR уровня 0 после кодирования и декодирования, байты всех уровней и сжатие относительно
+//                несжатого RGBA8 с мип-уровнями (так текстуры хранятся в видеопамяти сейчас);
+//                без -o и --out-dir файлы не пишутся, всё кодируется только в памяти
+// -----------------------------------------------------------------------------------------------------------
+#include <stb_image.h>
+
+#include <opengllibs/block_compression.h>
+#include <opengllibs/texture_container.h>
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct CookerOptions
+{
+    int format = -1; // -1 — auto
+    bool report = false;
+    std::string output;
+    std::string outputDirectory;
+    std::vector<std::string> inputs;
+};
+
+static bool parseArguments(int argc, char** argv, CookerOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--format" && hasValue)
+        {
+            std::string name = argv[++i];
+            int format = 0;
+            while (format < BLOCK_FORMAT_COUNT && name != blockFormatNames[format])
+                ++format;
+            if (name == "auto")
+                format = -1;
+            else if (format == BLOCK_FORMAT_COUNT)
+            {
+                std::cout << "Unknown format: " << name << std::endl;
+                return false;
+            }
+            options.format = format;
+        }
+        else if (arg == "--report")
+            options.report = true;
+        else if (arg == "-o" && hasValue)
+            options.output = argv[++i];
+        else if (arg == "--out-dir" && hasValue)
+            options.outputDirectory = argv[++i];
+        else if (!arg.empty() && arg[0] != '-')
+            options.inputs.push_back(arg);
+        else
+        {
+            std::cout << "Unknown argument: " << arg << std::endl;
+            return false;
+        }
+    }
+    bool writes = !options.output.empty() || !options.outputDirectory.empty();
+    if (options.inputs.empty() || (!writes && !options.report) ||
+        (!options.output.empty() && options.inputs.size() > 1))
+    {
+        std::cout << "Usage: texture_cooker [--format auto|bc1|bc3|bc4|bc5|bc7] [--report]"
+                     " (-o FILE | --out-dir DIR) INPUT...\n"
+                     "       texture_cooker [--format auto|bc1|bc3|bc4|bc5|bc7] --report INPUT..." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// сжать все уровни; возвращает время кодирования в секундах
+static double encodeLevels(BlockFormat format, const std::vector<RGBAImage>& mips, std::vector<std::vector<uint8_t>>& levels)
+{
+    auto start = std::chrono::steady_clock::now();
+    levels.resize(mips.size());
+    for (size_t i = 0; i < mips.size(); ++i)
+        BlockCompression::encode(format, mips[i], levels[i]);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// строка отчёта: формат, байт всех уровней, сжатие, PSNR цвета и альфы уровня 0, время кодирования
+static void reportFormat(const std::string& name, BlockFormat format, const std::vector<RGBAImage>& mips, int channels,
+                         size_t uncompressedBytes)
+{
+    std::vector<std::vector<uint8_t>> levels;
+    double seconds = encodeLevels(format, mips, levels);
+    size_t bytes = 0;
+    for (const std::vector<uint8_t>& level : levels)
+        bytes += level.size();
+    RGBAImage decoded;
+    BlockCompression::decode(format, levels[0].data(), mips[0].width, mips[0].height, decoded);
+    // каналы, которые формат хранит: BC4 — R, BC5 — RG, BC1 — RGB, BC3 и BC7 — RGBA
+    int colorChannels = format == BLOCK_BC4 ? 1 : format == BLOCK_BC5 ? 2 : std::min(channels, 3);
+    double colorPsnr = BlockCompression::psnr(mips[0], decoded, 0, colorChannels);
+    char alpha[32] = "";
+    if (channels == 4 && (format == BLOCK_BC3 || format == BLOCK_BC7))
+        std::snprintf(alpha, sizeof(alpha), ", alpha %6.2f dB", BlockCompression::psnr(mips[0], decoded, 3, 1));
+    char line[256];
+    std::snprintf(line, sizeof(line), "  %-4s %10zu bytes  %5.2fx  psnr %6.2f dB%s  encode %8.1f ms",
+                  blockFormatNames[format], bytes, (double)uncompressedBytes / bytes, colorPsnr, alpha, seconds * 1000.0);
+    std::cout << name << line << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    CookerOptions options;
+    if (!parseArguments(argc, argv, options))
+        return 1;
+
+    int failures = 0;
+    for (const std::string& input : options.inputs)
+    {
+        int width = 0, height = 0, channels = 0;
+        unsigned char* data = stbi_load(input.c_str(), &width, &height, &channels, 4);
+        if (data == nullptr)
+        {
+            std::cout << "Cannot load " << input << ": " << stbi_failure_reason() << std::endl;
+            ++failures;
+            continue;
+        }
+        RGBAImage image(width, height);
+        std::copy(data, data + image.pixels.size(), image.pixels.begin());
+        stbi_image_free(data);
+        std::vector<RGBAImage> mips = image.mipChain();
+
+        BlockFormat format = options.format < 0 ? BlockCompression::automaticFormat(channels) : (BlockFormat)options.format;
+        std::error_code error;
+        if (options.output.empty() && options.outputDirectory.empty())
+            std::cout << input << " (" << blockFormatNames[format] << ", " << width << "x" << height << ", "
+                      << mips.size() << " levels)" << std::endl;
+        else
+        {
+            std::vector<std::vector<uint8_t>> levels;
+            double seconds = encodeLevels(format, mips, levels);
+            std::vector<std::pair<int, int>> sizes;
+            for (const RGBAImage& mip : mips)
+                sizes.push_back({ mip.width, mip.height });
+
+            std::string output = options.output;
+            if (output.empty())
+                output = (std::filesystem::path(options.outputDirectory) / std::filesystem::path(input).stem()).string() + ".ctex";
+            std::filesystem::path parent = std::filesystem::path(output).parent_path();
+            if (!parent.empty())
+                std::filesystem::create_directories(parent, error);
+            uint32_t flags = channels == 4 ? CookedTexture::FLAG_ALPHA : 0;
+            if (!CookedTexture::write(output, format, flags, sizes, levels))
+            {
+                std::cout << "Cannot write " << output << std::endl;
+                ++failures;
+                continue;
+            }
+            std::cout << input << " -> " << output << " (" << blockFormatNames[format] << ", " << width << "x" << height
+                      << ", " << mips.size() << " levels, " << seconds * 1000.0 << " ms)" << std::endl;
+        }
+
+        if (options.report)
+        {
+            // несжатая текстура с мип-уровнями: RGBA8 (драйверы хранят GL_RGB в 4 байтах на пиксель)
+            size_t uncompressedBytes = 0;
+            for (const RGBAImage& mip : mips)
+                uncompressedBytes += mip.pixels.size();
+            std::uintmax_t sourceBytes = std::filesystem::file_size(input, error);
+            std::cout << "  source " << sourceBytes << " bytes, " << channels << " channels; rgba8 with mips "
+                      << uncompressedBytes << " bytes" << std::endl;
+            std::vector<BlockFormat> candidates;
+            if (channels <= 2)
+                candidates = { BLOCK_BC4, BLOCK_BC5 };
+            else
+                candidates = { BLOCK_BC1, BLOCK_BC3, BLOCK_BC7 };
+            for (BlockFormat candidate : candidates)
+                reportFormat(candidate == format ? "*" : " ", candidate, mips, channels, uncompressedBytes);
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}